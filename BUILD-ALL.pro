@@ -4,6 +4,11 @@ SUBDIRS = \
             pep9cpu \
             pep9micro \
             pep9term \
+            pep9test \
+
+# Pep9 and Pep9Micro use Pep9Term to write an image of their operating system.
+pep9asm.depends = pep9term
+pep9micro.depends = pep9term
 
 
 
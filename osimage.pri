@@ -0,0 +1,28 @@
+# Write an image of the application's default operating system next to its executable,
+# so that the application installs the image at launch instead of assembling the operating system.
+# Set OS_IMAGE_SOURCE to the operating system's source before including this file.
+#
+# The image is written by the Pep9Term of the same build, so BUILD-ALL.pro builds pep9term first.
+# If there is no Pep9Term, such as when this project is built on its own, the step fails without
+# failing the build, and the application assembles its operating system at launch instead.
+# The image is rewritten on every build, since it is only valid for the commit it was built from.
+macx: CONFIG(app_bundle) {
+    OS_IMAGE_TERM = $$OUT_PWD/../pep9term/Pep9Term.app/Contents/MacOS/Pep9Term
+    OS_IMAGE_FILE = $$OUT_PWD/$${TARGET}.app/Contents/MacOS/pep9os.img
+}
+else: win32 {
+    OS_IMAGE_TERM = $$OUT_PWD/../pep9term/Pep9Term.exe
+    OS_IMAGE_FILE = $$OUT_PWD/pep9os.img
+}
+else {
+    OS_IMAGE_TERM = $$OUT_PWD/../pep9term/Pep9Term
+    OS_IMAGE_FILE = $$OUT_PWD/pep9os.img
+}
+
+# A leading - lets make continue when the command fails.
+osimage.commands = -$$shell_quote($$shell_path($$OS_IMAGE_TERM)) osimage \
+    -s $$shell_quote($$shell_path($$OS_IMAGE_SOURCE)) -o $$shell_quote($$shell_path($$OS_IMAGE_FILE))
+# Run after the application is built by the default target.
+first.depends = $(first) osimage
+QMAKE_EXTRA_TARGETS += first osimage
+QMAKE_CLEAN += $$OS_IMAGE_FILE
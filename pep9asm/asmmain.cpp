@@ -20,6 +20,7 @@
 */
 
 #include <QtWidgets/QApplication>
+#include <QCommandLineParser>
 #include "asmmainwindow.h"
 #ifdef WIN32
 #include <string.h>
@@ -57,7 +58,24 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("Pep9");
     QCoreApplication::setApplicationVersion("9.3.0");
 
-    AsmMainWindow w;
+    // The CPU may access memory through a simulated cache, organized as in pep9term's run --cache.
+    // Parse leniently, since platforms may pass along options of their own.
+    QCommandLineParser parser;
+    QCommandLineOption cacheOption("cache", "Simulate a cache between the CPU and memory.", "cache_config");
+    parser.addOption(cacheOption);
+    parser.parse(a.arguments());
+    std::optional<CacheMemoryDevice::Configuration> cacheConfiguration;
+    if(parser.isSet(cacheOption)) {
+        CacheMemoryDevice::Configuration configuration;
+        QString errorMessage;
+        if(!CacheMemoryDevice::Configuration::fromString(parser.value(cacheOption), configuration, errorMessage)) {
+            std::cerr << errorMessage.toStdString() << std::endl;
+            return 1;
+        }
+        cacheConfiguration = configuration;
+    }
+
+    AsmMainWindow w(nullptr, cacheConfiguration);
     w.show();
     return a.exec();
 }
@@ -60,17 +60,23 @@
 #include "mainmemory.h"
 #include "memorychips.h"
 #include "memorydumppane.h"
+#include "osimagecache.h"
 #include "updatechecker.h"
 #include "redefinemnemonicsdialog.h"
 #include "registerfile.h"
+#include "simulationrunner.h"
 #include "symboltable.h"
 
-AsmMainWindow::AsmMainWindow(QWidget *parent) :
+AsmMainWindow::AsmMainWindow(QWidget *parent, std::optional<CacheMemoryDevice::Configuration> cacheConfiguration) :
     QMainWindow(parent),
     ui(new Ui::AsmMainWindow), debugState(DebugState::DISABLED), codeFont(QFont(Pep::codeFont, Pep::codeFontSize)),
     updateChecker(new UpdateChecker()), isInDarkMode(false),
-    memDevice(new MainMemory(nullptr)), controlSection(new IsaCpu(AsmProgramManager::getInstance(), memDevice)),
-    redefineMnemonicsDialog(new RedefineMnemonicsDialog(this)),programManager(AsmProgramManager::getInstance())
+    programManager(new AsmProgramManager(this)),
+    memDevice(new MainMemory(nullptr)),
+    cacheDevice(cacheConfiguration ? new CacheMemoryDevice(memDevice, *cacheConfiguration) : nullptr),
+    controlSection(new IsaCpu(programManager, cacheDevice.isNull() ? memDevice.staticCast<AMemoryDevice>()
+                                                                   : cacheDevice.staticCast<AMemoryDevice>())),
+    runner(new SimulationRunner(controlSection, this)), redefineMnemonicsDialog(new RedefineMnemonicsDialog(this))
 
 {
     // Initialize the memory subsystem
@@ -92,7 +98,8 @@ AsmMainWindow::AsmMainWindow(QWidget *parent) :
     ui->asmProgramTracePane->init(controlSection, programManager);
     ui->asmCpuPane->init(controlSection, controlSection);
     redefineMnemonicsDialog->init(true);
-    ui->executionStatisticsWidget->init(controlSection, false);
+    ui->executionStatisticsWidget->init(controlSection, programManager, false);
+    ui->executionStatisticsWidget->setCache(cacheDevice);
 
     // Create & connect all dialogs.
     helpDialog = new AsmHelpDialog(this);
@@ -162,6 +169,8 @@ AsmMainWindow::AsmMainWindow(QWidget *parent) :
     connect(this, &AsmMainWindow::simulationFinished, ui->executionStatisticsWidget, &ExecutionStatisticsWidget::onSimulationFinished, Qt::QueuedConnection);
     // Connect MainWindow so that it can propogate simulationFinished event and clean up when execution is finished.
     connect(controlSection.get(), &IsaCpu::simulationFinished, this, &AsmMainWindow::onSimulationFinished);
+    connect(runner, &SimulationRunner::finished, this, &AsmMainWindow::onRunFinished);
+    connect(runner, &SimulationRunner::progress, this, &AsmMainWindow::onRunProgress);
 
 
     // Connect simulation events that are internal to the class.
@@ -237,6 +246,12 @@ AsmMainWindow::AsmMainWindow(QWidget *parent) :
 
 AsmMainWindow::~AsmMainWindow()
 {
+    // A simulation on the worker thread must stop before the objects it uses are destroyed.
+    if(runner->isRunning()) {
+        controlSection->requestCancel();
+        memDevice->clearIO();
+        runner->waitForFinished();
+    }
     delete ui;
     delete helpDialog;
     delete aboutPepDialog;
@@ -741,10 +756,21 @@ void AsmMainWindow::assembleDefaultOperatingSystem()
     // If there is text, attempt to assemble it
     if(!defaultOSText.isEmpty()) {
         QSharedPointer<AsmProgram> prog;
+        // Prefer the image written next to the application by the build, and then the one cached
+        // by an earlier launch. Either is only loaded if it matches the source and the mnemonics.
+        OsImageCache bundledImage(OsImageCache::bundledImageFile());
+        OsImageCache userImage(OsImageCache::defaultImageFile());
+        if(!(prog = bundledImage.load(defaultOSText)).isNull() || !(prog = userImage.load(defaultOSText)).isNull()) {
+            // The listing is only assembled once the operating system is traced or profiled.
+            programManager->setOperatingSystemImage(prog, defaultOSText);
+            return;
+        }
         auto elist = QList<QPair<int, QString>>();
         IsaAsm assembler(*programManager);
         if(assembler.assembleOperatingSystem(defaultOSText, true, prog, elist)) {
             programManager->setOperatingSystem(prog);
+            // Failing to write the image only costs the next launch an assembly.
+            userImage.store(defaultOSText, *prog);
         }
         // If the operating system failed to assembly, we can't progress any further.
         // All application functionality depends on the operating system being defined.
@@ -848,6 +874,34 @@ bool AsmMainWindow::loadObjectCodeProgram()
     return hadData;
 }
 
+void AsmMainWindow::loadMachine()
+{
+    const QString source = ui->assemblerPane->getPaneContents(Enu::EPane::ESource);
+    const QString objectCode = ui->assemblerPane->getPaneContents(Enu::EPane::EObject);
+    QSharedPointer<const AsmProgram> operatingSystem = programManager->getOperatingSystem();
+    if(!snapshotOperatingSystem.isNull() && snapshotOperatingSystem == operatingSystem
+            && snapshotSource == source && snapshotObjectCode == objectCode
+            && controlSection->restoreSnapshot()) {
+        return;
+    }
+    invalidateSnapshot();
+    loadOperatingSystem();
+    // Only a successfully loaded program is worth returning to. Snapshots fail
+    // when a cache sits between the CPU and main memory.
+    if(loadObjectCodeProgram() && controlSection->takeSnapshot()) {
+        snapshotSource = source;
+        snapshotObjectCode = objectCode;
+        snapshotOperatingSystem = operatingSystem;
+    }
+}
+
+void AsmMainWindow::invalidateSnapshot()
+{
+    snapshotSource.clear();
+    snapshotObjectCode.clear();
+    snapshotOperatingSystem.clear();
+}
+
 void AsmMainWindow::set_Obj_Listing_filenames_from_Source()
 {
     ui->assemblerPane->setFilesFromSource();
@@ -877,6 +931,8 @@ void AsmMainWindow::debugButtonEnableHelper(const int which)
     ui->actionDebug_Step_Over_Assembler->setEnabled(which & DebugButtons::STEP_OVER_ASM);
     ui->actionDebug_Step_Into_Assembler->setEnabled(which & DebugButtons::STEP_INTO_ASM);
     ui->actionDebug_Step_Out_Assembler->setEnabled(which & DebugButtons::STEP_OUT_ASM);
+    ui->actionDebug_Step_Back_Assembler->setEnabled(which & DebugButtons::STEP_BACK_ASM);
+    ui->actionDebug_Reverse_Continue->setEnabled(which & DebugButtons::REVERSE_CONTINUE);
 
     // File open & new actions
     ui->actionFile_New_Asm->setEnabled(which & DebugButtons::OPEN_NEW);
@@ -914,6 +970,8 @@ bool AsmMainWindow::initializeSimulation()
     controlSection->onResetCPU();
     controlSection->initCPU();
     ui->asmCpuPane->clearCpu();
+    // Every run starts with a cold cache.
+    if(!cacheDevice.isNull()) cacheDevice->reset();
 
     // No longer emits simulationStarted(), as this could trigger extra screen painting that is unwanted.
     return true;
@@ -1129,31 +1187,21 @@ void AsmMainWindow::on_actionBuild_Execute_triggered()
         ui->memoryWidget->clearHighlight();
         ui->memoryWidget->refreshMemory();
         controlSection->onSimulationStarted();
-        controlSection->onRun();
-        connectViewUpdate();
+        // Only debugging can step backwards, so don't pay for the journal.
+        controlSection->setReverseStepEnabled(false);
+        // Execution continues in the background, and is wrapped up by onRunFinished().
+        runner->start([this](){controlSection->onRun();});
     }
     else {
         debugState = DebugState::DISABLED;
-    }
-    // If the simulator finished, then propogate that information to connect components.
-    if(controlSection->getExecutionFinished()) {
-        debugState = DebugState::DISABLED;
-        onSimulationFinished();
-        emit simulationFinished();
-    }
-    // Otherwise, the simulator paused execution, so don't explicitly terminate
-    // the simulator.
-    else {
-        handleDebugButtons();
-        emit simulationUpdate();
+        onRunFinished();
     }
 }
 
 void AsmMainWindow::on_actionBuild_Run_triggered()
 {
     if(!on_actionBuild_Assemble_triggered()) return;
-    loadOperatingSystem();
-    loadObjectCodeProgram();
+    loadMachine();
     debugState = DebugState::RUN;
     if (initializeSimulation()) {
         ui->asmProgramTracePane->startSimulationView();
@@ -1164,23 +1212,13 @@ void AsmMainWindow::on_actionBuild_Run_triggered()
         ui->memoryWidget->updateMemory();
         ui->memoryTracePane->updateTrace();
         controlSection->onSimulationStarted();
-        controlSection->onRun();
-        connectViewUpdate();
-
+        controlSection->setReverseStepEnabled(false);
+        // Execution continues in the background, and is wrapped up by onRunFinished().
+        runner->start([this](){controlSection->onRun();});
     }
     else {
         debugState = DebugState::DISABLED;
-    }
-    // If the simulator finished, then propogate that information to connect components.
-    if(controlSection->getExecutionFinished()) {
-        debugState = DebugState::DISABLED;
-        onSimulationFinished();
-    }
-    // Otherwise, the simulator paused execution, so don't explicitly terminate
-    // the simulator.
-    else {
-        handleDebugButtons();
-        emit simulationUpdate();
+        onRunFinished();
     }
 }
 
@@ -1229,6 +1267,8 @@ void AsmMainWindow::handleDebugButtons()
         enabledButtons |= DebugButtons::STEP_OUT_ASM*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_OVER_ASM*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_INTO_ASM*(enable_into * !waiting_io);
+        enabledButtons |= (DebugButtons::STEP_BACK_ASM | DebugButtons::REVERSE_CONTINUE)
+                *(controlSection->canStepBack() * !waiting_io);
         break;
     case DebugState::DEBUG_RESUMED:
         enabledButtons = DebugButtons::INTERRUPT | DebugButtons::STOP;
@@ -1253,14 +1293,15 @@ bool AsmMainWindow::on_actionDebug_Start_Debugging_triggered()
 
 bool AsmMainWindow::on_actionDebug_Start_Debugging_Object_triggered()
 {
-    loadOperatingSystem();
-    loadObjectCodeProgram();
+    loadMachine();
     connectViewUpdate();
     debugState = DebugState::DEBUG_ISA;
     ui->asmProgramTracePane->startSimulationView();
     if(initializeSimulation()) {
         emit simulationStarted();
         controlSection->onSimulationStarted();
+        // Journal every instruction, so that the debugger may step backwards.
+        controlSection->setReverseStepEnabled(true);
         controlSection->enableDebugging();
         controlSection->breakpointsSet(programManager->getBreakpoints());
         memDevice->clearBytesSet();
@@ -1315,6 +1356,13 @@ bool AsmMainWindow::on_actionDebug_Start_Debugging_Loader_triggered()
 
 void AsmMainWindow::on_actionDebug_Stop_Debugging_triggered()
 {
+    if(runner->isRunning()) {
+        // Release any pending input, and let onRunFinished() clean up once the simulation stops.
+        controlSection->requestCancel();
+        memDevice->clearIO();
+        ui->ioWidget->cancelWaiting();
+        return;
+    }
     connectViewUpdate();
     highlightActiveLines();
     debugState = DebugState::DISABLED;
@@ -1346,6 +1394,11 @@ void AsmMainWindow::on_actionDebug_Single_Step_Assembler_triggered()
 
 void AsmMainWindow::on_actionDebug_Interupt_Execution_triggered()
 {
+    if(runner->isRunning()) {
+        // The simulation pauses once it notices the request, and onRunFinished() updates the UI.
+        controlSection->requestBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
+        return;
+    }
     // Enable debugging in CPU and then temporarily pause execution.
     controlSection->enableDebugging();
     controlSection->forceBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
@@ -1362,16 +1415,8 @@ void AsmMainWindow::on_actionDebug_Continue_triggered()
     debugState = DebugState::DEBUG_RESUMED;
     handleDebugButtons();
     disconnectViewUpdate();
-    controlSection->onRun();
-    if(controlSection->hadErrorOnStep()) {
-        return; // we'll just return here instead of letting it fail and go to the bottom
-    }
-    connectViewUpdate();
-    if(controlSection->stoppedForBreakpoint()) {
-        emit simulationUpdate();
-        QApplication::processEvents();
-        highlightActiveLines();
-    }
+    // Execution continues in the background, and is wrapped up by onRunFinished().
+    runner->start([this](){controlSection->onRun();});
 }
 
 void AsmMainWindow::on_actionDebug_Step_Over_Assembler_triggered()
@@ -1425,6 +1470,27 @@ void AsmMainWindow::on_actionDebug_Step_Out_Assembler_triggered()
     emit simulationUpdate();
 }
 
+void AsmMainWindow::on_actionDebug_Step_Back_Assembler_triggered()
+{
+    debugState = DebugState::DEBUG_ISA;
+    ui->tabWidget->setCurrentIndex(ui->tabWidget->indexOf(ui->debuggerTab));
+    controlSection->stepBack();
+    emit simulationUpdate();
+}
+
+void AsmMainWindow::on_actionDebug_Reverse_Continue_triggered()
+{
+    ui->tabWidget->setCurrentIndex(ui->tabWidget->indexOf(ui->debuggerTab));
+    // Disconnect any drawing functions, since very many instructions might be undone.
+    disconnectViewUpdate();
+    controlSection->reverseContinue();
+    debugState = DebugState::DEBUG_ISA;
+    connectViewUpdate();
+    // Memory may have changed anywhere, so re-render it rather than update it in place.
+    ui->memoryWidget->refreshMemory();
+    emit simulationUpdate();
+}
+
 void AsmMainWindow::onASMBreakpointHit()
 {
     debugState = DebugState::DEBUG_ISA;
@@ -1445,6 +1511,7 @@ void AsmMainWindow::on_actionSystem_Clear_CPU_triggered()
 
 void AsmMainWindow::on_actionSystem_Clear_Memory_triggered()
 {
+    invalidateSnapshot();
     memDevice->clearMemory();
     ui->memoryWidget->refreshMemory();
     ui->memoryWidget->clearHighlight();
@@ -1456,6 +1523,7 @@ void AsmMainWindow::on_actionSystem_Assemble_Install_New_OS_triggered()
     auto output = programManager->assembleOS(ui->assemblerPane->getPaneContents(Enu::EPane::ESource),false);
     if(output->success) {
         programManager->setOperatingSystem(output->prog);
+        invalidateSnapshot();
         ui->assemblerPane->setPanesFromProgram(*output);
         ui->asmProgramTracePane->onRemoveAllBreakpoints();
         controlSection->breakpointsRemoveAll();
@@ -1476,6 +1544,7 @@ void AsmMainWindow::on_actionSystem_Assemble_Install_New_OS_triggered()
 void AsmMainWindow::on_actionSystem_Reinstall_Default_OS_triggered()
 {
     assembleDefaultOperatingSystem();
+    invalidateSnapshot();
     loadOperatingSystem();
     ui->memoryWidget->refreshMemory();
 }
@@ -1488,6 +1557,8 @@ void AsmMainWindow::on_actionSystem_Redefine_Mnemonics_triggered()
 void AsmMainWindow::redefine_Mnemonics_closed()
 {
     // Propogate ASM-level instruction definition changes across the application.
+    // The same source may now assemble differently, so don't trust the last load.
+    invalidateSnapshot();
     ui->assemblerPane->rebuildHighlightingRules();
     ui->asmProgramTracePane->rebuildHighlightingRules();
 }
@@ -1508,6 +1579,30 @@ void AsmMainWindow::onSimulationFinished()
 
 }
 
+void AsmMainWindow::onRunFinished()
+{
+    connectViewUpdate();
+    // The CPU's signals are blocked while it runs in the background,
+    // so determine how the simulation stopped after the fact.
+    if(controlSection->getExecutionFinished() || controlSection->hadErrorOnStep()) {
+        debugState = DebugState::DISABLED;
+        onSimulationFinished();
+        return;
+    }
+    if(controlSection->stoppedForBreakpoint()) {
+        onBreakpointHit(Enu::BreakpointTypes::ASSEMBLER);
+    }
+    // Otherwise, the simulator paused execution, so don't explicitly terminate
+    // the simulator.
+    handleDebugButtons();
+    emit simulationUpdate();
+}
+
+void AsmMainWindow::onRunProgress(ACPUModel::RunStatus status)
+{
+    ui->statusBar->showMessage(SimulationRunner::describeProgress(status, "instructions"));
+}
+
 void AsmMainWindow::onDarkModeChanged()
 {
     isInDarkMode = inDarkMode();
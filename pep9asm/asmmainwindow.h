@@ -22,7 +22,10 @@
 #define ASMMAINWINDOW_H
 
 #include <QtWidgets/QMainWindow>
+#include <optional>
 
+#include "acpumodel.h"
+#include "cachememorydevice.h"
 #include "pep.h"
 #include <QDir>
 #include "isaasm.h"
@@ -30,6 +33,7 @@ namespace Ui {
     class AsmMainWindow;
 }
 class AboutPep;
+class AsmProgram;
 class AsmProgramManager;
 class ByteConverterBin;
 class ByteConverterChar;
@@ -42,6 +46,7 @@ class MicrocodePane;
 class MicroObjectCodePane;
 class UpdateChecker;
 class RedefineMnemonicsDialog;
+class SimulationRunner;
 
 //WIP classes
 class IsaCpu;
@@ -62,7 +67,9 @@ enum class DebugState
 class AsmMainWindow : public QMainWindow {
     Q_OBJECT
 public:
-    AsmMainWindow(QWidget *parent = nullptr);
+    // If cacheConfiguration is set, the CPU accesses memory through a cache organized accordingly.
+    AsmMainWindow(QWidget *parent = nullptr,
+                  std::optional<CacheMemoryDevice::Configuration> cacheConfiguration = std::nullopt);
     ~AsmMainWindow();
 protected:
     void changeEvent(QEvent *e);
@@ -83,17 +90,23 @@ private:
     ByteConverterDec *byteConverterDec;
     ByteConverterHex *byteConverterHex;
     ByteConverterInstr *byteConverterInstr;
+    // Owns the user program and operating system shown in this window.
+    // Must be declared before the CPU, which is constructed with it.
+    AsmProgramManager* programManager;
     // Main Memory
     QSharedPointer<MainMemory> memDevice;
+    // Cache between the CPU and main memory, or nullptr if no cache was configured.
+    // Must be declared before the CPU, which is constructed with it.
+    QSharedPointer<CacheMemoryDevice> cacheDevice;
     QSharedPointer<IsaCpu> controlSection;
+    // Runs simulations on a worker thread.
+    SimulationRunner* runner;
 
     // Dialogues
     AsmHelpDialog *helpDialog;
     AboutPep *aboutPepDialog;
     RedefineMnemonicsDialog *redefineMnemonicsDialog;
 
-    AsmProgramManager* programManager;
-
     // Disconnect or reconnect events that notify views of changes in model,
     // Disconnecting these events allow for faster execution when running or continuing.
     void connectViewUpdate();
@@ -122,6 +135,15 @@ private:
     void assembleDefaultOperatingSystem();
     void loadOperatingSystem();
     bool loadObjectCodeProgram();
+    // Put the operating system and object code program in memory. If neither they nor the source
+    // changed since the last load, the CPU's snapshot is restored instead, which only copies back
+    // the memory modified since. Otherwise, both are loaded and a new snapshot is taken.
+    void loadMachine();
+    // Force the next loadMachine() to reload memory, e.g. because the operating system changed.
+    void invalidateSnapshot();
+    // What memory held when the CPU's snapshot was taken, or empty if there is no usable snapshot.
+    QString snapshotSource, snapshotObjectCode;
+    QSharedPointer<const AsmProgram> snapshotOperatingSystem;
 
     //
     void set_Obj_Listing_filenames_from_Source();
@@ -134,7 +156,8 @@ private:
     {
         static const int RUN = 1<<0, RUN_OBJECT = 1<<1, DEBUG = 1<<2, DEBUG_OBJECT = 1<<3, DEBUG_LOADER = 1<<4,
         INTERRUPT = 1<<5, CONTINUE = 1<<6, STOP = 1<<8, STEP_OVER_ASM = 1<<9, STEP_INTO_ASM = 1<<10,
-        STEP_OUT_ASM = 1<<11,/*, SINGLE_STEP_ASM = 1<<13*/ BUILD_ASM = 1<<14,
+        STEP_OUT_ASM = 1<<11, STEP_BACK_ASM = 1<<12,/*, SINGLE_STEP_ASM = 1<<13*/ BUILD_ASM = 1<<14,
+        REVERSE_CONTINUE = 1<<15,
         OPEN_NEW = 1<<17, INSTALL_OS = 1<<18, CLEAR = 1<<20;
     };
 
@@ -202,6 +225,9 @@ private slots:
     void on_actionDebug_Step_Into_Assembler_triggered();
     // Executes the next ISA instructions until the call depth is decreased by 1.
     void on_actionDebug_Step_Out_Assembler_triggered();
+    // Undo the last instruction, or all instructions back to a breakpoint, using the CPU's journal.
+    void on_actionDebug_Step_Back_Assembler_triggered();
+    void on_actionDebug_Reverse_Continue_triggered();
 
     // System
     void on_actionSystem_Clear_CPU_triggered();
@@ -236,6 +262,9 @@ private slots:
 
     //Run events
     void onSimulationFinished();
+    // React to a run or continue that stopped, either because it finished, failed, or hit a breakpoint.
+    void onRunFinished();
+    void onRunProgress(ACPUModel::RunStatus status);
 
     // Byte converter
     void slotByteConverterDecEdited(const QString &);
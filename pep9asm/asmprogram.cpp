@@ -63,6 +63,15 @@ AsmProgram::AsmProgram(QList<QSharedPointer<AsmCode> > programList, QSharedPoint
     programBounds = {static_cast<quint16>(burnAddress), static_cast<quint16>(burnValue)};
 }
 
+AsmProgram::AsmProgram(QVector<quint8> objectCode, QSharedPointer<SymbolTable> symbolTable,
+                       QSharedPointer<const StaticTraceInfo> traceInfo, quint16 burnAddress, quint16 burnValue) : program(),
+    objectCodeImage(objectCode), indexToMemAddress(), memAddressToIndex(), symTable(symbolTable), traceInfo(traceInfo),
+    burn(true), burnAddress(burnAddress), burnValue(burnValue)
+{
+    programByteLength = burnValue - burnAddress;
+    programBounds = {static_cast<quint16>(burnAddress), static_cast<quint16>(burnValue)};
+}
+
 AsmProgram::~AsmProgram()
 {
 
@@ -75,6 +84,7 @@ quint16 AsmProgram::getProgramLength() const
 
 const QVector<quint8> AsmProgram::getObjectCode() const
 {
+    if(program.isEmpty()) return objectCodeImage;
     QVector<quint8> vect;
     QList<int> objCode;
     for(QSharedPointer<AsmCode> line : program) {
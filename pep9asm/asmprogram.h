@@ -57,6 +57,9 @@ public:
     explicit AsmProgram();
     explicit AsmProgram(QList<QSharedPointer<AsmCode>> programList, QSharedPointer<SymbolTable> symbolTable, QSharedPointer<const StaticTraceInfo> traceInfo);
     explicit AsmProgram(QList<QSharedPointer<AsmCode>> programList, QSharedPointer<SymbolTable> symbolTable, QSharedPointer<const StaticTraceInfo> traceInfo, quint16 burnAddress, quint16 burnValue);
+    // Construct a burned program from its object code alone, such as one loaded from an OsImageCache.
+    // The program has no lines of code, so its listing and source are empty.
+    explicit AsmProgram(QVector<quint8> objectCode, QSharedPointer<SymbolTable> symbolTable, QSharedPointer<const StaticTraceInfo> traceInfo, quint16 burnAddress, quint16 burnValue);
     ~AsmProgram();
 
     // Getters and setters for program features
@@ -91,6 +94,8 @@ public:
 private:
     QPair<quint16, quint16> programBounds;
     QList<QSharedPointer<AsmCode>> program;
+    // Object code of a program constructed without lines of code.
+    QVector<quint8> objectCodeImage;
     QMap<int, quint16> indexToMemAddress;
     QMap<quint16, int> memAddressToIndex;
     quint16 programByteLength;
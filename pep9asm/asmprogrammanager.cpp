@@ -23,19 +23,12 @@
 #include <QSharedPointer>
 #include "asmcode.h"
 #include "symbolentry.h"
-AsmProgramManager* AsmProgramManager::instance = nullptr;
 AsmProgramManager::AsmProgramManager(QObject *parent): QObject(parent), operatingSystem(nullptr), userProgram(nullptr)
 {
     userProgram.clear();
     operatingSystem.clear();
 }
 
-AsmProgramManager *AsmProgramManager::getInstance()
-{
-    if(instance == nullptr) instance = new AsmProgramManager();
-    return instance;
-}
-
 QSharedPointer<AsmProgram> AsmProgramManager::getOperatingSystem()
 {
     return operatingSystem;
@@ -59,6 +52,28 @@ QSharedPointer<const AsmProgram> AsmProgramManager::getUserProgram() const
 void AsmProgramManager::setOperatingSystem(QSharedPointer<AsmProgram> prog)
 {
     operatingSystem = prog;
+    operatingSystemSource.clear();
+}
+
+void AsmProgramManager::setOperatingSystemImage(QSharedPointer<AsmProgram> prog, QString sourceText)
+{
+    operatingSystem = prog;
+    operatingSystemSource = sourceText;
+}
+
+bool AsmProgramManager::ensureOperatingSystemListing()
+{
+    if(operatingSystem.isNull()) return false;
+    else if(operatingSystem->numberOfLines() != 0) return true;
+    else if(operatingSystemSource.isEmpty()) return false;
+    QSharedPointer<AsmProgram> prog;
+    auto elist = QList<QPair<int, QString>>();
+    IsaAsm assembler(*this);
+    // An image is only loaded if its source still assembles with the current mnemonics,
+    // so this only fails if the mnemonics were redefined without reinstalling the operating system.
+    if(!assembler.assembleOperatingSystem(operatingSystemSource, true, prog, elist)) return false;
+    setOperatingSystem(prog);
+    return true;
 }
 
 quint16 AsmProgramManager::getMemoryVectorValue(MemoryVectors vector) const
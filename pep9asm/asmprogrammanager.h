@@ -38,6 +38,7 @@ class AsmProgramManager: public QObject
 {
     Q_OBJECT
 public:
+    explicit AsmProgramManager(QObject* parent = nullptr);
     struct AsmOutput {
         QSharedPointer<AsmProgram> prog;
         QList<QPair<int, QString>> errors;
@@ -57,11 +58,17 @@ public:
      */
     static quint16 getMemoryVectorOffset(MemoryVectors which);
 
-    static AsmProgramManager* getInstance();
     // Get or set operating system code
     QSharedPointer<AsmProgram> getOperatingSystem();
     QSharedPointer<const AsmProgram> getOperatingSystem() const;
     void setOperatingSystem(QSharedPointer<AsmProgram> prog);
+    // Install an operating system loaded from an OsImageCache, which has no listing.
+    // sourceText is kept, so that the listing can be assembled when it is first needed.
+    void setOperatingSystemImage(QSharedPointer<AsmProgram> prog, QString sourceText);
+    // Replace an operating system installed from an image with one assembled from its source.
+    // The object code is unchanged, so memory need not be reloaded.
+    // Returns true if the operating system has a listing.
+    bool ensureOperatingSystemListing();
     quint16 getMemoryVectorValue(MemoryVectors vector) const;
 
     // Get or set user program
@@ -87,9 +94,9 @@ signals:
     void setBreakpoints(QSet<quint16> addresses);
 
 private:
-    AsmProgramManager(QObject* parent = nullptr);
-    static AsmProgramManager* instance;
     QSharedPointer<AsmProgram> operatingSystem;
+    // Source of an operating system installed from an image, until its listing is assembled.
+    QString operatingSystemSource;
     QSharedPointer<AsmProgram> userProgram;
 
 };
@@ -121,6 +121,8 @@ void AsmProgramTracePane::updateSimulationView()
 
         if(programManager->getOperatingSystem()->getProgramBounds().first <= pc &&
                 programManager->getOperatingSystem()->getProgramBounds().second >= pc) {
+            // An operating system loaded from an image is only assembled once it must be shown.
+            programManager->ensureOperatingSystemListing();
             setProgram(programManager->getOperatingSystem());
         }
         else {
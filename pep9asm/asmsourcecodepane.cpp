@@ -118,7 +118,7 @@ bool AsmSourceCodePane::assemble()
     if(!success) {
         return false;
     }
-    AsmProgramManager::getInstance()->setUserProgram(currentProgram);
+    programManager->setUserProgram(currentProgram);
     for (int i = 0; i < currentProgram->getProgram().size(); i++) {
         if(currentProgram->getProgram()[i]->getMemoryAddress() >=0) {
             addressToIndex[currentProgram->getProgram()[i]->getMemoryAddress()] = i;
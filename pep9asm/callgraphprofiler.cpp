@@ -0,0 +1,194 @@
+// File: callgraphprofiler.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "callgraphprofiler.h"
+
+#include <algorithm>
+
+#include "asmcode.h"
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "symbolentry.h"
+
+CallGraphProfiler::CallGraphProfiler(): nodes(), stack(), lastCycleCount(0)
+{
+
+}
+
+CallGraphProfiler::~CallGraphProfiler()
+{
+
+}
+
+void CallGraphProfiler::clear()
+{
+    nodes.clear();
+    stack.clear();
+    lastCycleCount = 0;
+}
+
+void CallGraphProfiler::recordInstruction(quint16 startPC, quint8 instrSpec, quint16 endPC, quint64 cycleCount)
+{
+    // The outermost frame is whatever code the simulation started in.
+    if(stack.empty()) {
+        nodes.push_back({startPC, -1, 1, 0, 0, {}});
+        stack.push_back(0);
+    }
+    // A call is charged to the caller, and a return to the callee.
+    Node& frame = nodes[static_cast<size_t>(stack.back())];
+    frame.instructions++;
+    frame.cycles += cycleCount - lastCycleCount;
+    lastCycleCount = cycleCount;
+
+    const Pep::DecodedOp& op = Pep::decodeTable[instrSpec];
+    if(op.callDepthDelta > 0) {
+        quint32 function = op.isTrap ? trapKey | static_cast<quint32>(op.mnemonic) : endPC;
+        int callee = child(stack.back(), function);
+        nodes[static_cast<size_t>(callee)].calls++;
+        // An accelerated trap returns in the same step it was called, so it never becomes a frame.
+        bool returned = op.isTrap && endPC == static_cast<quint16>(startPC + (op.isUnary ? 1 : 3));
+        if(!returned) stack.push_back(callee);
+    }
+    // Ignore returns that would pop the outermost frame, such as when a program
+    // manipulates the stack directly.
+    else if(op.callDepthDelta < 0 && stack.size() > 1) {
+        stack.pop_back();
+    }
+}
+
+int CallGraphProfiler::getStackDepth() const
+{
+    return static_cast<int>(stack.size());
+}
+
+QList<CallGraphProfiler::SubroutineProfile> CallGraphProfiler::getSubroutineProfiles(const AsmProgramManager &manager) const
+{
+    // Accumulate inclusive costs bottom up; callees always have larger indices than their callers.
+    std::vector<quint64> inclusiveInstructions(nodes.size()), inclusiveCycles(nodes.size());
+    for(size_t index = nodes.size(); index-- > 0;) {
+        inclusiveInstructions[index] += nodes[index].instructions;
+        inclusiveCycles[index] += nodes[index].cycles;
+        if(nodes[index].parent >= 0) {
+            inclusiveInstructions[static_cast<size_t>(nodes[index].parent)] += inclusiveInstructions[index];
+            inclusiveCycles[static_cast<size_t>(nodes[index].parent)] += inclusiveCycles[index];
+        }
+    }
+
+    QMap<quint32, SubroutineProfile> profiles;
+    for(size_t index = 0; index < nodes.size(); index++) {
+        const Node& node = nodes[index];
+        if(!profiles.contains(node.function)) {
+            profiles.insert(node.function, {functionName(manager, node.function), 0, 0, 0, 0, 0});
+        }
+        SubroutineProfile& profile = profiles[node.function];
+        profile.calls += node.calls;
+        profile.exclusiveInstructions += node.instructions;
+        profile.exclusiveCycles += node.cycles;
+        // Only the outermost activation of a recursive subroutine contributes inclusive costs.
+        bool recursive = false;
+        for(int ancestor = node.parent; ancestor >= 0 && !recursive;
+            ancestor = nodes[static_cast<size_t>(ancestor)].parent) {
+            recursive = nodes[static_cast<size_t>(ancestor)].function == node.function;
+        }
+        if(!recursive) {
+            profile.inclusiveInstructions += inclusiveInstructions[index];
+            profile.inclusiveCycles += inclusiveCycles[index];
+        }
+    }
+
+    QList<SubroutineProfile> list = profiles.values();
+    std::stable_sort(list.begin(), list.end(), [](const SubroutineProfile& lhs, const SubroutineProfile& rhs) {
+        return lhs.inclusiveInstructions > rhs.inclusiveInstructions;
+    });
+    return list;
+}
+
+QString CallGraphProfiler::foldedStacks(const AsmProgramManager &manager, bool useCycles) const
+{
+    // Names are looked up once per node, rather than once per frame of every stack.
+    QStringList paths;
+    QString output;
+    QTextStream stream(&output);
+    for(const Node& node : nodes) {
+        QString name = functionName(manager, node.function);
+        // Frames are separated by semicolons, so they must not appear in names.
+        name.replace(';', ':');
+        if(node.parent < 0) paths.append(name);
+        else paths.append(paths[node.parent] + ";" + name);
+        quint64 count = useCycles ? node.cycles : node.instructions;
+        if(count != 0) stream << paths.last() << " " << count << "\n";
+    }
+    return output;
+}
+
+QString CallGraphProfiler::report(const AsmProgramManager &manager) const
+{
+    QString output;
+    QTextStream stream(&output);
+    bool hasCycles = std::any_of(nodes.cbegin(), nodes.cend(), [](const Node& node) {return node.cycles != 0;});
+    stream << QString("Subroutine").leftJustified(20) << QString("Calls").rightJustified(10)
+           << QString("Inclusive").rightJustified(14) << QString("Exclusive").rightJustified(14);
+    if(hasCycles) {
+        stream << QString("Incl. cycles").rightJustified(14) << QString("Excl. cycles").rightJustified(14);
+    }
+    stream << "\n";
+    for(const auto& profile : getSubroutineProfiles(manager)) {
+        stream << profile.name.leftJustified(20) << QString::number(profile.calls).rightJustified(10)
+               << QString::number(profile.inclusiveInstructions).rightJustified(14)
+               << QString::number(profile.exclusiveInstructions).rightJustified(14);
+        if(hasCycles) {
+            stream << QString::number(profile.inclusiveCycles).rightJustified(14)
+                   << QString::number(profile.exclusiveCycles).rightJustified(14);
+        }
+        stream << "\n";
+    }
+    return output;
+}
+
+int CallGraphProfiler::child(int parent, quint32 function)
+{
+    auto& children = nodes[static_cast<size_t>(parent)].children;
+    auto existing = children.constFind(function);
+    if(existing != children.constEnd()) return existing.value();
+    int index = static_cast<int>(nodes.size());
+    children.insert(function, index);
+    // Insert after updating children, since push_back may invalidate the reference.
+    nodes.push_back({function, parent, 0, 0, 0, {}});
+    return index;
+}
+
+QString CallGraphProfiler::functionName(const AsmProgramManager &manager, quint32 function)
+{
+    if(function & trapKey) {
+        static QMetaEnum mnemonicMetaenum = Enu::staticMetaObject.enumerator(
+                    Enu::staticMetaObject.indexOfEnumerator("EMnemonic"));
+        return QString(mnemonicMetaenum.valueToKey(static_cast<int>(function & ~trapKey))).toLower();
+    }
+    quint16 address = static_cast<quint16>(function);
+    // Prefer the label of the called line, which is its entry in the program's symbol table.
+    for(const auto& program : {manager.getUserProgram(), manager.getOperatingSystem()}) {
+        if(program.isNull()) continue;
+        auto bounds = program->getProgramBounds();
+        if(address < bounds.first || bounds.second < address) continue;
+        const AsmCode* code = program->memAddressToCode(address);
+        if(code != nullptr && code->hasSymbolEntry()) return code->getSymbolEntry()->getName();
+    }
+    return "0x" + QString("%1").arg(address, 4, 16, QLatin1Char('0')).toUpper();
+}
@@ -0,0 +1,93 @@
+// File: callgraphprofiler.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CALLGRAPHPROFILER_H
+#define CALLGRAPHPROFILER_H
+
+#include <vector>
+#include <QtCore>
+
+#include "pep.h"
+
+class AsmProgramManager;
+
+/*
+ * Attributes executed instructions (and microcode cycles, when simulated) to subroutines.
+ *
+ * A shadow call stack is pushed by CALL and traps, and popped by RET and RETTR. Each distinct
+ * stack is a node in a calling context tree, so the profile can be reported both per
+ * subroutine and as folded stacks, the text format consumed by flame graph tools:
+ *     main;sort;swap 1042
+ *
+ * Subroutines are identified by the address that was called, and traps by their mnemonic.
+ * Names are resolved against the symbol tables of the loaded programs only when reporting.
+ */
+class CallGraphProfiler
+{
+public:
+    // Costs of a single subroutine, summed over every stack on which it appears.
+    // Inclusive costs count recursive calls once.
+    struct SubroutineProfile
+    {
+        QString name;
+        quint64 calls;
+        quint64 inclusiveInstructions, exclusiveInstructions;
+        quint64 inclusiveCycles, exclusiveCycles;
+    };
+
+    explicit CallGraphProfiler();
+    ~CallGraphProfiler();
+    void clear();
+
+    // Record that the instruction at startPC with specifier instrSpec executed, leaving the program
+    // counter at endPC. cycleCount is the CPU's running total of cycles, or 0 if cycles are not simulated.
+    void recordInstruction(quint16 startPC, quint8 instrSpec, quint16 endPC, quint64 cycleCount);
+
+    // Returns the number of frames on the shadow call stack, including the outermost frame.
+    int getStackDepth() const;
+    // Return the profile of each subroutine that executed, ordered by inclusive instructions.
+    QList<SubroutineProfile> getSubroutineProfiles(const AsmProgramManager& manager) const;
+    // Return one "frame;frame;frame count" line per distinct call stack. Counts are
+    // exclusive instructions, or exclusive cycles if useCycles.
+    QString foldedStacks(const AsmProgramManager& manager, bool useCycles = false) const;
+    // Return a plain text table of getSubroutineProfiles(...).
+    QString report(const AsmProgramManager& manager) const;
+
+private:
+    // Subroutines are keyed by the called address; traps by trapKey | mnemonic.
+    static constexpr quint32 trapKey = 1 << 16;
+    struct Node
+    {
+        quint32 function;
+        // Index of the calling node, or -1 for the outermost frame.
+        int parent;
+        quint64 calls, instructions, cycles;
+        QMap<quint32, int> children;
+    };
+    // Nodes are only appended, so a node's callees always follow it.
+    std::vector<Node> nodes;
+    std::vector<int> stack;
+    quint64 lastCycleCount;
+    // Return the index of function called from parent, creating the node if needed.
+    int child(int parent, quint32 function);
+    static QString functionName(const AsmProgramManager& manager, quint32 function);
+};
+
+#endif // CALLGRAPHPROFILER_H
@@ -22,16 +22,35 @@
 #include "executionstatisticswidget.h"
 #include "ui_executionstatisticswidget.h"
 #include "pep.h"
+#include "asmcode.h"
+#include "asmprogrammanager.h"
+#include "cachememorydevice.h"
 
 #include <QDebug>
+#include <QFileDialog>
+#include <QMessageBox>
 
 ExecutionStatisticsWidget::ExecutionStatisticsWidget(QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::ExecutionStatisticsWidget), model(new QStandardItemModel(this))
+    ui(new Ui::ExecutionStatisticsWidget), manager(nullptr), showCycles(true), model(new QStandardItemModel(this)),
+    profileModel(new QStandardItemModel(this)), subroutineModel(new QStandardItemModel(this)),
+    cacheModel(new QStandardItemModel(this))
 {
     ui->setupUi(this);
     ui->treeView->setModel(model);
     model->setHorizontalHeaderLabels({"Instruction", "Frequency"});
+    ui->treeView_Profile->setModel(profileModel);
+    profileModel->setHorizontalHeaderLabels({"Address", "Source", "Count", "Taken", "Not Taken"});
+    ui->treeView_Subroutines->setModel(subroutineModel);
+    subroutineModel->setHorizontalHeaderLabels({"Subroutine", "Calls", "Inclusive Instructions", "Exclusive Instructions",
+                                                "Inclusive Cycles", "Exclusive Cycles"});
+    ui->treeView_Cache->setModel(cacheModel);
+    cacheModel->setHorizontalHeaderLabels({"Counter", "Value"});
+    // Only machines with a cache have anything to show in the cache tab.
+    ui->tabWidget->removeTab(ui->tabWidget->indexOf(ui->tab_Cache));
+    connect(ui->checkBox_Profile, &QCheckBox::toggled, this, &ExecutionStatisticsWidget::onProfileToggled);
+    connect(ui->checkBox_CallGraph, &QCheckBox::toggled, this, &ExecutionStatisticsWidget::onCallGraphToggled);
+    connect(ui->pushButton_SaveFoldedStacks, &QPushButton::clicked, this, &ExecutionStatisticsWidget::onSaveFoldedStacks);
 
     // Use the default palette of one of the line editors as a starting point,
     // and set its background color to be entirely transparent.
@@ -44,12 +63,30 @@ ExecutionStatisticsWidget::ExecutionStatisticsWidget(QWidget *parent) :
     ui->lineEdit_Instructions->setPalette(pal);
 }
 
-void ExecutionStatisticsWidget::init(QSharedPointer<InterfaceISACPU> cpu, bool showCycles)
+void ExecutionStatisticsWidget::init(QSharedPointer<InterfaceISACPU> cpu, AsmProgramManager* manager,
+                                     bool showCycles)
 {
     this->cpu = cpu;
+    this->manager = manager;
+    this->showCycles = showCycles;
     if(!showCycles) {
         ui->label->hide();
         ui->lineEdit_Cycles->hide();
+        // Without a microcode simulation, every subroutine would cost zero cycles.
+        ui->treeView_Subroutines->setColumnHidden(4, true);
+        ui->treeView_Subroutines->setColumnHidden(5, true);
+    }
+}
+
+void ExecutionStatisticsWidget::setCache(QSharedPointer<const CacheMemoryDevice> cache)
+{
+    this->cache = cache;
+    int index = ui->tabWidget->indexOf(ui->tab_Cache);
+    if(cache.isNull() && index != -1) {
+        ui->tabWidget->removeTab(index);
+    }
+    else if(!cache.isNull() && index == -1) {
+        ui->tabWidget->addTab(ui->tab_Cache, "Cache");
     }
 }
 
@@ -60,7 +97,7 @@ ExecutionStatisticsWidget::~ExecutionStatisticsWidget()
 
 void ExecutionStatisticsWidget::highlightOnFocus()
 {
-    if (ui->treeView->hasFocus()) {
+    if (hasFocus()) {
         ui->statsLabel->setAutoFillBackground(true);
     }
     else {
@@ -70,7 +107,8 @@ void ExecutionStatisticsWidget::highlightOnFocus()
 
 bool ExecutionStatisticsWidget::hasFocus()
 {
-    return ui->treeView->hasFocus();
+    return ui->treeView->hasFocus() || ui->treeView_Profile->hasFocus() || ui->treeView_Subroutines->hasFocus()
+            || ui->treeView_Cache->hasFocus();
 }
 
 
@@ -82,12 +120,21 @@ void ExecutionStatisticsWidget::onClear()
     // Sort by a non-existent column to prevent the "sorting arrow"
     // from appearing over unsorted data.
     ui->treeView->sortByColumn(-1, Qt::SortOrder::AscendingOrder);
+    profileModel->removeRows(0, profileModel->rowCount());
+    ui->treeView_Profile->sortByColumn(-1, Qt::SortOrder::AscendingOrder);
+    subroutineModel->removeRows(0, subroutineModel->rowCount());
+    ui->treeView_Subroutines->sortByColumn(-1, Qt::SortOrder::AscendingOrder);
+    ui->pushButton_SaveFoldedStacks->setEnabled(false);
+    cacheModel->removeRows(0, cacheModel->rowCount());
 }
 
 void ExecutionStatisticsWidget::onSimulationStarted()
 {
     // Make sure no statistics are displayed at the start of a run.
     onClear();
+    // The profiler may not be created or destroyed while the CPU is executing.
+    ui->checkBox_Profile->setEnabled(false);
+    ui->checkBox_CallGraph->setEnabled(false);
 }
 
 void ExecutionStatisticsWidget::onSimulationFinished()
@@ -96,6 +143,52 @@ void ExecutionStatisticsWidget::onSimulationFinished()
     ui->lineEdit_Cycles->setText(QLocale::system().toString(cpu->getCycleCount()));
     ui->lineEdit_Instructions->setText(QLocale::system().toString(cpu->getInstructionCount()));
     fillModel(cpu->getInstructionHistogram());
+    // Profiles show the source of the operating system and name its subroutines by their labels.
+    if((cpu->getProfiler() != nullptr || cpu->getCallGraphProfiler() != nullptr) && manager != nullptr) {
+        manager->ensureOperatingSystemListing();
+    }
+    if(cpu->getProfiler() != nullptr) {
+        fillProfileModel(*cpu->getProfiler());
+        // Show the hottest instructions first.
+        ui->treeView_Profile->sortByColumn(2, Qt::SortOrder::DescendingOrder);
+    }
+    if(cpu->getCallGraphProfiler() != nullptr && manager != nullptr) {
+        fillSubroutineModel(*cpu->getCallGraphProfiler());
+        // Show the subroutines that dominated the run first.
+        ui->treeView_Subroutines->sortByColumn(showCycles ? 4 : 2, Qt::SortOrder::DescendingOrder);
+        ui->pushButton_SaveFoldedStacks->setEnabled(true);
+    }
+    if(!cache.isNull()) fillCacheModel();
+    ui->checkBox_Profile->setEnabled(true);
+    ui->checkBox_CallGraph->setEnabled(true);
+}
+
+void ExecutionStatisticsWidget::onProfileToggled(bool checked)
+{
+    cpu->setProfilingEnabled(checked);
+}
+
+void ExecutionStatisticsWidget::onCallGraphToggled(bool checked)
+{
+    cpu->setCallGraphProfilingEnabled(checked);
+    // Disabling the profiler discards its stacks, so there is nothing left to save.
+    if(!checked) ui->pushButton_SaveFoldedStacks->setEnabled(false);
+}
+
+void ExecutionStatisticsWidget::onSaveFoldedStacks()
+{
+    if(cpu->getCallGraphProfiler() == nullptr || manager == nullptr) return;
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Folded Stacks", "stacks.folded",
+                                                    "Folded stacks (*.folded *.txt)");
+    if(fileName.isEmpty()) return;
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        QMessageBox::warning(this, "Save Folded Stacks",
+                             QString("Cannot write file %1:\n%2.").arg(fileName).arg(file.errorString()));
+        return;
+    }
+    QTextStream(&file) << cpu->getCallGraphProfiler()->foldedStacks(*manager, showCycles);
+    file.close();
 }
 
 // POD class to help aggregate statistics.
@@ -181,3 +274,68 @@ void ExecutionStatisticsWidget::fillModel(const QVector<quint32> histogram)
     }
 
 }
+
+void ExecutionStatisticsWidget::fillProfileModel(const IsaProfiler &profiler)
+{
+    profileModel->removeRows(0, profileModel->rowCount());
+    QList<IsaProfiler::InstructionProfile> instructions;
+    if(manager != nullptr) instructions = profiler.getExecutedInstructions(*manager);
+    else instructions = profiler.getExecutedInstructions(nullptr, 0, 0xFFFF);
+
+    for(const auto& instr : instructions) {
+        // Fixed width hexadecimal addresses sort correctly as strings.
+        QStandardItem* address = new QStandardItem("0x" + QString("%1").arg(instr.address, 4, 16, QLatin1Char('0')).toUpper());
+        QStandardItem* source = new QStandardItem(instr.code == nullptr ? QString()
+                                                                        : instr.code->getAssemblerSource().simplified());
+        QStandardItem* count = new QStandardItem();
+        // Make a variant from an int type to ensure that sorting works correctly.
+        count->setData(QVariant(instr.executions), Qt::DisplayRole);
+        QStandardItem* taken = new QStandardItem(), *notTaken = new QStandardItem();
+        // Only conditional branches record an outcome.
+        if(instr.taken + instr.notTaken != 0) {
+            taken->setData(QVariant(instr.taken), Qt::DisplayRole);
+            notTaken->setData(QVariant(instr.notTaken), Qt::DisplayRole);
+        }
+        profileModel->insertRow(profileModel->rowCount(), {address, source, count, taken, notTaken});
+    }
+}
+
+void ExecutionStatisticsWidget::fillSubroutineModel(const CallGraphProfiler &profiler)
+{
+    subroutineModel->removeRows(0, subroutineModel->rowCount());
+    for(const auto& subroutine : profiler.getSubroutineProfiles(*manager)) {
+        QList<QStandardItem*> row = {new QStandardItem(subroutine.name)};
+        // Make variants from int types to ensure that sorting works correctly.
+        for(quint64 value : {subroutine.calls, subroutine.inclusiveInstructions, subroutine.exclusiveInstructions,
+                             subroutine.inclusiveCycles, subroutine.exclusiveCycles}) {
+            QStandardItem* item = new QStandardItem();
+            item->setData(QVariant(value), Qt::DisplayRole);
+            row.append(item);
+        }
+        subroutineModel->insertRow(subroutineModel->rowCount(), row);
+    }
+}
+
+void ExecutionStatisticsWidget::fillCacheModel()
+{
+    cacheModel->removeRows(0, cacheModel->rowCount());
+    const CacheMemoryDevice::Statistics& stats = cache->getStatistics();
+    const quint64 accesses = stats.hits() + stats.misses();
+    const QList<QPair<QString, QString>> rows = {
+        {"Configuration", cache->getConfiguration().toString()},
+        {"Hits", QLocale::system().toString(stats.hits())},
+        {"Read hits", QLocale::system().toString(stats.readHits)},
+        {"Write hits", QLocale::system().toString(stats.writeHits)},
+        {"Misses", QLocale::system().toString(stats.misses())},
+        {"Read misses", QLocale::system().toString(stats.readMisses)},
+        {"Write misses", QLocale::system().toString(stats.writeMisses)},
+        // Avoid dividing by zero when a program never touched cachable memory.
+        {"Hit rate", accesses == 0 ? "-" : QLocale::system().toString(100.0 * stats.hits() / accesses, 'f', 2) + "%"},
+        {"Evictions", QLocale::system().toString(stats.evictions)},
+        {"Write backs", QLocale::system().toString(stats.writeBacks)},
+        {"Uncached accesses", QLocale::system().toString(stats.uncached)},
+    };
+    for(const auto& row : rows) {
+        cacheModel->appendRow({new QStandardItem(row.first), new QStandardItem(row.second)});
+    }
+}
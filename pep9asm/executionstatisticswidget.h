@@ -25,6 +25,8 @@
 #include <QWidget>
 #include "interfaceisacpu.h"
 #include <QStandardItemModel>
+class AsmProgramManager;
+class CacheMemoryDevice;
 
 namespace Ui {
 class ExecutionStatisticsWidget;
@@ -36,7 +38,11 @@ class ExecutionStatisticsWidget : public QWidget
 
 public:
     explicit ExecutionStatisticsWidget(QWidget *parent = nullptr);
-    void init(QSharedPointer<InterfaceISACPU> cpu, bool showCycles);
+    // The operating system in manager is assembled if it has no listing, when a profile of a run is shown.
+    void init(QSharedPointer<InterfaceISACPU> cpu, AsmProgramManager* manager, bool showCycles);
+    // Show the hits, misses, and evictions of cache after each run. The cache tab is hidden
+    // until a cache is set.
+    void setCache(QSharedPointer<const CacheMemoryDevice> cache);
     ~ExecutionStatisticsWidget();
 
     void highlightOnFocus();
@@ -50,11 +56,27 @@ public slots:
     void onSimulationStarted();
     void onSimulationFinished();
 
+private slots:
+    void onProfileToggled(bool checked);
+    void onCallGraphToggled(bool checked);
+    // Ask for a file, and write the folded stacks of the last run to it.
+    // Stacks are weighted by cycles when cycles are shown, and by instructions otherwise.
+    void onSaveFoldedStacks();
+
 private:
     Ui::ExecutionStatisticsWidget *ui;
     QSharedPointer<InterfaceISACPU> cpu;
-    QStandardItemModel* model;
+    AsmProgramManager* manager;
+    QSharedPointer<const CacheMemoryDevice> cache;
+    bool showCycles;
+    QStandardItemModel* model, *profileModel, *subroutineModel, *cacheModel;
     void fillModel(const QVector<quint32> histogram);
+    // Fill the profile view with every instruction executed during the last run.
+    void fillProfileModel(const IsaProfiler& profiler);
+    // Fill the subroutine view with the inclusive and exclusive costs of each subroutine called during the last run.
+    void fillSubroutineModel(const CallGraphProfiler& profiler);
+    // Fill the cache view with the counters gathered by cache during the last run.
+    void fillCacheModel();
 };
 
 #endif // EXECUTIONSTATISTICSWIDGET_H
@@ -32,14 +32,35 @@ InterfaceISACPU::InterfaceISACPU(const AMemoryDevice* dev, const AsmProgramManag
     manager(manager), opValCache(0),
     breakpointsISA(), asmInstructionCounter(0), asmBreakpointHit(false), doDebug(false),
     firstLineAfterCall(false), isTrapped(false), memTrace(QSharedPointer<MemoryTrace>::create()),
-    userActions(), osActions(), activeActions(&userActions)
+    userActions(), osActions(), activeActions(&userActions), profiler(nullptr),
+    callGraphProfiler(nullptr)
 {
     memTrace->activeStack = &memTrace->userStack;
 }
 
 InterfaceISACPU::~InterfaceISACPU()
 {
+    delete profiler;
+    delete callGraphProfiler;
+}
+
+InterfaceISACPU::TraceState InterfaceISACPU::saveTraceState() const
+{
+    return {opValCache, asmInstructionCounter, firstLineAfterCall, isTrapped,
+                activeActions == &osActions, *memTrace, userActions, osActions, heapPtr};
+}
 
+void InterfaceISACPU::restoreTraceState(const TraceState &state)
+{
+    opValCache = state.opValCache;
+    asmInstructionCounter = state.asmInstructionCounter;
+    firstLineAfterCall = state.firstLineAfterCall;
+    isTrapped = state.isTrapped;
+    *memTrace = state.memTrace;
+    userActions = state.userActions;
+    osActions = state.osActions;
+    activeActions = state.inOperatingSystem ? &osActions : &userActions;
+    heapPtr = state.heapPtr;
 }
 
 const QSet<quint16> InterfaceISACPU::getPCBreakpoints() const noexcept
@@ -71,6 +92,54 @@ void InterfaceISACPU::breakpointAdded(quint16 address) noexcept
     if(doDebug)qDebug() << "Added breakpoint at: " << address;
 }
 
+void InterfaceISACPU::setProfilingEnabled(bool enabled)
+{
+    if(enabled && profiler == nullptr) {
+        profiler = new IsaProfiler();
+    }
+    else if(!enabled) {
+        delete profiler;
+        profiler = nullptr;
+    }
+}
+
+bool InterfaceISACPU::isProfilingEnabled() const noexcept
+{
+    return profiler != nullptr;
+}
+
+const IsaProfiler *InterfaceISACPU::getProfiler() const noexcept
+{
+    return profiler;
+}
+
+void InterfaceISACPU::setCallGraphProfilingEnabled(bool enabled)
+{
+    if(enabled && callGraphProfiler == nullptr) {
+        callGraphProfiler = new CallGraphProfiler();
+    }
+    else if(!enabled) {
+        delete callGraphProfiler;
+        callGraphProfiler = nullptr;
+    }
+}
+
+bool InterfaceISACPU::isCallGraphProfilingEnabled() const noexcept
+{
+    return callGraphProfiler != nullptr;
+}
+
+const CallGraphProfiler *InterfaceISACPU::getCallGraphProfiler() const noexcept
+{
+    return callGraphProfiler;
+}
+
+void InterfaceISACPU::clearProfilers()
+{
+    if(profiler != nullptr) profiler->clear();
+    if(callGraphProfiler != nullptr) callGraphProfiler->clear();
+}
+
 QSharedPointer<const MemoryTrace> InterfaceISACPU::getMemoryTrace() const
 {
     return memTrace;
@@ -95,11 +164,12 @@ void InterfaceISACPU::doISAStepWhile(std::function<bool ()> condition)
 
 void InterfaceISACPU::calculateStackChangeStart(quint8 instr)
 {
-    if(Pep::isTrapMap[Pep::decodeMnemonic[instr]]) {
+    const Pep::DecodedOp& op = Pep::decodeTable[instr];
+    if(op.isTrap) {
         isTrapped = true;
         activeActions = &osActions;
     }
-    else if(Pep::decodeMnemonic[instr] == Enu::EMnemonic::RETTR) {
+    else if(op.mnemonic == Enu::EMnemonic::RETTR) {
         isTrapped = false;
         memTrace->activeStack = &memTrace->userStack;
         activeActions = &userActions;
@@ -127,7 +197,7 @@ void InterfaceISACPU::calculateStackChangeEnd(quint8 instr, quint16 opspec, quin
     if(!memTrace->activeStack->isStackIntact() || this->manager->getProgramAt(pc) == nullptr
             // For now, only allow tracing of user programs
             || this->manager->getUserProgram() != this->manager->getProgramAt(pc)) return;
-    Enu::EMnemonic mnemon = Pep::decodeMnemonic[instr];
+    Enu::EMnemonic mnemon = Pep::decodeTable[instr].mnemonic;
     quint16 size = 0;
     bool mallocPreError = false;
     switch(mnemon) {
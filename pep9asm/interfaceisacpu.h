@@ -24,6 +24,8 @@
 #include <QSet>
 #include <QtCore>
 #include <ostream>
+#include "callgraphprofiler.h"
+#include "isaprofiler.h"
 #include "stacktrace.h"
 class AMemoryDevice;
 class AsmProgramManager;
@@ -68,6 +70,19 @@ public:
     // Output breakpoint changes to the console.
     void setDebugBreakpoints(bool doDebug) noexcept;
 
+    // When enabled, count the executions of each instruction address and the outcomes
+    // of each conditional branch. Counts are cleared whenever a simulation starts.
+    void setProfilingEnabled(bool enabled);
+    bool isProfilingEnabled() const noexcept;
+    // Returns nullptr if profiling is disabled.
+    const IsaProfiler* getProfiler() const noexcept;
+    // When enabled, attribute instructions (and cycles) to subroutines through a shadow call stack.
+    // Costs are cleared whenever a simulation starts.
+    void setCallGraphProfilingEnabled(bool enabled);
+    bool isCallGraphProfilingEnabled() const noexcept;
+    // Returns nullptr if call graph profiling is disabled.
+    const CallGraphProfiler* getCallGraphProfiler() const noexcept;
+
 
     // Stores the call depth, and continues to execute ISA instructions
     // until the new call depth equals the old call depth.
@@ -103,6 +118,33 @@ protected:
     virtual void updateAtInstructionEnd() = 0;
     void calculateStackChangeStart(quint8 instr);
     void calculateStackChangeEnd(quint8 instr, quint16 opspec, quint16 sp, quint16 pc, quint16 acc);
+    inline bool isAnyProfilerEnabled() const
+    {
+        return profiler != nullptr || callGraphProfiler != nullptr;
+    }
+    // Record a completed instruction with each enabled profiler.
+    // cycleCount is the running total of cycles, or 0 if cycles are not simulated.
+    inline void profileInstruction(quint16 startPC, quint8 instrSpec, quint16 endPC, quint64 cycleCount)
+    {
+        if(profiler != nullptr) profiler->recordInstruction(startPC, instrSpec, endPC);
+        if(callGraphProfiler != nullptr) callGraphProfiler->recordInstruction(startPC, instrSpec, endPC, cycleCount);
+    }
+    void clearProfilers();
+
+    // The trace and instruction state of the CPU, which is saved along with
+    // registers and memory when a CPU takes a snapshot of the machine.
+    struct TraceState
+    {
+        quint16 opValCache;
+        quint64 asmInstructionCounter;
+        bool firstLineAfterCall, isTrapped, inOperatingSystem;
+        MemoryTrace memTrace;
+        QStack<stackAction> userActions, osActions;
+        quint16 heapPtr;
+    };
+    TraceState saveTraceState() const;
+    // The memory trace is restored in place, since the UI holds on to it.
+    void restoreTraceState(const TraceState& state);
 
     const AsmProgramManager* manager;
     // Decoded operand value. The UI needs this value to render properly,
@@ -121,6 +163,8 @@ protected:
     QSharedPointer<MemoryTrace> memTrace;
     QStack<stackAction> userActions, osActions, *activeActions;
     quint16 heapPtr;
+    IsaProfiler* profiler;
+    CallGraphProfiler* callGraphProfiler;
 };
 
 #endif // AISACPU_H
@@ -30,21 +30,14 @@
 #include "typetags.h"
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
-// Regular expressions for lexical analysis
-QRegExp IsaParserHelper::rxAddrMode("^((,)(\\s*)(i|d|x|n|s(?![fx])|sx(?![f])|sf|sfx){1}){1}");
-QRegExp IsaParserHelper::rxCharConst("^((\')(?![\'])(([^\'\\\\]){1}|((\\\\)([\'|b|f|n|r|t|v|\"|\\\\]))|((\\\\)(([x|X])([0-9|A-F|a-f]{2}))))(\'))");
-QRegExp IsaParserHelper::rxComment("^((;{1})(.)*)");
-QRegExp IsaParserHelper::rxDecConst("^((([+|-]{0,1})([0-9]+))|^(([1-9])([0-9]*)))");
-QRegExp IsaParserHelper::rxDotCommand("^((.)(([A-Z|a-z]{1})(\\w)*))");
-QRegExp IsaParserHelper::rxHexConst("^((0(?![x|X]))|((0)([x|X])([0-9|A-F|a-f])+)|((0)([0-9]+)))");
-QRegExp IsaParserHelper::rxIdentifier("^((([A-Z|a-z|_]{1})(\\w*))(:){0,1})");
-QRegExp IsaParserHelper::rxStringConst("^((\")((([^\"\\\\])|((\\\\)([\'|b|f|n|r|t|v|\"|\\\\]))|((\\\\)(([x|X])([0-9|A-F|a-f]{2}))))*)(\"))");
-
-// Regular expressions for trace tag analysis
-QRegExp IsaParserHelper::rxFormatTag("(#((1c)|(1d)|(1h)|(2d)|(2h))((\\d)+a)?(\\s|$))");
-QRegExp IsaParserHelper::rxArrayTag("(#((1c)|(1d)|(1h)|(2d)|(2h))(\\d)+a)(\\s|$)?");
-QRegExp IsaParserHelper::rxSymbolTag("#[a-zA-Z][a-zA-Z0-9]{0,7}");
-QRegExp IsaParserHelper::rxArrayMultiplier("((\\d)+)a");
+// Regular expressions for trace tag analysis.
+// Like QRegExp, which they replace, \d and \s match any Unicode digit and space.
+const QRegularExpression IsaParserHelper::rxFormatTag("(#((1c)|(1d)|(1h)|(2d)|(2h))((\\d)+a)?(\\s|$))",
+                                                      QRegularExpression::UseUnicodePropertiesOption);
+const QRegularExpression IsaParserHelper::rxArrayTag("(#((1c)|(1d)|(1h)|(2d)|(2h))(\\d)+a)(\\s|$)?",
+                                                     QRegularExpression::UseUnicodePropertiesOption);
+const QRegularExpression IsaParserHelper::rxSymbolTag("#[a-zA-Z][a-zA-Z0-9]{0,7}");
+const QRegularExpression IsaParserHelper::rxArrayMultiplier("((\\d)+)a");
 
 // Formats for trace tag error messages
 const QString bytesAllocMismatch = ";WARNING: Number of bytes allocated (%1) not equal to number of bytes listed in trace tag (%2).";
@@ -585,7 +578,7 @@ void IsaAsm::relocateCode(QList<QSharedPointer<AsmCode> > &codeList, quint16 add
 }
 
 bool IsaAsm::processSourceLine(SymbolTable* symTable, BURNInfo& info, StaticTraceInfo& traceInfo,
-                               int& byteCount, QString sourceLine, int lineNum, AsmCode *&code,
+                               int& byteCount, QStringView sourceLine, int lineNum, AsmCode *&code,
                                QString &errorString, bool &dotEndDetected, bool hasBreakpoint)
 {
     IsaParserHelper::ELexicalToken token; // Passed to getToken.
@@ -1438,102 +1431,210 @@ bool IsaAsm::hasArrayType(QString formatTag)
             && formatTag.contains(IsaParserHelper::rxArrayTag);
 }
 
-bool IsaAsm::getToken(QString &sourceLine, IsaParserHelper::ELexicalToken &token, QString &tokenString)
+namespace {
+// Hand written scanners for the lexical tokens of the assembly language.
+// Each is given the unconsumed part of a trimmed source line, starting at the first
+// character of the token, and returns the length of the token found there or 0 if the
+// token is malformed. They accept exactly the strings matched by the regular expressions
+// they replace, including the stray '|' that the original character classes admitted.
+
+bool isHexClassChar(QChar ch)
+{
+    const ushort c = ch.unicode();
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f') || c == '|';
+}
+
+bool isAsciiDigit(QChar ch)
+{
+    return ch.unicode() >= '0' && ch.unicode() <= '9';
+}
+
+bool isAsciiLetter(QChar ch)
+{
+    const ushort c = ch.unicode();
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// Same set of characters as \w.
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch.isMark() || ch == '_';
+}
+
+// Characters that may follow a backslash in a two character escape sequence.
+bool isSimpleEscape(QChar ch)
+{
+    switch (ch.unicode()) {
+    case '\'': case '|': case 'b': case 'f': case 'n':
+    case 'r': case 't': case 'v': case '"': case '\\':
+        return true;
+    default:
+        return false;
+    }
+}
+
+// True if text[pos] begins a four character hexadecimal escape sequence \xHH.
+bool isHexEscapeAt(QStringView text, qsizetype pos)
+{
+    if (pos + 3 >= text.size() || text.at(pos) != '\\') return false;
+    const QChar prefix = text.at(pos + 1);
+    return (prefix == 'x' || prefix == 'X' || prefix == '|')
+            && isHexClassChar(text.at(pos + 2)) && isHexClassChar(text.at(pos + 3));
+}
+
+QChar lowerAt(QStringView text, qsizetype pos)
+{
+    return pos < text.size() ? text.at(pos).toLower() : QChar();
+}
+
+qsizetype scanAddressingMode(QStringView text)
+{
+    qsizetype pos = 1; // Skip the comma.
+    while (pos < text.size() && text.at(pos).isSpace()) pos++;
+    switch (lowerAt(text, pos).unicode()) {
+    case 'i': case 'd': case 'x': case 'n':
+        return pos + 1;
+    case 's':
+        if (lowerAt(text, pos + 1) == 'f') {
+            return lowerAt(text, pos + 2) == 'x' ? pos + 3 : pos + 2;
+        }
+        else if (lowerAt(text, pos + 1) == 'x') {
+            // sxf is neither sx nor sfx.
+            return lowerAt(text, pos + 2) == 'f' ? 0 : pos + 2;
+        }
+        return pos + 1;
+    default:
+        return 0;
+    }
+}
+
+qsizetype scanCharConstant(QStringView text)
+{
+    if (text.size() < 3 || text.at(1) == '\'') return 0;
+    if (text.at(1) != '\\') {
+        return text.at(2) == '\'' ? 3 : 0;
+    }
+    // \| is both a simple escape and a hex escape prefix, so try both.
+    if (isSimpleEscape(text.at(2)) && text.size() > 3 && text.at(3) == '\'') return 4;
+    if (isHexEscapeAt(text, 1) && text.size() > 5 && text.at(5) == '\'') return 6;
+    return 0;
+}
+
+qsizetype scanDecConstant(QStringView text)
+{
+    qsizetype pos = (text.at(0) == '+' || text.at(0) == '-') ? 1 : 0;
+    const qsizetype digitsStart = pos;
+    while (pos < text.size() && isAsciiDigit(text.at(pos))) pos++;
+    return pos == digitsStart ? 0 : pos;
+}
+
+qsizetype scanDotCommand(QStringView text)
+{
+    if (text.size() < 2 || !(isAsciiLetter(text.at(1)) || text.at(1) == '|')) return 0;
+    qsizetype pos = 2;
+    while (pos < text.size() && isWordChar(text.at(pos))) pos++;
+    return pos;
+}
+
+qsizetype scanHexConstant(QStringView text)
+{
+    qsizetype pos = 2; // Skip the 0x prefix.
+    while (pos < text.size() && isHexClassChar(text.at(pos))) pos++;
+    return pos == 2 ? 0 : pos;
+}
+
+qsizetype scanIdentifier(QStringView text)
+{
+    if (!(isAsciiLetter(text.at(0)) || text.at(0) == '_')) return 0;
+    qsizetype pos = 1;
+    while (pos < text.size() && isWordChar(text.at(pos))) pos++;
+    if (pos < text.size() && text.at(pos) == ':') pos++;
+    return pos;
+}
+
+qsizetype scanStringConstant(QStringView text)
+{
+    qsizetype pos = 1; // Skip the opening quote.
+    while (pos < text.size()) {
+        const QChar ch = text.at(pos);
+        if (ch == '"') return pos + 1;
+        else if (ch != '\\') pos++;
+        else if (pos + 1 < text.size() && isSimpleEscape(text.at(pos + 1))) pos += 2;
+        else if (isHexEscapeAt(text, pos)) pos += 4;
+        else return 0;
+    }
+    return 0;
+}
+}
+
+bool IsaAsm::getToken(QStringView &sourceLine, IsaParserHelper::ELexicalToken &token, QString &tokenString)
 {
     sourceLine = sourceLine.trimmed();
-    if (sourceLine.length() == 0) {
+    if (sourceLine.isEmpty()) {
         token = IsaParserHelper::LT_EMPTY;
-        tokenString = "";
+        tokenString.clear();
         return true;
     }
-    QChar firstChar = sourceLine[0];
-    IsaParserHelper::rxAddrMode.setCaseSensitivity (Qt::CaseInsensitive);  // Make rxAddrMode not case sensitive
+    const QChar firstChar = sourceLine.at(0);
+    qsizetype length;
+    const char *error;
     if (firstChar == ',') {
-        if (IsaParserHelper::rxAddrMode.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed addressing mode.";
-            return false;
-        }
         token = IsaParserHelper::LT_ADDRESSING_MODE;
-        tokenString = IsaParserHelper::rxAddrMode.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanAddressingMode(sourceLine);
+        error = ";ERROR: Malformed addressing mode.";
     }
-    if (firstChar == '\'') {
-        if (IsaParserHelper::rxCharConst.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed character constant.";
-            return false;
-        }
+    else if (firstChar == '\'') {
         token = IsaParserHelper::LT_CHAR_CONSTANT;
-        tokenString = IsaParserHelper::rxCharConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanCharConstant(sourceLine);
+        error = ";ERROR: Malformed character constant.";
     }
-    if (firstChar == ';') {
-        if (IsaParserHelper::rxComment.indexIn(sourceLine) == -1) {
-            // This error should not occur, as any characters are allowed in a comment.
-            tokenString = ";ERROR: Malformed comment";
-            return false;
-        }
+    else if (firstChar == ';') {
+        // Any characters are allowed in a comment, so it can not be malformed.
         token = IsaParserHelper::LT_COMMENT;
-        tokenString = IsaParserHelper::rxComment.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = sourceLine.size();
+        error = nullptr;
     }
-    if (IsaParserHelper::startsWithHexPrefix(sourceLine)) {
-        if (IsaParserHelper::rxHexConst.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed hex constant.";
-            return false;
-        }
+    else if (IsaParserHelper::startsWithHexPrefix(sourceLine)) {
         token = IsaParserHelper::LT_HEX_CONSTANT;
-        tokenString = IsaParserHelper::rxHexConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanHexConstant(sourceLine);
+        error = ";ERROR: Malformed hex constant.";
     }
-    if ((firstChar.isDigit() || firstChar == '+' || firstChar == '-')) {
-        if (IsaParserHelper::rxDecConst.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed decimal constant.";
-            return false;
-        }
+    else if (firstChar.isDigit() || firstChar == '+' || firstChar == '-') {
         token = IsaParserHelper::LT_DEC_CONSTANT;
-        tokenString = IsaParserHelper::rxDecConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanDecConstant(sourceLine);
+        error = ";ERROR: Malformed decimal constant.";
     }
-    if (firstChar == '.') {
-        if (IsaParserHelper::rxDotCommand.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed dot command.";
-            return false;
-        }
+    else if (firstChar == '.') {
         token = IsaParserHelper::LT_DOT_COMMAND;
-        tokenString = IsaParserHelper::rxDotCommand.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanDotCommand(sourceLine);
+        error = ";ERROR: Malformed dot command.";
     }
-    if (firstChar.isLetter() || firstChar == '_') {
-        if (IsaParserHelper::rxIdentifier.indexIn(sourceLine) == -1) {
-            // This error should not occur, as one-character identifiers are valid.
-            tokenString = ";ERROR: Malformed identifier.";
-            return false;
-        }
-        tokenString = IsaParserHelper::rxIdentifier.capturedTexts()[0];
-        token = tokenString.endsWith(':') ?
-                    IsaParserHelper::LT_SYMBOL_DEF :
-                    IsaParserHelper::LT_IDENTIFIER;
-        sourceLine.remove(0, tokenString.length());
-        return true;
+    else if (firstChar.isLetter() || firstChar == '_') {
+        token = IsaParserHelper::LT_IDENTIFIER;
+        length = scanIdentifier(sourceLine);
+        error = ";ERROR: Malformed identifier.";
     }
-    if (firstChar == '\"') {
-        if (IsaParserHelper::rxStringConst.indexIn(sourceLine) == -1) {
-            tokenString = ";ERROR: Malformed string constant.";
-            return false;
-        }
+    else if (firstChar == '\"') {
         token = IsaParserHelper::LT_STRING_CONSTANT;
-        tokenString = IsaParserHelper::rxStringConst.capturedTexts()[0];
-        sourceLine.remove(0, tokenString.length());
-        return true;
+        length = scanStringConstant(sourceLine);
+        error = ";ERROR: Malformed string constant.";
     }
-    tokenString = ";ERROR: Syntax error.";
-    return false;
+    else {
+        tokenString = ";ERROR: Syntax error.";
+        return false;
+    }
+    if (length == 0) {
+        tokenString = error;
+        return false;
+    }
+    // Copy the token into tokenString's existing buffer, so that lexing a line
+    // does not allocate unless the parser has held on to the previous token.
+    tokenString.setUnicode(sourceLine.data(), static_cast<int>(length));
+    sourceLine = sourceLine.mid(length);
+    if (token == IsaParserHelper::LT_IDENTIFIER && tokenString.endsWith(':')) {
+        token = IsaParserHelper::LT_SYMBOL_DEF;
+    }
+    return true;
 }
 
 Enu::ESymbolFormat IsaAsm::primitiveType(QString formatTag) {
@@ -1548,8 +1649,7 @@ Enu::ESymbolFormat IsaAsm::primitiveType(QString formatTag) {
 QPair<quint8, Enu::ESymbolFormat> IsaAsm::arrayType(QString formatTag)
 {
     auto type = primitiveType(formatTag);
-    QRegularExpression matcher(IsaParserHelper::rxArrayMultiplier.pattern());
-    auto match = matcher.match(formatTag);
+    auto match = IsaParserHelper::rxArrayMultiplier.match(formatTag);
     QString text = match.captured(0);
     text.chop(1);
     int size = text.toInt();
@@ -1564,8 +1664,7 @@ bool IsaAsm::hasSymbolTag(QString comment)
 
 QStringList IsaAsm::extractTagList(QString comment)
 {
-    QRegularExpression reg(IsaParserHelper::rxSymbolTag.pattern());
-    auto items = reg.globalMatch(comment);
+    auto items = IsaParserHelper::rxSymbolTag.globalMatch(comment);
     QStringList out;
     while(items.hasNext()) {
         QString match = items.next().captured(0);
@@ -1575,7 +1674,7 @@ QStringList IsaAsm::extractTagList(QString comment)
     return out;
 }
 
-bool IsaParserHelper::startsWithHexPrefix(QString str)
+bool IsaParserHelper::startsWithHexPrefix(QStringView str)
 {
     if (str.length() < 2) return false;
     if (str[0] != '0') return false;
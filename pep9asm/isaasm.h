@@ -22,7 +22,8 @@
 #ifndef ASM_H
 #define ASM_H
 
-#include <QRegExp>
+#include <QRegularExpression>
+#include <QStringView>
 #include "enu.h"
 
 class AsmCode; // Forward declaration for argument of processSourceLine.
@@ -54,23 +55,15 @@ namespace IsaParserHelper
         PS_FINISH, PS_INSTRUCTION, PS_START, PS_STRING, PS_SYMBOL_DEF
     };
 
-    // Regular expressions for lexical analysis
-    extern QRegExp rxAddrMode;
-    extern QRegExp rxCharConst;
-    extern QRegExp rxComment;
-    extern QRegExp rxDecConst;
-    extern QRegExp rxDotCommand;
-    extern QRegExp rxHexConst;
-    extern QRegExp rxIdentifier;
-    extern QRegExp rxStringConst;
-
-    // Regular expressions for trace tag analysis
-    extern QRegExp rxFormatTag;
-    extern QRegExp rxSymbolTag;
-    extern QRegExp rxArrayMultiplier;
-    extern QRegExp rxArrayTag;
-
-    bool startsWithHexPrefix(QString str);
+    // Regular expressions for trace tag analysis.
+    // They are const, and only matched through const member functions, so that any
+    // number of assemblers may use them at once.
+    extern const QRegularExpression rxFormatTag;
+    extern const QRegularExpression rxSymbolTag;
+    extern const QRegularExpression rxArrayMultiplier;
+    extern const QRegularExpression rxArrayTag;
+
+    bool startsWithHexPrefix(QStringView str);
     // Post: Returns true if str starts with the characters 0x or 0X. Otherwise returns false.
 
     Enu::EAddrMode stringToAddrMode(QString str);
@@ -130,6 +123,14 @@ public:
     // and will be non-empty if returned false.
     // Note: will not automatically set manger's operatingSystem.
 
+    bool getToken(QStringView &sourceLine, IsaParserHelper::ELexicalToken &token, QString &tokenString);
+    // Pre: sourceLine views one line of source code.
+    // Post: If the next token is valid, sourceLine is advanced past the characters representing the next token,
+    // those characters are copied to tokenString, true is returned, and token is set to the token type.
+    // Post: The source line itself is never copied or modified, and no state is shared between calls,
+    // so any number of assemblers may lex concurrently.
+    // Post: If false is returned, then tokenString is set to the lexical error message.
+
 private:
 
     QPair<QSharedPointer<StructType>,QString> parseStruct(const SymbolTable& symTable, QString name, QStringList symbols,
@@ -144,13 +145,7 @@ private:
     // Pre: codeList contains a valid program
     // Post: The address of every line of code in codeList is increase by addressDelta
 
-    bool getToken(QString &sourceLine, IsaParserHelper::ELexicalToken &token, QString &tokenString);
-    // Pre: sourceLine has one line of source code.
-    // Post: If the next token is valid, the string of characters representing the next token are deleted from the
-    // beginning of sourceLine and returned in tokenString, true is returned, and token is set to the token type.
-    // Post: If false is returned, then tokenString is set to the lexical error message.
-
-    bool processSourceLine(SymbolTable* symTable, BURNInfo& info, StaticTraceInfo& traceInfo, int& byteCount, QString sourceLine, int lineNum, AsmCode *&code, QString &errorString, bool &dotEndDetected, bool hasBreakpoint = false);
+    bool processSourceLine(SymbolTable* symTable, BURNInfo& info, StaticTraceInfo& traceInfo, int& byteCount, QStringView sourceLine, int lineNum, AsmCode *&code, QString &errorString, bool &dotEndDetected, bool hasBreakpoint = false);
     // Pre: sourceLine has one line of source code.
     // Pre: lineNum is the line number of the source code.
     // Post: If the source line is valid, true is returned and code is set to the source code for the line.
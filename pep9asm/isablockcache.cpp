@@ -0,0 +1,217 @@
+// File: isablockcache.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "isablockcache.h"
+
+#include "amemorydevice.h"
+#include "pep.h"
+
+// Returns true if op may transfer control somewhere other than the next instruction.
+static bool endsBlock(const Pep::DecodedOp& op)
+{
+    if(op.isTrap) return true;
+    switch(op.mnemonic) {
+    case Enu::EMnemonic::BR:
+    case Enu::EMnemonic::BRLE:
+    case Enu::EMnemonic::BRLT:
+    case Enu::EMnemonic::BREQ:
+    case Enu::EMnemonic::BRNE:
+    case Enu::EMnemonic::BRGE:
+    case Enu::EMnemonic::BRGT:
+    case Enu::EMnemonic::BRV:
+    case Enu::EMnemonic::BRC:
+    case Enu::EMnemonic::CALL:
+    case Enu::EMnemonic::RET:
+    case Enu::EMnemonic::RETTR:
+    case Enu::EMnemonic::STOP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+IsaBlockCache::IsaBlockCache(AMemoryDevice *memory) noexcept: memory(memory), watcherId(-1), blocks(), pages(),
+    coverCount(1 << 16, 0), current(), index(0)
+{
+
+}
+
+IsaBlockCache::~IsaBlockCache()
+{
+    // Memory may outlive the cache, so it must stop reporting writes to it.
+    detach();
+}
+
+void IsaBlockCache::attach()
+{
+    if(watcherId >= 0) return;
+    // Discard cached blocks whenever the instructions they were decoded from change.
+    watcherId = memory->addWriteWatcher([this](quint16 first, quint16 last){invalidate(first, last);});
+}
+
+void IsaBlockCache::detach()
+{
+    if(watcherId < 0) return;
+    clear();
+    memory->removeWriteWatcher(watcherId);
+    watcherId = -1;
+}
+
+bool IsaBlockCache::isAttached() const noexcept
+{
+    return watcherId >= 0;
+}
+
+void IsaBlockCache::invalidate(quint16 first, quint16 last)
+{
+    // Loading a program or clearing memory rewrites everything.
+    if(first == 0 && last == 0xffff) {
+        clear();
+        return;
+    }
+    // Blocks may overlap (e.g. when jumping into the middle of another block),
+    // so every block covering the range must be discarded. A block spanning two
+    // pages is listed under both, so collect the blocks before discarding any.
+    QVector<QSharedPointer<Block>> overlapping;
+    for(int page = first >> pageBits; page <= last >> pageBits; page++) {
+        for(const auto& block : pages[static_cast<size_t>(page)]) {
+            if(block->first <= last && first <= block->last && !overlapping.contains(block)) {
+                overlapping.append(block);
+            }
+        }
+    }
+    for(const auto& block : overlapping) {
+        discardBlock(block);
+    }
+}
+
+void IsaBlockCache::clear()
+{
+    current = QSharedPointer<Block>();
+    index = 0;
+    if(blocks.isEmpty()) return;
+    for(auto block : blocks) {
+        block->valid = false;
+    }
+    blocks.clear();
+    for(auto& page : pages) {
+        page.clear();
+    }
+    coverCount.fill(0);
+    if(watcherId >= 0) memory->clearWatchedRanges(watcherId);
+}
+
+int IsaBlockCache::blockCount() const noexcept
+{
+    return blocks.size();
+}
+
+QSharedPointer<const IsaBlockCache::Block> IsaBlockCache::findBlock(quint16 pc)
+{
+    // Sequential lookups through find() must not resume in the middle of this block.
+    current = QSharedPointer<Block>();
+    return lookup(pc);
+}
+
+const IsaBlockCache::Instruction *IsaBlockCache::findSlow(quint16 pc)
+{
+    current = lookup(pc);
+    if(current.isNull()) return nullptr;
+    index = 1;
+    return &current->instructions[0];
+}
+
+QSharedPointer<IsaBlockCache::Block> IsaBlockCache::lookup(quint16 pc)
+{
+    // Without a watcher, modified instructions would go unnoticed.
+    if(watcherId < 0) return QSharedPointer<Block>();
+    QSharedPointer<Block> block = blocks.value(pc);
+    if(block.isNull()) {
+        block = buildBlock(pc);
+        if(!block.isNull()) insertBlock(block);
+    }
+    return block;
+}
+
+QSharedPointer<IsaBlockCache::Block> IsaBlockCache::buildBlock(quint16 pc) const
+{
+    QSharedPointer<Block> block = QSharedPointer<Block>::create();
+    quint32 address = pc;
+    quint8 is;
+    quint16 opSpec;
+    while(block->instructions.size() < maxBlockLength) {
+        // Blocks may not wrap around the end of memory or extend into IO / unmapped addresses.
+        if(address > 0xffff || !memory->isCachable(static_cast<quint16>(address))) break;
+        memory->getByte(static_cast<quint16>(address), is);
+        const Pep::DecodedOp& op = Pep::decodeTable[is];
+        quint32 length = 1;
+        opSpec = 0;
+        if(!op.isUnary && !op.isTrap) {
+            length = 3;
+            if(address + 2 > 0xffff
+                    || !memory->isCachable(static_cast<quint16>(address + 1))
+                    || !memory->isCachable(static_cast<quint16>(address + 2))) break;
+            memory->getWord(static_cast<quint16>(address + 1), opSpec);
+        }
+        block->instructions.append({static_cast<quint16>(address), is, opSpec});
+        address += length;
+        if(endsBlock(op)) break;
+    }
+    if(block->instructions.isEmpty()) return QSharedPointer<Block>();
+    block->first = pc;
+    block->last = static_cast<quint16>(address - 1);
+    block->valid = true;
+    return block;
+}
+
+void IsaBlockCache::insertBlock(QSharedPointer<Block> block)
+{
+    blocks.insert(block->first, block);
+    for(int page = block->first >> pageBits; page <= block->last >> pageBits; page++) {
+        pages[static_cast<size_t>(page)].append(block);
+    }
+    for(quint32 address = block->first; address <= block->last; address++) {
+        coverCount[static_cast<int>(address)]++;
+    }
+    memory->watchRange(watcherId, block->first, block->last);
+}
+
+void IsaBlockCache::discardBlock(QSharedPointer<Block> block)
+{
+    block->valid = false;
+    blocks.remove(block->first);
+    for(int page = block->first >> pageBits; page <= block->last >> pageBits; page++) {
+        pages[static_cast<size_t>(page)].removeOne(block);
+    }
+    // Stop watching each run of bytes that no remaining block covers.
+    quint32 runStart = block->last + 1u;
+    for(quint32 address = block->first; address <= block->last; address++) {
+        if(--coverCount[static_cast<int>(address)] == 0) {
+            if(runStart > block->last) runStart = address;
+        }
+        else if(runStart <= block->last) {
+            memory->unwatchRange(watcherId, static_cast<quint16>(runStart), static_cast<quint16>(address - 1));
+            runStart = block->last + 1u;
+        }
+    }
+    if(runStart <= block->last) {
+        memory->unwatchRange(watcherId, static_cast<quint16>(runStart), block->last);
+    }
+}
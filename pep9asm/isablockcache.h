@@ -0,0 +1,119 @@
+// File: isablockcache.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ISABLOCKCACHE_H
+#define ISABLOCKCACHE_H
+
+#include <array>
+#include <QHash>
+#include <QSharedPointer>
+#include <QVector>
+
+class AMemoryDevice;
+
+/*
+ * Caches the decoded instructions of basic blocks, keyed by the address of the first
+ * instruction in the block. A block extends up to and including the next instruction that
+ * may transfer control (branches, CALL, RET, RETTR, traps and STOP).
+ *
+ * Only instructions residing in cachable memory (RAM / ROM) are cached. While attached, the bytes
+ * covered by each block are watched through one of the memory device's write watchers, so that any
+ * modification of a cached instruction (self-modifying code, loading a new program, editing memory
+ * from the UI) discards the affected blocks. Blocks are indexed by the pages they cover, so that a
+ * write only examines the blocks on its own page, and each block stops watching its bytes when it is
+ * discarded, unless another block still covers them.
+ *
+ * Callers may execute a whole block returned by findBlock() before checking breakpoints or
+ * their run condition, since control can only leave a block at its last instruction. Callers
+ * that must stop after any instruction use find(), which returns one instruction at a time.
+ */
+class IsaBlockCache
+{
+public:
+    struct Instruction
+    {
+        quint16 address;
+        quint8 instrSpec;
+        // Only meaningful for non-unary instructions.
+        quint16 opSpec;
+    };
+    struct Block
+    {
+        quint16 first, last;
+        // Cleared once the block is discarded. A block stays alive while a caller holds it,
+        // so callers executing a block must stop once it is no longer valid.
+        bool valid;
+        QVector<Instruction> instructions;
+    };
+
+    explicit IsaBlockCache(AMemoryDevice* memory) noexcept;
+    ~IsaBlockCache();
+
+    // Register (or remove) the write watcher that discards blocks when memory changes.
+    // Blocks are only cached while attached.
+    void attach();
+    void detach();
+    bool isAttached() const noexcept;
+
+    // Return the decoded instruction starting at pc, building a new block if needed.
+    // Returns nullptr if the instruction at pc can not be cached.
+    inline const Instruction* find(quint16 pc)
+    {
+        // Fast path: execution continues sequentially within the current block.
+        if(!current.isNull() && current->valid && index < current->instructions.size()
+                && current->instructions[index].address == pc) {
+            return &current->instructions[index++];
+        }
+        return findSlow(pc);
+    }
+    // Return the block starting at pc, building it if needed.
+    // Returns nullptr if the instruction at pc can not be cached.
+    QSharedPointer<const Block> findBlock(quint16 pc);
+    // Discard any blocks containing an address between first and last (inclusive).
+    void invalidate(quint16 first, quint16 last);
+    // Discard all blocks.
+    void clear();
+    // Number of blocks currently cached.
+    int blockCount() const noexcept;
+
+    // Longest block that will be decoded, in instructions.
+    static constexpr int maxBlockLength = 64;
+
+private:
+    // Blocks are at most 3 * maxBlockLength bytes long, so each spans at most two pages.
+    static constexpr int pageBits = 8;
+    static constexpr int pageCount = (1 << 16) >> pageBits;
+    AMemoryDevice* memory;
+    int watcherId;
+    QHash<quint16, QSharedPointer<Block>> blocks;
+    // Every valid block, listed under each page it covers.
+    std::array<QVector<QSharedPointer<Block>>, pageCount> pages;
+    // Number of valid blocks covering each address. An address is watched while its count is nonzero.
+    QVector<quint16> coverCount;
+    QSharedPointer<Block> current;
+    int index;
+    const Instruction* findSlow(quint16 pc);
+    QSharedPointer<Block> lookup(quint16 pc);
+    QSharedPointer<Block> buildBlock(quint16 pc) const;
+    void insertBlock(QSharedPointer<Block> block);
+    void discardBlock(QSharedPointer<Block> block);
+};
+
+#endif // ISABLOCKCACHE_H
@@ -19,28 +19,70 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "isacpu.h"
+#include <algorithm>
 #include <functional>
-#include <QApplication>
 
 #include "acpumodel.h"
 #include "amemorydevice.h"
 #include "asmprogrammanager.h"
 #include "asmprogram.h"
 #include "interrupthandler.h"
+#include "isablockcache.h"
 #include "isacpumemoizer.h"
+#include "mainmemory.h"
 #include "pep.h"
 
-IsaCpu::IsaCpu(const AsmProgramManager *manager, QSharedPointer<AMemoryDevice> memDevice, QObject *parent):
-    ACPUModel(memDevice, parent), InterfaceISACPU(memDevice.get(), manager), memoizer(new IsaCpuMemoizer(*this))
+IsaCpu::IsaCpu(const AsmProgramManager *manager, QSharedPointer<AMemoryDevice> memDevice, QObject *parent,
+               IsaCpuCore core):
+    ACPUModel(memDevice, parent), InterfaceISACPU(memDevice.get(), manager), memoizer(new IsaCpuMemoizer(*this)),
+    core(core), blockCache(new IsaBlockCache(memDevice.get())), blockCacheEnabled(false),
+    trapAccelerationEnabled(false), trapAccelerationActive(false),
+    acceleratedTrapCounter(0), acceleratedInstructionCounter(0), snapshot(nullptr), journal(nullptr),
+    journalStart(), acceleratedTrapStep(0),
+    acceleratedTrapSpecifier(0), handlers(), decodeTableGeneration(0)
 {
     // Create & register callbacks for breakpoint interrupts.
     std::function<void(void)> bpHandler = [this](){breakpointAsmHandler();};
     ACPUModel::handler->registerHandler(Interrupts::BREAKPOINT_ASM, bpHandler);
+    refreshDecodedState();
 }
 
 IsaCpu::~IsaCpu()
 {
+    // Memory may outlive the CPU, so it must let go of the journal.
+    setReverseStepEnabled(false);
     delete memoizer;
+    delete blockCache;
+    delete snapshot;
+}
+
+IsaCpuCore IsaCpu::getCore() const noexcept
+{
+    return core;
+}
+
+void IsaCpu::setBlockCacheEnabled(bool enabled)
+{
+    blockCacheEnabled = enabled;
+    blockCache->clear();
+    // Only watch memory while the cache is in use, so that other watchers of the
+    // same memory (such as another CPU's cache) are unaffected.
+    if(enabled) blockCache->attach();
+    else blockCache->detach();
+}
+
+bool IsaCpu::isBlockCacheEnabled() const noexcept
+{
+    return blockCacheEnabled;
+}
+
+void IsaCpu::refreshDecodedState()
+{
+    if(core == IsaCpuCore::THREADED) {
+        buildHandlerTable();
+    }
+    blockCache->clear();
+    decodeTableGeneration = Pep::decodeTableGeneration;
 }
 
 void IsaCpu::stepOver()
@@ -60,9 +102,9 @@ bool IsaCpu::canStepInto() const
 {
     quint8 byte;
     memory->getByte(getCPURegWordStart(Enu::CPURegisters::PC), byte);
-    Enu::EMnemonic mnemon = Pep::decodeMnemonic[byte];
+    const Pep::DecodedOp& op = Pep::decodeTable[byte];
     // Can only step into calls, trap instructions.
-    return (mnemon == Enu::EMnemonic::CALL) || Pep::isTrapMap[mnemon];
+    return (op.mnemonic == Enu::EMnemonic::CALL) || op.isTrap;
 }
 
 void IsaCpu::stepInto()
@@ -103,6 +145,8 @@ const QVector<quint32> IsaCpu::getInstructionHistogram()
 
 RegisterFile &IsaCpu::getRegisterBank()
 {
+    // Callers may read or overwrite the status bits directly.
+    materializeStatusBits();
     return registerBank;
 }
 
@@ -112,45 +156,30 @@ const RegisterFile &IsaCpu::getRegisterBank() const
 }
 
 void IsaCpu::onISAStep()
+{
+    if(headless) stepInstruction<false>();
+    else stepInstruction<true>();
+}
+
+template<bool emitChanges>
+void IsaCpu::stepInstruction()
 {
     asmBreakpointHit = false;
+    // Mnemonics may have been redefined since the last instruction.
+    if(decodeTableGeneration != Pep::decodeTableGeneration) refreshDecodedState();
+    // Record how this instruction modifies the machine, so that it may be undone.
+    if(journal != nullptr) beginJournalStep();
     // Store PC at the start of the cycle, so that we know where the instruction started from.
     // Also store any other values needed for detailed statistics
     memoizer->storeStateInstrStart();
     memory->onCycleStarted();
     InterfaceISACPU::calculateStackChangeStart(this->getCPURegByteStart(Enu::CPURegisters::IS));
 
-    // Load PC from register bank, allocate space for operand if it exists.
-    quint16 opSpec, pc = registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC);
-    quint16 startPC = pc;
-    quint8 is;
-
-    bool okay = memory->readByte(pc, is);
-
-    registerBank.writeRegisterByte(Enu::CPURegisters::IS, is);
-    Enu::EMnemonic mnemon = Pep::decodeMnemonic[is];
-    Enu::EAddrMode addrMode;
-
-    pc += 1;
-    registerBank.writeRegisterWord(Enu::CPURegisters::PC, pc);
-    if(Pep::isTrapMap[mnemon]) {
-        executeTrap(mnemon);
-    }
-    else if(Pep::isUnaryMap[mnemon]) {
-        executeUnary(mnemon);
-    }
-    else {
-        okay &= memory->readWord(pc, opSpec);
-        registerBank.writeRegisterWord(Enu::CPURegisters::OS, opSpec);
-        addrMode = Pep::decodeAddrMode[is];
-        pc += 2;
-        registerBank.writeRegisterWord(Enu::CPURegisters::PC, pc);
-        executeNonunary(mnemon, opSpec, addrMode);
-    }
-
-    if(!okay) {
-        controlError = true;
-        errorMessage = "Error: Failed to perform memory access.";
+    quint16 startPC = registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC);
+    executeInstruction();
+    if(isAnyProfilerEnabled()) {
+        profileInstruction(startPC, executedInstructionSpecifier(),
+                           registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC), 0);
     }
 
     // Post instruction execution cleanup
@@ -161,24 +190,29 @@ void IsaCpu::onISAStep()
                                              this->getCPURegWordCurrent(Enu::CPURegisters::A));
     memoizer->storeStateInstrEnd();
     updateAtInstructionEnd();
-    emit asmInstructionFinished();
+    if constexpr(emitChanges) emit asmInstructionFinished();
     asmInstructionCounter++;
 
     // qDebug().noquote().nospace() << memoizer->memoize();
 
+    // Observers may examine the status bits after every instruction, unless running headless.
+    if constexpr(emitChanges) materializeStatusBits();
+    if(journal != nullptr) endJournalStep();
     registerBank.flattenFile();
 
     // Modulus must be greater than 1, or there will be no gaurentee of forward progress.
     // If modulus were 1, then debug debug breakpoints that were signaled externally
     // during process events would never be cleared by branch handler.
     if(asmInstructionCounter % 500 == 0) {
-        QApplication::processEvents();
+        pollRequests(asmInstructionCounter);
     }
 
     // If execution finished on this instruction, then restore original starting program counter,
     // as the instruction at the current program counter will not be executed.
     if(executionFinished || hadErrorOnStep()) {
         registerBank.writePCStart(startPC);
+        synchronizeStatusBits();
+        if constexpr(!emitChanges) synchronizeChanges();
         emit simulationFinished();
     }
 
@@ -188,27 +222,174 @@ void IsaCpu::onISAStep()
     ACPUModel::handler->handleQueuedInterrupts();
 }
 
-void IsaCpu::updateAtInstructionEnd()
+void IsaCpu::doISAStepWhile(std::function<bool ()> condition)
 {
-    // Handle changing of call stack depth if the executed instruction affects the call stack.
-    if(Pep::decodeMnemonic[getRegisterBank().readRegisterByteCurrent(Enu::CPURegisters::IS)] == Enu::EMnemonic::CALL){
-        callDepth++;
+    // Headless mode can't change during a run, so choose the loop once rather than on every instruction.
+    if(headless) stepWhile<false>(condition);
+    else stepWhile<true>(condition);
+}
+
+template<bool emitChanges>
+void IsaCpu::stepWhile(const std::function<bool ()> &condition)
+{
+    do {
+        // Blocks are only run headless.
+        if(!emitChanges && canExecuteBlock()) executeBlock();
+        else stepInstruction<emitChanges>();
+    } while(condition());
+}
+
+quint64 IsaCpu::stepLimit() const noexcept
+{
+    return IsaBlockCache::maxBlockLength;
+}
+
+void IsaCpu::executeBlock()
+{
+    asmBreakpointHit = false;
+    // Mnemonics may have been redefined since the last block.
+    if(decodeTableGeneration != Pep::decodeTableGeneration) refreshDecodedState();
+    quint16 startPC = registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC);
+    // Hold a reference, since the block is discarded if the program modifies it.
+    QSharedPointer<const IsaBlockCache::Block> block = blockCache->findBlock(startPC);
+    if(block.isNull()) {
+        // Blocks are only run headless.
+        stepInstruction<false>();
+        return;
+    }
+
+    const quint64 pollsBefore = asmInstructionCounter / 500;
+    const int length = static_cast<int>(std::min(static_cast<quint64>(block->instructions.size()),
+                                                 std::max(stepLimit(), static_cast<quint64>(1))));
+    for(int index = 0; index < length; index++) {
+        const IsaBlockCache::Instruction& instr = block->instructions[index];
+        startPC = instr.address;
+        // The same bookkeeping as onISAStep(), minus everything canExecuteBlock() ruled out.
+        memoizer->storeStateInstrStart();
+        memory->onCycleStarted();
+        InterfaceISACPU::calculateStackChangeStart(this->getCPURegByteStart(Enu::CPURegisters::IS));
+
+        // Only the last instruction in a block may branch, so the program counter simply advances.
+        const quint8 is = instr.instrSpec;
+        const Pep::DecodedOp& op = Pep::decodeTable[is];
+        quint16 pc = static_cast<quint16>(instr.address + 1);
+        registerBank.writeRegisterByte(Enu::CPURegisters::IS, is);
+        if(!op.isTrap && !op.isUnary) {
+            registerBank.writeRegisterWord(Enu::CPURegisters::OS, instr.opSpec);
+            pc += 2;
+        }
+        registerBank.writeRegisterWord(Enu::CPURegisters::PC, pc);
+        dispatchInstruction(is, instr.opSpec);
+
+        InterfaceISACPU::calculateStackChangeEnd(this->getCPURegByteCurrent(Enu::CPURegisters::IS),
+                                                 this->getCPURegWordCurrent(Enu::CPURegisters::OS),
+                                                 this->getCPURegWordStart(Enu::CPURegisters::SP),
+                                                 this->getCPURegWordStart(Enu::CPURegisters::PC),
+                                                 this->getCPURegWordCurrent(Enu::CPURegisters::A));
+        memoizer->storeStateInstrEnd();
+        updateAtInstructionEnd();
+        asmInstructionCounter++;
+        registerBank.flattenFile();
+        // Errors end the simulation, and stores into the block discard it.
+        if(executionFinished || !block->valid) break;
+    }
+
+    // Requests are polled at least as often as by onISAStep().
+    if(asmInstructionCounter / 500 != pollsBefore) {
+        pollRequests(asmInstructionCounter);
+    }
+
+    if(executionFinished || hadErrorOnStep()) {
+        registerBank.writePCStart(startPC);
+        synchronizeStatusBits();
+        if(headless) synchronizeChanges();
+        emit simulationFinished();
+    }
+    ACPUModel::handler->handleQueuedInterrupts();
+}
+
+void IsaCpu::executeInstruction()
+{
+    // Load PC from register bank.
+    quint16 pc = registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC);
+    quint16 opSpec = 0;
+    quint8 is;
+    bool okay = true;
+
+    // Instructions in RAM / ROM have already been fetched and decoded if they are in the block cache.
+    const IsaBlockCache::Instruction* cached = blockCacheEnabled ? blockCache->find(pc) : nullptr;
+    if(cached != nullptr) {
+        is = cached->instrSpec;
+    }
+    else {
+        okay = memory->readByte(pc, is);
+    }
+
+    registerBank.writeRegisterByte(Enu::CPURegisters::IS, is);
+
+    pc += 1;
+    registerBank.writeRegisterWord(Enu::CPURegisters::PC, pc);
+
+    // Fetch the operand specifier of non-unary instructions.
+    const Pep::DecodedOp& op = Pep::decodeTable[is];
+    if(!op.isTrap && !op.isUnary) {
+        if(cached != nullptr) {
+            opSpec = cached->opSpec;
+        }
+        else {
+            okay &= memory->readWord(pc, opSpec);
+        }
+        registerBank.writeRegisterWord(Enu::CPURegisters::OS, opSpec);
+        pc += 2;
+        registerBank.writeRegisterWord(Enu::CPURegisters::PC, pc);
+    }
+
+    dispatchInstruction(is, opSpec);
+
+    if(!okay) {
+        controlError = true;
+        errorMessage = "Error: Failed to perform memory access.";
     }
-    else if(Pep::isTrapMap[Pep::decodeMnemonic[getRegisterBank().readRegisterByteCurrent(Enu::CPURegisters::IS)]]){
-        callDepth++;
+}
+
+void IsaCpu::executeDecoded(quint16 opSpec)
+{
+    const Pep::DecodedOp& op = Pep::decodeTable[registerBank.readRegisterByteCurrent(Enu::CPURegisters::IS)];
+    if(op.isTrap) {
+        executeTrap(op.mnemonic);
     }
-    else if(Pep::decodeMnemonic[getRegisterBank().readRegisterByteCurrent(Enu::CPURegisters::IS)] == Enu::EMnemonic::RET){
-        callDepth--;
+    else if(op.isUnary) {
+        executeUnary(op.mnemonic);
     }
-    else if(Pep::decodeMnemonic[getRegisterBank().readRegisterByteCurrent(Enu::CPURegisters::IS)] == Enu::EMnemonic::RETTR){
-        callDepth--;
+    else {
+        executeNonunary(op.mnemonic, opSpec, op.addrMode);
     }
+}
+
+void IsaCpu::updateAtInstructionEnd()
+{
+    // Handle changing of call stack depth if the executed instruction affects the call stack.
+    // An accelerated trap both calls and returns from its handler.
+    callDepth += Pep::decodeTable[executedInstructionSpecifier()].callDepthDelta
+            - (acceleratedTrapStep == asmInstructionCounter + 1 ? 1 : 0);
     if(hadErrorOnStep()) {
         executionFinished = true;
     }
 
 }
 
+void IsaCpu::synchronizeStatusBits()
+{
+    if(!lazyStatusBits.isPending()) return;
+    lazyStatusBits.materialize(registerBank);
+    registerBank.writeStatusBitsStart(registerBank.readStatusBitsCurrent());
+}
+
+void IsaCpu::materializeStatusBits()
+{
+    lazyStatusBits.materialize(registerBank);
+}
+
 bool IsaCpu::readOperandWordValue(quint16 operand, Enu::EAddrMode addrMode, quint16 &opVal)
 {
     bool rVal = operandWordValueHelper(operand, addrMode, &AMemoryDevice::readWord, opVal);
@@ -250,7 +431,7 @@ void IsaCpu::initCPU()
 
 bool IsaCpu::getStatusBitCurrent(Enu::EStatusBit statusBit) const
 {
-    quint8 NZVCSbits = registerBank.readStatusBitsCurrent();
+    quint8 NZVCSbits = currentStatusBits();
     switch(statusBit)
     {
     // Mask out bit of interest, then convert to bool
@@ -336,8 +517,13 @@ void IsaCpu::onSimulationStarted()
     executionFinished = false;
     asmBreakpointHit = false;
     memoizer->clear();
+    clearProfilers();
     memory->clearErrors();
     ACPUModel::handler->clearQueuedInterrupts();
+    blockCache->clear();
+    if(journal != nullptr) journal->clear();
+    // The operating system may have been replaced since the last simulation.
+    trapAccelerationActive = trapAccelerationEnabled && isStockOperatingSystem();
 }
 
 void IsaCpu::onSimulationFinished()
@@ -378,6 +564,8 @@ bool IsaCpu::onRun()
         return !hadErrorOnStep() && !executionFinished && !(inDebug && asmBreakpointHit);};
     // Always execute at least once, otherwise cannot progress past breakpoints
     doISAStepWhile(func);
+    // Execution may have been cancelled between instructions.
+    synchronizeStatusBits();
 
     // If a breakpoint was reached, or if there was an error on the control flow.
     // return before final statistics are computed or the simulation is finished.
@@ -393,6 +581,185 @@ bool IsaCpu::onRun()
     return true;
 }
 
+bool IsaCpu::takeSnapshot()
+{
+    MainMemory* mainMemory = dynamic_cast<MainMemory*>(memory.get());
+    if(mainMemory == nullptr) return false;
+    // The snapshot must not depend on the pending flag-producing operation.
+    synchronizeStatusBits();
+    mainMemory->takeSnapshot();
+    delete snapshot;
+    snapshot = new Snapshot{registerBank, saveTraceState(), callDepth,
+            acceleratedTrapCounter, acceleratedInstructionCounter};
+    return true;
+}
+
+bool IsaCpu::restoreSnapshot()
+{
+    MainMemory* mainMemory = dynamic_cast<MainMemory*>(memory.get());
+    if(snapshot == nullptr || mainMemory == nullptr || !mainMemory->restoreSnapshot()) return false;
+    // Same as onResetCPU(), except that state is taken from the snapshot rather than cleared.
+    // Restoring memory informs the block cache of every page that changed.
+    ACPUModel::handler->clearQueuedInterrupts();
+    memoizer->clear();
+    if(journal != nullptr) journal->clear();
+    restoreTraceState(snapshot->trace);
+    asmBreakpointHit = false;
+    inSimulation = false;
+    inDebug = false;
+    callDepth = snapshot->callDepth;
+    controlError = false;
+    executionFinished = false;
+    errorMessage = "";
+    registerBank = snapshot->registers;
+    lazyStatusBits.discard();
+    acceleratedTrapCounter = snapshot->acceleratedTrapCounter;
+    acceleratedInstructionCounter = snapshot->acceleratedInstructionCounter;
+    acceleratedTrapStep = 0;
+    return true;
+}
+
+bool IsaCpu::hasSnapshot() const noexcept
+{
+    return snapshot != nullptr;
+}
+
+bool IsaCpu::setReverseStepEnabled(bool enabled, int capacity)
+{
+    MainMemory* mainMemory = dynamic_cast<MainMemory*>(memory.get());
+    if(enabled && mainMemory == nullptr) return false;
+    if(mainMemory != nullptr) mainMemory->setJournal(nullptr);
+    delete journal;
+    journal = nullptr;
+    if(enabled) {
+        journal = new WriteJournal(capacity);
+        mainMemory->setJournal(journal);
+    }
+    return true;
+}
+
+bool IsaCpu::isReverseStepEnabled() const noexcept
+{
+    return journal != nullptr;
+}
+
+bool IsaCpu::canStepBack() const noexcept
+{
+    return journal != nullptr && journal->stepCount() > 0;
+}
+
+bool IsaCpu::stepBack()
+{
+    QVector<WriteJournal::Entry> entries;
+    if(journal == nullptr || !journal->popStep(entries)) return false;
+    // Clear at start, so as to preserve highlighting AFTER finshing a write.
+    memory->clearBytesWritten();
+    synchronizeStatusBits();
+    bool trapStepChanged = false, previousAccelerated = false;
+    // Entries are ordered most recent first, so a location written twice ends up with its oldest value.
+    for(const WriteJournal::Entry& entry : entries) {
+        switch(entry.target) {
+        case WriteJournal::Target::MEMORY:
+            memory->setByte(entry.address, entry.value);
+            break;
+        case WriteJournal::Target::REGISTER:
+            registerBank.writeRegisterByte(static_cast<quint8>(entry.address), entry.value);
+            break;
+        case WriteJournal::Target::STATUS_BITS:
+            registerBank.writeStatusBits(entry.value);
+            break;
+        case WriteJournal::Target::CONTROL:
+            switch(entry.value) {
+            case JournalSlot::CALL_DEPTH:
+                callDepth = static_cast<qint16>(entry.address);
+                break;
+            case JournalSlot::OPERAND_VALUE:
+                opValCache = entry.address;
+                break;
+            case JournalSlot::ACCELERATED_TRAPS:
+                acceleratedTrapCounter -= entry.address;
+                break;
+            case JournalSlot::ACCELERATED_INSTRUCTIONS:
+                acceleratedInstructionCounter -= entry.address;
+                break;
+            case JournalSlot::ACCELERATED_TRAP_STEP:
+                previousAccelerated = entry.address != 0;
+                trapStepChanged = true;
+                break;
+            }
+            break;
+        case WriteJournal::Target::INPUT:
+            // Only a MainMemory may be journaled.
+            static_cast<MainMemory*>(memory.get())->unreadInput(entry.address, entry.value);
+            break;
+        default:
+            break;
+        }
+    }
+    registerBank.flattenFile();
+    memoizer->undoStateInstrStart();
+    asmInstructionCounter--;
+    // The previous instruction, now the most recent one, was executed on step asmInstructionCounter.
+    if(trapStepChanged) acceleratedTrapStep = previousAccelerated ? asmInstructionCounter : 0;
+    // Undoing the instruction also undoes any error it caused.
+    memory->clearErrors();
+    controlError = false;
+    executionFinished = false;
+    errorMessage = "";
+    asmBreakpointHit = false;
+    if(memTrace->userStack.isStackIntact()) {
+        memTrace->userStack.setStackIntact(false);
+        memTrace->userStack.setErrorMessage("WARNING: The stack trace is not available after stepping back.");
+    }
+    return true;
+}
+
+void IsaCpu::reverseContinue()
+{
+    while(stepBack()) {
+        if(breakpointsISA.contains(registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC))) break;
+    }
+}
+
+void IsaCpu::beginJournalStep()
+{
+    journal->beginStep();
+    // Status bits must be in the register bank to be compared at the end of the instruction.
+    materializeStatusBits();
+    journalStart = {registerBank, callDepth, opValCache,
+                    acceleratedTrapCounter, acceleratedInstructionCounter, acceleratedTrapStep};
+}
+
+void IsaCpu::endJournalStep()
+{
+    materializeStatusBits();
+    registerBank.journalChanges(journalStart.registers, *journal);
+    if(callDepth != journalStart.callDepth) {
+        journal->recordControl(JournalSlot::CALL_DEPTH, static_cast<quint16>(journalStart.callDepth));
+    }
+    if(opValCache != journalStart.opValCache) {
+        journal->recordControl(JournalSlot::OPERAND_VALUE, journalStart.opValCache);
+    }
+    if(acceleratedTrapCounter != journalStart.acceleratedTrapCounter) {
+        journal->recordControl(JournalSlot::ACCELERATED_TRAPS,
+                               static_cast<quint16>(acceleratedTrapCounter - journalStart.acceleratedTrapCounter));
+    }
+    // A single trap may emulate more instructions than fit in one entry.
+    for(quint64 added = acceleratedInstructionCounter - journalStart.acceleratedInstructionCounter; added != 0;) {
+        const quint16 part = static_cast<quint16>(std::min(added, static_cast<quint64>(0xffff)));
+        journal->recordControl(JournalSlot::ACCELERATED_INSTRUCTIONS, part);
+        added -= part;
+    }
+    if(acceleratedTrapStep != journalStart.acceleratedTrapStep) {
+        // An accelerated trap leaves its step number in acceleratedTrapStep, which equals the
+        // instruction count at the start of the next instruction.
+        const bool previousAccelerated = journalStart.acceleratedTrapStep != 0
+                && journalStart.acceleratedTrapStep == asmInstructionCounter - 1;
+        journal->recordControl(JournalSlot::ACCELERATED_TRAP_STEP, previousAccelerated ? 1 : 0);
+    }
+    journal->endStep();
+}
+
 void IsaCpu::onResetCPU()
 {
     // Reset all internal state, but keep loaded micropgoram & breakpoints
@@ -408,8 +775,13 @@ void IsaCpu::onResetCPU()
     errorMessage = "";
     asmBreakpointHit = false;
     registerBank.clearRegisters();
+    lazyStatusBits.discard();
     registerBank.clearStatusBits();
-
+    blockCache->clear();
+    if(journal != nullptr) journal->clear();
+    acceleratedTrapCounter = 0;
+    acceleratedInstructionCounter = 0;
+    acceleratedTrapStep = 0;
 }
 
 bool IsaCpu::operandWordValueHelper(quint16 operand, Enu::EAddrMode addrMode,
@@ -652,6 +1024,7 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
     case Enu::EMnemonic::RETTR:
         memory->readByte(sp, tempByte);
         // Function will automatically mask out bits that don't matter
+        lazyStatusBits.discard();
         registerBank.writeStatusBits(tempByte);
         memory->readWord(sp + 1, temp);
         registerBank.writeRegisterWord(Enu::CPURegisters::A, temp);
@@ -668,81 +1041,56 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
         break;
 
     case Enu::EMnemonic::MOVFLGA:
-        registerBank.writeRegisterWord(Enu::CPURegisters::A, registerBank.readStatusBitsCurrent());
+        registerBank.writeRegisterWord(Enu::CPURegisters::A, currentStatusBits());
         break;
 
     case Enu::EMnemonic::MOVAFLG:
         // Only move the low order byte of accumulator to the status bits.
+        lazyStatusBits.discard();
         registerBank.writeStatusBits(static_cast<quint8>(acc));
         break;
 
     case Enu::EMnemonic::NOTA: // Modifies NZ bits
         acc = ~acc;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, acc);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, acc & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, acc == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, acc);
         break;
 
     case Enu::EMnemonic::NOTX: // Modifies NZ bits
         idx = ~idx;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, idx);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, idx & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, idx == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, idx);
         break;
 
     case Enu::EMnemonic::NEGA: // Modifies NZV bits
         acc = ~acc + 1;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, acc);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, acc & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, acc == 0);
-        // Only a signed overflow if register is 0x8000.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, acc == 0x8000);
+        // Set NZ, and only a signed overflow if register is 0x8000.
+        lazyStatusBits.setNegate(registerBank, acc);
         break;
 
     case Enu::EMnemonic::NEGX: // Modifies NZV bits
         idx = ~idx + 1;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, idx);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, idx & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, idx == 0);
-        // Only a signed overflow if register is 0x8000.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, idx == 0x8000);
+        // Set NZ, and only a signed overflow if register is 0x8000.
+        lazyStatusBits.setNegate(registerBank, idx);
         break;
 
     // Arithmetic shift instructions
     case Enu::EMnemonic::ASLA: // Modifies NZVC bits
         temp = static_cast<quint16>(acc << 1);
         registerBank.writeRegisterWord(Enu::CPURegisters::A, temp);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, temp & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, temp == 0);
-        // Signed overflow occurs when the starting & ending values of the high order bit differ (a xor temp == 1).
-        // Then shift the result over by 15 places to only keep high order bit (which is the sign).
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (acc ^ temp) >> 15);
-        // Carry out if register starts with high order 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, acc & 0x8000);
+        // Set NZ, signed overflow if the high order bit changed, and carry out the high order bit.
+        lazyStatusBits.setShiftLeft(acc, temp);
         break;
 
     case Enu::EMnemonic::ASLX: // Modifies NZVC bits
         temp = static_cast<quint16>(idx << 1);
         registerBank.writeRegisterWord(Enu::CPURegisters::X, temp);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, temp & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, temp == 0);
-        // Signed overflow occurs when the starting & ending values of the high order bit differ (a xor temp == 1).
-        // Then shift the result over by 15 places to only keep high order bit (which is the sign).
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (idx ^ temp) >> 15);
-        // Carry out if register starts with high order 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, idx & 0x8000);
+        // Set NZ, signed overflow if the high order bit changed, and carry out the high order bit.
+        lazyStatusBits.setShiftLeft(idx, temp);
 
         break;
 
@@ -753,12 +1101,8 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
                                     // If the high order bit is 1, then sign extend with 1, else 0.
                                     ((acc & 0x8000) ? 1<<15 : 0));
         registerBank.writeRegisterWord(Enu::CPURegisters::A, temp);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, temp & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, temp == 0);
-        // Carry out if register starts with low order 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, acc & 0x01);
+        // Set NZ, and carry out if register starts with low order 1.
+        lazyStatusBits.setShiftRight(registerBank, acc, temp);
         break;
 
     case Enu::EMnemonic::ASRX: // Modifies NZC bits
@@ -768,16 +1112,13 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
                                     // If the high order bit is 1, then sign extend with 1, else 0.
                                     ((idx & 0x8000) ? 1<<15 : 0));
         registerBank.writeRegisterWord(Enu::CPURegisters::X, temp);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, temp & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, temp == 0);
-        // Carry out if register starts with low order 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, idx & 0x01);
+        // Set NZ, and carry out if register starts with low order 1.
+        lazyStatusBits.setShiftRight(registerBank, idx, temp);
         break;
 
     // Rotate instructions.
     case Enu::EMnemonic::RORA: // Modifies C bits
+        materializeStatusBits();
         temp = static_cast<quint16>(acc >> 1
                                     // Shift the carry to high order bit.
                                     | (registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_C)
@@ -788,6 +1129,7 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
         break;
 
     case Enu::EMnemonic::RORX: // Modifies C bit
+        materializeStatusBits();
         temp = static_cast<quint16>(idx >> 1
                                     // Shift the carry to high order bit.
                                     | (registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_C)
@@ -798,6 +1140,7 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
         break;
 
     case Enu::EMnemonic::ROLA: // Modifies C bit
+        materializeStatusBits();
         temp = static_cast<quint16>(acc << 1
                                     // Shift the carry in to low order bit.
                                     | (registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_C)
@@ -808,6 +1151,7 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
         break;
 
     case Enu::EMnemonic::ROLX: // Modifies C bit
+        materializeStatusBits();
         temp = static_cast<quint16>(acc << 1
                                     // Shift the carry in to low order bit.
                                     | (registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_C)
@@ -817,7 +1161,7 @@ void IsaCpu::executeUnary(Enu::EMnemonic mnemon)
         break;
 
     case Enu::EMnemonic::NOP0:
-        if(Pep::isTrapMap[Enu::EMnemonic::NOP0]) {
+        if(Pep::isTrapMap.value(Enu::EMnemonic::NOP0)) {
             controlError = true;
             executionFinished = true;
             errorMessage = "Error: NOP0 is not a unary instruction.";
@@ -851,58 +1195,56 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         break;
 
     case Enu::EMnemonic::BRLE:
-        if(registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N) ||
-                registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_Z)) {
+        if(currentStatusBits() & (Enu::NMask | Enu::ZMask)) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRLT:
-        if(registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N)) {
+        if(currentStatusBits() & Enu::NMask) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BREQ:
-        if(registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_Z)) {
+        if(currentStatusBits() & Enu::ZMask) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRNE:
-        if(!registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_Z)) {
+        if(!(currentStatusBits() & Enu::ZMask)) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRGE:
-        if(!registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N)) {
+        if(!(currentStatusBits() & Enu::NMask)) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRGT:
-        if(!registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N) &&
-                !registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_Z)) {
+        if(!(currentStatusBits() & (Enu::NMask | Enu::ZMask))) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRV:
-        if(registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_V)) {
+        if(currentStatusBits() & Enu::VMask) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
         break;
 
     case Enu::EMnemonic::BRC:
-        if(registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_C)) {
+        if(currentStatusBits() & Enu::CMask) {
             memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
             registerBank.writeRegisterWord(Enu::CPURegisters::PC, tempWord);
         }
@@ -932,16 +1274,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier plus the accumulator
         result = a + tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(a ^ tempWord) & (a ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < a  || result < tempWord);
+        // Set NZ, signed overflow, and carry out of the addition.
+        lazyStatusBits.setAdd(a, tempWord, result);
         break;
 
     case Enu::EMnemonic::ADDX:
@@ -949,16 +1283,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier plus the index reg.
         result = x + tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(x ^ tempWord) & (x ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < x  || result < tempWord);
+        // Set NZ, signed overflow, and carry out of the addition.
+        lazyStatusBits.setAdd(x, tempWord, result);
         break;
 
     case Enu::EMnemonic::SUBA:
@@ -968,16 +1294,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier plus the accumulator.
         result = a + tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(a ^ tempWord) & (a ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < a  || result < tempWord);
+        // Set NZ, signed overflow, and carry out of the addition.
+        lazyStatusBits.setAdd(a, tempWord, result);
         break;
 
     case Enu::EMnemonic::SUBX:
@@ -987,16 +1305,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier plus the index reg.
         result = x + tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(x ^ tempWord) & (x ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < x  || result < tempWord);
+        // Set NZ, signed overflow, and carry out of the addition.
+        lazyStatusBits.setAdd(x, tempWord, result);
         break;
 
     case Enu::EMnemonic::ANDA:
@@ -1004,10 +1314,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier bitwise and'ed with the accumulator.
         result = a & tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, result);
         break;
 
     case Enu::EMnemonic::ANDX:
@@ -1015,10 +1323,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier bitwise and'ed the index reg.
         result = x & tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, result);
         break;
 
     case Enu::EMnemonic::ORA:
@@ -1026,20 +1332,16 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the decoded operand specifier bitwise or'ed with the accumulator.
         result = a | tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, result);
         break;
     case Enu::EMnemonic::ORX:
         memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
         // The result is the decoded operand specifier bitwise or'ed the index reg.
         result = x | tempWord;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, result);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, result);
         break;
 
     case Enu::EMnemonic::CPWA:
@@ -1047,19 +1349,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the two's complement of the decoded operand specifier plus a.
         tempWord = ~tempWord + 1;
         result = a + tempWord;
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(a ^  tempWord) & (a ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < a  || result < tempWord);
-        // If there was a signed overflow, selectively invert N bit.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N)
-                                    ^ registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_V));
+        // Set NZVC as for an addition, but invert N if there was a signed overflow.
+        lazyStatusBits.setCompareWord(a, tempWord, result, a);
         break;
 
     case Enu::EMnemonic::CPWX:
@@ -1067,37 +1358,23 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // The result is the two's complement of the decoded operand specifier plus x.
         tempWord = ~tempWord + 1;
         result = x + tempWord;
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // There is a signed overflow iff the high order bits of the register and operand
-        //are the same, and one input & the output differ in sign.
-        // >> Shifts in 0's (unsigned shorts), so after shift, only high order bit remain.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, (~(x ^ tempWord) & (x ^ result)) >> 15);
-        // Carry out iff result is unsigned less than register or operand.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, result < a  || result < tempWord);
-        // If there was a signed overflow, selectively invert N bit.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_N)
-                                    ^ registerBank.readStatusBitCurrent(Enu::EStatusBit::STATUS_V));
+        // Set NZVC as for an addition, but invert N if there was a signed overflow.
+        // The carry is computed against the accumulator, as it always has been.
+        lazyStatusBits.setCompareWord(x, tempWord, result, a);
         break;
 
     case Enu::EMnemonic::LDWA:
         memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
         registerBank.writeRegisterWord(Enu::CPURegisters::A, tempWord);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, tempWord & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, tempWord == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, tempWord);
         break;
 
     case Enu::EMnemonic::LDWX:
         memSuccess = readOperandWordValue(opSpec, addrMode, tempWord);
         registerBank.writeRegisterWord(Enu::CPURegisters::X, tempWord);
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, tempWord & 0x8000);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, tempWord == 0);
+        // Is negative if high order bit is 1, is zero if all bits are 0's.
+        lazyStatusBits.setNZ(registerBank, tempWord);
         break;
 
     case Enu::EMnemonic::STWA:
@@ -1117,13 +1394,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // Narrow a and operand to 1 byte before widening to 2 bytes for result.
         tempWord = ~tempByte + 1;
         result = (a + tempWord) & 0xff;
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x80);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // RTL specifies zeroing out V, C bits.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, false);
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, false);
+        // Set NZ from the low order byte. RTL specifies zeroing out V, C bits.
+        lazyStatusBits.setCompareByte(static_cast<quint8>(result));
         break;
 
     case Enu::EMnemonic::CPBX:
@@ -1132,13 +1404,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         // Narrow a and operand to 1 byte before widening to 2 bytes for result.
         tempWord = ~tempByte + 1;
         result = (x + tempWord) & 0xff;
-        // Is negative if high order bit is 1.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, result & 0x80);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, result == 0);
-        // RTL specifies zeroing out V, C bits.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, false);
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, false);
+        // Set NZ from the low order byte. RTL specifies zeroing out V, C bits.
+        lazyStatusBits.setCompareByte(static_cast<quint8>(result));
         break;
 
     case Enu::EMnemonic::LDBA:
@@ -1146,9 +1413,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         tempWord = a & 0xff00;
         tempWord |= tempByte;
         registerBank.writeRegisterWord(Enu::CPURegisters::A, tempWord);
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, false);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, (tempWord & 0xff) == 0);
+        // Never negative, and is zero if all bits of the low order byte are 0's.
+        lazyStatusBits.setNZ(registerBank, tempWord & 0xff);
 
         break;
 
@@ -1157,9 +1423,8 @@ void IsaCpu::executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMo
         tempWord = x & 0xff00;
         tempWord |= tempByte;
         registerBank.writeRegisterWord(Enu::CPURegisters::X, tempWord);
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, false);
-         // Is zero if all bits are 0's.
-        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, (tempWord & 0xff) == 0);
+        // Never negative, and is zero if all bits of the low order byte are 0's.
+        lazyStatusBits.setNZ(registerBank, tempWord & 0xff);
         break;
 
     case Enu::EMnemonic::STBA:
@@ -1223,7 +1488,8 @@ void IsaCpu::executeTrap(Enu::EMnemonic mnemon)
         memSuccess &= memory->writeWord(tempAddr - 7, registerBank.readRegisterWordCurrent(Enu::CPURegisters::X) /*X*/);
         // Writes to mem[T-8], mem[T-9].
         memSuccess &= memory->writeWord(tempAddr - 9, registerBank.readRegisterWordCurrent(Enu::CPURegisters::A) /*A*/);
-        // Writes to mem[T-10].
+        // Writes to mem[T-10]. The operating system may modify the status bits directly.
+        materializeStatusBits();
         memSuccess &= memory->writeByte(tempAddr - 10, registerBank.readStatusBitsCurrent() /*NZVC*/);
         memSuccess &= memory->readWord(pcAddr, pc);
         registerBank.writeRegisterWord(Enu::CPURegisters::SP, tempAddr - 10);
@@ -1246,12 +1512,17 @@ void IsaCpu::executeTrap(Enu::EMnemonic mnemon)
         controlError = true;
         errorMessage = "Error: Failed to perform memory access.";
     }
+    else if(trapAccelerationActive) {
+        executeAcceleratedTrap(mnemon);
+    }
 }
 
 void IsaCpu::breakpointAsmHandler()
 {
     // Callback function
     asmBreakpointHit = true;
+    synchronizeStatusBits();
+    if(headless) synchronizeChanges();
     emit hitBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
     return;
 }
@@ -21,8 +21,11 @@
 #ifndef ISACPU_H
 #define ISACPU_H
 #include "interfaceisacpu.h"
+#include <array>
 #include <QElapsedTimer>
+#include "lazystatusbits.h"
 #include "registerfile.h"
+#include "writejournal.h"
 
 /* Though not part of the specification, the trap mechanism  must
  * set the index register to 0 to prevent a bug in OS where
@@ -36,14 +39,69 @@
  * to function correctly. This flag enables or disables this behvaior
  */
 #define hardwarePCIncr true
+
+// Selects how IsaCpu executes individual instructions.
+// Both cores produce identical register and memory state.
+enum class IsaCpuCore
+{
+    // Decode the mnemonic and addressing mode, and dispatch through switch statements.
+    SWITCH,
+    // Dispatch through a table of handlers specialized for each instruction specifier.
+    THREADED
+};
+
 class CPUDataSection;
+class IsaBlockCache;
 class IsaCpuMemoizer;
 class IsaCpu: public ACPUModel, public InterfaceISACPU
 {
     friend class IsaCpuMemoizer;
 public:
-    explicit IsaCpu(const AsmProgramManager* manager, QSharedPointer<AMemoryDevice>, QObject* parent = nullptr);
+    explicit IsaCpu(const AsmProgramManager* manager, QSharedPointer<AMemoryDevice>, QObject* parent = nullptr,
+                    IsaCpuCore core = IsaCpuCore::SWITCH);
     virtual ~IsaCpu() override;
+    IsaCpuCore getCore() const noexcept;
+    // When enabled, decoded basic blocks are cached so that instructions in RAM / ROM
+    // need not be re-fetched and re-decoded every time they are executed.
+    void setBlockCacheEnabled(bool enabled);
+    bool isBlockCacheEnabled() const noexcept;
+    // When enabled, and the installed operating system is the stock Pep/9 operating system,
+    // DECI, DECO, HEXO, and STRO are executed in C++ rather than through the OS trap handlers.
+    // Memory, registers, status bits, and charIn / charOut traffic are the same either way.
+    void setTrapAccelerationEnabled(bool enabled);
+    bool isTrapAccelerationEnabled() const noexcept;
+    // Is trap acceleration enabled and applicable to the installed operating system?
+    bool isTrapAccelerationActive() const noexcept;
+    // Returns how many traps were executed in C++.
+    quint64 getAcceleratedTrapCount() const noexcept;
+    // Returns how many instructions would have been executed without trap acceleration.
+    // Equal to getInstructionCount() when no traps were accelerated.
+    quint64 getEmulatedInstructionCount() const noexcept;
+    // Record the registers, memory, and trace state of the machine, so that restoreSnapshot()
+    // can return to them without reloading any programs. Replaces any previous snapshot.
+    // Memory is copied lazily, one page at a time as it is modified, so that taking a snapshot
+    // is cheap. Returns false if the memory device is not a MainMemory.
+    bool takeSnapshot();
+    // Reset the CPU, and return the machine to the state recorded by takeSnapshot(). Only memory
+    // modified since the snapshot was taken or last restored is copied back, and the snapshot may
+    // be restored any number of times. Returns false if there is no snapshot.
+    bool restoreSnapshot();
+    bool hasSnapshot() const noexcept;
+    // When enabled, the old values of the registers and memory modified by each instruction
+    // are kept in a journal of at most capacity entries, so that instructions may be undone by
+    // stepBack() without re-executing the program. The oldest instructions are forgotten
+    // once the journal fills. Returns false if the memory device is not a MainMemory.
+    bool setReverseStepEnabled(bool enabled, int capacity = WriteJournal::defaultCapacity);
+    bool isReverseStepEnabled() const noexcept;
+    // Is there an instruction in the journal that can be undone?
+    bool canStepBack() const noexcept;
+    // Undo the most recently executed instruction. Input it consumed is returned to the input buffer,
+    // but output can't be taken back, and the stack trace is abandoned, since trace tags can only be
+    // followed forwards.
+    // Returns false if there was no instruction to undo.
+    bool stepBack();
+    // Undo instructions until the program counter reaches a breakpoint, or the journal is exhausted.
+    void reverseContinue();
     // InterfaceISACPU interface
 public:
     void stepOver() override;
@@ -54,14 +112,29 @@ public:
     quint64 getInstructionCount() override;
     const QVector<quint32> getInstructionHistogram() override;
 
+    // Writes any lazily computed status bits to the register bank before returning it.
     RegisterFile& getRegisterBank();
+    // Status bits may be stale while the simulation runs headless, use getStatusBitCurrent() instead.
     const RegisterFile& getRegisterBank() const;
+    // Fetch, decode, and execute the instruction at the program counter, without any of
+    // the statistics, trace, or breakpoint bookkeeping performed by onISAStep().
+    // Allows other CPUs to use this CPU as a fast path over their own architectural state.
+    void executeInstruction();
 
 protected:
     void onISAStep() override;
+    // Runs whole cached blocks between evaluations of condition when nothing observes individual
+    // instructions (see canExecuteBlock()), and single steps through onISAStep() otherwise.
+    void doISAStepWhile(std::function<bool(void)> condition) override;
+    // The most instructions doISAStepWhile() may execute before evaluating its condition again.
+    // Subclasses whose condition counts instructions must not let a block overshoot the count.
+    virtual quint64 stepLimit() const noexcept;
     void updateAtInstructionEnd() override;
     bool readOperandWordValue(quint16 operand, Enu::EAddrMode addrMode, quint16& opVal);
     bool readOperandByteValue(quint16 operand, Enu::EAddrMode addrMode, quint8& opVal);
+    // Write any lazily computed status bits to both the start and current status bits.
+    // Must only be called between instructions, when the start and current status bits agree.
+    void synchronizeStatusBits();
 
 
     // ACPUModel interface
@@ -89,8 +162,103 @@ public slots:
 
 private:
     RegisterFile registerBank;
+    // The NZVC bits set by the last flag-producing instruction, which have not been written
+    // to registerBank yet. Written back when an instruction reads them in a way that can't
+    // be answered from the pending operation, or when an observer may examine registerBank.
+    LazyStatusBits lazyStatusBits;
+    // Return the current status bits, including any pending in lazyStatusBits.
+    inline quint8 currentStatusBits() const
+    {
+        return lazyStatusBits.resolve(registerBank.readStatusBitsCurrent());
+    }
+    void materializeStatusBits();
     QElapsedTimer timer;
     IsaCpuMemoizer* memoizer;
+    IsaCpuCore core;
+    IsaBlockCache* blockCache;
+    bool blockCacheEnabled;
+    bool trapAccelerationEnabled, trapAccelerationActive;
+    quint64 acceleratedTrapCounter, acceleratedInstructionCounter;
+    // State recorded by takeSnapshot(), or nullptr if there is none.
+    // Memory keeps its own (copy-on-write) snapshot.
+    struct Snapshot
+    {
+        RegisterFile registers;
+        TraceState trace;
+        int callDepth;
+        quint64 acceleratedTrapCounter, acceleratedInstructionCounter;
+    };
+    Snapshot* snapshot;
+    // Journal of the writes made by each instruction, or nullptr if reverse stepping is disabled.
+    WriteJournal* journal;
+    // Pieces of state, other than registers and memory, that must be restored when undoing an instruction.
+    // The accelerated trap counters are 64 bits wide, so the amount each instruction added is
+    // recorded instead of their old values. ACCELERATED_TRAP_STEP records whether the
+    // previous instruction was an accelerated trap.
+    enum JournalSlot: quint8
+    {
+        CALL_DEPTH, OPERAND_VALUE, ACCELERATED_TRAPS, ACCELERATED_INSTRUCTIONS, ACCELERATED_TRAP_STEP
+    };
+    // The state of the machine at the start of the instruction being journaled.
+    struct JournalStart
+    {
+        RegisterFile registers;
+        int callDepth;
+        quint16 opValCache;
+        quint64 acceleratedTrapCounter, acceleratedInstructionCounter, acceleratedTrapStep;
+    } journalStart;
+    void beginJournalStep();
+    void endJournalStep();
+    // An accelerated trap leaves RETTR in the IS register, as the handler would have.
+    // Remember the trap's own specifier, and the instruction (counting from 1) it was executed on.
+    quint64 acceleratedTrapStep;
+    quint8 acceleratedTrapSpecifier;
+    // Returns the specifier of the instruction most recently executed by onISAStep(),
+    // which differs from the IS register after an accelerated trap.
+    inline quint8 executedInstructionSpecifier() const
+    {
+        if(acceleratedTrapStep == asmInstructionCounter + 1) return acceleratedTrapSpecifier;
+        return registerBank.readRegisterByteCurrent(Enu::CPURegisters::IS);
+    }
+    // Execute the instruction whose specifier is in the IS register, once it and its
+    // operand specifier (if any) have been fetched.
+    using InstrHandler = void (IsaCpu::*)(quint16 opSpec);
+    // One handler per instruction specifier, used by the threaded core.
+    std::array<InstrHandler, 256> handlers;
+    void buildHandlerTable();
+    // Value of Pep::decodeTableGeneration when the handlers and cached blocks were derived.
+    quint32 decodeTableGeneration;
+    // Rederive the handlers and discard cached blocks, since redefining a
+    // mnemonic may change which instructions are unary or traps.
+    void refreshDecodedState();
+    void executeDecoded(quint16 opSpec);
+    // Dispatch the fetched instruction to the selected core.
+    inline void dispatchInstruction(quint8 is, quint16 opSpec)
+    {
+        if(core == IsaCpuCore::THREADED) (this->*handlers[is])(opSpec);
+        else executeDecoded(opSpec);
+    }
+    // Blocks may only be run as a unit when no breakpoint, journal, profiler, or
+    // observer of individual instructions needs the machine after every instruction.
+    inline bool canExecuteBlock() const
+    {
+        return blockCacheEnabled && headless && !inDebug && journal == nullptr && !isAnyProfilerEnabled();
+    }
+    // Execute the cached block at the program counter, checking for requests, breakpoints, and
+    // the end of the simulation once the block is finished, rather than after every instruction.
+    void executeBlock();
+    // The body of onISAStep() and doISAStepWhile(). Observers are only notified of each instruction
+    // if emitChanges, so that headless runs compile the notifications out of the loop entirely.
+    template<bool emitChanges> void stepInstruction();
+    template<bool emitChanges> void stepWhile(const std::function<bool(void)>& condition);
+    template<Enu::EMnemonic mnemon> static InstrHandler nonunaryHandlerFor(Enu::EAddrMode addrMode);
+    template<Enu::EMnemonic mnemon> void executeUnaryHandler(quint16 opSpec);
+    template<Enu::EMnemonic mnemon> void executeTrapHandler(quint16 opSpec);
+    template<Enu::EMnemonic mnemon, Enu::EAddrMode addrMode> void executeNonunaryHandler(quint16 opSpec);
+    template<Enu::EAddrMode addrMode> bool readOperandWord(quint16 operand, quint16& opVal);
+    template<Enu::EAddrMode addrMode> bool readOperandByte(quint16 operand, quint8& opVal);
+    template<Enu::EAddrMode addrMode> bool computeStoreAddress(quint16 operand, quint16& address);
+
     bool operandWordValueHelper(quint16 operand, Enu::EAddrMode addrMode,
                            bool (AMemoryDevice::*readFunc)(quint16, quint16&) const, quint16& opVal);
     bool operandByteValueHelper(quint16 operand, Enu::EAddrMode addrMode,
@@ -100,6 +268,18 @@ private:
     void executeUnary(Enu::EMnemonic mnemon);
     void executeNonunary(Enu::EMnemonic mnemon, quint16 opSpec, Enu::EAddrMode addrMode);
     void executeTrap(Enu::EMnemonic mnemon);
+    // Trap acceleration, which is implemented in isacputraps.cpp.
+    bool isStockOperatingSystem() const;
+    // Perform the OS part of a trap whose hardware part has been performed.
+    // Returns false if the trap must be left to the operating system.
+    bool executeAcceleratedTrap(Enu::EMnemonic mnemon);
+    // Each returns false if the trap handler halts rather than returning from the trap.
+    bool acceleratedDECI(quint16 frame, quint16 operandAddr, quint64& emulated, bool& okay);
+    void acceleratedDECO(quint16 frame, quint16 operandAddr, quint64& emulated, bool& okay);
+    void acceleratedHEXO(quint16 frame, quint16 operandAddr, quint64& emulated, bool& okay);
+    void acceleratedSTRO(quint16 frame, quint16 operandAddr, quint64& emulated, bool& okay);
+    // Output the null terminated string at address as prntMsg would, and return its length.
+    quint16 acceleratedPrintMessage(quint16 address, quint64& emulated, bool& okay);
     // Callback function to handle InteruptHandler's BREAKPOINT_ASM.
     void breakpointAsmHandler();
 };
@@ -60,6 +60,14 @@ void IsaCpuMemoizer::storeStateInstrStart()
     cpu.registerBank.setIRCache(instr);
 }
 
+void IsaCpuMemoizer::undoStateInstrStart()
+{
+    quint8 instr;
+    // The journal restored the instruction specifier along with the rest of memory.
+    cpu.getMemoryDevice()->getByte(cpu.registerBank.readRegisterWordStart(Enu::CPURegisters::PC), instr);
+    state.instructionsCalled[instr]--;
+}
+
 QString IsaCpuMemoizer::memoize()
 {
     const RegisterFile& file = cpu.registerBank;
@@ -75,7 +83,7 @@ QString IsaCpuMemoizer::memoize()
             .arg(formatNum(file.readRegisterWordCurrent(Enu::CPURegisters::A)),
                  formatNum(file.readRegisterWordCurrent(Enu::CPURegisters::X)),
                  formatNum(file.readRegisterWordCurrent(Enu::CPURegisters::SP)));
-    NZVC = QString(" SNZVC=") % QString("%1").arg(QString::number(file.readStatusBitsCurrent(), 2), 5, '0');
+    NZVC = QString(" SNZVC=") % QString("%1").arg(QString::number(cpu.currentStatusBits(), 2), 5, '0');
     build = (attemptAddrReplace(symTable, file.readRegisterWordStart(Enu::CPURegisters::PC)) + QString(":")).leftJustified(10) %
             formatInstr(symTable, file.getIRCache(), file.readRegisterWordCurrent(Enu::CPURegisters::OS));
     build += "  " + AX;
@@ -83,16 +91,17 @@ QString IsaCpuMemoizer::memoize()
     build += "  " + AX;
     build += NZVC;
     ir = file.getIRCache();
-    if(Pep::isTrapMap[Pep::decodeMnemonic[ir]]) {
+    const Pep::DecodedOp& op = Pep::decodeTable[ir];
+    if(op.isTrap) {
         build += generateTrapFrame(state);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::RETTR) {
+    else if(op.mnemonic == Enu::EMnemonic::RETTR) {
         build += generateTrapFrame(state,false);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::CALL) {
+    else if(op.mnemonic == Enu::EMnemonic::CALL) {
         build += generateStackFrame(state);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::RET) {
+    else if(op.mnemonic == Enu::EMnemonic::RET) {
         build += generateStackFrame(state,false);
     }
     return build;
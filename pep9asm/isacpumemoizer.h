@@ -33,6 +33,9 @@ public:
     void clear();
     void storeStateInstrEnd();
     void storeStateInstrStart();
+    // Undo storeStateInstrStart() for an instruction that has been stepped back over.
+    // Memory and registers must already be restored to their values at the start of the instruction.
+    void undoStateInstrStart();
     QString memoize();
     QString finalStatistics();
     quint64 getCycleCount();
@@ -0,0 +1,477 @@
+// File: isacputhreaded.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "isacpu.h"
+
+#include "amemorydevice.h"
+#include "pep.h"
+
+/*
+ * Threaded execution core for IsaCpu.
+ *
+ * Every instruction specifier is bound to a handler that has been specialized at
+ * compile time for its mnemonic and addressing mode, so executing an instruction
+ * is a single indirect call with no decoding. The handlers mirror executeUnary(),
+ * executeNonunary(), and the operand helpers exactly (including their quirks),
+ * so that both cores produce identical register and memory state.
+ */
+
+using namespace Enu;
+
+void IsaCpu::buildHandlerTable()
+{
+    for(int it = 0; it < 256; it++) {
+        const Pep::DecodedOp& op = Pep::decodeTable[static_cast<size_t>(it)];
+        InstrHandler handler = nullptr;
+        if(op.isTrap) {
+            switch(op.mnemonic) {
+            case EMnemonic::NOP0: handler = &IsaCpu::executeTrapHandler<EMnemonic::NOP0>; break;
+            case EMnemonic::NOP1: handler = &IsaCpu::executeTrapHandler<EMnemonic::NOP1>; break;
+            case EMnemonic::NOP: handler = &IsaCpu::executeTrapHandler<EMnemonic::NOP>; break;
+            case EMnemonic::DECI: handler = &IsaCpu::executeTrapHandler<EMnemonic::DECI>; break;
+            case EMnemonic::DECO: handler = &IsaCpu::executeTrapHandler<EMnemonic::DECO>; break;
+            case EMnemonic::HEXO: handler = &IsaCpu::executeTrapHandler<EMnemonic::HEXO>; break;
+            case EMnemonic::STRO: handler = &IsaCpu::executeTrapHandler<EMnemonic::STRO>; break;
+            default: break;
+            }
+        }
+        else if(op.isUnary) {
+            switch(op.mnemonic) {
+            case EMnemonic::STOP: handler = &IsaCpu::executeUnaryHandler<EMnemonic::STOP>; break;
+            case EMnemonic::RET: handler = &IsaCpu::executeUnaryHandler<EMnemonic::RET>; break;
+            case EMnemonic::RETTR: handler = &IsaCpu::executeUnaryHandler<EMnemonic::RETTR>; break;
+            case EMnemonic::MOVSPA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::MOVSPA>; break;
+            case EMnemonic::MOVFLGA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::MOVFLGA>; break;
+            case EMnemonic::MOVAFLG: handler = &IsaCpu::executeUnaryHandler<EMnemonic::MOVAFLG>; break;
+            case EMnemonic::NOTA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::NOTA>; break;
+            case EMnemonic::NOTX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::NOTX>; break;
+            case EMnemonic::NEGA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::NEGA>; break;
+            case EMnemonic::NEGX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::NEGX>; break;
+            case EMnemonic::ASLA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ASLA>; break;
+            case EMnemonic::ASLX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ASLX>; break;
+            case EMnemonic::ASRA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ASRA>; break;
+            case EMnemonic::ASRX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ASRX>; break;
+            case EMnemonic::ROLA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ROLA>; break;
+            case EMnemonic::ROLX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::ROLX>; break;
+            case EMnemonic::RORA: handler = &IsaCpu::executeUnaryHandler<EMnemonic::RORA>; break;
+            case EMnemonic::RORX: handler = &IsaCpu::executeUnaryHandler<EMnemonic::RORX>; break;
+            default: break;
+            }
+        }
+        else {
+            switch(op.mnemonic) {
+            case EMnemonic::BR: handler = nonunaryHandlerFor<EMnemonic::BR>(op.addrMode); break;
+            case EMnemonic::BRLE: handler = nonunaryHandlerFor<EMnemonic::BRLE>(op.addrMode); break;
+            case EMnemonic::BRLT: handler = nonunaryHandlerFor<EMnemonic::BRLT>(op.addrMode); break;
+            case EMnemonic::BREQ: handler = nonunaryHandlerFor<EMnemonic::BREQ>(op.addrMode); break;
+            case EMnemonic::BRNE: handler = nonunaryHandlerFor<EMnemonic::BRNE>(op.addrMode); break;
+            case EMnemonic::BRGE: handler = nonunaryHandlerFor<EMnemonic::BRGE>(op.addrMode); break;
+            case EMnemonic::BRGT: handler = nonunaryHandlerFor<EMnemonic::BRGT>(op.addrMode); break;
+            case EMnemonic::BRV: handler = nonunaryHandlerFor<EMnemonic::BRV>(op.addrMode); break;
+            case EMnemonic::BRC: handler = nonunaryHandlerFor<EMnemonic::BRC>(op.addrMode); break;
+            case EMnemonic::CALL: handler = nonunaryHandlerFor<EMnemonic::CALL>(op.addrMode); break;
+            case EMnemonic::ADDSP: handler = nonunaryHandlerFor<EMnemonic::ADDSP>(op.addrMode); break;
+            case EMnemonic::SUBSP: handler = nonunaryHandlerFor<EMnemonic::SUBSP>(op.addrMode); break;
+            case EMnemonic::ADDA: handler = nonunaryHandlerFor<EMnemonic::ADDA>(op.addrMode); break;
+            case EMnemonic::ADDX: handler = nonunaryHandlerFor<EMnemonic::ADDX>(op.addrMode); break;
+            case EMnemonic::SUBA: handler = nonunaryHandlerFor<EMnemonic::SUBA>(op.addrMode); break;
+            case EMnemonic::SUBX: handler = nonunaryHandlerFor<EMnemonic::SUBX>(op.addrMode); break;
+            case EMnemonic::ANDA: handler = nonunaryHandlerFor<EMnemonic::ANDA>(op.addrMode); break;
+            case EMnemonic::ANDX: handler = nonunaryHandlerFor<EMnemonic::ANDX>(op.addrMode); break;
+            case EMnemonic::ORA: handler = nonunaryHandlerFor<EMnemonic::ORA>(op.addrMode); break;
+            case EMnemonic::ORX: handler = nonunaryHandlerFor<EMnemonic::ORX>(op.addrMode); break;
+            case EMnemonic::CPWA: handler = nonunaryHandlerFor<EMnemonic::CPWA>(op.addrMode); break;
+            case EMnemonic::CPWX: handler = nonunaryHandlerFor<EMnemonic::CPWX>(op.addrMode); break;
+            case EMnemonic::CPBA: handler = nonunaryHandlerFor<EMnemonic::CPBA>(op.addrMode); break;
+            case EMnemonic::CPBX: handler = nonunaryHandlerFor<EMnemonic::CPBX>(op.addrMode); break;
+            case EMnemonic::LDWA: handler = nonunaryHandlerFor<EMnemonic::LDWA>(op.addrMode); break;
+            case EMnemonic::LDWX: handler = nonunaryHandlerFor<EMnemonic::LDWX>(op.addrMode); break;
+            case EMnemonic::LDBA: handler = nonunaryHandlerFor<EMnemonic::LDBA>(op.addrMode); break;
+            case EMnemonic::LDBX: handler = nonunaryHandlerFor<EMnemonic::LDBX>(op.addrMode); break;
+            case EMnemonic::STWA: handler = nonunaryHandlerFor<EMnemonic::STWA>(op.addrMode); break;
+            case EMnemonic::STWX: handler = nonunaryHandlerFor<EMnemonic::STWX>(op.addrMode); break;
+            case EMnemonic::STBA: handler = nonunaryHandlerFor<EMnemonic::STBA>(op.addrMode); break;
+            case EMnemonic::STBX: handler = nonunaryHandlerFor<EMnemonic::STBX>(op.addrMode); break;
+            default: break;
+            }
+        }
+        // Anything without a specialized handler (e.g. NOP0 when it is not a trap)
+        // is executed by the switch based core, which also handles errors.
+        handlers[static_cast<size_t>(it)] = handler != nullptr ? handler : &IsaCpu::executeDecoded;
+    }
+}
+
+template<EMnemonic mnemon>
+IsaCpu::InstrHandler IsaCpu::nonunaryHandlerFor(EAddrMode addrMode)
+{
+    switch(addrMode) {
+    case EAddrMode::I: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::I>;
+    case EAddrMode::D: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::D>;
+    case EAddrMode::N: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::N>;
+    case EAddrMode::S: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::S>;
+    case EAddrMode::SF: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::SF>;
+    case EAddrMode::X: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::X>;
+    case EAddrMode::SX: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::SX>;
+    case EAddrMode::SFX: return &IsaCpu::executeNonunaryHandler<mnemon, EAddrMode::SFX>;
+    default: return nullptr;
+    }
+}
+
+template<EAddrMode addrMode>
+bool IsaCpu::readOperandWord(quint16 operand, quint16 &opVal)
+{
+    bool rVal = true;
+    quint16 effectiveAddress = 0;
+    if constexpr(addrMode == EAddrMode::I) {
+        opVal = operand;
+    }
+    else if constexpr(addrMode == EAddrMode::D) {
+        effectiveAddress = operand;
+        rVal = memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::S) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::X) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::X);
+        rVal = memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::SX) {
+        effectiveAddress = operand
+                + registerBank.readRegisterWordCurrent(CPURegisters::SP)
+                + registerBank.readRegisterWordCurrent(CPURegisters::X);
+        rVal = memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::N) {
+        effectiveAddress = operand;
+        rVal = memory->readWord(effectiveAddress, effectiveAddress);
+        rVal &= memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::SF) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readWord(effectiveAddress, effectiveAddress);
+        rVal &= memory->readWord(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::SFX) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readWord(effectiveAddress, effectiveAddress);
+        effectiveAddress += registerBank.readRegisterWordCurrent(CPURegisters::X);
+        rVal &= memory->readWord(effectiveAddress, opVal);
+    }
+    // Cache the decoded operand value for the UI, as readOperandWordValue(...) does.
+    InterfaceISACPU::opValCache = opVal;
+    return rVal;
+}
+
+template<EAddrMode addrMode>
+bool IsaCpu::readOperandByte(quint16 operand, quint8 &opVal)
+{
+    bool rVal = true;
+    quint16 effectiveAddress = 0;
+    quint8 tempByteHi, tempByteLo;
+    if constexpr(addrMode == EAddrMode::I) {
+        opVal = static_cast<quint8>(operand & 0xff);
+    }
+    else if constexpr(addrMode == EAddrMode::D) {
+        effectiveAddress = operand;
+        rVal = memory->readByte(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::S) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readByte(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::X) {
+        effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::X);
+        rVal = memory->readByte(effectiveAddress, opVal);
+    }
+    else if constexpr(addrMode == EAddrMode::SX) {
+        effectiveAddress = operand
+                + registerBank.readRegisterWordCurrent(CPURegisters::SP)
+                + registerBank.readRegisterWordCurrent(CPURegisters::X);
+        rVal = memory->readByte(effectiveAddress, opVal);
+    }
+    else {
+        // Indirect modes fetch the pointer one byte at a time.
+        if constexpr(addrMode == EAddrMode::N) {
+            effectiveAddress = operand;
+        }
+        else {
+            effectiveAddress = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        }
+        rVal = memory->readByte(effectiveAddress, tempByteHi);
+        rVal &= memory->readByte(static_cast<quint16>(effectiveAddress + 1), tempByteLo);
+        effectiveAddress = static_cast<quint16>(tempByteHi << 8 | tempByteLo);
+        if constexpr(addrMode == EAddrMode::SFX) {
+            effectiveAddress += registerBank.readRegisterWordCurrent(CPURegisters::X);
+        }
+        rVal &= memory->readByte(effectiveAddress, opVal);
+    }
+    // Cache the decoded operand value for the UI, as readOperandByteValue(...) does.
+    InterfaceISACPU::opValCache = opVal;
+    return rVal;
+}
+
+template<EAddrMode addrMode>
+bool IsaCpu::computeStoreAddress(quint16 operand, quint16 &address)
+{
+    bool rVal = true;
+    if constexpr(addrMode == EAddrMode::I) {
+        // Can't store to an immediate.
+        address = 0;
+        rVal = false;
+    }
+    else if constexpr(addrMode == EAddrMode::D) {
+        address = operand;
+    }
+    else if constexpr(addrMode == EAddrMode::S) {
+        address = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+    }
+    else if constexpr(addrMode == EAddrMode::X) {
+        address = operand + registerBank.readRegisterWordCurrent(CPURegisters::X);
+    }
+    else if constexpr(addrMode == EAddrMode::SX) {
+        address = operand
+                + registerBank.readRegisterWordCurrent(CPURegisters::SP)
+                + registerBank.readRegisterWordCurrent(CPURegisters::X);
+    }
+    else if constexpr(addrMode == EAddrMode::N) {
+        address = operand;
+        rVal = memory->readWord(address, address);
+    }
+    else if constexpr(addrMode == EAddrMode::SF) {
+        address = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readWord(address, address);
+    }
+    else if constexpr(addrMode == EAddrMode::SFX) {
+        address = operand + registerBank.readRegisterWordCurrent(CPURegisters::SP);
+        rVal = memory->readWord(address, address);
+        address += registerBank.readRegisterWordCurrent(CPURegisters::X);
+    }
+    return rVal;
+}
+
+template<EMnemonic mnemon>
+void IsaCpu::executeTrapHandler(quint16)
+{
+    // Traps are rare and involve many memory accesses, so there is little to be gained by specializing them.
+    executeTrap(mnemon);
+}
+
+template<EMnemonic mnemon>
+void IsaCpu::executeUnaryHandler(quint16)
+{
+    quint16 temp, sp, acc, idx;
+    quint8 tempByte;
+    sp = registerBank.readRegisterWordCurrent(CPURegisters::SP);
+    acc = registerBank.readRegisterWordCurrent(CPURegisters::A);
+    idx = registerBank.readRegisterWordCurrent(CPURegisters::X);
+
+    if constexpr(mnemon == EMnemonic::STOP) {
+        executionFinished = true;
+    }
+    else if constexpr(mnemon == EMnemonic::RET) {
+        memory->readWord(sp, temp);
+        registerBank.writeRegisterWord(CPURegisters::PC, temp);
+        sp += 2;
+        registerBank.writeRegisterWord(CPURegisters::SP, sp);
+    }
+    else if constexpr(mnemon == EMnemonic::RETTR) {
+        memory->readByte(sp, tempByte);
+        lazyStatusBits.discard();
+        registerBank.writeStatusBits(tempByte);
+        memory->readWord(sp + 1, temp);
+        registerBank.writeRegisterWord(CPURegisters::A, temp);
+        memory->readWord(sp + 3, temp);
+        registerBank.writeRegisterWord(CPURegisters::X, temp);
+        memory->readWord(sp + 5, temp);
+        registerBank.writeRegisterWord(CPURegisters::PC, temp);
+        memory->readWord(sp + 7, temp);
+        registerBank.writeRegisterWord(CPURegisters::SP, temp);
+    }
+    else if constexpr(mnemon == EMnemonic::MOVSPA) {
+        registerBank.writeRegisterWord(CPURegisters::A, sp);
+    }
+    else if constexpr(mnemon == EMnemonic::MOVFLGA) {
+        registerBank.writeRegisterWord(CPURegisters::A, currentStatusBits());
+    }
+    else if constexpr(mnemon == EMnemonic::MOVAFLG) {
+        lazyStatusBits.discard();
+        registerBank.writeStatusBits(static_cast<quint8>(acc));
+    }
+    else if constexpr(mnemon == EMnemonic::NOTA || mnemon == EMnemonic::NOTX) {
+        CPURegisters reg = mnemon == EMnemonic::NOTA ? CPURegisters::A : CPURegisters::X;
+        temp = ~(mnemon == EMnemonic::NOTA ? acc : idx);
+        registerBank.writeRegisterWord(reg, temp);
+        lazyStatusBits.setNZ(registerBank, temp);
+    }
+    else if constexpr(mnemon == EMnemonic::NEGA || mnemon == EMnemonic::NEGX) {
+        CPURegisters reg = mnemon == EMnemonic::NEGA ? CPURegisters::A : CPURegisters::X;
+        temp = ~(mnemon == EMnemonic::NEGA ? acc : idx) + 1;
+        registerBank.writeRegisterWord(reg, temp);
+        lazyStatusBits.setNegate(registerBank, temp);
+    }
+    else if constexpr(mnemon == EMnemonic::ASLA || mnemon == EMnemonic::ASLX) {
+        CPURegisters reg = mnemon == EMnemonic::ASLA ? CPURegisters::A : CPURegisters::X;
+        quint16 old = mnemon == EMnemonic::ASLA ? acc : idx;
+        temp = static_cast<quint16>(old << 1);
+        registerBank.writeRegisterWord(reg, temp);
+        lazyStatusBits.setShiftLeft(old, temp);
+    }
+    else if constexpr(mnemon == EMnemonic::ASRA || mnemon == EMnemonic::ASRX) {
+        CPURegisters reg = mnemon == EMnemonic::ASRA ? CPURegisters::A : CPURegisters::X;
+        quint16 old = mnemon == EMnemonic::ASRA ? acc : idx;
+        temp = static_cast<quint16>(old >> 1 | ((old & 0x8000) ? 1<<15 : 0));
+        registerBank.writeRegisterWord(reg, temp);
+        lazyStatusBits.setShiftRight(registerBank, old, temp);
+    }
+    else if constexpr(mnemon == EMnemonic::RORA || mnemon == EMnemonic::RORX) {
+        CPURegisters reg = mnemon == EMnemonic::RORA ? CPURegisters::A : CPURegisters::X;
+        quint16 old = mnemon == EMnemonic::RORA ? acc : idx;
+        // Rotates need the carry in, and only modify C.
+        materializeStatusBits();
+        temp = static_cast<quint16>(old >> 1
+                                    | (registerBank.readStatusBitCurrent(EStatusBit::STATUS_C) ? 1<<15 : 0));
+        registerBank.writeRegisterWord(reg, temp);
+        registerBank.writeStatusBit(EStatusBit::STATUS_C, old & 0x01);
+    }
+    else if constexpr(mnemon == EMnemonic::ROLA || mnemon == EMnemonic::ROLX) {
+        CPURegisters reg = mnemon == EMnemonic::ROLA ? CPURegisters::A : CPURegisters::X;
+        // Matches executeUnary(...): ROLX rotates the accumulator into X, but takes its carry from X.
+        materializeStatusBits();
+        temp = static_cast<quint16>(acc << 1
+                                    | (registerBank.readStatusBitCurrent(EStatusBit::STATUS_C) ? 1 : 0));
+        registerBank.writeRegisterWord(reg, temp);
+        registerBank.writeStatusBit(EStatusBit::STATUS_C, (mnemon == EMnemonic::ROLA ? acc : idx) & 0x8000);
+    }
+}
+
+template<EMnemonic mnemon, EAddrMode addrMode>
+void IsaCpu::executeNonunaryHandler(quint16 opSpec)
+{
+    quint16 tempWord = 0, result, address;
+    quint8 tempByte;
+    const quint16 a = registerBank.readRegisterWordCurrent(CPURegisters::A);
+    const quint16 x = registerBank.readRegisterWordCurrent(CPURegisters::X);
+    const quint16 sp = registerBank.readRegisterWordCurrent(CPURegisters::SP);
+    bool memSuccess = true;
+
+    if constexpr(mnemon == EMnemonic::BR || mnemon == EMnemonic::BRLE || mnemon == EMnemonic::BRLT
+            || mnemon == EMnemonic::BREQ || mnemon == EMnemonic::BRNE || mnemon == EMnemonic::BRGE
+            || mnemon == EMnemonic::BRGT || mnemon == EMnemonic::BRV || mnemon == EMnemonic::BRC) {
+        bool taken;
+        // Branches evaluate any pending status bits, but leave them pending.
+        if constexpr(mnemon == EMnemonic::BR) taken = true;
+        else if constexpr(mnemon == EMnemonic::BRLE) taken = currentStatusBits() & (NMask | ZMask);
+        else if constexpr(mnemon == EMnemonic::BRLT) taken = currentStatusBits() & NMask;
+        else if constexpr(mnemon == EMnemonic::BREQ) taken = currentStatusBits() & ZMask;
+        else if constexpr(mnemon == EMnemonic::BRNE) taken = !(currentStatusBits() & ZMask);
+        else if constexpr(mnemon == EMnemonic::BRGE) taken = !(currentStatusBits() & NMask);
+        else if constexpr(mnemon == EMnemonic::BRGT) taken = !(currentStatusBits() & (NMask | ZMask));
+        else if constexpr(mnemon == EMnemonic::BRV) taken = currentStatusBits() & VMask;
+        else taken = currentStatusBits() & CMask;
+        if(taken) {
+            memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+            registerBank.writeRegisterWord(CPURegisters::PC, tempWord);
+        }
+    }
+    else if constexpr(mnemon == EMnemonic::CALL) {
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        const quint16 newSP = sp - 2;
+        memSuccess &= memory->writeWord(newSP, registerBank.readRegisterWordCurrent(CPURegisters::PC));
+        registerBank.writeRegisterWord(CPURegisters::PC, tempWord);
+        registerBank.writeRegisterWord(CPURegisters::SP, newSP);
+    }
+    else if constexpr(mnemon == EMnemonic::ADDSP) {
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        registerBank.writeRegisterWord(CPURegisters::SP, sp + tempWord);
+    }
+    else if constexpr(mnemon == EMnemonic::SUBSP) {
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        registerBank.writeRegisterWord(CPURegisters::SP, sp - tempWord);
+    }
+    else if constexpr(mnemon == EMnemonic::ADDA || mnemon == EMnemonic::ADDX
+                      || mnemon == EMnemonic::SUBA || mnemon == EMnemonic::SUBX) {
+        constexpr bool useA = mnemon == EMnemonic::ADDA || mnemon == EMnemonic::SUBA;
+        const quint16 reg = useA ? a : x;
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        // Subtraction adds the two's complement of the operand.
+        if constexpr(mnemon == EMnemonic::SUBA || mnemon == EMnemonic::SUBX) tempWord = ~tempWord + 1;
+        result = reg + tempWord;
+        registerBank.writeRegisterWord(useA ? CPURegisters::A : CPURegisters::X, result);
+        lazyStatusBits.setAdd(reg, tempWord, result);
+    }
+    else if constexpr(mnemon == EMnemonic::ANDA || mnemon == EMnemonic::ANDX
+                      || mnemon == EMnemonic::ORA || mnemon == EMnemonic::ORX) {
+        constexpr bool useA = mnemon == EMnemonic::ANDA || mnemon == EMnemonic::ORA;
+        const quint16 reg = useA ? a : x;
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        if constexpr(mnemon == EMnemonic::ANDA || mnemon == EMnemonic::ANDX) result = reg & tempWord;
+        else result = reg | tempWord;
+        registerBank.writeRegisterWord(useA ? CPURegisters::A : CPURegisters::X, result);
+        lazyStatusBits.setNZ(registerBank, result);
+    }
+    else if constexpr(mnemon == EMnemonic::CPWA || mnemon == EMnemonic::CPWX) {
+        const quint16 reg = mnemon == EMnemonic::CPWA ? a : x;
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        tempWord = ~tempWord + 1;
+        result = reg + tempWord;
+        // Matches executeNonunary(...): both CPWA and CPWX compute carry against the accumulator.
+        lazyStatusBits.setCompareWord(reg, tempWord, result, a);
+    }
+    else if constexpr(mnemon == EMnemonic::CPBA || mnemon == EMnemonic::CPBX) {
+        memSuccess = readOperandByte<addrMode>(opSpec, tempByte);
+        tempWord = ~tempByte + 1;
+        result = ((mnemon == EMnemonic::CPBA ? a : x) + tempWord) & 0xff;
+        lazyStatusBits.setCompareByte(static_cast<quint8>(result));
+    }
+    else if constexpr(mnemon == EMnemonic::LDWA || mnemon == EMnemonic::LDWX) {
+        memSuccess = readOperandWord<addrMode>(opSpec, tempWord);
+        registerBank.writeRegisterWord(mnemon == EMnemonic::LDWA ? CPURegisters::A : CPURegisters::X, tempWord);
+        lazyStatusBits.setNZ(registerBank, tempWord);
+    }
+    else if constexpr(mnemon == EMnemonic::LDBA || mnemon == EMnemonic::LDBX) {
+        memSuccess = readOperandByte<addrMode>(opSpec, tempByte);
+        tempWord = ((mnemon == EMnemonic::LDBA ? a : x) & 0xff00) | tempByte;
+        registerBank.writeRegisterWord(mnemon == EMnemonic::LDBA ? CPURegisters::A : CPURegisters::X, tempWord);
+        // Never negative, since only the low order byte is examined.
+        lazyStatusBits.setNZ(registerBank, tempWord & 0xff);
+    }
+    else if constexpr(mnemon == EMnemonic::STWA || mnemon == EMnemonic::STWX
+                      || mnemon == EMnemonic::STBA || mnemon == EMnemonic::STBX) {
+        const quint16 value = (mnemon == EMnemonic::STWA || mnemon == EMnemonic::STBA) ? a : x;
+        memSuccess = computeStoreAddress<addrMode>(opSpec, address);
+        if constexpr(addrMode != EAddrMode::I) {
+            if constexpr(mnemon == EMnemonic::STWA || mnemon == EMnemonic::STWX) {
+                memSuccess &= memory->writeWord(address, value);
+            }
+            else {
+                memSuccess &= memory->writeByte(address, static_cast<quint8>(0xff & value));
+            }
+        }
+        // For stores, the cached operand value is the address that was written.
+        InterfaceISACPU::opValCache = address;
+    }
+
+    if(!memSuccess) {
+        controlError = true;
+        errorMessage = "Error: Failed to perform memory access.";
+    }
+}
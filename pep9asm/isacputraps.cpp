@@ -0,0 +1,540 @@
+// File: isacputraps.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "isacpu.h"
+
+#include <array>
+#include <utility>
+
+#include "amemorydevice.h"
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "pep.h"
+#include "registerfile.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+
+/*
+ * Trap acceleration for IsaCpu.
+ *
+ * The DECI, DECO, HEXO, and STRO handlers of the stock operating system execute
+ * hundreds of instructions per trap. Once the hardware part of a trap has been performed,
+ * these functions perform the OS part directly: every charIn read and charOut write is
+ * made in the same order, the OS globals and the system stack are left holding the same
+ * values, and the registers are restored from the trap frame as RETTR would.
+ * Below the trap frame, each handler writes the return addresses of the dispatcher's and
+ * its own calls and every one of its locals, in the order the operating system does,
+ * so no byte of memory differs from a trap the operating system handled itself.
+ *
+ * Each handler also counts the instructions the operating system would have executed,
+ * so that instruction counts can be reported as if the traps had been emulated.
+ * The counts follow the control flow of pep9os.pep exactly, so any change to the stock OS
+ * must be reflected both here and in stockSymbols.
+ */
+
+namespace {
+// Addresses of the symbols in the stock operating system that trap acceleration relies on.
+namespace StockOs {
+constexpr quint16 wordTemp = 0xFC0F;
+constexpr quint16 addrMask = 0xFC11;
+constexpr quint16 opAddr = 0xFC13;
+constexpr quint16 charIn = 0xFC15;
+constexpr quint16 charOut = 0xFC16;
+constexpr quint16 trap = 0xFC52;
+constexpr quint16 trapReturn = 0xFC71;
+constexpr quint16 opcode30 = 0xFD77;
+constexpr quint16 deciMsg = 0xFED1;
+constexpr quint16 opcode38 = 0xFEEB;
+constexpr quint16 opcode40 = 0xFF76;
+constexpr quint16 opcode48 = 0xFFC2;
+constexpr quint16 exitPrnt = 0xFFF3;
+}
+
+// An operating system is the stock OS only if each of these symbols has its stock value.
+// Including the labels between the handlers ensures that the handlers are the stock length.
+const std::array<std::pair<const char*, quint16>, 21> stockSymbols = {{
+    {"wordTemp", StockOs::wordTemp}, {"byteTemp", 0xFC10}, {"addrMask", StockOs::addrMask},
+    {"opAddr", StockOs::opAddr}, {"charIn", StockOs::charIn}, {"charOut", StockOs::charOut},
+    {"trap", StockOs::trap}, {"return", StockOs::trapReturn}, {"nonUnJT", 0xFC72},
+    {"assertAd", 0xFC7C}, {"setAddr", 0xFCCE}, {"opcode30", StockOs::opcode30},
+    {"deciErr", 0xFEBE}, {"deciMsg", StockOs::deciMsg}, {"opcode38", StockOs::opcode38},
+    {"divide", 0xFF44}, {"opcode40", StockOs::opcode40}, {"hexOut", 0xFFA9},
+    {"opcode48", StockOs::opcode48}, {"prntMsg", 0xFFDE}, {"exitPrnt", StockOs::exitPrnt}
+}};
+
+// Instructions executed by setAddr's handler for each addressing mode, i through sfx.
+const std::array<quint8, 8> setAddrInstructions = {4, 5, 6, 6, 7, 6, 7, 8};
+
+// Mirror CPBA followed by BRLT / BRGT, which only compare the low order byte.
+inline bool byteLessThan(quint8 value, quint8 operand)
+{
+    return static_cast<quint8>(value - operand) & 0x80;
+}
+
+inline bool byteGreaterThan(quint8 value, quint8 operand)
+{
+    quint8 result = static_cast<quint8>(value - operand);
+    return !(result & 0x80) && result != 0;
+}
+
+inline bool isDecimalDigit(quint8 value)
+{
+    return !byteLessThan(value, '0') && !byteGreaterThan(value, '9');
+}
+}
+
+void IsaCpu::setTrapAccelerationEnabled(bool enabled)
+{
+    trapAccelerationEnabled = enabled;
+    trapAccelerationActive = enabled && isStockOperatingSystem();
+}
+
+bool IsaCpu::isTrapAccelerationEnabled() const noexcept
+{
+    return trapAccelerationEnabled;
+}
+
+bool IsaCpu::isTrapAccelerationActive() const noexcept
+{
+    return trapAccelerationActive;
+}
+
+quint64 IsaCpu::getAcceleratedTrapCount() const noexcept
+{
+    return acceleratedTrapCounter;
+}
+
+quint64 IsaCpu::getEmulatedInstructionCount() const noexcept
+{
+    return asmInstructionCounter + acceleratedInstructionCounter;
+}
+
+bool IsaCpu::isStockOperatingSystem() const
+{
+    QSharedPointer<const AsmProgram> os = manager->getOperatingSystem();
+    if(os.isNull()) return false;
+    const QSharedPointer<SymbolTable> symTable = os->getSymbolTable();
+    for(const auto& symbol : stockSymbols) {
+        if(!symTable->exists(symbol.first)) return false;
+        QSharedPointer<SymbolEntry> entry = symTable->getValue(symbol.first);
+        if(!entry->isDefined() || entry->getValue() != symbol.second) return false;
+    }
+    return true;
+}
+
+bool IsaCpu::executeAcceleratedTrap(Enu::EMnemonic mnemon)
+{
+    // Addressing modes each trap handler asserts are legal, one bit per addressing mode.
+    quint16 legalModes;
+    switch(mnemon) {
+    case Enu::EMnemonic::DECI:
+        legalModes = 0x00FE;
+        break;
+    case Enu::EMnemonic::DECO:
+        [[fallthrough]];
+    case Enu::EMnemonic::HEXO:
+        legalModes = 0x00FF;
+        break;
+    case Enu::EMnemonic::STRO:
+        legalModes = 0x003E;
+        break;
+    default:
+        return false;
+    }
+    // The trap vector may have been changed at run time.
+    if(registerBank.readRegisterWordCurrent(Enu::CPURegisters::PC) != StockOs::trap) return false;
+    quint8 addrMode = registerBank.readRegisterByteCurrent(Enu::CPURegisters::IS) & 0x07;
+    // Let the operating system report illegal addressing modes itself.
+    if(!(legalModes & (1 << addrMode))) return false;
+
+    // The hardware part of the trap left SP pointing at the trap frame.
+    quint16 frame = registerBank.readRegisterWordCurrent(Enu::CPURegisters::SP);
+    bool okay = true;
+    quint16 oldX, oldPC, oldSP, opSpec, operandAddr = 0;
+    okay &= memory->readWord(frame + 3, oldX);
+    okay &= memory->readWord(frame + 5, oldPC);
+    okay &= memory->readWord(frame + 7, oldSP);
+
+    // The trap dispatcher calls the handler, which later returns to the dispatcher's RETTR.
+    okay &= memory->writeWord(frame - 2, StockOs::trapReturn);
+    okay &= memory->writeWord(StockOs::addrMask, legalModes);
+
+    // Compute the address of the trap's operand as setAddr does.
+    // The program counter in the trap frame is already past the operand specifier.
+    quint16 opSpecAddr = oldPC - 2;
+    if(addrMode != 0) {
+        okay &= memory->readWord(opSpecAddr, opSpec);
+    }
+    switch(addrMode) {
+    case 0: // i
+        operandAddr = opSpecAddr;
+        break;
+    case 1: // d
+        operandAddr = opSpec;
+        break;
+    case 2: // n
+        okay &= memory->readWord(opSpec, operandAddr);
+        break;
+    case 3: // s
+        operandAddr = opSpec + oldSP;
+        break;
+    case 4: // sf
+        okay &= memory->readWord(static_cast<quint16>(opSpec + oldSP), operandAddr);
+        break;
+    case 5: // x
+        operandAddr = opSpec + oldX;
+        break;
+    case 6: // sx
+        operandAddr = opSpec + oldX + oldSP;
+        break;
+    case 7: // sfx
+        okay &= memory->readWord(static_cast<quint16>(opSpec + oldSP), operandAddr);
+        operandAddr += oldX;
+        break;
+    }
+    okay &= memory->writeWord(StockOs::opAddr, operandAddr);
+
+    // The trap dispatcher (9 instructions before the handler's RETTR), the handler's assertion
+    // of its addressing mode (3 instructions to call assertAd, which loops once per mode),
+    // and the handler's call to setAddr.
+    quint64 emulated = 9 + 3 + (7 + 3 * addrMode) + 1 + (4 + setAddrInstructions[addrMode]);
+    bool returns = true;
+    // The last operand specifier fetched before the handler returns.
+    quint16 lastOpSpec = 0;
+    if(okay) {
+        switch(mnemon) {
+        case Enu::EMnemonic::DECI:
+            returns = acceleratedDECI(frame, operandAddr, emulated, okay);
+            lastOpSpec = 13;
+            break;
+        case Enu::EMnemonic::DECO:
+            acceleratedDECO(frame, operandAddr, emulated, okay);
+            lastOpSpec = 6;
+            break;
+        case Enu::EMnemonic::HEXO:
+            acceleratedHEXO(frame, operandAddr, emulated, okay);
+            lastOpSpec = StockOs::charOut;
+            break;
+        case Enu::EMnemonic::STRO:
+            acceleratedSTRO(frame, operandAddr, emulated, okay);
+            lastOpSpec = 2;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(!okay) {
+        controlError = true;
+        errorMessage = "Error: Failed to perform memory access.";
+    }
+    else if(returns) {
+        acceleratedTrapSpecifier = registerBank.readRegisterByteCurrent(Enu::CPURegisters::IS);
+        acceleratedTrapStep = asmInstructionCounter + 1;
+        executeUnary(Enu::EMnemonic::RETTR);
+        registerBank.writeRegisterByte(Enu::CPURegisters::IS,
+                                       static_cast<quint8>(Pep::opCodeMap.value(Enu::EMnemonic::RETTR)));
+        registerBank.writeRegisterWord(Enu::CPURegisters::OS, lastOpSpec);
+        emulated += 1;
+    }
+    acceleratedTrapCounter++;
+    acceleratedInstructionCounter += emulated;
+    return true;
+}
+
+bool IsaCpu::acceleratedDECI(quint16 frame, quint16 operandAddr, quint64 &emulated, bool &okay)
+{
+    // Stack offsets of locals, relative to SP after they are allocated.
+    enum Local: quint16 {temp = 0, state = 2, isNeg = 4, isOvfl = 6, valAscii = 8, asciiCh = 10, total = 11};
+    enum State: quint16 {init = 0, sign = 1, digit = 2};
+    quint16 locals = frame - 2 - 13;
+
+    // Return address of the call to setAddr.
+    okay &= memory->writeWord(frame - 4, StockOs::opcode30 + 12);
+    okay &= memory->writeWord(locals + isOvfl, 0);
+    okay &= memory->writeWord(locals + state, init);
+    emulated += 5;
+
+    State current = init;
+    bool negative = false, overflow = false;
+    quint16 value = 0;
+    quint8 ch;
+    bool parsing = true, valid = true;
+    while(parsing && valid && okay) {
+        okay &= memory->readByte(StockOs::charIn, ch);
+        if(!okay) break;
+        quint16 chValue = ch & 0x0F;
+        okay &= memory->writeByte(locals + asciiCh, ch);
+        okay &= memory->writeWord(locals + valAscii, chValue);
+        emulated += 8;
+        switch(current) {
+        case init:
+            if(ch == '+' || ch == '-') {
+                // The '-' test follows the failed '+' test.
+                emulated += ch == '+' ? 7 : 9;
+                negative = ch == '-';
+                okay &= memory->writeWord(locals + isNeg, negative ? 1 : 0);
+                okay &= memory->writeWord(locals + state, sign);
+                current = sign;
+                break;
+            }
+            emulated += 6 + (byteLessThan(ch, '0') ? 0 : 2);
+            if(isDecimalDigit(ch)) {
+                negative = false;
+                value = chValue;
+                okay &= memory->writeWord(locals + isNeg, 0);
+                okay &= memory->writeWord(locals + total, value);
+                okay &= memory->writeWord(locals + state, digit);
+                current = digit;
+                emulated += 7;
+            }
+            else if(ch == ' ') {
+                emulated += 2;
+            }
+            else if(ch == '\n') {
+                emulated += 5;
+            }
+            else {
+                emulated += 4;
+                valid = false;
+            }
+            break;
+        case sign:
+            emulated += byteLessThan(ch, '0') ? 2 : 4;
+            if(isDecimalDigit(ch)) {
+                value = chValue;
+                okay &= memory->writeWord(locals + total, value);
+                okay &= memory->writeWord(locals + state, digit);
+                current = digit;
+                emulated += 5;
+            }
+            else {
+                valid = false;
+            }
+            break;
+        case digit:
+            emulated += byteLessThan(ch, '0') ? 2 : 4;
+            if(!isDecimalDigit(ch)) {
+                parsing = false;
+                break;
+            }
+            // value = 10 * value + chValue, computed as (8 * value + 2 * value) + chValue.
+            // Overflow is checked after each shift and addition, as ASLA and ADDA set V.
+            bool overflowed = false;
+            quint16 times2 = static_cast<quint16>(value << 1);
+            overflowed |= (value ^ times2) & 0x8000;
+            okay &= memory->writeWord(locals + temp, times2);
+            quint16 times4 = static_cast<quint16>(times2 << 1);
+            overflowed |= (times2 ^ times4) & 0x8000;
+            quint16 times8 = static_cast<quint16>(times4 << 1);
+            overflowed |= (times4 ^ times8) & 0x8000;
+            quint16 times10 = times8 + times2;
+            overflowed |= ~(times8 ^ times2) & (times8 ^ times10) & 0x8000;
+            quint16 result = times10 + chValue;
+            overflowed |= ~(times10 ^ chValue) & (times10 ^ result) & 0x8000;
+            if(overflowed) {
+                overflow = true;
+                okay &= memory->writeWord(locals + isOvfl, 1);
+            }
+            value = result;
+            okay &= memory->writeWord(locals + total, value);
+            emulated += 20;
+            break;
+        }
+    }
+    if(!okay) return true;
+
+    if(!valid) {
+        // deciErr prints an error message, and halts inside of the trap handler.
+        okay &= memory->writeByte(StockOs::charOut, '\n');
+        okay &= memory->writeWord(frame - 17, StockOs::deciMsg);
+        // The call to prntMsg returns to the STOP preceding deciMsg.
+        okay &= memory->writeWord(frame - 19, StockOs::deciMsg - 1);
+        emulated += 6;
+        quint16 length = acceleratedPrintMessage(StockOs::deciMsg, emulated, okay);
+        emulated += 1;
+        registerBank.writeRegisterWord(Enu::CPURegisters::A, 0);
+        registerBank.writeRegisterWord(Enu::CPURegisters::X, length);
+        registerBank.writeRegisterWord(Enu::CPURegisters::SP, frame - 17);
+        registerBank.writeRegisterWord(Enu::CPURegisters::PC, StockOs::deciMsg);
+        registerBank.writeRegisterByte(Enu::CPURegisters::IS,
+                                       static_cast<quint8>(Pep::opCodeMap.value(Enu::EMnemonic::STOP)));
+        registerBank.writeRegisterWord(Enu::CPURegisters::OS, StockOs::exitPrnt);
+        // Flags as left by loading the message's null terminator, after ADDX incremented X.
+        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_N, false);
+        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_Z, true);
+        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_V, false);
+        registerBank.writeStatusBit(Enu::EStatusBit::STATUS_C, false);
+        executionFinished = true;
+        return false;
+    }
+
+    // deciNorm
+    emulated += 2;
+    if(negative) {
+        emulated += 3;
+        // -32768 can't be negated, but is not an overflow either.
+        if(value != 0x8000) {
+            value = static_cast<quint16>(-value);
+            okay &= memory->writeWord(locals + total, value);
+            emulated += 3;
+        }
+        else {
+            overflow = false;
+            okay &= memory->writeWord(locals + isOvfl, 0);
+            emulated += 2;
+        }
+    }
+
+    // setNZ replaces the NZV bits in the trap frame, and keeps only C.
+    quint8 flags;
+    okay &= memory->readByte(frame, flags);
+    flags &= 0x01;
+    emulated += 4 + 2 + 2 + 1;
+    if(value & 0x8000) {
+        flags |= 0x08;
+        emulated += 1;
+    }
+    if(value == 0) {
+        flags |= 0x04;
+        emulated += 1;
+    }
+    if(overflow) {
+        flags |= 0x02;
+        emulated += 1;
+    }
+    okay &= memory->writeByte(frame, flags);
+
+    // exitDeci
+    okay &= memory->writeWord(operandAddr, value);
+    emulated += 4;
+    return true;
+}
+
+void IsaCpu::acceleratedDECO(quint16 frame, quint16 operandAddr, quint64 &emulated, bool &okay)
+{
+    // Stack offsets of locals, relative to SP after they are allocated.
+    enum Local: quint16 {remain = 0, outYet = 2, place = 4};
+    quint16 locals = frame - 2 - 6;
+    // Return addresses of the four calls to divide.
+    static const std::array<quint16, 4> divideReturns = {0x31, 0x3A, 0x43, 0x4C};
+    static const std::array<quint16, 4> places = {10000, 1000, 100, 10};
+
+    quint16 value;
+    okay &= memory->readWord(operandAddr, value);
+    emulated += 4;
+    if(value & 0x8000) {
+        okay &= memory->writeByte(StockOs::charOut, '-');
+        // -32768 remains negative, but the repeated subtraction in divide still works.
+        value = static_cast<quint16>(-value);
+        emulated += 3;
+    }
+    okay &= memory->writeWord(locals + remain, value);
+    okay &= memory->writeWord(locals + outYet, 0);
+    emulated += 3;
+
+    bool outputYet = false;
+    for(size_t it = 0; it < places.size() && okay; it++) {
+        okay &= memory->writeWord(locals + place, places[it]);
+        okay &= memory->writeWord(locals - 2, StockOs::opcode38 + divideReturns[it]);
+        emulated += 3 + 2;
+        // Division by repeated subtraction, until the remainder's sign bit is set.
+        quint16 quotient = 0;
+        while(true) {
+            quint16 next = value - places[it];
+            emulated += 2;
+            if(next & 0x8000) break;
+            quotient++;
+            value = next;
+            okay &= memory->writeWord(locals + remain, value);
+            emulated += 3;
+        }
+        emulated += 2;
+        if(quotient != 0) {
+            outputYet = true;
+            okay &= memory->writeWord(locals + outYet, 1);
+            okay &= memory->writeByte(StockOs::charOut, static_cast<quint8>(quotient | 0x30));
+            emulated += 6;
+        }
+        else if(outputYet) {
+            okay &= memory->writeByte(StockOs::charOut, '0');
+            emulated += 5;
+        }
+        else {
+            emulated += 3;
+        }
+    }
+    // The ones place is always written.
+    okay &= memory->writeByte(StockOs::charOut, static_cast<quint8>(value | 0x30));
+    emulated += 5;
+}
+
+void IsaCpu::acceleratedHEXO(quint16 frame, quint16 operandAddr, quint64 &emulated, bool &okay)
+{
+    quint16 value;
+    okay &= memory->readWord(operandAddr, value);
+    okay &= memory->writeWord(StockOs::wordTemp, value);
+    // Return address of the last call to hexOut.
+    okay &= memory->writeWord(frame - 4, StockOs::opcode40 + 0x32);
+    emulated += 8 + 2 + 6 + 2 + 1;
+    for(int shift = 12; shift >= 0 && okay; shift -= 4) {
+        quint8 nybble = (value >> shift) & 0x0F;
+        if(nybble > 9) {
+            okay &= memory->writeByte(StockOs::charOut, static_cast<quint8>((nybble - 9) | 0x40));
+            emulated += 8;
+        }
+        else {
+            okay &= memory->writeByte(StockOs::charOut, static_cast<quint8>(nybble | 0x30));
+            emulated += 6;
+        }
+    }
+}
+
+void IsaCpu::acceleratedSTRO(quint16 frame, quint16 operandAddr, quint64 &emulated, bool &okay)
+{
+    // The string's address is passed to prntMsg on the stack.
+    okay &= memory->writeWord(frame - 4, operandAddr);
+    okay &= memory->writeWord(frame - 6, StockOs::opcode48 + 0x18);
+    emulated += 4;
+    acceleratedPrintMessage(operandAddr, emulated, okay);
+    emulated += 2;
+}
+
+quint16 IsaCpu::acceleratedPrintMessage(quint16 address, quint64 &emulated, bool &okay)
+{
+    quint16 length = 0;
+    quint8 ch;
+    emulated += 2;
+    while(okay) {
+        okay &= memory->readByte(static_cast<quint16>(address + length), ch);
+        emulated += 2;
+        if(!okay || ch == 0) break;
+        okay &= memory->writeByte(StockOs::charOut, ch);
+        emulated += 3;
+        // The OS would loop forever printing memory that contains no null bytes.
+        if(++length == 0) {
+            controlError = true;
+            errorMessage = "Error: STRO string is not null terminated.";
+            break;
+        }
+    }
+    emulated += 1;
+    return length;
+}
@@ -0,0 +1,218 @@
+// File: isaprofiler.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "isaprofiler.h"
+
+#include <algorithm>
+
+#include "amemorydevice.h"
+#include "asmcode.h"
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "memoizerhelper.h"
+
+static const QString countsHeader = QString("%1 %2 %3  ").arg("Count", 10).arg("Taken", 10).arg("Not taken", 10);
+
+// Only instructions are executed, and so only they get counts in a listing.
+static bool isInstruction(const AsmCode* code)
+{
+    return dynamic_cast<const UnaryInstruction*>(code) != nullptr
+            || dynamic_cast<const NonUnaryInstruction*>(code) != nullptr;
+}
+
+// Return the program whose object code contains address, or nullptr if there is none.
+static const AsmProgram* programContaining(const AsmProgramManager& manager, quint16 address)
+{
+    for(const auto& program : {manager.getUserProgram(), manager.getOperatingSystem()}) {
+        if(program.isNull()) continue;
+        auto bounds = program->getProgramBounds();
+        if(bounds.first <= address && address <= bounds.second) return program.data();
+    }
+    return nullptr;
+}
+
+IsaProfiler::IsaProfiler(): executions(1 << 16, 0), taken(1 << 16, 0), notTaken(1 << 16, 0)
+{
+
+}
+
+IsaProfiler::~IsaProfiler()
+{
+
+}
+
+void IsaProfiler::clear()
+{
+    std::fill(executions.begin(), executions.end(), 0);
+    std::fill(taken.begin(), taken.end(), 0);
+    std::fill(notTaken.begin(), notTaken.end(), 0);
+}
+
+quint64 IsaProfiler::getExecutionCount(quint16 address) const
+{
+    return executions[address];
+}
+
+quint64 IsaProfiler::getTakenCount(quint16 address) const
+{
+    return taken[address];
+}
+
+quint64 IsaProfiler::getNotTakenCount(quint16 address) const
+{
+    return notTaken[address];
+}
+
+quint64 IsaProfiler::getTotalExecutions() const
+{
+    quint64 total = 0;
+    for(quint64 count : executions) total += count;
+    return total;
+}
+
+QList<IsaProfiler::InstructionProfile> IsaProfiler::getExecutedInstructions(const AsmProgram *program,
+                                                                             quint16 first, quint16 last) const
+{
+    QList<InstructionProfile> list;
+    for(int address = first; address <= last; address++) {
+        if(executions[static_cast<size_t>(address)] == 0) continue;
+        quint16 addr = static_cast<quint16>(address);
+        const AsmCode* code = program == nullptr ? nullptr : program->memAddressToCode(addr);
+        list.append({addr, code, executions[addr], taken[addr], notTaken[addr]});
+    }
+    return list;
+}
+
+QList<IsaProfiler::InstructionProfile> IsaProfiler::getExecutedInstructions(const AsmProgramManager &manager) const
+{
+    QList<InstructionProfile> list = getExecutedInstructions(nullptr, 0, 0xFFFF);
+    for(auto& instr : list) {
+        const AsmProgram* program = programContaining(manager, instr.address);
+        if(program != nullptr) instr.code = program->memAddressToCode(instr.address);
+    }
+    return list;
+}
+
+QList<IsaProfiler::InstructionProfile> IsaProfiler::getHottestInstructions(const AsmProgramManager &manager,
+                                                                            int count) const
+{
+    QList<InstructionProfile> list = getExecutedInstructions(manager);
+    std::stable_sort(list.begin(), list.end(), [](const InstructionProfile& lhs, const InstructionProfile& rhs) {
+        return lhs.executions > rhs.executions;
+    });
+    if(list.size() > count) list.erase(list.begin() + count, list.end());
+    return list;
+}
+
+QString IsaProfiler::annotatedListing(const AsmProgram &program, bool executedOnly) const
+{
+    // Find the source lines of the executed instructions.
+    QHash<const AsmCode*, quint16> codeAddress;
+    auto bounds = program.getProgramBounds();
+    for(const auto& instr : getExecutedInstructions(&program, bounds.first, bounds.second)) {
+        if(instr.code != nullptr) codeAddress.insert(instr.code, instr.address);
+    }
+
+    QString blank = QString(countsHeader.length(), ' ');
+    QString dashes = QString(79, '-');
+    QStringList output;
+    output << blank + dashes;
+    output << blank + "      Object";
+    output << countsHeader + "Addr  code   Symbol   Mnemon  Operand     Comment";
+    output << blank + dashes;
+    QStringList sourceLines;
+    for(const auto& code : program.getProgram()) {
+        sourceLines.clear();
+        code->appendSourceLine(sourceLines);
+        if(sourceLines.isEmpty()) continue;
+        bool instruction = isInstruction(code.data()) && code->getEmitObjectCode();
+        if(executedOnly && !codeAddress.contains(code.data())) continue;
+
+        QString prefix = blank;
+        if(codeAddress.contains(code.data())) {
+            prefix = formatCounts(codeAddress[code.data()]);
+        }
+        else if(instruction) {
+            prefix = QString("%1 %2 %3  ").arg(0, 10).arg("", 10).arg("", 10);
+        }
+        output << prefix + sourceLines.first();
+        for(int it = 1; it < sourceLines.size(); it++) output << blank + sourceLines[it];
+    }
+    output << blank + dashes;
+    return output.join("\n") + "\n";
+}
+
+QString IsaProfiler::report(const AsmProgramManager &manager, const AMemoryDevice &memory, int hottestCount) const
+{
+    QStringList output;
+    output << QString("Profile of %1 instructions.").arg(getTotalExecutions());
+    output << "";
+
+    output << "Hottest instructions:";
+    output << countsHeader + "Addr    Instruction";
+    for(const auto& instr : getHottestInstructions(manager, hottestCount)) {
+        QString text = instr.code != nullptr ? instr.code->getAssemblerSource().trimmed()
+                                             : disassemble(memory, instr.address);
+        output << formatCounts(instr.address) + formatAddress(instr.address) + "  " + text;
+    }
+    output << "";
+
+    QSharedPointer<const AsmProgram> os = manager.getOperatingSystem();
+    QSharedPointer<const AsmProgram> user = manager.getUserProgram();
+    output << "User program:";
+    if(!user.isNull()) {
+        output << annotatedListing(*user);
+    }
+    else {
+        // Without the user program's source, disassemble whatever executed below the operating system.
+        quint16 last = os.isNull() ? 0xFFFF : static_cast<quint16>(os->getProgramBounds().first - 1);
+        output << countsHeader + "Addr    Instruction";
+        for(const auto& instr : getExecutedInstructions(nullptr, 0, last)) {
+            output << formatCounts(instr.address) + formatAddress(instr.address) + "  "
+                      + disassemble(memory, instr.address);
+        }
+        output << "";
+    }
+
+    if(!os.isNull()) {
+        output << "Operating system (executed instructions only):";
+        output << annotatedListing(*os, true);
+    }
+    return output.join("\n");
+}
+
+QString IsaProfiler::formatCounts(quint16 address) const
+{
+    QString takenText = "", notTakenText = "";
+    if(taken[address] != 0 || notTaken[address] != 0) {
+        takenText = QString::number(taken[address]);
+        notTakenText = QString::number(notTaken[address]);
+    }
+    return QString("%1 %2 %3  ").arg(executions[address], 10).arg(takenText, 10).arg(notTakenText, 10);
+}
+
+QString IsaProfiler::disassemble(const AMemoryDevice &memory, quint16 address)
+{
+    quint8 instrSpec = 0;
+    quint16 opSpec = 0;
+    memory.getByte(address, instrSpec);
+    if(!Pep::decodeTable[instrSpec].isUnary) memory.getWord(static_cast<quint16>(address + 1), opSpec);
+    return formatInstr(nullptr, instrSpec, opSpec).trimmed();
+}
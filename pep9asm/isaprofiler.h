@@ -0,0 +1,101 @@
+// File: isaprofiler.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ISAPROFILER_H
+#define ISAPROFILER_H
+
+#include <vector>
+#include <QtCore>
+
+#include "pep.h"
+
+class AMemoryDevice;
+class AsmCode;
+class AsmProgram;
+class AsmProgramManager;
+
+/*
+ * Counts how many times the instruction at each address is executed, and how many times
+ * each conditional branch is taken or not taken.
+ *
+ * Counters are dense arrays indexed by address, so recording an instruction is a single increment.
+ * Counts are joined back to the source lines of an AsmProgram only when a report is requested.
+ *
+ * A CPU that does not profile holds no IsaProfiler at all, so profiling costs nothing when disabled.
+ */
+class IsaProfiler
+{
+public:
+    // Execution counts of a single instruction.
+    struct InstructionProfile
+    {
+        quint16 address;
+        // The source line of the instruction, or nullptr if no program contains the address.
+        const AsmCode* code;
+        quint64 executions, taken, notTaken;
+    };
+
+    explicit IsaProfiler();
+    ~IsaProfiler();
+    void clear();
+
+    // Record that the instruction at startPC executed, leaving the program counter at endPC.
+    inline void recordInstruction(quint16 startPC, quint8 instrSpec, quint16 endPC)
+    {
+        executions[startPC]++;
+        if(Pep::decodeTable[instrSpec].isConditionalBranch) {
+            // A branch whose target is the following instruction is counted as not taken,
+            // since the two outcomes can't be told apart.
+            if(endPC != static_cast<quint16>(startPC + 3)) taken[startPC]++;
+            else notTaken[startPC]++;
+        }
+    }
+
+    quint64 getExecutionCount(quint16 address) const;
+    quint64 getTakenCount(quint16 address) const;
+    quint64 getNotTakenCount(quint16 address) const;
+    quint64 getTotalExecutions() const;
+
+    // Return the instructions between first and last (inclusive) that executed at least once,
+    // ordered by address. Source lines are looked up in program, which may be nullptr.
+    QList<InstructionProfile> getExecutedInstructions(const AsmProgram* program,
+                                                       quint16 first, quint16 last) const;
+    // Return every instruction that executed at least once, ordered by address.
+    // Source lines are looked up in the user program and operating system of manager.
+    QList<InstructionProfile> getExecutedInstructions(const AsmProgramManager& manager) const;
+    // Return the most executed instructions in memory, most executed first.
+    QList<InstructionProfile> getHottestInstructions(const AsmProgramManager& manager, int count) const;
+
+    // Return the program listing, with the counts of each instruction prepended to its line.
+    // If executedOnly, lines of instructions that never executed are omitted.
+    QString annotatedListing(const AsmProgram& program, bool executedOnly = false) const;
+    // Return a plain text report of the hottest instructions, followed by annotated listings of the
+    // user program and the operating system. Instructions that are not part of a program are
+    // disassembled from memory.
+    QString report(const AsmProgramManager& manager, const AMemoryDevice& memory, int hottestCount = 20) const;
+
+private:
+    std::vector<quint64> executions, taken, notTaken;
+    // Format the counts of an instruction as fixed width columns.
+    QString formatCounts(quint16 address) const;
+    static QString disassemble(const AMemoryDevice& memory, quint16 address);
+};
+
+#endif // ISAPROFILER_H
@@ -0,0 +1,186 @@
+// File: lazystatusbits.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef LAZYSTATUSBITS_H
+#define LAZYSTATUSBITS_H
+
+#include <QtCore>
+
+#include "enu.h"
+#include "registerfile.h"
+
+/*
+ * Defers the computation of the NZVC bits for IsaCpu.
+ *
+ * Most instructions that set status bits are followed by another instruction that overwrites
+ * them before any branch examines them. Rather than writing each bit to the register file as it is
+ * computed, the ISA core records the last flag-producing operation along with its operands.
+ * The bits are computed only when something reads them, using the same expressions the core
+ * previously evaluated eagerly, so the results are bit-identical.
+ *
+ * An operation that leaves some of the NZVC bits unchanged (e.g. loads leave V and C alone)
+ * first writes any pending bits it does not overwrite to the register file.
+ */
+class LazyStatusBits
+{
+public:
+    enum class Operation : quint8
+    {
+        // No bits are pending, the register file is up to date.
+        NONE,
+        // N and Z from a 16 bit result, e.g. loads, NOT, AND, OR.
+        NZ,
+        // N and Z from an 8 bit result stored in the high order byte, V and C cleared, e.g. CPBr.
+        COMPARE_BYTE,
+        // N, Z, and V from a two's complement negation.
+        NEGATE,
+        // NZVC from an arithmetic shift left of lhs.
+        SHIFT_LEFT,
+        // N, Z, and C from an arithmetic shift right of lhs.
+        SHIFT_RIGHT,
+        // NZVC from result = lhs + rhs, where C is computed against carryLhs.
+        ADD,
+        // As ADD, with N inverted when there is a signed overflow.
+        COMPARE_WORD
+    };
+
+    // Status bits computed from only N and Z.
+    void setNZ(RegisterFile& file, quint16 result)
+    {
+        record(file, Operation::NZ, Enu::NMask | Enu::ZMask);
+        this->result = result;
+    }
+    void setCompareByte(quint8 result)
+    {
+        op = Operation::COMPARE_BYTE;
+        mask = Enu::NMask | Enu::ZMask | Enu::VMask | Enu::CMask;
+        this->result = static_cast<quint16>(result << 8);
+    }
+    void setNegate(RegisterFile& file, quint16 result)
+    {
+        record(file, Operation::NEGATE, Enu::NMask | Enu::ZMask | Enu::VMask);
+        this->result = result;
+    }
+    void setShiftLeft(quint16 lhs, quint16 result)
+    {
+        op = Operation::SHIFT_LEFT;
+        mask = Enu::NMask | Enu::ZMask | Enu::VMask | Enu::CMask;
+        this->lhs = lhs;
+        this->result = result;
+    }
+    void setShiftRight(RegisterFile& file, quint16 lhs, quint16 result)
+    {
+        record(file, Operation::SHIFT_RIGHT, Enu::NMask | Enu::ZMask | Enu::CMask);
+        this->lhs = lhs;
+        this->result = result;
+    }
+    void setAdd(quint16 lhs, quint16 rhs, quint16 result)
+    {
+        setArithmetic(Operation::ADD, lhs, rhs, result, lhs);
+    }
+    void setCompareWord(quint16 lhs, quint16 rhs, quint16 result, quint16 carryLhs)
+    {
+        setArithmetic(Operation::COMPARE_WORD, lhs, rhs, result, carryLhs);
+    }
+
+    inline bool isPending() const noexcept
+    {
+        return op != Operation::NONE;
+    }
+    // Return statusBits, as they would be after the pending operation is applied to them.
+    inline quint8 resolve(quint8 statusBits) const
+    {
+        if(op == Operation::NONE) return statusBits;
+        // Is negative if high order bit is 1.
+        bool n = result & 0x8000;
+        // Is zero if all bits are 0's.
+        bool z = result == 0;
+        bool v = false, c = false;
+        switch(op) {
+        case Operation::NEGATE:
+            // Only a signed overflow if register is 0x8000.
+            v = result == 0x8000;
+            break;
+        case Operation::SHIFT_LEFT:
+            // Signed overflow occurs when the starting & ending values of the high order bit differ.
+            v = (lhs ^ result) >> 15;
+            // Carry out if register starts with high order 1.
+            c = lhs & 0x8000;
+            break;
+        case Operation::SHIFT_RIGHT:
+            // Carry out if register starts with low order 1.
+            c = lhs & 0x01;
+            break;
+        case Operation::ADD:
+            [[fallthrough]];
+        case Operation::COMPARE_WORD:
+            // There is a signed overflow iff the high order bits of the register and operand
+            // are the same, and one input & the output differ in sign.
+            v = (~(lhs ^ rhs) & (lhs ^ result)) >> 15;
+            // Carry out iff result is unsigned less than register or operand.
+            c = result < carryLhs || result < rhs;
+            // If there was a signed overflow, selectively invert N bit.
+            if(op == Operation::COMPARE_WORD) n ^= v;
+            break;
+        default:
+            break;
+        }
+        quint8 bits = static_cast<quint8>((n ? Enu::NMask : 0) | (z ? Enu::ZMask : 0)
+                                          | (v ? Enu::VMask : 0) | (c ? Enu::CMask : 0));
+        return static_cast<quint8>((statusBits & ~mask) | (bits & mask));
+    }
+    // Write the pending status bits to the register file.
+    inline void materialize(RegisterFile& file)
+    {
+        if(op == Operation::NONE) return;
+        file.writeStatusBits(resolve(file.readStatusBitsCurrent()));
+        op = Operation::NONE;
+    }
+    // Forget the pending operation, because all status bits are about to be overwritten.
+    inline void discard() noexcept
+    {
+        op = Operation::NONE;
+    }
+
+private:
+    Operation op = Operation::NONE;
+    // The NZVC bits the pending operation sets.
+    quint8 mask = 0;
+    quint16 lhs = 0, rhs = 0, result = 0, carryLhs = 0;
+
+    // Prepare to record an operation that only sets the bits in newMask.
+    inline void record(RegisterFile& file, Operation newOp, quint8 newMask)
+    {
+        if(mask & ~newMask) materialize(file);
+        op = newOp;
+        mask = newMask;
+    }
+    inline void setArithmetic(Operation newOp, quint16 lhs, quint16 rhs, quint16 result, quint16 carryLhs)
+    {
+        op = newOp;
+        mask = Enu::NMask | Enu::ZMask | Enu::VMask | Enu::CMask;
+        this->lhs = lhs;
+        this->rhs = rhs;
+        this->result = result;
+        this->carryLhs = carryLhs;
+    }
+};
+
+#endif // LAZYSTATUSBITS_H
@@ -53,7 +53,7 @@ QString formatAddress(quint16 address)
 QString mnemonDecode(quint8 instrSpec)
 {
     static QMetaEnum metaenum = Enu::staticMetaObject.enumerator(Enu::staticMetaObject.indexOfEnumerator("EMnemonic"));
-    return QString(metaenum.valueToKey((int)Pep::decodeMnemonic[instrSpec])).toLower();
+    return QString(metaenum.valueToKey((int)Pep::decodeTable[instrSpec].mnemonic)).toLower();
 }
 
 // Convert a mnemonic into its string
@@ -77,12 +77,12 @@ QString formatNonUnary(SymbolTable* symTable, quint8 instrSpec,quint16 oprSpec)
 {
     return formatIS(instrSpec).leftJustified(inst_size) %
             QString(attemptOperSpecReplace(symTable, oprSpec)).rightJustified(max_symLen) %
-            ", " % Pep::intToAddrMode(Pep::decodeAddrMode[instrSpec]).leftJustified(4,' ');
+            ", " % Pep::intToAddrMode(Pep::decodeTable[instrSpec].addrMode).leftJustified(4,' ');
 }
 
 QString formatInstr(SymbolTable* symTable, quint8 instrSpec,quint16 oprSpec)
 {
-    if(Pep::isUnaryMap[Pep::decodeMnemonic[instrSpec]]) {
+    if(Pep::decodeTable[instrSpec].isUnary) {
         return formatUnary(instrSpec);
     }
     else {
@@ -88,10 +88,15 @@ void NewMemoryTracePane::updateTrace()
         ui->warningLabel->setText(trace->heapTrace.getErrorMessage());
     }
     // Using main memory device, update
-    for(quint16 address : memorySection->getBytesWritten()) {
-        if(addressToItems.contains(address)) {
-            addressToItems[address]->setModified(true);
-            addressToItems[address]->updateValue();
+    MemoryBitmap::RangeIterator ranges(memorySection->getBytesWritten());
+    while(ranges.hasNext()) {
+        MemoryRange range = ranges.next();
+        for(quint32 address = range.first; address <= range.last; address++) {
+            auto item = addressToItems.find(static_cast<quint16>(address));
+            if(item != addressToItems.end()) {
+                (*item)->setModified(true);
+                (*item)->updateValue();
+            }
         }
     }
 
@@ -0,0 +1,330 @@
+// File: objectfile.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "objectfile.h"
+
+#include <algorithm>
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+
+#include "asmcode.h"
+#include "asmprogram.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+namespace {
+// Identifies a file as a binary object file, and the layout of the file.
+// Bump the version whenever the layout or the meaning of a field changes.
+const quint32 fileMagic = 0x50394F42; // "P9OB"
+const quint16 fileVersion = 1;
+
+inline QString formatAddress(quint16 address)
+{
+    return "0x" + QString("%1").arg(address, 4, 16, QLatin1Char('0')).toUpper();
+}
+}
+
+const QString ObjectFile::extension = "pepb";
+
+ObjectFile::ObjectFile(): objectCode(), loadAddress(0), burn(false), burnValue(0),
+    symbolTable(QSharedPointer<SymbolTable>::create()), traceInfo(QSharedPointer<StaticTraceInfo>::create()),
+    lines(), listing(), addressSymbols()
+{
+
+}
+
+ObjectFile::ObjectFile(const AsmProgram &program): objectCode(program.getObjectCode()),
+    loadAddress(program.hasBurn() ? program.getBurnAddress() : 0), burn(program.hasBurn()),
+    burnValue(program.hasBurn() ? program.getBurnValue() : 0), symbolTable(program.getSymbolTable()),
+    traceInfo(QSharedPointer<StaticTraceInfo>::create()), lines(), listing(), addressSymbols()
+{
+    if(symbolTable.isNull()) symbolTable = QSharedPointer<SymbolTable>::create();
+    // Only keep the parts of the trace information that can be stored.
+    if(!program.getTraceInfo().isNull()) {
+        auto programInfo = program.getTraceInfo();
+        traceInfo->staticTraceError = programInfo->staticTraceError;
+        traceInfo->hadTraceTags = programInfo->hadTraceTags;
+        traceInfo->hasHeapMalloc = programInfo->hasHeapMalloc;
+        traceInfo->heapPtr = programInfo->heapPtr;
+        traceInfo->mallocPtr = programInfo->mallocPtr;
+    }
+
+    // Each line of the program is one line of source.
+    for(int index = 0; index < program.numberOfLines(); index++) {
+        const AsmCode* code = program.getCodeAtIndex(static_cast<quint32>(index));
+        if(!code->getEmitObjectCode() || code->objectCodeLength() == 0) continue;
+        lines.append({static_cast<quint16>(code->getMemoryAddress()), code->objectCodeLength(),
+                      static_cast<quint32>(index), code->getAssemblerSource()});
+    }
+    std::stable_sort(lines.begin(), lines.end(), [](const Line& lhs, const Line& rhs){return lhs.address < rhs.address;});
+
+    listing = program.getProgramListing();
+    if(!symbolTable->getSymbolMap().isEmpty()) {
+        listing.append("\n");
+        listing.append(symbolTable->getSymbolTableListing());
+    }
+    indexAddressSymbols();
+}
+
+ObjectFile::~ObjectFile()
+{
+
+}
+
+const QVector<quint8> &ObjectFile::getObjectCode() const noexcept
+{
+    return objectCode;
+}
+
+quint16 ObjectFile::getLoadAddress() const noexcept
+{
+    return loadAddress;
+}
+
+bool ObjectFile::hasBurn() const noexcept
+{
+    return burn;
+}
+
+quint16 ObjectFile::getBurnValue() const noexcept
+{
+    return burnValue;
+}
+
+QSharedPointer<const SymbolTable> ObjectFile::getSymbolTable() const noexcept
+{
+    return symbolTable;
+}
+
+QSharedPointer<const StaticTraceInfo> ObjectFile::getTraceInfo() const noexcept
+{
+    return traceInfo;
+}
+
+const QVector<ObjectFile::Line> &ObjectFile::getLines() const noexcept
+{
+    return lines;
+}
+
+const QString &ObjectFile::getListing() const noexcept
+{
+    return listing;
+}
+
+const ObjectFile::Line *ObjectFile::lineAt(quint16 address) const
+{
+    // Find the last line starting at or before address.
+    auto next = std::upper_bound(lines.cbegin(), lines.cend(), address,
+                                 [](quint16 value, const Line& line){return value < line.address;});
+    if(next == lines.cbegin()) return nullptr;
+    const Line& line = *(next - 1);
+    if(address - line.address >= line.length) return nullptr;
+    return &line;
+}
+
+QString ObjectFile::describeAddress(quint16 address) const
+{
+    QStringList parts;
+    auto next = std::upper_bound(addressSymbols.cbegin(), addressSymbols.cend(), address,
+                                 [](quint16 value, const QPair<quint16, QString>& symbol){return value < symbol.first;});
+    if(next != addressSymbols.cbegin()) {
+        const auto& symbol = *(next - 1);
+        if(symbol.first == address) parts.append(symbol.second);
+        else parts.append(symbol.second + "+" + formatAddress(static_cast<quint16>(address - symbol.first)));
+    }
+    if(const Line* line = lineAt(address)) {
+        parts.append(QString("line %1: %2").arg(line->sourceLine + 1).arg(line->source.simplified()));
+    }
+    if(parts.isEmpty()) return formatAddress(address);
+    return QString("%1 (%2)").arg(formatAddress(address), parts.join(", "));
+}
+
+QByteArray ObjectFile::toBytes() const
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_10);
+
+    out << fileMagic << fileVersion;
+    out << loadAddress << burn << burnValue
+        << QByteArray(reinterpret_cast<const char*>(objectCode.constData()), objectCode.size());
+    writeSymbolTable(out, *symbolTable);
+
+    QString heapName, mallocName;
+    if(!traceInfo->heapPtr.isNull()) heapName = traceInfo->heapPtr->getName();
+    if(!traceInfo->mallocPtr.isNull()) mallocName = traceInfo->mallocPtr->getName();
+    out << traceInfo->staticTraceError << traceInfo->hadTraceTags << traceInfo->hasHeapMalloc
+        << heapName << mallocName;
+
+    out << static_cast<quint32>(lines.size());
+    for(const auto& line : lines) {
+        out << line.address << line.length << line.sourceLine << line.source;
+    }
+    out << listing;
+    return bytes;
+}
+
+bool ObjectFile::store(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly)) return false;
+    file.write(toBytes());
+    return file.commit();
+}
+
+bool ObjectFile::fromBytes(const QByteArray &bytes, ObjectFile &objectFile, QString &errorMessage)
+{
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_10);
+
+    quint32 magic;
+    quint16 version;
+    in >> magic >> version;
+    if(in.status() != QDataStream::Ok || magic != fileMagic) {
+        errorMessage = "Not a Pep/9 object file.";
+        return false;
+    }
+    else if(version != fileVersion) {
+        errorMessage = QString("Unsupported object file version %1.").arg(version);
+        return false;
+    }
+
+    ObjectFile parsed;
+    QByteArray code;
+    in >> parsed.loadAddress >> parsed.burn >> parsed.burnValue >> code;
+    parsed.objectCode.resize(code.size());
+    std::copy(code.cbegin(), code.cend(), parsed.objectCode.begin());
+    parsed.symbolTable = readSymbolTable(in);
+
+    QString heapName, mallocName;
+    in >> parsed.traceInfo->staticTraceError >> parsed.traceInfo->hadTraceTags >> parsed.traceInfo->hasHeapMalloc
+       >> heapName >> mallocName;
+    if(!heapName.isEmpty()) parsed.traceInfo->heapPtr = parsed.symbolTable->getValue(heapName);
+    if(!mallocName.isEmpty()) parsed.traceInfo->mallocPtr = parsed.symbolTable->getValue(mallocName);
+
+    quint32 lineCount;
+    in >> lineCount;
+    for(quint32 it = 0; it < lineCount && in.status() == QDataStream::Ok; it++) {
+        Line line;
+        in >> line.address >> line.length >> line.sourceLine >> line.source;
+        parsed.lines.append(line);
+    }
+    in >> parsed.listing;
+
+    // A truncated or otherwise damaged file must not be run.
+    if(in.status() != QDataStream::Ok || parsed.loadAddress + parsed.objectCode.size() > (1 << 16)) {
+        errorMessage = "The object file is damaged.";
+        return false;
+    }
+    parsed.indexAddressSymbols();
+    objectFile = parsed;
+    return true;
+}
+
+bool ObjectFile::load(const QString &fileName, ObjectFile &objectFile, QString &errorMessage)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        errorMessage = QString("Could not open file: %1.").arg(fileName);
+        return false;
+    }
+    return fromBytes(file.readAll(), objectFile, errorMessage);
+}
+
+bool ObjectFile::isObjectFile(const QByteArray &bytes)
+{
+    if(bytes.size() < static_cast<int>(sizeof(fileMagic))) return false;
+    QDataStream in(bytes);
+    quint32 magic;
+    in >> magic;
+    return magic == fileMagic;
+}
+
+void ObjectFile::writeSymbolTable(QDataStream &out, const SymbolTable &symbolTable)
+{
+    QList<QSharedPointer<SymbolEntry>> symbols = symbolTable.getSymbolEntries();
+    out << static_cast<quint32>(symbols.size());
+    for(const auto& symbol : symbols) {
+        auto rawValue = symbol->getRawValue();
+        quint16 value = 0, offset = 0;
+        switch(rawValue->getSymbolType()) {
+        case SymbolType::ADDRESS:
+        {
+            auto location = qSharedPointerCast<SymbolValueLocation>(rawValue);
+            value = location->getBase();
+            offset = location->getOffset();
+            break;
+        }
+        case SymbolType::NUMERIC_CONSTANT:
+            value = static_cast<quint16>(rawValue->getValue());
+            break;
+        case SymbolType::EMPTY:
+            break;
+        }
+        out << symbol->getName() << static_cast<quint8>(rawValue->getSymbolType()) << value << offset;
+    }
+}
+
+QSharedPointer<SymbolTable> ObjectFile::readSymbolTable(QDataStream &in)
+{
+    auto symbolTable = QSharedPointer<SymbolTable>::create();
+    quint32 symbolCount;
+    in >> symbolCount;
+    for(quint32 it = 0; it < symbolCount && in.status() == QDataStream::Ok; it++) {
+        QString name;
+        quint8 type;
+        quint16 value, offset;
+        in >> name >> type >> value >> offset;
+        switch(static_cast<SymbolType>(type)) {
+        case SymbolType::ADDRESS:
+        {
+            auto location = QSharedPointer<SymbolValueLocation>::create(value);
+            location->setOffset(offset);
+            symbolTable->setValue(name, location);
+            break;
+        }
+        case SymbolType::NUMERIC_CONSTANT:
+            symbolTable->setValue(name, QSharedPointer<SymbolValueNumeric>::create(value));
+            break;
+        case SymbolType::EMPTY:
+            symbolTable->insertSymbol(name);
+            break;
+        default:
+            // A symbol type this version does not know about can only come from a damaged file.
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+    }
+    return symbolTable;
+}
+
+void ObjectFile::indexAddressSymbols()
+{
+    addressSymbols.clear();
+    for(const auto& symbol : symbolTable->getSymbolEntries()) {
+        if(symbol->getRawValue()->getSymbolType() != SymbolType::ADDRESS) continue;
+        addressSymbols.append({static_cast<quint16>(symbol->getValue()), symbol->getName()});
+    }
+    std::sort(addressSymbols.begin(), addressSymbols.end());
+}
@@ -0,0 +1,114 @@
+// File: objectfile.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OBJECTFILE_H
+#define OBJECTFILE_H
+
+#include <QByteArray>
+#include <QPair>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class AsmProgram;
+class QDataStream;
+class SymbolTable;
+struct StaticTraceInfo;
+
+/*
+ * A program's object code in a versioned binary format, along with everything needed to describe it
+ * without its source: the load address, the symbol table, the address and source of every line that
+ * generated object code, the listing, and the program's trace information.
+ *
+ * A file is read with a single read, and unlike the hexadecimal text of a .pepo file needs no parsing
+ * to recover the object code. Files start with a magic number, so they can be told apart from .pepo files.
+ *
+ * Trace information is limited to the flags and heap / malloc symbols of the program. The types of
+ * trace tagged symbols are not stored, but the tags remain in the source of each line.
+ */
+class ObjectFile
+{
+public:
+    // A line of source that generated object code.
+    struct Line
+    {
+        quint16 address;
+        quint16 length;
+        // Zero-based line number in the source program.
+        quint32 sourceLine;
+        QString source;
+    };
+
+    // File name extension of binary object files.
+    static const QString extension;
+
+    // Create an empty object file, with no object code.
+    ObjectFile();
+    // Capture the object code, symbols, listing, and trace information of program.
+    explicit ObjectFile(const AsmProgram& program);
+    ~ObjectFile();
+
+    const QVector<quint8>& getObjectCode() const noexcept;
+    // Address of the first byte of object code, which is 0 unless the program is burned.
+    quint16 getLoadAddress() const noexcept;
+    bool hasBurn() const noexcept;
+    quint16 getBurnValue() const noexcept;
+    QSharedPointer<const SymbolTable> getSymbolTable() const noexcept;
+    QSharedPointer<const StaticTraceInfo> getTraceInfo() const noexcept;
+    // Lines that generated object code, in order of increasing address.
+    const QVector<Line>& getLines() const noexcept;
+    // Program listing and symbol table, as written to a .pepl file.
+    const QString& getListing() const noexcept;
+
+    // Returns the line whose object code contains address, or nullptr if there is none.
+    const Line* lineAt(quint16 address) const;
+    // Describe address as an offset from the closest preceding address symbol, followed by
+    // the source of the line containing it, e.g. "0x0014 (loop+0x0003, line 12: ADDA 1,i)".
+    QString describeAddress(quint16 address) const;
+
+    QByteArray toBytes() const;
+    // Write the object file to fileName, replacing it only once the whole file is written.
+    bool store(const QString& fileName) const;
+    // Returns false and explains why in errorMessage if bytes is not a valid object file.
+    static bool fromBytes(const QByteArray& bytes, ObjectFile& objectFile, QString& errorMessage);
+    static bool load(const QString& fileName, ObjectFile& objectFile, QString& errorMessage);
+    // Returns true if bytes start with the magic number of an object file.
+    static bool isObjectFile(const QByteArray& bytes);
+
+    // Symbol table serialization, shared with OsImageCache. An unknown symbol type
+    // marks the stream as corrupt, so that callers reject the whole file.
+    static void writeSymbolTable(QDataStream& out, const SymbolTable& symbolTable);
+    static QSharedPointer<SymbolTable> readSymbolTable(QDataStream& in);
+
+private:
+    QVector<quint8> objectCode;
+    quint16 loadAddress;
+    bool burn;
+    quint16 burnValue;
+    QSharedPointer<SymbolTable> symbolTable;
+    QSharedPointer<StaticTraceInfo> traceInfo;
+    QVector<Line> lines;
+    QString listing;
+    // Address symbols sorted by value, for describeAddress().
+    QVector<QPair<quint16, QString>> addressSymbols;
+    void indexAddressSymbols();
+};
+
+#endif // OBJECTFILE_H
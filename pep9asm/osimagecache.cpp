@@ -0,0 +1,165 @@
+// File: osimagecache.cpp
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "osimagecache.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "asmprogram.h"
+#include "objectfile.h"
+#include "pep.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+namespace {
+// Identifies a file as an operating system image, and the layout of the image.
+// Bump the version whenever the layout or the meaning of a field changes.
+const quint32 imageMagic = 0x50394F53; // "P9OS"
+const quint16 imageVersion = 1;
+}
+
+OsImageCache::OsImageCache(QString imageFile): imageFile(imageFile)
+{
+
+}
+
+OsImageCache::~OsImageCache()
+{
+
+}
+
+QSharedPointer<AsmProgram> OsImageCache::load(const QString &sourceText) const
+{
+    QFile file(imageFile);
+    if(!file.open(QIODevice::ReadOnly)) return nullptr;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_10);
+
+    quint32 magic;
+    quint16 version;
+    QByteArray hash;
+    in >> magic >> version >> hash;
+    if(in.status() != QDataStream::Ok || magic != imageMagic
+            || version != imageVersion || hash != sourceHash(sourceText)) {
+        return nullptr;
+    }
+
+    quint16 burnAddress, burnValue;
+    QByteArray objectCode;
+    in >> burnAddress >> burnValue >> objectCode;
+
+    auto symTable = ObjectFile::readSymbolTable(in);
+
+    auto traceInfo = QSharedPointer<StaticTraceInfo>::create();
+    QString heapName, mallocName;
+    in >> traceInfo->staticTraceError >> traceInfo->hadTraceTags >> traceInfo->hasHeapMalloc
+       >> heapName >> mallocName;
+    if(!heapName.isEmpty()) traceInfo->heapPtr = symTable->getValue(heapName);
+    if(!mallocName.isEmpty()) traceInfo->mallocPtr = symTable->getValue(mallocName);
+
+    // A truncated or otherwise damaged image must not be installed.
+    if(in.status() != QDataStream::Ok || objectCode.isEmpty()) {
+        return nullptr;
+    }
+    QVector<quint8> code(objectCode.size());
+    std::copy(objectCode.cbegin(), objectCode.cend(), code.begin());
+    return QSharedPointer<AsmProgram>::create(code, symTable, traceInfo, burnAddress, burnValue);
+}
+
+bool OsImageCache::store(const QString &sourceText, const AsmProgram &os) const
+{
+    // Only burned programs can be rebuilt from their object code.
+    if(!os.hasBurn()) return false;
+    // Symbol types reference symbols and each other, and are not worth serializing
+    // for the operating system, which isn't trace tagged.
+    QSharedPointer<const StaticTraceInfo> traceInfo = os.getTraceInfo();
+    if(!traceInfo.isNull() && (!traceInfo->staticAllocSymbolTypes.isEmpty()
+                               || !traceInfo->dynamicAllocSymbolTypes.isEmpty()
+                               || !traceInfo->instrToSymlist.isEmpty())) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(imageFile).absolutePath());
+    // Write to a temporary file which replaces the image once complete, so that
+    // simultaneous launches never read a partially written image.
+    QSaveFile file(imageFile);
+    if(!file.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_10);
+
+    out << imageMagic << imageVersion << sourceHash(sourceText);
+    QVector<quint8> objectCode = os.getObjectCode();
+    out << os.getBurnAddress() << os.getBurnValue()
+        << QByteArray(reinterpret_cast<const char*>(objectCode.constData()), objectCode.size());
+
+    ObjectFile::writeSymbolTable(out, *os.getSymbolTable());
+
+    bool staticTraceError = false, hadTraceTags = false, hasHeapMalloc = false;
+    QString heapName, mallocName;
+    if(!traceInfo.isNull()) {
+        staticTraceError = traceInfo->staticTraceError;
+        hadTraceTags = traceInfo->hadTraceTags;
+        hasHeapMalloc = traceInfo->hasHeapMalloc;
+        if(!traceInfo->heapPtr.isNull()) heapName = traceInfo->heapPtr->getName();
+        if(!traceInfo->mallocPtr.isNull()) mallocName = traceInfo->mallocPtr->getName();
+    }
+    out << staticTraceError << hadTraceTags << hasHeapMalloc << heapName << mallocName;
+
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+QByteArray OsImageCache::sourceHash(const QString &sourceText)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(sourceText.toUtf8());
+    // A different build may assemble the same source differently, so an image
+    // must never outlive the assembler that produced it. Every application of a build
+    // shares one assembler, so images written by Pep9Term are valid in the others.
+    hash.addData(QCoreApplication::applicationVersion().toUtf8());
+#ifdef GIT_SHA
+    hash.addData(GIT_SHA);
+#endif
+    // The spelling and addressing modes of the trap mnemonics can be redefined,
+    // which changes how the same source text assembles.
+    for(auto mnemonic : Pep::enumToMnemonMap.keys()) {
+        hash.addData(Pep::enumToMnemonMap.value(mnemonic).toUtf8());
+        hash.addData(QByteArray::number(Pep::addrModesMap.value(mnemonic)));
+        hash.addData(QByteArray::number(Pep::isUnaryMap.value(mnemonic)));
+    }
+    return hash.result();
+}
+
+QString OsImageCache::defaultImageFile()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("pep9os.img");
+}
+
+QString OsImageCache::bundledImageFile()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath("pep9os.img");
+}
@@ -0,0 +1,72 @@
+// File: osimagecache.h
+/*
+    Pep9 is a virtual machine for writing machine language and assembly
+    language programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OSIMAGECACHE_H
+#define OSIMAGECACHE_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+
+class AsmProgram;
+
+/*
+ * Stores an assembled operating system in a compact binary image, so that later
+ * launches can install it in one step instead of running the assembler.
+ *
+ * An image holds the object code, burn address and value, symbol table, and trace
+ * information of the operating system. It also holds a hash of the source text and of
+ * the mnemonic definitions it was assembled with, and is only loaded if both still match,
+ * so editing the operating system or redefining mnemonics causes it to be reassembled.
+ *
+ * The build writes an image of each application's default operating system next to its
+ * executable, using Pep9Term. Images do not depend on which application wrote them, so that
+ * image is valid for the application built alongside it.
+ *
+ * Images do not hold the lines of code of the operating system, so programs loaded from an
+ * image have no listing. Callers needing the listing must assemble the operating system.
+ */
+class OsImageCache
+{
+public:
+    explicit OsImageCache(QString imageFile);
+    ~OsImageCache();
+
+    // Returns the operating system stored for sourceText, or a null pointer if
+    // there is no image, it can't be read, or it is stale.
+    QSharedPointer<AsmProgram> load(const QString& sourceText) const;
+    // Write os, which was assembled from sourceText, as the image for sourceText.
+    // Returns false if os can't be represented as an image or the image can't be written.
+    bool store(const QString& sourceText, const AsmProgram& os) const;
+
+    // Hash identifying sourceText assembled by this build of the suite with the current
+    // mnemonic definitions.
+    static QByteArray sourceHash(const QString& sourceText);
+    // Location of the image file for the default operating system, in the user's cache directory.
+    static QString defaultImageFile();
+    // Location of the image file for the default operating system written by the build,
+    // next to the application's executable.
+    static QString bundledImageFile();
+
+private:
+    QString imageFile;
+};
+
+#endif // OSIMAGECACHE_H
@@ -23,6 +23,7 @@ HEADERS += \
     asmprogram.h \
     asmprogrammanager.h \
     asmsourcecodepane.h \
+    callgraphprofiler.h \
     cpphighlighter.h \
     executionstatisticswidget.h \
     interfaceisacpu.h \
@@ -34,9 +35,14 @@ HEADERS += \
     stacktrace.h \
     redefinemnemonicsdialog.h \
     asmcpupane.h \
+    isablockcache.h \
+    isaprofiler.h \
     isacpu.h \
     isacpumemoizer.h \
+    lazystatusbits.h \
     memoizerhelper.h \
+    objectfile.h \
+    osimagecache.h \
     asmprogramtracepane.h \
     asmprogramlistingpane.h \
     assemblerpane.h
@@ -48,6 +54,7 @@ SOURCES += \
     asmprogram.cpp \
     asmprogrammanager.cpp \
     asmsourcecodepane.cpp \
+    callgraphprofiler.cpp \
     cpphighlighter.cpp \
     executionstatisticswidget.cpp \
     interfaceisacpu.cpp \
@@ -59,9 +66,15 @@ SOURCES += \
     stacktrace.cpp \
     redefinemnemonicsdialog.cpp \
     asmcpupane.cpp \
+    isablockcache.cpp \
+    isaprofiler.cpp \
     isacpu.cpp \
     isacpumemoizer.cpp \
+    isacputhreaded.cpp \
+    isacputraps.cpp \
     memoizerhelper.cpp \
+    objectfile.cpp \
+    osimagecache.cpp \
     asmprogramtracepane.cpp \
     asmprogramlistingpane.cpp \
     assemblerpane.cpp
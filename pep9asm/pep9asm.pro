@@ -66,3 +66,7 @@ include("../installer/installer-creator.pri")
 
 #Generate SHA hash of current git commit, and make available as GIT_SHA macro.
 include("../gitversion.pri")
+
+#Write an image of the default operating system next to the executable, using Pep9Term.
+OS_IMAGE_SOURCE = $$PWD/help-asm/figures/pep9os.pep
+include("../osimage.pri")
@@ -152,6 +152,8 @@ void RedefineMnemonicsDialog::init(bool nop0IsTrap)
 
 void RedefineMnemonicsDialog::reject()
 {
+    // Instruction properties may have changed, so rebuild the cached decoder table.
+    Pep::initDecoderTables();
     QDialog::reject();
     emit closed();
 }
@@ -220,6 +220,14 @@ void StackTrace::setErrorMessage(QString message)
     errMessage = message;
 }
 
+void StackTrace::detachFrames()
+{
+    for(auto& frame : callStack) {
+        frame = QSharedPointer<StackFrame>::create(*frame);
+    }
+    nextFrame = QSharedPointer<StackFrame>::create(*nextFrame);
+}
+
 StackTrace::operator QString() const
 {
     QList<QString> ts;
@@ -253,6 +261,25 @@ void MemoryTrace::clear()
     traceWarnings = false;
 }
 
+MemoryTrace::MemoryTrace(const MemoryTrace &other): traceWarnings(other.traceWarnings), userStack(other.userStack),
+    activeStack(&userStack), heapTrace(other.heapTrace), globalTrace(other.globalTrace)
+{
+    userStack.detachFrames();
+    heapTrace.detachFrames();
+}
+
+MemoryTrace &MemoryTrace::operator=(const MemoryTrace &other)
+{
+    traceWarnings = other.traceWarnings;
+    userStack = other.userStack;
+    userStack.detachFrames();
+    activeStack = &userStack;
+    heapTrace = other.heapTrace;
+    heapTrace.detachFrames();
+    globalTrace = other.globalTrace;
+    return *this;
+}
+
 bool MemoryTrace::hasTraceWarnings() const
 {
     return traceWarnings;
@@ -526,6 +553,13 @@ void HeapTrace::setErrorMessage(QString message)
     errMessage = message;
 }
 
+void HeapTrace::detachFrames()
+{
+    for(auto& frame : heap) {
+        frame = QSharedPointer<StackFrame>::create(*frame);
+    }
+}
+
 HeapTrace::operator QString() const
 {
     QList<QString> items;
@@ -112,6 +112,8 @@ public:
     void setStackIntact(bool value);
     QString getErrorMessage() const;
     void setErrorMessage(QString message);
+    // Replace each frame with a copy, so that this trace no longer shares frames with any trace it was copied from.
+    void detachFrames();
 
 };
 
@@ -154,6 +156,8 @@ public:
     bool inMalloc() const;
     QString getErrorMessage() const;
     void setErrorMessage(QString message);
+    // Replace each frame with a copy, so that this trace no longer shares frames with any trace it was copied from.
+    void detachFrames();
 
     operator QString() const;
 };
@@ -174,6 +178,10 @@ class MemoryTrace
     bool traceWarnings;
 public:
     explicit MemoryTrace();
+    // Copies share no stack frames with the original, so that either may be modified
+    // without affecting the other.
+    MemoryTrace(const MemoryTrace& other);
+    MemoryTrace& operator=(const MemoryTrace& other);
     void clear();
     StackTrace userStack, *activeStack;
     HeapTrace heapTrace;
@@ -23,10 +23,13 @@
 #include "acpumodel.h"
 #include "amemorydevice.h"
 #include "interrupthandler.h"
+#include <QCoreApplication>
 #include <QSharedPointer>
+#include <QThread>
 ACPUModel::ACPUModel(QSharedPointer<AMemoryDevice> memoryDev, QObject* parent) noexcept: QObject(parent), memory(memoryDev),
     handler(new InterruptHandler()), callDepth(0), inDebug(false), inSimulation(false),
-    executionFinished(false), controlError(false), errorMessage("")
+    executionFinished(false), headless(false), controlError(false), errorMessage(""),
+    pendingRequests(0), publishedStatus(), statusMutex()
 {
 
 }
@@ -49,6 +52,7 @@ const AMemoryDevice *ACPUModel::getMemoryDevice() const noexcept
 void ACPUModel::setMemoryDevice(QSharedPointer<AMemoryDevice> newDevice)
 {
     memory = newDevice;
+    memory->setHeadless(headless);
 }
 
 bool ACPUModel::getExecutionFinished() const noexcept
@@ -71,8 +75,85 @@ int ACPUModel::getCallDepth() const noexcept
     return callDepth;
 }
 
+void ACPUModel::setHeadless(bool headless) noexcept
+{
+    this->headless = headless;
+    memory->setHeadless(headless);
+}
+
+bool ACPUModel::isHeadless() const noexcept
+{
+    return headless;
+}
+
+void ACPUModel::requestCancel() noexcept
+{
+    pendingRequests.fetchAndOrOrdered(cancelRequest);
+}
+
+void ACPUModel::requestBreakpoint(Enu::BreakpointTypes type) noexcept
+{
+    pendingRequests.fetchAndOrOrdered(static_cast<int>(type));
+}
+
+void ACPUModel::clearRequests() noexcept
+{
+    pendingRequests.fetchAndStoreOrdered(0);
+}
+
+ACPUModel::RunStatus ACPUModel::getPublishedStatus() const
+{
+    QMutexLocker locker(&statusMutex);
+    return publishedStatus;
+}
+
+void ACPUModel::pollRequests(quint64 progress)
+{
+    {
+        RunStatus status;
+        status.steps = progress;
+        status.a = getCPURegWordCurrent(Enu::CPURegisters::A);
+        status.x = getCPURegWordCurrent(Enu::CPURegisters::X);
+        status.sp = getCPURegWordCurrent(Enu::CPURegisters::SP);
+        status.pc = getCPURegWordCurrent(Enu::CPURegisters::PC);
+        status.is = getCPURegByteCurrent(Enu::CPURegisters::IS);
+        status.nzvcs = static_cast<quint8>(getStatusBitCurrent(Enu::STATUS_N) << 4
+                                           | getStatusBitCurrent(Enu::STATUS_Z) << 3
+                                           | getStatusBitCurrent(Enu::STATUS_V) << 2
+                                           | getStatusBitCurrent(Enu::STATUS_C) << 1
+                                           | getStatusBitCurrent(Enu::STATUS_S));
+        QMutexLocker locker(&statusMutex);
+        publishedStatus = status;
+    }
+    // Simulations run synchronously on the GUI thread (e.g. stepping) must keep the UI responsive,
+    // and this is also where such a UI gets to make its requests.
+    QCoreApplication* app = QCoreApplication::instance();
+    if(app != nullptr && QThread::currentThread() == app->thread()) {
+        QCoreApplication::processEvents();
+    }
+    int requests = pendingRequests.fetchAndStoreOrdered(0);
+    if(requests == 0) return;
+    if(requests & cancelRequest) {
+        onCancelExecution();
+    }
+    if(requests & static_cast<int>(Enu::BreakpointTypes::ASSEMBLER)) {
+        enableDebugging();
+        forceBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
+    }
+    if(requests & static_cast<int>(Enu::BreakpointTypes::MICROCODE)) {
+        enableDebugging();
+        forceBreakpoint(Enu::BreakpointTypes::MICROCODE);
+    }
+}
+
 void ACPUModel::onClearMemory()
 {
     memory->clearErrors();
     memory->clearMemory();
 }
+
+void ACPUModel::synchronizeChanges()
+{
+    memory->synchronizeChanges();
+    emit changesSynchronized();
+}
@@ -22,6 +22,8 @@
 #ifndef ACPUMODEL_H
 #define ACPUMODEL_H
 
+#include <QAtomicInteger>
+#include <QMutex>
 #include <QObject>
 #include "enu.h"
 
@@ -64,6 +66,32 @@ public:
     // Return the depth of the call stack (#calls+#traps-#ret-#rettr)
     int getCallDepth() const noexcept;
 
+    // In headless mode, the CPU and its memory device do not emit per-instruction or
+    // per-store notifications. Instead, changesSynchronized() is emitted when the simulation
+    // stops, hits a breakpoint, or synchronizeChanges() is explicitly called.
+    // Used by command line tools where there is no UI observing the simulation.
+    void setHeadless(bool headless) noexcept;
+    bool isHeadless() const noexcept;
+
+    // Thread-safe requests that may be made while the simulation runs on another thread.
+    // They are acted upon the next time the simulation loop polls for requests.
+    void requestCancel() noexcept;
+    void requestBreakpoint(Enu::BreakpointTypes type) noexcept;
+    // Discard requests that were not acted upon before the simulation stopped.
+    void clearRequests() noexcept;
+    // The state of the machine as of the last poll, between two steps.
+    struct RunStatus
+    {
+        // Number of steps (instructions or cycles) completed.
+        quint64 steps;
+        quint16 a, x, sp, pc;
+        quint8 is;
+        // The N, Z, V, C, and S bits, from most to least significant.
+        quint8 nzvcs;
+    };
+    // Safe to call from any thread, so that a UI may display progress of a running simulation.
+    RunStatus getPublishedStatus() const;
+
     // Prepare the CPU for starting simulations / debugging.
     virtual void initCPU() = 0;
     // Fetch values of the status bit reigsters(NZVCS bits).
@@ -105,21 +133,36 @@ public slots:
     virtual void onResetCPU() = 0;
     // Wipe all values stored in the memory device backing the CPU.
     virtual void onClearMemory();
+    // Notify observers that the batch of changes made since the last synchronization
+    // is available for inspection.
+    void synchronizeChanges();
 
 signals:
     void simulationFinished();
     void hitBreakpoint(Enu::BreakpointTypes type);
     // If a simulator does not support assembler (Pep9CPU), then this will not be emitted.
     void asmInstructionFinished();
+    // Emitted in headless mode at stops, breakpoints, and explicit synchronization points.
+    void changesSynchronized();
 
 protected:
     QSharedPointer<AMemoryDevice> memory;
     QSharedPointer<InterruptHandler> handler;
     int callDepth;
-    bool inDebug, inSimulation, executionFinished;
+    bool inDebug, inSimulation, executionFinished, headless;
     mutable bool controlError;
     //
     mutable QString errorMessage;
+    // Bitwise OR of Enu::BreakpointTypes and cancelRequest.
+    QAtomicInt pendingRequests;
+    // Guarded by statusMutex, since the fields must be read together.
+    RunStatus publishedStatus;
+    mutable QMutex statusMutex;
+    static constexpr int cancelRequest = 1 << 2;
+    // Must be called periodically by the simulation loop, between steps.
+    // Applies pending requests, and publishes progress and the registers.
+    // When the simulation is driven from the GUI thread, also gives the event loop a chance to run.
+    void pollRequests(quint64 progress);
 };
 
 #endif // ACPUMODEL_H
@@ -109,6 +109,11 @@ public:
     // Can the contents of this chip be cached, or are they volatile?
     // To reduce unecessary code, assume a chip is cachable unless overriden.
     virtual bool isCachable() const noexcept { return true;}
+    // If the chip keeps its contents in a contiguous array of bytes which may be
+    // read and set without side effects, return a pointer to the first byte.
+    // Main memory uses this to access RAM / ROM directly, bypassing virtual dispatch.
+    // The pointer is invalidated when the chip is resized.
+    virtual quint8* getBackingStore() noexcept { return nullptr;}
 
     // Read / Write functions that may generate signals or trap for IO.
     virtual bool readByte(quint16 offsetFromBase, quint8& output) const = 0;
@@ -23,7 +23,7 @@
 #include "amemorydevice.h"
 
 AMemoryDevice::AMemoryDevice(QObject *parent) noexcept: QObject(parent), bytesWritten(), bytesSet(),
-    errorMessage(""), error(false)
+    errorMessage(""), error(false), headless(false), writeWatchers(), nextWatcherId(0)
 {
 
 }
@@ -44,12 +44,12 @@ void AMemoryDevice::clearErrors()
     errorMessage = "";
 }
 
-const QSet<quint16> AMemoryDevice::getBytesWritten() const noexcept
+const MemoryBitmap &AMemoryDevice::getBytesWritten() const noexcept
 {
     return bytesWritten;
 }
 
-const QSet<quint16> AMemoryDevice::getBytesSet() const noexcept
+const MemoryBitmap &AMemoryDevice::getBytesSet() const noexcept
 {
     return bytesSet;
 }
@@ -64,6 +64,66 @@ void AMemoryDevice::clearBytesSet() noexcept
     bytesSet.clear();
 }
 
+void AMemoryDevice::setHeadless(bool headless) noexcept
+{
+    this->headless = headless;
+}
+
+bool AMemoryDevice::isHeadless() const noexcept
+{
+    return headless;
+}
+
+int AMemoryDevice::addWriteWatcher(std::function<void (quint16, quint16)> watcher)
+{
+    auto entry = QSharedPointer<WriteWatcher>::create();
+    entry->id = nextWatcherId++;
+    entry->callback = watcher;
+    writeWatchers.append(entry);
+    return entry->id;
+}
+
+void AMemoryDevice::removeWriteWatcher(int id)
+{
+    for(int index = 0; index < writeWatchers.size(); index++) {
+        if(writeWatchers[index]->id == id) {
+            writeWatchers.remove(index);
+            return;
+        }
+    }
+}
+
+void AMemoryDevice::watchRange(int id, quint16 first, quint16 last) noexcept
+{
+    for(auto watcher : writeWatchers) {
+        if(watcher->id == id) watcher->watchedBytes.insertRange(first, last);
+    }
+}
+
+void AMemoryDevice::unwatchRange(int id, quint16 first, quint16 last) noexcept
+{
+    for(auto watcher : writeWatchers) {
+        if(watcher->id == id) watcher->watchedBytes.removeRange(first, last);
+    }
+}
+
+void AMemoryDevice::clearWatchedRanges(int id) noexcept
+{
+    for(auto watcher : writeWatchers) {
+        if(watcher->id == id) watcher->watchedBytes.clear();
+    }
+}
+
+bool AMemoryDevice::isCachable(quint16) const noexcept
+{
+    return false;
+}
+
+void AMemoryDevice::synchronizeChanges()
+{
+    emit changesSynchronized();
+}
+
 bool AMemoryDevice::readWord(quint16 offsetFromBase, quint16 &output) const
 {
     quint8 temp = 0;
@@ -23,7 +23,11 @@
 #define AMEMORYDEVICE_H
 
 #include <QObject>
-#include <QSet>
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+
+#include "memorybitmap.h"
 
 /*
  * This class provides a unified interface for memory devices (like RAM, or a cache).
@@ -50,9 +54,27 @@ class AMemoryDevice : public QObject
 {
     Q_OBJECT
 protected:
-    QSet<quint16> bytesWritten, bytesSet;
+    MemoryBitmap bytesWritten, bytesSet;
     mutable QString errorMessage;
     mutable bool error;
+    bool headless;
+    struct WriteWatcher
+    {
+        int id;
+        // Addresses whose modification must be reported to callback.
+        MemoryBitmap watchedBytes;
+        std::function<void(quint16, quint16)> callback;
+    };
+    QVector<QSharedPointer<WriteWatcher>> writeWatchers;
+    int nextWatcherId;
+    // Subclasses must call this whenever the bytes between first and last (inclusive) may have changed.
+    inline void notifyWatcher(quint16 first, quint16 last)
+    {
+        for(int index = 0; index < writeWatchers.size(); index++) {
+            const WriteWatcher& watcher = *writeWatchers.at(index);
+            if(watcher.watchedBytes.intersects(first, last)) watcher.callback(first, last);
+        }
+    }
 public:
     explicit AMemoryDevice(QObject *parent = nullptr) noexcept;
 
@@ -69,16 +91,38 @@ public:
     void clearErrors();
 
     // Returns the set of bytes the have been written / set.
-    // since the last clear.
-    const QSet<quint16> getBytesWritten() const noexcept;
-    const QSet<quint16> getBytesSet() const noexcept;
+    // since the last clear. Walk the set with MemoryBitmap::RangeIterator.
+    const MemoryBitmap& getBytesWritten() const noexcept;
+    const MemoryBitmap& getBytesSet() const noexcept;
     // Call after all components have (synchronously) had a chance
     // to access these fields. The set of written / set bytes will
     // continue to grow until explicitly reset.
     void clearBytesWritten() noexcept;
     void clearBytesSet() noexcept;
 
+    // In headless mode, changed(...) is not emitted for individual stores.
+    // Written / set bytes are still recorded, and observers are notified in bulk
+    // via changesSynchronized() whenever synchronizeChanges() is called.
+    // Devices that wrap another device pass the setting along to it.
+    virtual void setHeadless(bool headless) noexcept;
+    bool isHeadless() const noexcept;
+
+    // Consumers that cache the contents of memory (e.g. decoded instructions) register a watcher,
+    // which is invoked with the modified range whenever one of the bytes it watches is written or set.
+    // Any number of watchers may be registered, and each watches its own set of bytes.
+    // Returns the id used to refer to the watcher, which must be removed before its owner is destroyed.
+    int addWriteWatcher(std::function<void(quint16, quint16)> watcher);
+    void removeWriteWatcher(int id);
+    void watchRange(int id, quint16 first, quint16 last) noexcept;
+    void unwatchRange(int id, quint16 first, quint16 last) noexcept;
+    void clearWatchedRanges(int id) noexcept;
+    // Returns true if the contents of address may only change through this device,
+    // and reading it has no side effects. Such addresses are safe to cache.
+    virtual bool isCachable(quint16 address) const noexcept;
+
 public slots:
+    // Notify observers that the bytes written / set since the last clear are ready to be inspected.
+    void synchronizeChanges();
     // Clear the contents of memory. All addresses from 0 to size will be set to 0.
     virtual void clearMemory() = 0;
     // Methods (currently unused) that are useful for implementing a cache
@@ -103,6 +147,8 @@ public slots:
 signals:
     // Signal that a memory address has been written / set.
     void changed(quint16 address, quint8 newValue);
+    // Signal that a batch of changes is available through getBytesWritten() / getBytesSet().
+    void changesSynchronized();
 
 
 };
@@ -0,0 +1,325 @@
+// File: cachememorydevice.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "cachememorydevice.h"
+
+#include <QtAlgorithms>
+#include <QStringList>
+
+namespace {
+inline bool isPowerOfTwo(quint32 value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+}
+
+bool CacheMemoryDevice::Configuration::isValid(QString &errorMessage) const
+{
+    if(!isPowerOfTwo(size) || size > (1<<16)) {
+        errorMessage = QString("Cache size must be a power of two no larger than 65536, not %1.").arg(size);
+        return false;
+    }
+    else if(!isPowerOfTwo(lineSize) || lineSize > size) {
+        errorMessage = QString("Cache line size must be a power of two no larger than the cache, not %1.").arg(lineSize);
+        return false;
+    }
+    else if(!isPowerOfTwo(associativity) || associativity > size / lineSize) {
+        errorMessage = QString("Cache associativity must be a power of two no larger than the number of lines, not %1.")
+                .arg(associativity);
+        return false;
+    }
+    return true;
+}
+
+bool CacheMemoryDevice::Configuration::fromString(const QString &spec, Configuration &config, QString &errorMessage)
+{
+    Configuration parsed;
+    for(const QString& pair : spec.split(",", Qt::SkipEmptyParts)) {
+        QStringList keyValue = pair.split("=");
+        if(keyValue.length() != 2) {
+            errorMessage = QString("Expected key=value in cache configuration, not \"%1\".").arg(pair);
+            return false;
+        }
+        QString key = keyValue[0].trimmed().toLower(), value = keyValue[1].trimmed().toLower();
+        bool ok = true;
+        if(key == "size") parsed.size = value.toUInt(&ok);
+        else if(key == "ways") parsed.associativity = value.toUInt(&ok);
+        else if(key == "line") parsed.lineSize = value.toUInt(&ok);
+        else if(key == "write" && value == "back") parsed.writePolicy = WritePolicy::WRITE_BACK;
+        else if(key == "write" && value == "through") parsed.writePolicy = WritePolicy::WRITE_THROUGH;
+        else if(key == "replace" && value == "lru") parsed.replacementPolicy = ReplacementPolicy::LRU;
+        else if(key == "replace" && value == "fifo") parsed.replacementPolicy = ReplacementPolicy::FIFO;
+        else if(key == "replace" && value == "random") parsed.replacementPolicy = ReplacementPolicy::RANDOM;
+        else ok = false;
+        if(!ok) {
+            errorMessage = QString("Invalid cache configuration \"%1\".").arg(pair);
+            return false;
+        }
+    }
+    if(!parsed.isValid(errorMessage)) return false;
+    config = parsed;
+    return true;
+}
+
+QString CacheMemoryDevice::Configuration::toString() const
+{
+    QString write = writePolicy == WritePolicy::WRITE_BACK ? "back" : "through";
+    QString replace;
+    switch(replacementPolicy) {
+    case ReplacementPolicy::LRU:
+        replace = "lru";
+        break;
+    case ReplacementPolicy::FIFO:
+        replace = "fifo";
+        break;
+    case ReplacementPolicy::RANDOM:
+        replace = "random";
+        break;
+    }
+    return QString("size=%1,ways=%2,line=%3,write=%4,replace=%5")
+            .arg(size).arg(associativity).arg(lineSize).arg(write).arg(replace);
+}
+
+CacheMemoryDevice::CacheMemoryDevice(QSharedPointer<AMemoryDevice> device, Configuration configuration,
+                                     QObject *parent): AMemoryDevice(parent), device(device),
+    configuration(configuration), lines(configuration.size / configuration.lineSize),
+    statistics(), clock(0), randomState(0),
+    lineBits(qCountTrailingZeroBits(configuration.lineSize)),
+    setBits(qCountTrailingZeroBits(configuration.size / configuration.lineSize / configuration.associativity)),
+    setMask(static_cast<quint16>((1 << setBits) - 1)), watcherId(-1)
+{
+    reset();
+    // Consumers watch this device, so pass along every change made to the wrapped device.
+    watcherId = this->device->addWriteWatcher([this](quint16 first, quint16 last){notifyWatcher(first, last);});
+    this->device->watchRange(watcherId, 0, 0xffff);
+}
+
+CacheMemoryDevice::~CacheMemoryDevice()
+{
+    device->removeWriteWatcher(watcherId);
+}
+
+QSharedPointer<AMemoryDevice> CacheMemoryDevice::getDevice() const noexcept
+{
+    return device;
+}
+
+const CacheMemoryDevice::Configuration &CacheMemoryDevice::getConfiguration() const noexcept
+{
+    return configuration;
+}
+
+const CacheMemoryDevice::Statistics &CacheMemoryDevice::getStatistics() const noexcept
+{
+    return statistics;
+}
+
+void CacheMemoryDevice::reset() noexcept
+{
+    for(auto& line : lines) {
+        line = {0, false, false, 0};
+    }
+    statistics = Statistics();
+    clock = 0;
+    // Use a fixed seed, so that runs with random replacement can be reproduced.
+    randomState = 0x9E3779B9;
+}
+
+QString CacheMemoryDevice::report() const
+{
+    const quint64 accesses = statistics.hits() + statistics.misses();
+    // Avoid dividing by zero when a program never touched cachable memory.
+    const double hitRate = accesses == 0 ? 0 : 100.0 * statistics.hits() / accesses;
+    return QString("Cache (%1):\n"
+                   "  %2 hits (%3 reads, %4 writes), %5 misses (%6 reads, %7 writes), %8% hit rate.\n"
+                   "  %9 evictions, %10 write backs, %11 uncached accesses.\n")
+            .arg(configuration.toString())
+            .arg(statistics.hits()).arg(statistics.readHits).arg(statistics.writeHits)
+            .arg(statistics.misses()).arg(statistics.readMisses).arg(statistics.writeMisses)
+            .arg(hitRate, 0, 'f', 2)
+            .arg(statistics.evictions).arg(statistics.writeBacks).arg(statistics.uncached);
+}
+
+quint32 CacheMemoryDevice::maxAddress() const noexcept
+{
+    return device->maxAddress();
+}
+
+bool CacheMemoryDevice::isCachable(quint16 address) const noexcept
+{
+    return device->isCachable(address);
+}
+
+void CacheMemoryDevice::setHeadless(bool headless) noexcept
+{
+    AMemoryDevice::setHeadless(headless);
+    device->setHeadless(headless);
+}
+
+void CacheMemoryDevice::clearMemory()
+{
+    device->clearMemory();
+    reset();
+    clearErrors();
+}
+
+void CacheMemoryDevice::onCycleStarted()
+{
+    device->onCycleStarted();
+}
+
+void CacheMemoryDevice::onCycleFinished()
+{
+    device->onCycleFinished();
+}
+
+bool CacheMemoryDevice::readByte(quint16 address, quint8 &output) const
+{
+    access(address, false);
+    bool retVal = device->readByte(address, output);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::writeByte(quint16 address, quint8 value)
+{
+    access(address, true);
+    bool retVal = device->writeByte(address, value);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::getByte(quint16 address, quint8 &output) const
+{
+    bool retVal = device->getByte(address, output);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::setByte(quint16 address, quint8 value)
+{
+    bool retVal = device->setByte(address, value);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::readWord(quint16 address, quint16 &output) const
+{
+    accessWord(address, false);
+    bool retVal = device->readWord(address, output);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::writeWord(quint16 address, quint16 value)
+{
+    accessWord(address, true);
+    bool retVal = device->writeWord(address, value);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::getWord(quint16 address, quint16 &output) const
+{
+    bool retVal = device->getWord(address, output);
+    mirrorErrors();
+    return retVal;
+}
+
+bool CacheMemoryDevice::setWord(quint16 address, quint16 value)
+{
+    bool retVal = device->setWord(address, value);
+    mirrorErrors();
+    return retVal;
+}
+
+void CacheMemoryDevice::access(quint16 address, bool write) const
+{
+    if(!device->isCachable(address)) {
+        statistics.uncached++;
+        return;
+    }
+    clock++;
+    const quint32 set = (address >> lineBits) & setMask;
+    const quint16 tag = static_cast<quint16>(address >> (lineBits + setBits));
+    Line* ways = &lines[set * configuration.associativity];
+    const bool writeBack = configuration.writePolicy == WritePolicy::WRITE_BACK;
+
+    for(quint32 way = 0; way < configuration.associativity; way++) {
+        Line& line = ways[way];
+        if(!line.valid || line.tag != tag) continue;
+        if(write) statistics.writeHits++;
+        else statistics.readHits++;
+        if(configuration.replacementPolicy == ReplacementPolicy::LRU) line.stamp = clock;
+        line.dirty |= write && writeBack;
+        return;
+    }
+
+    if(write) statistics.writeMisses++;
+    else statistics.readMisses++;
+    // A write-through cache sends write misses to memory without allocating a line.
+    if(write && !writeBack) return;
+
+    Line& line = ways[victim(set)];
+    if(line.valid) {
+        statistics.evictions++;
+        if(line.dirty) statistics.writeBacks++;
+    }
+    line = {tag, true, write, clock};
+}
+
+void CacheMemoryDevice::accessWord(quint16 address, bool write) const
+{
+    access(address, write);
+    const quint16 last = address + 1;
+    if((last >> lineBits) != (address >> lineBits)) access(last, write);
+}
+
+quint32 CacheMemoryDevice::victim(quint32 set) const
+{
+    const Line* ways = &lines[set * configuration.associativity];
+    for(quint32 way = 0; way < configuration.associativity; way++) {
+        if(!ways[way].valid) return way;
+    }
+    if(configuration.replacementPolicy == ReplacementPolicy::RANDOM) {
+        // xorshift32, which is plenty for picking a way.
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        return randomState & (configuration.associativity - 1);
+    }
+    // LRU and FIFO both evict the line with the oldest stamp, they only differ in when it is updated.
+    quint32 oldest = 0;
+    for(quint32 way = 1; way < configuration.associativity; way++) {
+        if(ways[way].stamp < ways[oldest].stamp) oldest = way;
+    }
+    return oldest;
+}
+
+void CacheMemoryDevice::mirrorErrors() const
+{
+    // The CPU only checks this device for errors, and only clears this device's errors.
+    if(device->hadError()) {
+        error = true;
+        errorMessage = device->getErrorMessage();
+        device->clearErrors();
+    }
+}
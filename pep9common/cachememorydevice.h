@@ -0,0 +1,148 @@
+// File: cachememorydevice.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CACHEMEMORYDEVICE_H
+#define CACHEMEMORYDEVICE_H
+
+#include <vector>
+
+#include <QSharedPointer>
+
+#include "amemorydevice.h"
+
+/*
+ * A set associative cache placed in front of another memory device, usually a MainMemory.
+ * The cache only models which lines are resident, so that hits, misses, and evictions can be
+ * counted. Values are always stored in and returned by the wrapped device, so a program behaves
+ * identically with or without a cache.
+ *
+ * Only read and write pass through the cache. Get and set are used by the UI and the loader,
+ * so they go straight to the wrapped device, as do accesses to addresses that are not cachable
+ * (e.g. memory-mapped IO).
+ *
+ * A write-back cache allocates a line on a write miss, and counts a write back whenever
+ * a dirty line is evicted. A write-through cache does not allocate on a write miss.
+ */
+class CacheMemoryDevice : public AMemoryDevice
+{
+    Q_OBJECT
+public:
+    enum class WritePolicy {
+        WRITE_BACK, WRITE_THROUGH
+    };
+    enum class ReplacementPolicy {
+        LRU, FIFO, RANDOM
+    };
+    struct Configuration {
+        // Number of bytes of data held by the cache.
+        quint32 size = 1024;
+        // Number of lines in each set. A value of 1 is a direct mapped cache.
+        quint32 associativity = 2;
+        // Number of bytes in each line.
+        quint32 lineSize = 16;
+        WritePolicy writePolicy = WritePolicy::WRITE_BACK;
+        ReplacementPolicy replacementPolicy = ReplacementPolicy::LRU;
+
+        // All sizes must be powers of two, and the cache may hold at most 64k.
+        // If the configuration is unusable, returns false and explains why in errorMessage.
+        bool isValid(QString& errorMessage) const;
+        // Parse a comma separated list of key=value pairs, where any key may be omitted, e.g.
+        // "size=1024,ways=2,line=16,write=back,replace=lru".
+        // write may be back or through, and replace may be lru, fifo, or random.
+        // Returns false and explains the problem in errorMessage if spec is malformed or invalid.
+        static bool fromString(const QString& spec, Configuration& config, QString& errorMessage);
+        QString toString() const;
+    };
+    struct Statistics {
+        quint64 readHits = 0, readMisses = 0;
+        quint64 writeHits = 0, writeMisses = 0;
+        // Number of valid lines replaced to make room for another line.
+        quint64 evictions = 0;
+        // Number of evicted lines that were dirty, and would be copied to memory.
+        quint64 writeBacks = 0;
+        // Number of reads and writes of addresses that are not cachable.
+        quint64 uncached = 0;
+        quint64 hits() const noexcept { return readHits + writeHits;}
+        quint64 misses() const noexcept { return readMisses + writeMisses;}
+    };
+
+    explicit CacheMemoryDevice(QSharedPointer<AMemoryDevice> device, Configuration configuration,
+                               QObject* parent = nullptr);
+    ~CacheMemoryDevice() override;
+
+    QSharedPointer<AMemoryDevice> getDevice() const noexcept;
+    const Configuration& getConfiguration() const noexcept;
+    const Statistics& getStatistics() const noexcept;
+    // Invalidate every line and zero the statistics, as if the machine was just switched on.
+    void reset() noexcept;
+    // Summarize the configuration and statistics of the cache in a few lines of text.
+    QString report() const;
+
+    // AMemoryDevice interface
+    quint32 maxAddress() const noexcept override;
+    bool isCachable(quint16 address) const noexcept override;
+    void setHeadless(bool headless) noexcept override;
+
+public slots:
+    // Clears the wrapped device, and resets the cache.
+    void clearMemory() override;
+    void onCycleStarted() override;
+    void onCycleFinished() override;
+    bool readByte(quint16 address, quint8 &output) const override;
+    bool writeByte(quint16 address, quint8 value) override;
+    bool getByte(quint16 address, quint8 &output) const override;
+    bool setByte(quint16 address, quint8 value) override;
+    // A word that straddles two lines accesses both of them.
+    bool readWord(quint16 address, quint16 &output) const override;
+    bool writeWord(quint16 address, quint16 value) override;
+    bool getWord(quint16 address, quint16 &output) const override;
+    bool setWord(quint16 address, quint16 value) override;
+
+private:
+    struct Line {
+        quint16 tag;
+        bool valid, dirty;
+        // Time of the last access for LRU, or of the fill for FIFO.
+        quint64 stamp;
+    };
+    QSharedPointer<AMemoryDevice> device;
+    Configuration configuration;
+    // The state of the cache changes on every read, which is a const operation.
+    mutable std::vector<Line> lines;
+    mutable Statistics statistics;
+    mutable quint64 clock;
+    mutable quint32 randomState;
+    int lineBits, setBits;
+    quint16 setMask;
+    // Id of the watcher forwarding changes made to the wrapped device.
+    int watcherId;
+
+    // Look up the line containing address, filling it if needed.
+    void access(quint16 address, bool write) const;
+    // Access the lines containing the first and last byte of a word.
+    void accessWord(quint16 address, bool write) const;
+    // Pick the way of set that will receive a new line.
+    quint32 victim(quint32 set) const;
+    // Take on any error the wrapped device reported during the last access.
+    void mirrorErrors() const;
+};
+
+#endif // CACHEMEMORYDEVICE_H
@@ -174,6 +174,10 @@ namespace Enu {
     };
     Q_ENUM_NS(EClockSignals);
 
+    // Number of control and clock signals, for sizing fixed length arrays of signals.
+    static const int controlSignalCount = PValid + 1;
+    static const int clockSignalCount = PValidCk + 1;
+
     enum EMemoryRegisters
     {
         MEM_MARA,MEM_MARB,MEM_MDR,MEM_MDRO,MEM_MDRE
@@ -0,0 +1,84 @@
+// File: inputsource.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "inputsource.h"
+
+AInputSource::~AInputSource()
+{
+
+}
+
+ByteArrayInputSource::ByteArrayInputSource(QByteArray input): buffer(input), cursor(0)
+{
+
+}
+
+ByteArrayInputSource::~ByteArrayInputSource()
+{
+
+}
+
+bool ByteArrayInputSource::nextByte(quint8 &value)
+{
+    if(cursor >= buffer.length()) return false;
+    value = static_cast<quint8>(buffer[cursor++]);
+    return true;
+}
+
+void ByteArrayInputSource::append(const QByteArray &input)
+{
+    // Drop consumed bytes before growing the buffer, so that the copy is
+    // amortized over the bytes that were read since the last append.
+    if(cursor > 0) {
+        buffer.remove(0, cursor);
+        cursor = 0;
+    }
+    buffer.append(input);
+}
+
+FileInputSource::FileInputSource(QString fileName): file(fileName), stream(), chunk(), cursor(0)
+{
+
+}
+
+FileInputSource::~FileInputSource()
+{
+    file.close();
+}
+
+bool FileInputSource::open()
+{
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+    stream.setDevice(&file);
+    return true;
+}
+
+bool FileInputSource::nextByte(quint8 &value)
+{
+    if(cursor >= chunk.length()) {
+        if(!file.isOpen() || stream.atEnd()) return false;
+        chunk = stream.read(chunkSize).toLatin1();
+        cursor = 0;
+        if(chunk.isEmpty()) return false;
+    }
+    value = static_cast<quint8>(chunk[cursor++]);
+    return true;
+}
@@ -0,0 +1,82 @@
+// File: inputsource.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+
+/*
+ * A source of bytes for memory mapped input. MainMemory queues sources for
+ * each input address, and draws one byte from them per request by an InputChip.
+ *
+ * Sources only ever move forward, so consuming n bytes takes O(n) time.
+ */
+class AInputSource
+{
+public:
+    virtual ~AInputSource();
+    // Remove the next byte from the source, and store it in value.
+    // Returns false if the source has been exhausted.
+    virtual bool nextByte(quint8& value) = 0;
+};
+
+/*
+ * Input held in memory, such as the contents of the batch input pane.
+ * Consumed bytes are discarded periodically rather than on every read.
+ */
+class ByteArrayInputSource : public AInputSource
+{
+    QByteArray buffer;
+    int cursor;
+public:
+    explicit ByteArrayInputSource(QByteArray input = QByteArray());
+    ~ByteArrayInputSource() override;
+    bool nextByte(quint8& value) override;
+    void append(const QByteArray& input);
+};
+
+/*
+ * Input streamed from a text file one chunk at a time, so that large input files
+ * need only a constant amount of memory. Text is decoded exactly as a QTextStream
+ * reading the whole file would, and then converted to Latin-1.
+ */
+class FileInputSource : public AInputSource
+{
+    QFile file;
+    QTextStream stream;
+    QByteArray chunk;
+    int cursor;
+public:
+    // Number of characters decoded from the file at a time.
+    static constexpr qint64 chunkSize = 1 << 16;
+
+    explicit FileInputSource(QString fileName);
+    ~FileInputSource() override;
+    // Returns false if the file could not be opened for reading.
+    bool open();
+    bool nextByte(quint8& value) override;
+};
+
+#endif // INPUTSOURCE_H
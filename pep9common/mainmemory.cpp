@@ -20,17 +20,27 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <QApplication>
+#include <algorithm>
+#include <cstring>
+
 #include <QDebug>
+#include <QtEndian>
 
 #include "amemorychip.h"
+#include "inputsource.h"
 #include "memorychips.h"
 #include "mainmemory.h"
+#include "writejournal.h"
 
 MainMemory::MainMemory(QObject* parent) noexcept: AMemoryDevice (parent), updateMemMap(true),
-    endChip(new NilChip(0xffff, 0, this)), addressToChipLookupTable(1 << 16), maxAddr(0)
+    endChip(new NilChip(0xffff, 0, this)), addressToChipLookupTable(1 << 16), maxAddr(0),
+    maxAddrValid(false), pageData(), pagePermissions(), snapshotActive(false),
+    snapshotLayoutChanged(false), restoringSnapshot(false), snapshotLayout(), snapshotBytesWritten(),
+    snapshotBytesSet(), snapshotContents(), snapshotPageSaved(), snapshotPageDirty(), journal(nullptr)
 {
-
+    // No chips are installed, so every page must take the slow path.
+    pageData.fill(nullptr);
+    pagePermissions.fill(PagePermissions::NONE);
 }
 
 MainMemory::~MainMemory()
@@ -40,6 +50,8 @@ MainMemory::~MainMemory()
 
 quint32 MainMemory::maxAddress() const noexcept
 {
+    // Only walk the chip map if a chip was inserted or removed since the last call.
+    if(maxAddrValid) return maxAddr;
     // The size of main memory is equal to the value of highest address + 1
     // ( + 1 since addresses start at 0, not 1). The highest address in a chip
     // is the address of the chip plus its size.
@@ -52,14 +64,20 @@ quint32 MainMemory::maxAddress() const noexcept
         }
     }
     maxAddr -= 1;
+    maxAddrValid = true;
     // Account for addresses starting at 0, not 1.
     return maxAddr;
 }
 
 void MainMemory::insertChip(QSharedPointer<AMemoryChip> chip, quint16 address)
 {
+    if(snapshotActive && !restoringSnapshot) {
+        preserveAllPages();
+        snapshotLayoutChanged = true;
+    }
     memoryChipMap.insert(address, chip);
     ptrLookup.insert(chip.get(), chip);
+    invalidateBounds();
     // Chip being passed in might be re-used from previous executions,
     // so make sure to explicitly reset its address to prevent mapping errors.
     chip->setBaseAddress(address);
@@ -94,6 +112,7 @@ void MainMemory::constructMemoryDevice(QList<MemoryChipSpec> specList)
 {
     // Prevent interim memory map updates, as many chips will be inserted and removed.
     autoUpdateMemoryMap(false);
+    invalidateBounds();
     // Cache all old memory chips and use them to construct new memory specification.
     auto chipCache = removeAllChips();
     for(auto spec : specList) {
@@ -153,16 +172,26 @@ QSharedPointer<AMemoryChip> MainMemory::removeChip(quint16 address)
     // If the user requested out internal "end chip" that blanks out unused
     // addresses, just return a nullptr.
     if(chip == endChip.get()) return QSharedPointer<AMemoryChip>(nullptr);
+    // The chip's contents must be saved while they are still reachable.
+    if(snapshotActive && !restoringSnapshot) {
+        preserveAllPages();
+        snapshotLayoutChanged = true;
+    }
     // Remove chip from lookup tables.
     // addressToChipLookupTable.remove(retVal->getBaseAddress());
     auto retVal = ptrLookup[chip];
     ptrLookup.remove(chip);
+    invalidateBounds();
     if(updateMemMap) calculateAddressToChip();
     return retVal;
 }
 
 QVector<QSharedPointer<AMemoryChip> > MainMemory::removeAllChips()
 {
+    if(snapshotActive && !restoringSnapshot) {
+        preserveAllPages();
+        snapshotLayoutChanged = true;
+    }
     auto temp = memoryChipMap.values();
     QVector<QSharedPointer<AMemoryChip> > retVal;
     for(auto it : temp) {
@@ -180,6 +209,7 @@ QVector<QSharedPointer<AMemoryChip> > MainMemory::removeAllChips()
     }
     memoryChipMap.clear();
     ptrLookup.clear();
+    invalidateBounds();
     if(updateMemMap) calculateAddressToChip();
     return retVal;
 }
@@ -191,22 +221,40 @@ void MainMemory::autoUpdateMemoryMap(bool update) noexcept
     if(updateMemMap) calculateAddressToChip();
 }
 
-void MainMemory::loadValues(quint16 address, QVector<quint8> values) noexcept
+void MainMemory::loadValues(quint16 address, const QVector<quint8>& values) noexcept
 {
     // Block signals being omitted, as it was causing issues with large heap sizes.
     bool block = signalsBlocked();
     blockSignals(true);
-    // For ever value in the values array that falls in range of the memory module.
-    for(quint16 idx = 0;idx < values.length()
-        && idx + address <= static_cast<qint32>(maxAddress()); idx++) {
-        bytesSet.insert(idx + address);
-        setByte(idx + address, values[idx]);
+    // Only copy values that fall in range of the memory module. If no memory is
+    // installed, maxAddress() + 1 wraps around to 0, and nothing is copied.
+    const quint32 end = std::min(static_cast<quint32>(address) + static_cast<quint32>(values.length()),
+                                 maxAddress() + 1);
+    const quint8* source = values.constData();
+    for(quint32 it = address; it < end;) {
+        quint16 pageAddr = static_cast<quint16>(it);
+        // Process the values up to the end of the current page in one step.
+        quint32 runEnd = std::min(end, (it | pageMask) + 1);
+        if(mustPreserve(pageAddr)) preservePage(pageAddr >> pageBits);
+        if(fastPage(pageAddr, PagePermissions::FAST_SET)) {
+            std::memcpy(fastAddress(pageAddr), source + (it - address), runEnd - it);
+            bytesSet.insertRange(pageAddr, static_cast<quint16>(runEnd - 1));
+            notifyWatcher(pageAddr, static_cast<quint16>(runEnd - 1));
+        }
+        else {
+            for(quint32 byte = it; byte < runEnd; byte++) {
+                bytesSet.insert(static_cast<quint16>(byte));
+                setByte(static_cast<quint16>(byte), source[byte - address]);
+            }
+        }
+        it = runEnd;
     }
     blockSignals(block);
 }
 
 void MainMemory::clearMemory()
 {
+    if(snapshotActive) preserveAllPages();
     // Inform each chip that it needs to be zero'ed out.
     for(auto chip : memoryChipMap) {
         chip->clear();
@@ -214,6 +262,7 @@ void MainMemory::clearMemory()
     // Cleared memory has no written or set bytes.
     bytesSet.clear();
     bytesWritten.clear();
+    notifyWatcher(0, 0xffff);
     // Remove pending error messages and pending IO.
     clearErrors();
     clearIO();
@@ -231,6 +280,11 @@ void MainMemory::onCycleFinished()
 
 bool MainMemory::readByte(quint16 address, quint8 &output) const
 {
+    // RAM and ROM reads have no side effects, so they can be served directly.
+    if(fastPage(address, PagePermissions::FAST_READ)) {
+        output = *fastAddress(address);
+        return true;
+    }
     const AMemoryChip *chip = chipAt(address);
     // Since IO can fail, wrap it in a try-catch.
     try {
@@ -260,11 +314,25 @@ bool MainMemory::readByte(quint16 address, quint8 &output) const
 
 bool MainMemory::writeByte(quint16 address, quint8 value)
 {
+    if(fastPage(address, PagePermissions::FAST_WRITE)) {
+        *fastAddress(address) = value;
+        bytesWritten.insert(address);
+        notifyWatcher(address, address);
+        if(!headless) emit changed(address, value);
+        return true;
+    }
+    // Pages are made fast again once they have been copied into the snapshot.
+    else if(mustPreserve(address)) {
+        preservePage(address >> pageBits);
+        return writeByte(address, value);
+    }
     AMemoryChip *chip = chipAt(address);
+    if(journal != nullptr) journalByte(chip, address);
     try {
         bool retVal = chip->writeByte(address - chip->getBaseAddress(), value);
         bytesWritten.insert(address);
-        emit changed(address, value);
+        notifyWatcher(address, address);
+        if(!headless) emit changed(address, value);
         return retVal;
     } catch (std::range_error& e) {
         error = true;
@@ -279,6 +347,10 @@ bool MainMemory::writeByte(quint16 address, quint8 value)
 
 bool MainMemory::getByte(quint16 address, quint8 &output) const
 {
+    if(fastPage(address, PagePermissions::FAST_READ)) {
+        output = *fastAddress(address);
+        return true;
+    }
     const AMemoryChip *chip = chipAt(address);
     try {
         bool retVal = chip->getByte(address - chip->getBaseAddress(), output);
@@ -296,11 +368,24 @@ bool MainMemory::getByte(quint16 address, quint8 &output) const
 
 bool MainMemory::setByte(quint16 address, quint8 value)
 {
+    if(fastPage(address, PagePermissions::FAST_SET)) {
+        *fastAddress(address) = value;
+        bytesSet.insert(address);
+        notifyWatcher(address, address);
+        if(!headless) emit changed(address, value);
+        return true;
+    }
+    else if(mustPreserve(address)) {
+        preservePage(address >> pageBits);
+        return setByte(address, value);
+    }
     AMemoryChip *chip = chipAt(address);
+    if(journal != nullptr) journalByte(chip, address);
     try {
         bool retVal = chip->setByte(address - chip->getBaseAddress(), value);
         bytesSet.insert(address);
-        emit changed(address, value);
+        notifyWatcher(address, address);
+        if(!headless) emit changed(address, value);
         return retVal;
     } catch (std::range_error& e) {
         error = true;
@@ -313,6 +398,62 @@ bool MainMemory::setByte(quint16 address, quint8 value)
     }
 }
 
+bool MainMemory::readWord(quint16 address, quint16 &output) const
+{
+    if(fastWord(address, PagePermissions::FAST_READ)) {
+        output = qFromBigEndian<quint16>(fastAddress(address));
+        return true;
+    }
+    // Word straddles a page boundary or touches a slow page.
+    return AMemoryDevice::readWord(address, output);
+}
+
+bool MainMemory::writeWord(quint16 address, quint16 value)
+{
+    if(fastWord(address, PagePermissions::FAST_WRITE)) {
+        qToBigEndian<quint16>(value, fastAddress(address));
+        bytesWritten.insert(address);
+        bytesWritten.insert(static_cast<quint16>(address + 1));
+        notifyWatcher(address, static_cast<quint16>(address + 1));
+        if(!headless) {
+            emit changed(address, static_cast<quint8>(value >> 8));
+            emit changed(static_cast<quint16>(address + 1), static_cast<quint8>(value & 0xff));
+        }
+        return true;
+    }
+    return AMemoryDevice::writeWord(address, value);
+}
+
+bool MainMemory::getWord(quint16 address, quint16 &output) const
+{
+    if(fastWord(address, PagePermissions::FAST_READ)) {
+        output = qFromBigEndian<quint16>(fastAddress(address));
+        return true;
+    }
+    return AMemoryDevice::getWord(address, output);
+}
+
+bool MainMemory::setWord(quint16 address, quint16 value)
+{
+    if(fastWord(address, PagePermissions::FAST_SET)) {
+        qToBigEndian<quint16>(value, fastAddress(address));
+        bytesSet.insert(address);
+        bytesSet.insert(static_cast<quint16>(address + 1));
+        notifyWatcher(address, static_cast<quint16>(address + 1));
+        if(!headless) {
+            emit changed(address, static_cast<quint8>(value >> 8));
+            emit changed(static_cast<quint16>(address + 1), static_cast<quint8>(value & 0xff));
+        }
+        return true;
+    }
+    return AMemoryDevice::setWord(address, value);
+}
+
+bool MainMemory::isCachable(quint16 address) const noexcept
+{
+    return chipAt(address)->isCachable();
+}
+
 void MainMemory::clearIO()
 {
     for(auto key : inputBuffer.keys()) {
@@ -321,12 +462,22 @@ void MainMemory::clearIO()
         InputChip* in = dynamic_cast<InputChip*>(chipAt(key));
         quint16 offsetFromBase = key - in->getBaseAddress();
         if(in->waitingForInput(offsetFromBase)) {
-            in->onInputCanceled(key);
+            in->onInputCanceled(offsetFromBase);
         }
     }
     for(auto address : waitingOnInput) {
         onInputCanceled(address);
     }
+    // A simulation on another thread may be waiting on a request that has not been delivered yet.
+    for(auto chip : memoryChipMap) {
+        if(chip->getChipType() != AMemoryChip::ChipTypes::IDEV) continue;
+        InputChip* in = dynamic_cast<InputChip*>(chip.get());
+        for(quint32 offset = 0; offset < in->getSize(); offset++) {
+            if(in->waitingForInput(static_cast<quint16>(offset))) {
+                in->onInputCanceled(static_cast<quint16>(offset));
+            }
+        }
+    }
     inputBuffer.clear();
     waitingOnInput.clear();
 }
@@ -344,6 +495,19 @@ void MainMemory::onInputReceived(quint16 address, QChar input)
 void MainMemory::onInputReceived(quint16 address, QString input)
 {
     if(input.isEmpty()) return;
+    // Extend an in-memory buffer rather than queueing a new source for each piece of input.
+    if(inputBuffer.contains(address) && !inputBuffer[address].isEmpty()) {
+        auto buffered = inputBuffer[address].last().dynamicCast<ByteArrayInputSource>();
+        if(!buffered.isNull()) {
+            buffered->append(input.toLatin1());
+            return;
+        }
+    }
+    onInputReceived(address, QSharedPointer<AInputSource>(new ByteArrayInputSource(input.toLatin1())));
+}
+
+void MainMemory::onInputReceived(quint16 address, QSharedPointer<AInputSource> input)
+{
     AMemoryChip *temp = chipAt(address);
     InputChip *chip;
     if(temp->getChipType() != AMemoryChip::ChipTypes::IDEV) {
@@ -352,18 +516,13 @@ void MainMemory::onInputReceived(quint16 address, QString input)
     else {
         chip = dynamic_cast<InputChip*>(temp);
     }
+    inputBuffer[address].append(input);
     quint16 offsetFromBase = address - chip->getBaseAddress();
-    if(chip->waitingForInput(offsetFromBase)) {
-        quint8 first = static_cast<quint8>(input.front().toLatin1());
-        QByteArray rest = input.mid(1,-1).toLatin1();
-        inputBuffer.insert(address, rest);
+    quint8 first;
+    if(chip->waitingForInput(offsetFromBase) && nextBufferedInput(address, first)) {
         chip->onInputReceived(offsetFromBase, first);
         // Now that the address has been served IO, it is not waiting anymore.
         waitingOnInput.remove(address);
-    } else if(inputBuffer.contains(address)) {
-        inputBuffer[address].append(input.toLatin1());
-    } else {
-        inputBuffer.insert(address, input.toLatin1());
     }
 }
 
@@ -391,20 +550,16 @@ void MainMemory::onInputAborted(quint16 address)
 
 void MainMemory::onChipInputRequested(quint16 address)
 {
-    if(inputBuffer.contains(address)) {
-        quint8 first = inputBuffer[address].front();
-        quint16 offsetFromBase = address - chipAt(address)->getBaseAddress();
-        inputBuffer[address].remove(0, 1);
-        if(inputBuffer[address].length() == 0) {
-            inputBuffer.remove(address);
-        }
+    quint16 offsetFromBase = address - chipAt(address)->getBaseAddress();
+    // If the simulation runs on another thread, the request may have been canceled before it was delivered.
+    if(!dynamic_cast<InputChip*>(chipAt(address))->waitingForInput(offsetFromBase)) return;
+    quint8 first;
+    if(nextBufferedInput(address, first)) {
         dynamic_cast<InputChip*>(chipAt(address))->onInputReceived(offsetFromBase, first);
     }
     else {
         waitingOnInput.insert(address);
         emit inputRequested(address);
-        // Make sure the signal is handled by the UI immediately
-        QApplication::processEvents();
     }
 }
 
@@ -413,6 +568,22 @@ void MainMemory::onChipOutputWritten(quint16 address, quint8 value)
     emit outputWritten(address, value);
 }
 
+bool MainMemory::nextBufferedInput(quint16 address, quint8 &value)
+{
+    auto sources = inputBuffer.find(address);
+    if(sources == inputBuffer.end()) return false;
+    while(!sources->isEmpty()) {
+        if(sources->first()->nextByte(value)) {
+            // The simulation waits inside the step that requested the input, so the byte belongs to that step.
+            if(journal != nullptr && journal->isRecording()) journal->recordInput(address, value);
+            return true;
+        }
+        sources->removeFirst();
+    }
+    inputBuffer.erase(sources);
+    return false;
+}
+
 void MainMemory::calculateAddressToChip() noexcept
 {
     for (int it = 0; it < addressToChipLookupTable.size(); it++) {
@@ -425,5 +596,170 @@ void MainMemory::calculateAddressToChip() noexcept
             addressToChipLookupTable[static_cast<int>(it)] = chip.get();
         }
     }
+    calculatePageTable();
     maxAddress();
 }
+
+void MainMemory::invalidateBounds() noexcept
+{
+    maxAddrValid = false;
+}
+
+void MainMemory::calculatePageTable() noexcept
+{
+    for(quint32 page = 0; page < pageCount; page++) {
+        calculatePage(page);
+    }
+    // The memory map changed, so anything cached about it is stale.
+    notifyWatcher(0, 0xffff);
+}
+
+void MainMemory::calculatePage(quint32 page) noexcept
+{
+    pageData[page] = nullptr;
+    pagePermissions[page] = PagePermissions::NONE;
+    quint32 pageStart = page << pageBits;
+    AMemoryChip* chip = addressToChipLookupTable[static_cast<int>(pageStart)];
+    // Only chips that expose their storage (RAM, ROM) are eligible.
+    if(chip == nullptr || chip->getBackingStore() == nullptr) return;
+    // Every address on the page must belong to the same chip, otherwise
+    // some accesses on the page would be routed to the wrong chip.
+    for(quint32 it = pageStart; it < pageStart + (1 << pageBits); it++) {
+        if(addressToChipLookupTable[static_cast<int>(it)] != chip) return;
+    }
+    pageData[page] = chip->getBackingStore() + (pageStart - chip->getBaseAddress());
+    // Reads and sets never have side effects on RAM / ROM, but writes to
+    // ROM are silently discarded, so let the chip handle those.
+    quint8 perms = PagePermissions::FAST_READ | PagePermissions::FAST_SET;
+    if(chip->getIOFunctions() & AMemoryChip::WRITE) perms |= PagePermissions::FAST_WRITE;
+    // Route the first modification of the page through preservePage(), and
+    // every modification through the journal.
+    if((snapshotActive && !snapshotPageDirty[page]) || journal != nullptr) perms &= PagePermissions::FAST_READ;
+    pagePermissions[page] = perms;
+}
+
+void MainMemory::takeSnapshot()
+{
+    snapshotActive = true;
+    snapshotLayoutChanged = false;
+    snapshotLayout.clear();
+    for(auto chip : memoryChipMap) {
+        snapshotLayout.append({chip->getChipType(), chip->getBaseAddress(), chip->getSize()});
+    }
+    snapshotBytesWritten = bytesWritten;
+    snapshotBytesSet = bytesSet;
+    // Allocated once, and reused by later snapshots.
+    if(snapshotContents.isEmpty()) snapshotContents.resize(1 << 16);
+    snapshotPageSaved.fill(false);
+    snapshotPageDirty.fill(false);
+    for(quint32 page = 0; page < pageCount; page++) {
+        pagePermissions[page] &= PagePermissions::FAST_READ;
+    }
+}
+
+bool MainMemory::restoreSnapshot()
+{
+    if(!snapshotActive) return false;
+    clearErrors();
+    clearIO();
+    if(snapshotLayoutChanged) {
+        // Every page was saved when the layout first changed, so all will be copied back below.
+        restoringSnapshot = true;
+        constructMemoryDevice(snapshotLayout);
+        restoringSnapshot = false;
+        snapshotLayoutChanged = false;
+    }
+    for(quint32 page = 0; page < pageCount; page++) {
+        if(!snapshotPageDirty[page]) continue;
+        const quint16 first = static_cast<quint16>(page << pageBits);
+        const quint16 last = first | pageMask;
+        if(pageData[page] != nullptr) {
+            std::memcpy(pageData[page], snapshotContents.constData() + first, 1 << pageBits);
+        }
+        else {
+            // Only RAM / ROM are part of the snapshot, the state of IO chips is left as is.
+            for(quint32 address = first; address <= last; address++) {
+                AMemoryChip* chip = chipAt(static_cast<quint16>(address));
+                auto type = chip->getChipType();
+                if(type != AMemoryChip::ChipTypes::RAM && type != AMemoryChip::ChipTypes::ROM) continue;
+                chip->setByte(static_cast<quint16>(address - chip->getBaseAddress()), snapshotContents[static_cast<int>(address)]);
+            }
+        }
+        snapshotPageDirty[page] = false;
+        calculatePage(page);
+        notifyWatcher(first, last);
+    }
+    bytesWritten = snapshotBytesWritten;
+    bytesSet = snapshotBytesSet;
+    return true;
+}
+
+void MainMemory::discardSnapshot() noexcept
+{
+    snapshotActive = false;
+    // Contents and layout are unchanged, so there is no need to notify the watcher.
+    for(quint32 page = 0; page < pageCount; page++) {
+        calculatePage(page);
+    }
+}
+
+bool MainMemory::hasSnapshot() const noexcept
+{
+    return snapshotActive;
+}
+
+void MainMemory::setJournal(WriteJournal *journal) noexcept
+{
+    this->journal = journal;
+    for(quint32 page = 0; page < pageCount; page++) {
+        calculatePage(page);
+    }
+}
+
+void MainMemory::unreadInput(quint16 address, quint8 value)
+{
+    inputBuffer[address].prepend(QSharedPointer<AInputSource>(
+                                     new ByteArrayInputSource(QByteArray(1, static_cast<char>(value)))));
+}
+
+void MainMemory::journalByte(const AMemoryChip *chip, quint16 address)
+{
+    if(!journal->isRecording()) return;
+    // Output can't be taken back, and input is journaled as it is consumed, so only storage is journaled here.
+    auto type = chip->getChipType();
+    if(type != AMemoryChip::ChipTypes::RAM && type != AMemoryChip::ChipTypes::ROM) return;
+    quint8 oldValue = 0;
+    chip->getByte(static_cast<quint16>(address - chip->getBaseAddress()), oldValue);
+    journal->recordMemory(address, oldValue);
+}
+
+void MainMemory::preservePage(quint32 page) noexcept
+{
+    if(!snapshotPageSaved[page]) {
+        const quint32 first = page << pageBits;
+        if(pageData[page] != nullptr) {
+            std::memcpy(snapshotContents.data() + first, pageData[page], 1 << pageBits);
+        }
+        else {
+            for(quint32 address = first; address < first + (1 << pageBits); address++) {
+                const AMemoryChip* chip = chipAt(static_cast<quint16>(address));
+                auto type = chip->getChipType();
+                quint8 value = 0;
+                if(type == AMemoryChip::ChipTypes::RAM || type == AMemoryChip::ChipTypes::ROM) {
+                    chip->getByte(static_cast<quint16>(address - chip->getBaseAddress()), value);
+                }
+                snapshotContents[static_cast<int>(address)] = value;
+            }
+        }
+        snapshotPageSaved[page] = true;
+    }
+    snapshotPageDirty[page] = true;
+    calculatePage(page);
+}
+
+void MainMemory::preserveAllPages() noexcept
+{
+    for(quint32 page = 0; page < pageCount; page++) {
+        if(!snapshotPageDirty[page]) preservePage(page);
+    }
+}
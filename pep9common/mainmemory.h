@@ -22,15 +22,20 @@
 #ifndef MAINMEMORY_H
 #define MAINMEMORY_H
 
+#include <array>
+
 #include <QMap>
 #include <QObject>
+#include <QSet>
 #include <QSharedPointer>
 #include <QVector>
 
 #include "amemorychip.h"
 #include "amemorydevice.h"
+class AInputSource;
 class AMemoryChip;
 class NilChip;
+class WriteJournal;
 
 /*
  * Structure that specifies the locatiocation & size
@@ -59,11 +64,47 @@ class MainMemory : public AMemoryDevice
     QMap<quint16, QSharedPointer<AMemoryChip>> memoryChipMap;
     QMap<AMemoryChip*, QSharedPointer<AMemoryChip>> ptrLookup;
     // Buffer input for particular addresses (needed for batch character input).
-    mutable QMap<quint16, QByteArray> inputBuffer;
+    // Sources are consumed in order, and removed once exhausted.
+    mutable QMap<quint16, QList<QSharedPointer<AInputSource>>> inputBuffer;
     // A list of all memory locations that have a pending input request.
     mutable QSet<quint16> waitingOnInput;
-    // Highest accessible address in memory.
+    // Highest accessible address in memory. Computing it requires a walk over
+    // all installed chips, so it is cached until the memory map changes.
     mutable quint32 maxAddr;
+    mutable bool maxAddrValid;
+
+    // Memory is divided into pages of 2^pageBits bytes. A page that is
+    // entirely contained in a single RAM or ROM chip is accessed directly
+    // through pageData, skipping chip lookup, virtual dispatch, and exception
+    // handling. All other pages (IO, nil, and partially-filled pages) use the
+    // chip-based slow path.
+    static constexpr quint8 pageBits = 8;
+    static constexpr quint16 pageMask = (1 << pageBits) - 1;
+    static constexpr quint32 pageCount = (1 << 16) >> pageBits;
+    enum PagePermissions: quint8 {
+        NONE = 0, FAST_READ = 1<<0, FAST_WRITE = 1<<1, FAST_SET = 1<<2
+    };
+    // Pointer to the first byte of each page in its chip's backing store,
+    // or nullptr if the page must take the slow path.
+    std::array<quint8*, pageCount> pageData;
+    // Operations that may be performed on each page via pageData.
+    std::array<quint8, pageCount> pagePermissions;
+
+    // Copy-on-write snapshot of memory. While a snapshot is active, a page loses its fast
+    // write / set permissions until it is first modified, at which point its contents are
+    // copied into snapshotContents and the page is marked dirty.
+    bool snapshotActive, snapshotLayoutChanged, restoringSnapshot;
+    QList<MemoryChipSpec> snapshotLayout;
+    MemoryBitmap snapshotBytesWritten, snapshotBytesSet;
+    // Contents of memory when the snapshot was taken, valid only for saved pages.
+    QVector<quint8> snapshotContents;
+    // Pages whose contents have been copied, and pages that may differ from the snapshot.
+    std::array<bool, pageCount> snapshotPageSaved, snapshotPageDirty;
+
+    // Receives the old value of every RAM / ROM byte modified while it is recording, or nullptr.
+    // While attached, every page loses its fast write / set permissions, so that the fast
+    // paths need not check for it.
+    WriteJournal* journal;
 
 public:
     explicit MainMemory(QObject* parent = nullptr) noexcept;
@@ -100,7 +141,29 @@ public:
     void autoUpdateMemoryMap(bool update) noexcept;
 
     // Copies the bytes from values into main memory starting at address.
-    void loadValues(quint16 address, QVector<quint8> values) noexcept;
+    // Runs of bytes that fall on RAM / ROM pages are copied in bulk.
+    void loadValues(quint16 address, const QVector<quint8>& values) noexcept;
+
+    // Record the chip layout and the contents of RAM / ROM, so that restoreSnapshot()
+    // may return to them. Replaces any previous snapshot. Pages are copied lazily, the
+    // first time each is modified, so the cost of taking a snapshot doesn't depend on
+    // how much memory is installed. Changing the chip layout copies every page.
+    void takeSnapshot();
+    // Return memory to the state recorded by takeSnapshot(), copying back only the pages
+    // modified since the snapshot was taken or last restored. Outstanding IO is canceled,
+    // and no changed(...) signals are emitted. Returns false if there is no snapshot.
+    // The snapshot remains active, so that it may be restored again.
+    bool restoreSnapshot();
+    void discardSnapshot() noexcept;
+    bool hasSnapshot() const noexcept;
+
+    // Record the old values of bytes modified by writes and sets in journal, along with every byte
+    // of buffered input consumed. The journal is not owned by memory, and must be detached
+    // (by passing nullptr) before it is deleted.
+    void setJournal(WriteJournal* journal) noexcept;
+    // Return a consumed byte of input to the front of address's buffer, so that it will be read again.
+    // Bytes must be returned in the reverse of the order in which they were consumed.
+    void unreadInput(quint16 address, quint8 value);
 
 public slots:
     // Set the values in all memory chips to 0, clear all outstanding IO operations.
@@ -115,6 +178,14 @@ public slots:
     bool writeByte(quint16 address, quint8 value) override;
     bool getByte(quint16 address, quint8 &output) const override;
     bool setByte(quint16 address, quint8 value) override;
+    // When both bytes of a word lie on the same fast page, access the
+    // word with a single load / store.
+    bool readWord(quint16 address, quint16 &output) const override;
+    bool writeWord(quint16 address, quint16 value) override;
+    bool getWord(quint16 address, quint16 &output) const override;
+    bool setWord(quint16 address, quint16 value) override;
+    // RAM and ROM are cachable, while IO and unmapped addresses are not.
+    bool isCachable(quint16 address) const noexcept override;
 
     // Clear any saved input, and cancel any outstanding IO requests.
     void clearIO();
@@ -124,6 +195,8 @@ public slots:
     void onInputReceived(quint16 address, quint8 input);
     void onInputReceived(quint16 address, QChar input);
     void onInputReceived(quint16 address, QString input);
+    // Queue a source whose bytes are delivered after any input already buffered for address.
+    void onInputReceived(quint16 address, QSharedPointer<AInputSource> input);
 
     void onInputCanceled(quint16 address);
     void onInputAborted(quint16 address);
@@ -137,7 +210,39 @@ protected slots:
     void onChipOutputWritten(quint16 address, quint8 value);
 
 private:
+    // Remove the next buffered byte of input for address. Returns false if there is none.
+    bool nextBufferedInput(quint16 address, quint8& value);
     void calculateAddressToChip() noexcept;
+    // Mark the cached memory bounds as stale after the chip layout changed.
+    void invalidateBounds() noexcept;
+    // Rebuild the page table from addressToChipLookupTable.
+    void calculatePageTable() noexcept;
+    // Compute the page table entry for a single page.
+    void calculatePage(quint32 page) noexcept;
+    // Copy the page into the snapshot if it hasn't been already, and allow it to be modified.
+    void preservePage(quint32 page) noexcept;
+    // Preserve every page, before chips are removed from memory.
+    void preserveAllPages() noexcept;
+    // Record the current value of address in the journal, if it belongs to RAM / ROM.
+    void journalByte(const AMemoryChip* chip, quint16 address);
+    inline bool mustPreserve(quint16 address) const noexcept
+    {
+        return snapshotActive && !snapshotPageDirty[address >> pageBits];
+    }
+    // Returns true if the page holding address allows the requested operation(s)
+    // via the fast path, and if the word starting at address doesn't cross a page.
+    inline bool fastPage(quint16 address, quint8 permission) const noexcept
+    {
+        return pagePermissions[address >> pageBits] & permission;
+    }
+    inline bool fastWord(quint16 address, quint8 permission) const noexcept
+    {
+        return (address & pageMask) != pageMask && fastPage(address, permission);
+    }
+    inline quint8* fastAddress(quint16 address) const noexcept
+    {
+        return pageData[address >> pageBits] + (address & pageMask);
+    }
 };
 
 #endif // MAINMEMORY_H
@@ -0,0 +1,263 @@
+// File: memoryaccesstrace.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "memoryaccesstrace.h"
+
+#include <QThread>
+
+#include "registerfile.h"
+
+namespace {
+// Append delta, interpreted as a signed difference, as a zigzag encoded LEB128 varint.
+// Small differences in either direction take a single byte.
+inline void appendDelta(QByteArray& output, quint16 delta)
+{
+    int signedDelta = static_cast<qint16>(delta);
+    quint32 zigzag = static_cast<quint32>(signedDelta < 0 ? -2 * signedDelta - 1 : 2 * signedDelta);
+    while(zigzag >= 0x80) {
+        output.append(static_cast<char>((zigzag & 0x7f) | 0x80));
+        zigzag >>= 7;
+    }
+    output.append(static_cast<char>(zigzag));
+}
+}
+
+MemoryAccessTraceWriter::MemoryAccessTraceWriter(QString fileName): buffer(capacity), head(0), cachedTail(0),
+    tail(0), stopping(false), file(fileName), writer(nullptr), writeError(false), lastPC(0), nextAddress(0)
+{
+
+}
+
+MemoryAccessTraceWriter::~MemoryAccessTraceWriter()
+{
+    close();
+}
+
+bool MemoryAccessTraceWriter::open()
+{
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    file.write(reinterpret_cast<const char*>(magic), sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    writer = QThread::create([this](){drain();});
+    writer->start();
+    return true;
+}
+
+bool MemoryAccessTraceWriter::close()
+{
+    if(writer == nullptr) return !writeError;
+    stopping.store(true, std::memory_order_release);
+    writer->wait();
+    delete writer;
+    writer = nullptr;
+    writeError |= !file.flush();
+    file.close();
+    return !writeError;
+}
+
+quint64 MemoryAccessTraceWriter::getAccessCount() const noexcept
+{
+    return head.load(std::memory_order_relaxed);
+}
+
+void MemoryAccessTraceWriter::waitForSpace(quint64 index)
+{
+    // The writer is a whole buffer behind, so give it the processor until it catches up.
+    while(index - (cachedTail = tail.load(std::memory_order_acquire)) == capacity) {
+        QThread::yieldCurrentThread();
+    }
+}
+
+void MemoryAccessTraceWriter::drain()
+{
+    // Encoded records are written in large chunks, rather than one system call per access.
+    static const int chunkSize = 1 << 16;
+    QByteArray chunk;
+    chunk.reserve(chunkSize + 16);
+    quint64 index = tail.load(std::memory_order_relaxed);
+    forever {
+        quint64 end = head.load(std::memory_order_acquire);
+        if(index == end) {
+            // Every access recorded before stopping was set is visible once it is observed.
+            if(stopping.load(std::memory_order_acquire)
+                    && index == head.load(std::memory_order_acquire)) break;
+            QThread::usleep(100);
+            continue;
+        }
+        for(; index != end; index++) {
+            encode(buffer[index & mask], chunk);
+            if(chunk.size() >= chunkSize) {
+                writeError |= file.write(chunk) != chunk.size();
+                chunk.clear();
+            }
+        }
+        tail.store(index, std::memory_order_release);
+    }
+    writeError |= file.write(chunk) != chunk.size();
+}
+
+void MemoryAccessTraceWriter::encode(const Access &access, QByteArray &output)
+{
+    quint8 tag = access.flags;
+    quint16 pcDelta = static_cast<quint16>(access.pc - lastPC);
+    quint16 addressDelta = static_cast<quint16>(access.address - nextAddress);
+    if(pcDelta != 0) tag |= pcFlag;
+    if(addressDelta != 0) tag |= addressFlag;
+    output.append(static_cast<char>(tag));
+    if(pcDelta != 0) appendDelta(output, pcDelta);
+    if(addressDelta != 0) appendDelta(output, addressDelta);
+    bool word = access.flags & wordFlag;
+    if(word) output.append(static_cast<char>(access.value >> 8));
+    output.append(static_cast<char>(access.value & 0xff));
+    lastPC = access.pc;
+    nextAddress = static_cast<quint16>(access.address + (word ? 2 : 1));
+}
+
+TracingMemoryDevice::TracingMemoryDevice(QSharedPointer<AMemoryDevice> device, QObject *parent):
+    AMemoryDevice(parent), device(device), writer(nullptr), registers(nullptr), watcherId(-1)
+{
+    // Consumers watch this device, so pass along every change made to the wrapped device.
+    watcherId = this->device->addWriteWatcher([this](quint16 first, quint16 last){notifyWatcher(first, last);});
+    this->device->watchRange(watcherId, 0, 0xffff);
+}
+
+TracingMemoryDevice::~TracingMemoryDevice()
+{
+    device->removeWriteWatcher(watcherId);
+}
+
+void TracingMemoryDevice::setWriter(MemoryAccessTraceWriter *writer) noexcept
+{
+    this->writer = writer;
+}
+
+void TracingMemoryDevice::setProgramCounterSource(const RegisterFile *registers) noexcept
+{
+    this->registers = registers;
+}
+
+QSharedPointer<AMemoryDevice> TracingMemoryDevice::getDevice() const noexcept
+{
+    return device;
+}
+
+quint32 TracingMemoryDevice::maxAddress() const noexcept
+{
+    return device->maxAddress();
+}
+
+bool TracingMemoryDevice::isCachable(quint16 address) const noexcept
+{
+    return device->isCachable(address);
+}
+
+void TracingMemoryDevice::setHeadless(bool headless) noexcept
+{
+    AMemoryDevice::setHeadless(headless);
+    device->setHeadless(headless);
+}
+
+void TracingMemoryDevice::clearMemory()
+{
+    device->clearMemory();
+    clearErrors();
+}
+
+void TracingMemoryDevice::onCycleStarted()
+{
+    device->onCycleStarted();
+}
+
+void TracingMemoryDevice::onCycleFinished()
+{
+    device->onCycleFinished();
+}
+
+bool TracingMemoryDevice::readByte(quint16 address, quint8 &output) const
+{
+    bool retVal = device->readByte(address, output);
+    record(MemoryAccessTraceWriter::AccessKind::READ, false, address, output);
+    return retVal;
+}
+
+bool TracingMemoryDevice::writeByte(quint16 address, quint8 value)
+{
+    bool retVal = device->writeByte(address, value);
+    record(MemoryAccessTraceWriter::AccessKind::WRITE, false, address, value);
+    return retVal;
+}
+
+bool TracingMemoryDevice::getByte(quint16 address, quint8 &output) const
+{
+    bool retVal = device->getByte(address, output);
+    record(MemoryAccessTraceWriter::AccessKind::GET, false, address, output);
+    return retVal;
+}
+
+bool TracingMemoryDevice::setByte(quint16 address, quint8 value)
+{
+    bool retVal = device->setByte(address, value);
+    record(MemoryAccessTraceWriter::AccessKind::SET, false, address, value);
+    return retVal;
+}
+
+bool TracingMemoryDevice::readWord(quint16 address, quint16 &output) const
+{
+    bool retVal = device->readWord(address, output);
+    record(MemoryAccessTraceWriter::AccessKind::READ, true, address, output);
+    return retVal;
+}
+
+bool TracingMemoryDevice::writeWord(quint16 address, quint16 value)
+{
+    bool retVal = device->writeWord(address, value);
+    record(MemoryAccessTraceWriter::AccessKind::WRITE, true, address, value);
+    return retVal;
+}
+
+bool TracingMemoryDevice::getWord(quint16 address, quint16 &output) const
+{
+    bool retVal = device->getWord(address, output);
+    record(MemoryAccessTraceWriter::AccessKind::GET, true, address, output);
+    return retVal;
+}
+
+bool TracingMemoryDevice::setWord(quint16 address, quint16 value)
+{
+    bool retVal = device->setWord(address, value);
+    record(MemoryAccessTraceWriter::AccessKind::SET, true, address, value);
+    return retVal;
+}
+
+void TracingMemoryDevice::record(MemoryAccessTraceWriter::AccessKind kind, bool word,
+                                 quint16 address, quint16 value) const
+{
+    if(writer != nullptr) {
+        quint16 pc = registers == nullptr ? 0 : registers->readRegisterWordStart(Enu::CPURegisters::PC);
+        writer->record(kind, word, pc, address, value);
+    }
+    // The CPU only checks this device for errors, and only clears this device's errors.
+    if(device->hadError()) {
+        error = true;
+        errorMessage = device->getErrorMessage();
+        device->clearErrors();
+    }
+}
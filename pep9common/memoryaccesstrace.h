@@ -0,0 +1,162 @@
+// File: memoryaccesstrace.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MEMORYACCESSTRACE_H
+#define MEMORYACCESSTRACE_H
+
+#include <atomic>
+#include <vector>
+
+#include <QFile>
+#include <QSharedPointer>
+
+#include "amemorydevice.h"
+class QThread;
+class RegisterFile;
+
+/*
+ * Streams memory accesses to a compact binary file. The simulation thread appends accesses to a
+ * single-producer, single-consumer ring buffer, which a background thread drains and encodes.
+ * Recording an access is a handful of plain stores and one atomic store, and only waits if the
+ * writer falls a full buffer behind.
+ *
+ * File format: the 4 byte magic "P9MT" and a version byte (1), followed by one record per access.
+ * Each record starts with a tag byte:
+ *     bits 0-1: access kind (0 read, 1 write, 2 get, 3 set)
+ *     bit  2:   the access was a word, rather than a byte
+ *     bit  3:   a PC delta follows
+ *     bit  4:   an address delta follows
+ * Deltas are signed 16 bit differences, zigzag encoded as unsigned LEB128 varints. The PC delta is
+ * relative to the PC of the previous record, and is omitted when it is 0. The address delta is
+ * relative to the address following the previous access (its address plus its width), so runs of
+ * sequential accesses such as instruction fetches omit it. Both start from 0. The record ends with
+ * the value read or written, 1 or 2 bytes big endian.
+ */
+class MemoryAccessTraceWriter
+{
+public:
+    enum class AccessKind: quint8
+    {
+        READ = 0, WRITE = 1, GET = 2, SET = 3
+    };
+    static constexpr quint8 magic[4] = {'P', '9', 'M', 'T'};
+    static constexpr quint8 version = 1;
+
+    explicit MemoryAccessTraceWriter(QString fileName);
+    // Finishes writing the file, if that has not been done yet.
+    ~MemoryAccessTraceWriter();
+    // Create the file and start the background writer. Returns false if the file could not be opened.
+    bool open();
+    // Wait for every recorded access to be written, and close the file.
+    // Returns false if any part of the trace could not be written.
+    bool close();
+    quint64 getAccessCount() const noexcept;
+
+    inline void record(AccessKind kind, bool word, quint16 pc, quint16 address, quint16 value)
+    {
+        quint64 index = head.load(std::memory_order_relaxed);
+        if(index - cachedTail == capacity) waitForSpace(index);
+        buffer[index & mask] = {pc, address, value,
+                                static_cast<quint8>(static_cast<quint8>(kind) | (word ? wordFlag : 0))};
+        head.store(index + 1, std::memory_order_release);
+    }
+
+private:
+    struct Access
+    {
+        quint16 pc, address, value;
+        quint8 flags;
+    };
+    static constexpr quint8 wordFlag = 1 << 2, pcFlag = 1 << 3, addressFlag = 1 << 4;
+    // Number of accesses the buffer holds. Must be a power of 2.
+    static constexpr quint64 capacity = 1 << 16;
+    static constexpr quint64 mask = capacity - 1;
+    std::vector<Access> buffer;
+    // Producer and consumer positions are kept on separate cache lines, so that they do not
+    // contend with each other. The producer caches the consumer's position, and only re-reads
+    // it when the buffer appears full.
+    alignas(64) std::atomic<quint64> head;
+    quint64 cachedTail;
+    alignas(64) std::atomic<quint64> tail;
+    std::atomic<bool> stopping;
+
+    QFile file;
+    QThread* writer;
+    bool writeError;
+    // Encoder state, owned by the writer thread.
+    quint16 lastPC, nextAddress;
+
+    void waitForSpace(quint64 index);
+    // Body of the writer thread.
+    void drain();
+    void encode(const Access& access, QByteArray& output);
+};
+
+/*
+ * A memory device that forwards every access to another device, recording each read, write,
+ * get, and set in a MemoryAccessTraceWriter along with the PC of the instruction performing it.
+ *
+ * Errors, and changes reported to write watchers, are mirrored from the wrapped device. Memory
+ * mapped IO signals are not, so IO must still be connected to the wrapped device.
+ */
+class TracingMemoryDevice : public AMemoryDevice
+{
+    Q_OBJECT
+public:
+    explicit TracingMemoryDevice(QSharedPointer<AMemoryDevice> device, QObject* parent = nullptr);
+    ~TracingMemoryDevice() override;
+
+    // Accesses are only recorded while a writer is attached. The writer is not owned by the device.
+    void setWriter(MemoryAccessTraceWriter* writer) noexcept;
+    // The start PC of registers is recorded with each access, which is the address of
+    // the instruction being executed by an IsaCpu. Records 0 if not set.
+    void setProgramCounterSource(const RegisterFile* registers) noexcept;
+    QSharedPointer<AMemoryDevice> getDevice() const noexcept;
+
+    // AMemoryDevice interface
+    quint32 maxAddress() const noexcept override;
+    bool isCachable(quint16 address) const noexcept override;
+    void setHeadless(bool headless) noexcept override;
+
+public slots:
+    void clearMemory() override;
+    void onCycleStarted() override;
+    void onCycleFinished() override;
+    bool readByte(quint16 address, quint8 &output) const override;
+    bool writeByte(quint16 address, quint8 value) override;
+    bool getByte(quint16 address, quint8 &output) const override;
+    bool setByte(quint16 address, quint8 value) override;
+    bool readWord(quint16 address, quint16 &output) const override;
+    bool writeWord(quint16 address, quint16 value) override;
+    bool getWord(quint16 address, quint16 &output) const override;
+    bool setWord(quint16 address, quint16 value) override;
+
+private:
+    QSharedPointer<AMemoryDevice> device;
+    MemoryAccessTraceWriter* writer;
+    const RegisterFile* registers;
+    // Id of the watcher forwarding changes made to the wrapped device.
+    int watcherId;
+    // Record an access, and take on any error it caused in the wrapped device.
+    void record(MemoryAccessTraceWriter::AccessKind kind, bool word, quint16 address, quint16 value) const;
+};
+
+#endif // MEMORYACCESSTRACE_H
@@ -0,0 +1,161 @@
+// File: memorybitmap.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "memorybitmap.h"
+
+#include <algorithm>
+#include <QtAlgorithms>
+
+static constexpr quint32 addressCount = 1 << 16;
+
+MemoryBitmap::MemoryBitmap() noexcept: blocks(), summary()
+{
+
+}
+
+void MemoryBitmap::insertRange(quint16 first, quint16 last) noexcept
+{
+    for(quint32 address = first; address <= last;) {
+        const quint32 block = address / blockBits;
+        const quint32 lowBit = address % blockBits;
+        const quint32 highBit = std::min(blockBits - 1, last - block * blockBits);
+        // Set bits lowBit through highBit inclusive.
+        quint64 mask = ~quint64(0) << lowBit;
+        if(highBit != blockBits - 1) mask &= (quint64(1) << (highBit + 1)) - 1;
+        blocks[block] |= mask;
+        summary[block / blockBits] |= quint64(1) << (block % blockBits);
+        address = (block + 1) * blockBits;
+    }
+}
+
+void MemoryBitmap::removeRange(quint16 first, quint16 last) noexcept
+{
+    for(quint32 address = first; address <= last;) {
+        const quint32 block = address / blockBits;
+        const quint32 lowBit = address % blockBits;
+        const quint32 highBit = std::min(blockBits - 1, last - block * blockBits);
+        // Clear bits lowBit through highBit inclusive.
+        quint64 mask = ~quint64(0) << lowBit;
+        if(highBit != blockBits - 1) mask &= (quint64(1) << (highBit + 1)) - 1;
+        blocks[block] &= ~mask;
+        // The summary must not claim that an empty block holds any addresses.
+        if(blocks[block] == 0) summary[block / blockBits] &= ~(quint64(1) << (block % blockBits));
+        address = (block + 1) * blockBits;
+    }
+}
+
+bool MemoryBitmap::intersects(quint16 first, quint16 last) const noexcept
+{
+    return findNextSet(first) <= last;
+}
+
+bool MemoryBitmap::isEmpty() const noexcept
+{
+    for(auto word : summary) {
+        if(word != 0) return false;
+    }
+    return true;
+}
+
+quint32 MemoryBitmap::count() const noexcept
+{
+    quint32 total = 0;
+    for(auto word : blocks) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+void MemoryBitmap::clear() noexcept
+{
+    // Only zero blocks known to be in use, which is much cheaper for sparse sets.
+    for(quint32 index = 0; index < summaryCount; index++) {
+        quint64 word = summary[index];
+        while(word != 0) {
+            blocks[index * blockBits + qCountTrailingZeroBits(word)] = 0;
+            word &= word - 1;
+        }
+        summary[index] = 0;
+    }
+}
+
+MemoryBitmap &MemoryBitmap::unite(const MemoryBitmap &other) noexcept
+{
+    for(quint32 index = 0; index < summaryCount; index++) {
+        quint64 word = other.summary[index];
+        summary[index] |= word;
+        while(word != 0) {
+            const quint32 block = index * blockBits + qCountTrailingZeroBits(word);
+            blocks[block] |= other.blocks[block];
+            word &= word - 1;
+        }
+    }
+    return *this;
+}
+
+quint32 MemoryBitmap::findNextSet(quint32 start) const noexcept
+{
+    if(start >= addressCount) return addressCount;
+    quint32 block = start / blockBits;
+    // Check the remainder of the block containing start.
+    quint64 bits = blocks[block] & (~quint64(0) << (start % blockBits));
+    if(bits != 0) return block * blockBits + qCountTrailingZeroBits(bits);
+    // Use the summary to skip over empty blocks.
+    block++;
+    for(quint32 index = block / blockBits; index < summaryCount; index++) {
+        quint64 word = summary[index];
+        if(index == block / blockBits) word &= ~quint64(0) << (block % blockBits);
+        if(word != 0) {
+            const quint32 found = index * blockBits + qCountTrailingZeroBits(word);
+            return found * blockBits + qCountTrailingZeroBits(blocks[found]);
+        }
+    }
+    return addressCount;
+}
+
+quint32 MemoryBitmap::findNextClear(quint32 start) const noexcept
+{
+    for(quint32 block = start / blockBits; block < blockCount; block++) {
+        quint64 bits = ~blocks[block];
+        if(block == start / blockBits) bits &= ~quint64(0) << (start % blockBits);
+        if(bits != 0) return block * blockBits + qCountTrailingZeroBits(bits);
+    }
+    return addressCount;
+}
+
+MemoryBitmap::RangeIterator::RangeIterator(const MemoryBitmap &bitmap) noexcept:
+    bitmap(bitmap), position(bitmap.findNextSet(0))
+{
+
+}
+
+bool MemoryBitmap::RangeIterator::hasNext() const noexcept
+{
+    return position < addressCount;
+}
+
+MemoryRange MemoryBitmap::RangeIterator::next() noexcept
+{
+    const quint32 first = position;
+    const quint32 end = bitmap.findNextClear(first);
+    position = bitmap.findNextSet(end);
+    return {static_cast<quint16>(first), static_cast<quint16>(end - 1)};
+}
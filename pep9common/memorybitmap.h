@@ -0,0 +1,100 @@
+// File: memorybitmap.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MEMORYBITMAP_H
+#define MEMORYBITMAP_H
+
+#include <array>
+#include <QtGlobal>
+
+// An inclusive, ascending range of addresses [first, last].
+struct MemoryRange
+{
+    quint16 first, last;
+};
+
+/*
+ * A fixed-size set of 16 bit addresses, stored as one bit per address (8 KiB total).
+ *
+ * Insertion is a pair of bit operations, and never allocates, which makes it
+ * suitable for recording every store performed by a running program.
+ * A coarse summary bitmap records which 64-address blocks contain any addresses,
+ * so that sparse sets can be walked without visiting every block.
+ *
+ * Addresses are consumed via RangeIterator, which yields maximal runs of consecutive
+ * addresses in ascending order.
+ */
+class MemoryBitmap
+{
+public:
+    static constexpr quint32 blockBits = 64;
+    static constexpr quint32 blockCount = (1 << 16) / blockBits;
+    static constexpr quint32 summaryCount = blockCount / blockBits;
+
+    class RangeIterator
+    {
+    public:
+        explicit RangeIterator(const MemoryBitmap& bitmap) noexcept;
+        // Returns true if there is another range to be visited.
+        bool hasNext() const noexcept;
+        // Return the next maximal range of consecutive addresses.
+        MemoryRange next() noexcept;
+    private:
+        const MemoryBitmap& bitmap;
+        // Next address to be examined, or 1<<16 if iteration is complete.
+        quint32 position;
+    };
+
+    MemoryBitmap() noexcept;
+
+    inline void insert(quint16 address) noexcept
+    {
+        const quint32 block = address / blockBits;
+        blocks[block] |= quint64(1) << (address % blockBits);
+        summary[block / blockBits] |= quint64(1) << (block % blockBits);
+    }
+    // Insert all addresses between first and last, inclusive.
+    void insertRange(quint16 first, quint16 last) noexcept;
+    // Remove all addresses between first and last, inclusive.
+    void removeRange(quint16 first, quint16 last) noexcept;
+    inline bool contains(quint16 address) const noexcept
+    {
+        return blocks[address / blockBits] & (quint64(1) << (address % blockBits));
+    }
+    // Returns true if any address between first and last, inclusive, is present.
+    bool intersects(quint16 first, quint16 last) const noexcept;
+    bool isEmpty() const noexcept;
+    // Number of addresses present in the set.
+    quint32 count() const noexcept;
+    void clear() noexcept;
+    // Add all addresses in other to this set.
+    MemoryBitmap& unite(const MemoryBitmap& other) noexcept;
+
+private:
+    std::array<quint64, blockCount> blocks;
+    std::array<quint64, summaryCount> summary;
+    // Return the first address >= start that is present (or absent) in the set.
+    // If no such address exists, returns 1<<16.
+    quint32 findNextSet(quint32 start) const noexcept;
+    quint32 findNextClear(quint32 start) const noexcept;
+};
+
+#endif // MEMORYBITMAP_H
@@ -19,7 +19,8 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
-#include <QApplication>
+#include <QCoreApplication>
+#include <QThread>
 
 #include "memorychips.h"
 
@@ -141,9 +142,13 @@ bool NilChip::setByte(quint16 offsetFromBase, quint8)
 
 InputChip::InputChip(quint32 size, quint16 baseAddress, QObject *parent):
     AMemoryChip (size, baseAddress, parent), memory(QVector<quint8>(static_cast<qint32>(size), 0)),
-    waiting(QVector<bool>(static_cast<qint32>(size), false)), requestCanceled(QVector<bool>(static_cast<qint32>(size), false)),
-    requestAborted(QVector<bool>(static_cast<qint32>(size), false))
+    waiting(new std::atomic<bool>[size]), requestCanceled(QVector<bool>(static_cast<qint32>(size), false)),
+    requestAborted(QVector<bool>(static_cast<qint32>(size), false)), requestResolved(true), requestMutex(),
+    requestCondition()
 {
+    for(quint32 it = 0; it < size; it++) {
+        waiting[it].store(false);
+    }
 
 }
 
@@ -156,7 +161,7 @@ void InputChip::resize(quint32 newSize) noexcept
 {
     this->size = newSize;
     memory.resize(static_cast<qint32>(size));
-    waiting.resize(static_cast<qint32>(size));
+    waiting.reset(new std::atomic<bool>[size]);
     requestCanceled.resize(static_cast<qint32>(size));
     requestAborted.resize(static_cast<qint32>(size));
     clear(); // Reset all values to false / 0.
@@ -175,12 +180,16 @@ AMemoryChip::ChipTypes InputChip::getChipType() const noexcept
 
 void InputChip::clear() noexcept
 {
+    QMutexLocker locker(&requestMutex);
     for (quint32 it = 0; it < size; it++) {
         memory[static_cast<qint32>(it)] = 0;
-        waiting[static_cast<qint32>(it)] = false;
+        waiting[it].store(false);
         requestCanceled[static_cast<qint32>(it)] = false;
         requestAborted[static_cast<qint32>(it)] = false;
     }
+    // Nothing is waiting anymore.
+    requestResolved = true;
+    requestCondition.wakeAll();
 }
 
 bool InputChip::isCachable() const noexcept
@@ -191,13 +200,30 @@ bool InputChip::isCachable() const noexcept
 bool InputChip::readByte(quint16 offsetFromBase, quint8 &output) const
 {
     // If the read would be out of bounds, throw an error.
-    if(offsetFromBase >= size) outOfBoundsReadHelper(offsetFromBase);   
-    waiting[offsetFromBase] = true;
-    requestCanceled[offsetFromBase] = false;
-    requestAborted[offsetFromBase] = false;
+    if(offsetFromBase >= size) outOfBoundsReadHelper(offsetFromBase);
+    {
+        QMutexLocker locker(&requestMutex);
+        requestCanceled[offsetFromBase] = false;
+        requestAborted[offsetFromBase] = false;
+        requestResolved = false;
+        waiting[offsetFromBase].store(true);
+    }
+    // The request may be resolved synchronously by a direct connection, so the lock must not be held.
     emit inputRequested(baseAddress + offsetFromBase);
-    // Let the UI handle I/O before returning to this device
-    QApplication::processEvents();
+    QMutexLocker locker(&requestMutex);
+    QCoreApplication* app = QCoreApplication::instance();
+    if(app != nullptr && QThread::currentThread() == app->thread()) {
+        // Let the UI handle I/O before returning to this device
+        locker.unlock();
+        QCoreApplication::processEvents();
+        locker.relock();
+    }
+    else {
+        // The request is served on the GUI thread, so sleep until it has been resolved.
+        while(!requestResolved) {
+            requestCondition.wait(&requestMutex);
+        }
+    }
     if(requestCanceled[offsetFromBase]) return false;
     else if(requestAborted[offsetFromBase]) {
         memory[offsetFromBase] = errorChar;
@@ -232,26 +258,36 @@ bool InputChip::setByte(quint16 offsetFromBase, quint8 value)
 
 bool InputChip::waitingForInput(quint16 offsetFromBase) const
 {
-    return waiting[offsetFromBase];
+    return waiting[offsetFromBase].load();
 }
 
 void InputChip::onInputReceived(quint16 offsetFromBase, quint8 value)
 {
     if(offsetFromBase >= size) outOfBoundsWriteHelper(offsetFromBase, value);
+    QMutexLocker locker(&requestMutex);
     memory[offsetFromBase] = value;
-    waiting[offsetFromBase] = false;
+    resolveRequest(offsetFromBase, false, false);
 }
 
 void InputChip::onInputCanceled(quint16 offsetFromBase)
 {
-    waiting[offsetFromBase] = false;
-    requestCanceled[offsetFromBase] = true;
+    QMutexLocker locker(&requestMutex);
+    resolveRequest(offsetFromBase, true, false);
 }
 
 void InputChip::onInputAborted(quint16 offsetFromBase)
 {
-    waiting[offsetFromBase] = false;
-    requestAborted[offsetFromBase] = true;
+    QMutexLocker locker(&requestMutex);
+    resolveRequest(offsetFromBase, false, true);
+}
+
+void InputChip::resolveRequest(quint16 offsetFromBase, bool canceled, bool aborted)
+{
+    waiting[offsetFromBase].store(false);
+    if(canceled) requestCanceled[offsetFromBase] = true;
+    if(aborted) requestAborted[offsetFromBase] = true;
+    requestResolved = true;
+    requestCondition.wakeAll();
 }
 
 
@@ -364,6 +400,11 @@ void RAMChip::clear() noexcept
     }
 }
 
+quint8 *RAMChip::getBackingStore() noexcept
+{
+    return memory.data();
+}
+
 bool RAMChip::readByte(quint16 offsetFromBase, quint8 &output) const
 {
     return getByte(offsetFromBase, output);
@@ -427,6 +468,11 @@ void ROMChip::clear() noexcept
     }
 }
 
+quint8 *ROMChip::getBackingStore() noexcept
+{
+    return memory.data();
+}
+
 bool ROMChip::readByte(quint16 offsetFromBase, quint8 &output) const
 {
     return getByte(offsetFromBase, output);
@@ -22,7 +22,11 @@
 #ifndef MEMORYCHIPS_H
 #define MEMORYCHIPS_H
 
+#include <atomic>
+#include <memory>
+#include <QMutex>
 #include <QVector>
+#include <QWaitCondition>
 
 #include "amemorychip.h"
 
@@ -74,7 +78,19 @@ public:
 class InputChip : public AMemoryChip {
     Q_OBJECT
     mutable QVector<quint8> memory;
-    mutable QVector<bool> waiting, requestCanceled, requestAborted;
+    // Read without locking by the UI (e.g. MainMemory::clearIO()) while a simulation
+    // on another thread may be setting it.
+    mutable std::unique_ptr<std::atomic<bool>[]> waiting;
+    // Guarded by requestMutex.
+    mutable QVector<bool> requestCanceled, requestAborted;
+    // Set once the outstanding request has been received, canceled, or aborted.
+    mutable bool requestResolved;
+    // A simulation running on another thread sleeps on requestCondition until its
+    // request is resolved on the GUI thread.
+    mutable QMutex requestMutex;
+    mutable QWaitCondition requestCondition;
+    // Mark the request for offsetFromBase resolved, and wake the simulation waiting on it.
+    void resolveRequest(quint16 offsetFromBase, bool canceled, bool aborted);
     // If IO is aborted, which character shall be returned. Defaults to
     // 0x04 (EndOfTransmission).
     static constexpr quint8 errorChar = 0x04;
@@ -148,6 +164,7 @@ public:
     IOFunctions getIOFunctions() const noexcept override;
     ChipTypes getChipType() const noexcept override;
     void clear() noexcept override;
+    quint8* getBackingStore() noexcept override;
 
     bool readByte(quint16 offsetFromBase, quint8 &output) const override;
     bool writeByte(quint16 offsetFromBase, quint8 value) override;
@@ -170,6 +187,7 @@ public:
     IOFunctions getIOFunctions() const noexcept override;
     ChipTypes getChipType() const noexcept override;
     void clear() noexcept override;
+    quint8* getBackingStore() noexcept override;
 
     bool readByte(quint16 offsetFromBase, quint8 &output) const override;
     bool writeByte(quint16 offsetFromBase, quint8 value) override;
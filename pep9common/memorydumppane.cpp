@@ -137,6 +137,8 @@ void MemoryDumpPane::refreshMemoryLines(quint16 firstByte, quint16 lastByte)
     quint8 tempData;
     QChar ch;
     QString memoryDumpLine;
+    // The memory map can't change during a refresh, so only fetch its size once.
+    const quint32 maxAddress = memDevice->maxAddress();
     // Disable screen updates while re-writing all data fields to save execution time.
     bool updates = ui->tableView->updatesEnabled();
     ui->tableView->setUpdatesEnabled(false);
@@ -145,7 +147,7 @@ void MemoryDumpPane::refreshMemoryLines(quint16 firstByte, quint16 lastByte)
         memoryDumpLine.clear();
         for(int col = 0; col < bytesPerLine; col++) {
             // Only access memory if it is in range
-            if(quint32(row * bytesPerLine + col) <= memDevice->maxAddress()) {
+            if(quint32(row * bytesPerLine + col) <= maxAddress) {
                 // Use the data in the memory section to set the value in the model.
                 memDevice->getByte(static_cast<quint16>(row * bytesPerLine + col), tempData);
                 data->setData(data->index(row, col + 1), QString("%1").arg(tempData, 2, 16, QChar('0')).toUpper());
@@ -211,7 +213,7 @@ void MemoryDumpPane::highlight()
     if(!highlightPC) {
         // Don't preform any PC highlighting
     }
-    else if(!Pep::isUnaryMap[Pep::decodeMnemonic[is]]) {
+    else if(!Pep::decodeTable[is].isUnary) {
         for(int it = 0; it < 3; it++) {
             quint16 as16 = static_cast<quint16>(pc + it);
             highlightByte(as16, colors->altTextHighlight, colors->memoryHighlightPC);
@@ -223,17 +225,19 @@ void MemoryDumpPane::highlight()
         highlightedData.append(pc);
     }
 
-    for(quint16 byte : lastModifiedBytes) {
-        highlightByte(byte, colors->arrowColorOn, colors->memoryHighlightChanged);
-        highlightedData.append(byte);
+    MemoryBitmap::RangeIterator ranges(lastModifiedBytes);
+    while(ranges.hasNext()) {
+        MemoryRange range = ranges.next();
+        for(quint32 byte = range.first; byte <= range.last; byte++) {
+            highlightByte(static_cast<quint16>(byte), colors->arrowColorOn, colors->memoryHighlightChanged);
+            highlightedData.append(static_cast<quint16>(byte));
+        }
     }
 
 }
 
 void MemoryDumpPane::updateMemory()
 {
-    QList<quint16> list;
-    QSet<quint16> linesToBeUpdated;
     // Don't clear the memDevice's written / set bytes, since other UI components might
     // need access to them.
     // However, must clear the local cache of modified bytes, or there is the potential to over-highlight.
@@ -241,16 +245,20 @@ void MemoryDumpPane::updateMemory()
     modifiedBytes.unite(memDevice->getBytesSet());
     modifiedBytes.unite(memDevice->getBytesWritten());
     lastModifiedBytes = memDevice->getBytesWritten();
-    list = modifiedBytes.toList();
-    while(!list.isEmpty()) {
-        linesToBeUpdated.insert(list.takeFirst() / bytesPerLine);
-    }
-    list = linesToBeUpdated.toList();
-    std::sort(list.begin(), list.end());
 
-    for(auto x: list) {
+    // Ranges are visited in ascending order, so track the first line that has not yet
+    // been refreshed to avoid refreshing a line shared by two ranges twice.
+    quint32 nextLine = 0;
+    MemoryBitmap::RangeIterator ranges(modifiedBytes);
+    while(ranges.hasNext()) {
+        MemoryRange range = ranges.next();
+        quint32 firstLine = std::max(nextLine, static_cast<quint32>(range.first / bytesPerLine));
+        quint32 lastLine = range.last / bytesPerLine;
+        if(firstLine > lastLine) continue;
         // Multiply by 8 to convert from line # to address of first byte on a line.
-        refreshMemoryLines(x * bytesPerLine, x * bytesPerLine);
+        refreshMemoryLines(static_cast<quint16>(firstLine * bytesPerLine),
+                           static_cast<quint16>(lastLine * bytesPerLine));
+        nextLine = lastLine + 1;
     }
     ui->tableView->resizeColumnsToContents();
 
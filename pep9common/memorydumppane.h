@@ -29,6 +29,7 @@
 #include <QStyledItemDelegate>
 #include <QWidget>
 #include "colors.h"
+#include "memorybitmap.h"
 namespace Ui {
     class MemoryDumpPane;
 }
@@ -129,7 +130,7 @@ private:
     QList<quint16> highlightedData;
     // This is a list of bytes that are currently highlighted.
 
-    QSet<quint16> modifiedBytes, lastModifiedBytes;
+    MemoryBitmap modifiedBytes, lastModifiedBytes;
     // This is a list of bytes that were modified since the last update. This is cached for a convenient time to update
     // such as when we hit a breakpoint, the program finishes, or the end of the single step.
     // lastModifiedBytes indicates which bytes were written in the last ISA instruction.
@@ -20,6 +20,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdexcept>
+
 #include <QFile>
 #include <QString>
 #include <QStringList>
@@ -121,6 +123,7 @@ QMap<QString, Enu::ECPUKeywords> Pep::mnemonToStatusSpecMap;
 
 void Pep::initMicroEnumMnemonMaps(CPUType cpuType, bool fullCtrlSection)
 {
+    assertMapsMutable("initMicroEnumMnemonMaps");
     branchFuncToMnemonMap.clear(); mnemonToBranchFuncMap.clear();
     if(fullCtrlSection) {
         mnemonToBranchFuncMap.insert("GT",uBRGT); branchFuncToMnemonMap.insert(uBRGT,"GT");
@@ -320,6 +323,7 @@ QMap<Enu::EMnemonic, QString> Pep::enumToMnemonMap;
 QMap<QString, Enu::EMnemonic> Pep::mnemonToEnumMap;
 void Pep::initEnumMnemonMaps()
 {
+    assertMapsMutable("initEnumMnemonMaps");
     enumToMnemonMap.clear(); mnemonToEnumMap.clear(); // Can be called from Redefine Mnemonics
 
     QMetaObject meta = Enu::staticMetaObject;
@@ -355,6 +359,7 @@ void initMnemMapHelper(EMnemonic mnemon,int start,bool unary,bool addrModeReq,bo
 
 void Pep::initMnemonicMaps(bool NOP0IsTrap)
 {
+    assertMapsMutable("initMnemonicMaps");
     if(NOP0IsTrap) {
         initMnemMapHelper(EMnemonic::NOP0, 38, true, false, true);
     }
@@ -437,6 +442,7 @@ void Pep::initMnemonicMaps(bool NOP0IsTrap)
 QMap<Enu::EMnemonic, int > Pep::addrModesMap;
 void Pep::initAddrModesMap()
 {
+    assertMapsMutable("initAddrModesMap");
         constexpr int all = static_cast<int>(EAddrMode::ALL);
     constexpr int IX = static_cast<int>(EAddrMode::I)|static_cast<int>(EAddrMode::X);
     constexpr int store = all & (~static_cast<int>(EAddrMode::I));
@@ -494,6 +500,8 @@ bool Pep::isStoreMnemonic(EMnemonic mnemon)
 // Decoder tables
 QVector<Enu::EMnemonic> Pep::decodeMnemonic(256);
 QVector<Enu::EAddrMode> Pep::decodeAddrMode(256);
+std::array<Pep::DecodedOp, 256> Pep::decodeTable;
+quint32 Pep::decodeTableGeneration = 0;
 void initDecoderTableAHelper(EMnemonic val,int startIdx)
 {
     Pep::decodeMnemonic[startIdx] = val; Pep::decodeAddrMode[startIdx] = EAddrMode::I;
@@ -522,6 +530,7 @@ void initDecoderTableHelperTrap(EMnemonic val,int startIdx,int distance){
 
 void Pep::initDecoderTables()
 {
+    assertMapsMutable("initDecoderTables");
     decodeMnemonic[0] = EMnemonic::STOP; decodeAddrMode[0] = EAddrMode::NONE;
     decodeMnemonic[1] = EMnemonic::RET; decodeAddrMode[1] = EAddrMode::NONE;
     decodeMnemonic[2] = EMnemonic::RETTR; decodeAddrMode[2] = EAddrMode::NONE;
@@ -583,6 +592,36 @@ void Pep::initDecoderTables()
     initDecoderTableAAAHelper(EMnemonic::STWX, 232);
     initDecoderTableAAAHelper(EMnemonic::STBA, 240);
     initDecoderTableAAAHelper(EMnemonic::STBX, 248);
+
+    // Flatten the per-mnemonic maps into a table indexed by instruction specifier.
+    for(int it = 0; it < 256; it++) {
+        DecodedOp& op = decodeTable[static_cast<size_t>(it)];
+        op.mnemonic = decodeMnemonic[it];
+        op.addrMode = decodeAddrMode[it];
+        op.isUnary = isUnaryMap.value(op.mnemonic);
+        op.isTrap = isTrapMap.value(op.mnemonic);
+        switch(op.mnemonic) {
+        case EMnemonic::BRLE: [[fallthrough]];
+        case EMnemonic::BRLT: [[fallthrough]];
+        case EMnemonic::BREQ: [[fallthrough]];
+        case EMnemonic::BRNE: [[fallthrough]];
+        case EMnemonic::BRGE: [[fallthrough]];
+        case EMnemonic::BRGT: [[fallthrough]];
+        case EMnemonic::BRV: [[fallthrough]];
+        case EMnemonic::BRC:
+            op.isConditionalBranch = true;
+            break;
+        default:
+            op.isConditionalBranch = false;
+            break;
+        }
+        if(op.isUnary) op.operandWidth = 0;
+        else op.operandWidth = static_cast<quint8>(operandDisplayFieldWidth(op.mnemonic) / 2);
+        if(op.mnemonic == EMnemonic::CALL || op.isTrap) op.callDepthDelta = 1;
+        else if(op.mnemonic == EMnemonic::RET || op.mnemonic == EMnemonic::RETTR) op.callDepthDelta = -1;
+        else op.callDepthDelta = 0;
+    }
+    decodeTableGeneration++;
 }
 
 QMap<Enu::EMnemonic, QString> Pep::defaultEnumToMicrocodeInstrSymbol;
@@ -592,6 +631,7 @@ QVector<QString> Pep::instSpecToMicrocodeAddrSymbol;
 QString Pep::defaultStartSymbol;
 void Pep::initMicroDecoderTables()
 {
+    assertMapsMutable("initMicroDecoderTables");
     defaultStartSymbol = "start";
     // Initialize insturction specifiers for microcode symbols
     defaultEnumToMicrocodeInstrSymbol.clear();
@@ -637,3 +677,22 @@ void Pep::initMicroDecoderTables()
         instSpecToMicrocodeAddrSymbol[it] = defaultEnumToMicrocodeAddrSymbol[Pep::decodeAddrMode[it]];
     }
 }
+
+QAtomicInt Pep::mapFreezeCount;
+void Pep::freezeMaps()
+{
+    mapFreezeCount.ref();
+}
+
+void Pep::thawMaps()
+{
+    mapFreezeCount.deref();
+}
+
+void Pep::assertMapsMutable(const char *function)
+{
+    if(mapFreezeCount.loadAcquire() != 0) {
+        throw std::logic_error(QString("Pep::%1 called while the mnemonic maps are frozen.")
+                               .arg(function).toStdString());
+    }
+}
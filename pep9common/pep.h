@@ -22,6 +22,8 @@
 #ifndef PEP_H
 #define PEP_H
 
+#include <array>
+#include <QAtomicInt>
 #include <QColor>
 #include <QMap>
 #include <QString>
@@ -121,7 +123,27 @@ public:
     static QVector<Enu::EAddrMode> decodeAddrMode;
     // Does a particular instruction perform a store instead of a load?
     static bool isStoreMnemonic(Enu::EMnemonic);
+    // Everything the simulators need to know about an instruction specifier,
+    // gathered into a single table entry so that hot paths avoid map lookups.
+    struct DecodedOp
+    {
+        Enu::EMnemonic mnemonic;
+        Enu::EAddrMode addrMode;
+        bool isUnary, isTrap;
+        // Is the instruction a branch whose outcome depends on the status bits?
+        bool isConditionalBranch;
+        // Number of bytes in the operand's value (0 for unary, 1 for byte loads & compares).
+        quint8 operandWidth;
+        // Change in call depth caused by executing the instruction.
+        qint8 callDepthDelta;
+    };
+    static std::array<DecodedOp, 256> decodeTable;
+    // Must be called after initMnemonicMaps(...), and again whenever
+    // the properties of an instruction are redefined.
     static void initDecoderTables();
+    // Incremented by every call to initDecoderTables(), so that anything derived
+    // from decodeTable can tell when it must be derived again.
+    static quint32 decodeTableGeneration;
 
     // Microprogram decoder table
     // Map mnemonic to the symbol in microcode which implements that instruction.
@@ -135,5 +157,15 @@ public:
     static QString defaultStartSymbol;
     static void initMicroDecoderTables();
 
+    // The maps and tables above are shared by every simulator in the process. While they are
+    // frozen, such as while a batch of simulations reads them from several threads, calling
+    // any of the init functions above throws std::logic_error instead of mutating them.
+    // Freezes nest, and the maps become mutable again once every freeze has been thawed.
+    static void freezeMaps();
+    static void thawMaps();
+
+private:
+    static QAtomicInt mapFreezeCount;
+    static void assertMapsMutable(const char* function);
 };
 #endif // PEP_H
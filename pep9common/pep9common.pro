@@ -26,12 +26,16 @@ HEADERS += \
     byteconverterdec.h \
     byteconverterhex.h \
     byteconverterinstr.h \
+    cachememorydevice.h \
     colors.h \
     enu.h \
     inputpane.h \
+    inputsource.h \
     interrupthandler.h \
     iowidget.h \
     mainmemory.h \
+    memoryaccesstrace.h \
+    memorybitmap.h \
     memorychips.h \
     memorydumppane.h \
     outputpane.h \
@@ -42,7 +46,9 @@ HEADERS += \
     terminalpane.h \
     updatechecker.h \
     registerfile.h \
+    simulationrunner.h \
     darkhelper.h \
+    writejournal.h \
 
 
 SOURCES += \
@@ -55,11 +61,15 @@ SOURCES += \
     byteconverterdec.cpp \
     byteconverterhex.cpp \
     byteconverterinstr.cpp \
+    cachememorydevice.cpp \
     colors.cpp \
     inputpane.cpp \
+    inputsource.cpp \
     interrupthandler.cpp \
     iowidget.cpp \
     mainmemory.cpp \
+    memoryaccesstrace.cpp \
+    memorybitmap.cpp \
     memorychips.cpp \
     memorydumppane.cpp \
     outputpane.cpp \
@@ -70,7 +80,9 @@ SOURCES += \
     terminalpane.cpp \
     updatechecker.cpp \
     enu.cpp \
-    registerfile.cpp
+    registerfile.cpp \
+    simulationrunner.cpp \
+    writejournal.cpp
 
 macx{
     QT += macextras
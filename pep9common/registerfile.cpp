@@ -21,6 +21,8 @@
 */
 #include "registerfile.h"
 
+#include "writejournal.h"
+
 RegisterFile::RegisterFile(): registersStart(),
     registersCurrent(),
     statusBitsStart(0),
@@ -175,6 +177,19 @@ void RegisterFile::writePCStart(quint16 val)
     }
 }
 
+void RegisterFile::writeStatusBitsStart(quint8 bits)
+{
+    // Only keep SNZVC positions
+    statusBitsStart = bits & 0b11111;
+}
+
+void RegisterFile::writeRegisterByteStart(quint8 reg, quint8 val)
+{
+    if(reg <= Enu::maxRegisterNumber) {
+        registersStart[reg] = val;
+    }
+}
+
 void RegisterFile::setIRCache(quint8 val)
 {
     irCache = val;
@@ -198,6 +213,19 @@ void RegisterFile::flattenFile()
     statusBitsStart = statusBitsCurrent;
 }
 
+void RegisterFile::journalChanges(const RegisterFile &previous, WriteJournal &journal) const
+{
+    // Comparing the whole (small) file once per step keeps bookkeeping out of every register write.
+    for(std::size_t reg = 0; reg < registersCurrent.size(); reg++) {
+        if(registersCurrent[reg] != previous.registersCurrent[reg]) {
+            journal.recordRegister(static_cast<quint8>(reg), previous.registersCurrent[reg]);
+        }
+    }
+    if(statusBitsCurrent != previous.statusBitsCurrent) {
+        journal.recordStatusBits(previous.statusBitsCurrent);
+    }
+}
+
 bool RegisterFile::crackStatusBit(quint8 statusBits, Enu::EStatusBit bit)
 {
     int mask = 0;
@@ -26,6 +26,7 @@
 #include <QtCore>
 
 #include "enu.h"
+class WriteJournal;
 
 /*
  * Provides access to all 32 CPU registers and 5 status bits with one backup history state.
@@ -95,6 +96,10 @@ public:
 
     // Modifies the starting value of the program counter. Needed for correct highlighting.
     void writePCStart(quint16 val);
+    // Modifies the starting value of the status bits. Needed by CPUs that write status bits lazily.
+    void writeStatusBitsStart(quint8 bits);
+    // Modifies the starting value of a register byte. Needed to undo the end of an instruction.
+    void writeRegisterByteStart(quint8 reg, quint8 val);
 
     // Since the value in the IR isn't correct at the start of a cycle,
     // implementations might choose to predict the correct value and cache it.
@@ -105,6 +110,10 @@ public:
 
     // Copy all current values to the starting values.
     void flattenFile();
+
+    // Record in journal the old value of each current register byte and the status bits,
+    // where they differ from the current values of previous.
+    void journalChanges(const RegisterFile& previous, WriteJournal& journal) const;
 };
 
 #endif // REGISTERFILE_H
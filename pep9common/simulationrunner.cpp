@@ -0,0 +1,97 @@
+// File: simulationrunner.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "simulationrunner.h"
+
+#include <QtConcurrent>
+
+#include "acpumodel.h"
+
+SimulationRunner::SimulationRunner(QSharedPointer<ACPUModel> cpu, QObject *parent): QObject(parent),
+    cpu(cpu), watcher(), progressTimer(), running(false), wasHeadless(false)
+{
+    progressTimer.setInterval(progressInterval);
+    connect(&watcher, &QFutureWatcher<void>::finished, this, &SimulationRunner::onWorkerFinished);
+    connect(&progressTimer, &QTimer::timeout, this, &SimulationRunner::onProgressTimeout);
+}
+
+SimulationRunner::~SimulationRunner()
+{
+    // The worker must not outlive the objects it references.
+    if(running) {
+        cpu->requestCancel();
+        waitForFinished();
+    }
+}
+
+bool SimulationRunner::isRunning() const noexcept
+{
+    return running;
+}
+
+void SimulationRunner::start(std::function<void ()> body)
+{
+    if(running) return;
+    running = true;
+    // Requests made after the last simulation stopped are stale.
+    cpu->clearRequests();
+    // Nothing on the GUI thread may observe the CPU mid-instruction, so suppress
+    // per-instruction notifications and report how the simulation stopped in finished().
+    wasHeadless = cpu->isHeadless();
+    cpu->setHeadless(true);
+    cpu->blockSignals(true);
+    progressTimer.start();
+    watcher.setFuture(QtConcurrent::run(body));
+}
+
+void SimulationRunner::waitForFinished()
+{
+    watcher.waitForFinished();
+}
+
+void SimulationRunner::onWorkerFinished()
+{
+    progressTimer.stop();
+    cpu->blockSignals(false);
+    cpu->setHeadless(wasHeadless);
+    running = false;
+    emit finished();
+}
+
+QString SimulationRunner::describeProgress(const ACPUModel::RunStatus &status, const QString &unit)
+{
+    auto hex = [](quint16 value, int width) {
+        return QString::number(value, 16).toUpper().rightJustified(width, '0');
+    };
+    static const char names[] = "NZVCS";
+    QString bits;
+    for(int bit = 0; bit < 5; bit++) {
+        bits.append(status.nzvcs & (1 << (4 - bit)) ? QChar(names[bit]) : QChar('-'));
+    }
+    return QString("Running: %1 %2 executed    PC=%3 IS=%4 A=%5 X=%6 SP=%7 %8")
+            .arg(status.steps).arg(unit, hex(status.pc, 4), hex(status.is, 2),
+                                   hex(status.a, 4), hex(status.x, 4), hex(status.sp, 4), bits);
+}
+
+void SimulationRunner::onProgressTimeout()
+{
+    emit progress(cpu->getPublishedStatus());
+}
@@ -0,0 +1,76 @@
+// File: simulationrunner.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SIMULATIONRUNNER_H
+#define SIMULATIONRUNNER_H
+
+#include <functional>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+
+#include "acpumodel.h"
+
+/*
+ * Executes a long-running simulation (e.g. ACPUModel::onRun()) on a worker thread,
+ * so that the GUI thread need not pump its own events from within the simulation loop.
+ *
+ * While running, the CPU is headless and its signals are blocked. The UI may only interact
+ * with the simulation via ACPUModel::requestCancel() / requestBreakpoint() and memory mapped IO,
+ * and should inspect how the simulation stopped once finished() is emitted.
+ * Meanwhile, progress(...) is emitted at display rate with a snapshot of the step count and registers.
+ */
+class SimulationRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SimulationRunner(QSharedPointer<ACPUModel> cpu, QObject *parent = nullptr);
+    virtual ~SimulationRunner() override;
+    // Returns true from start(...) until finished() is emitted.
+    bool isRunning() const noexcept;
+    // Execute body on a worker thread. Does nothing if a simulation is already running.
+    void start(std::function<void(void)> body);
+    // Block until the worker thread has finished executing.
+    void waitForFinished();
+    // Interval between progress updates, in milliseconds.
+    static constexpr int progressInterval = 33;
+    // Describe a running simulation for the status bar, where unit names what a step is (e.g. "cycles").
+    static QString describeProgress(const ACPUModel::RunStatus& status, const QString& unit);
+
+signals:
+    // The registers, and the number of steps the CPU has completed, as of its last poll.
+    void progress(ACPUModel::RunStatus status);
+    // Emitted on the thread owning this object once the simulation has stopped.
+    void finished();
+
+private slots:
+    void onWorkerFinished();
+    void onProgressTimeout();
+
+private:
+    QSharedPointer<ACPUModel> cpu;
+    QFutureWatcher<void> watcher;
+    QTimer progressTimer;
+    bool running, wasHeadless;
+};
+
+#endif // SIMULATIONRUNNER_H
@@ -0,0 +1,123 @@
+// File: writejournal.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "writejournal.h"
+
+WriteJournal::WriteJournal(int capacity): buffer(qMax(capacity, 2)), head(0), size(0), steps(0),
+    recording(false), overflowed(false)
+{
+
+}
+
+void WriteJournal::beginStep()
+{
+    endStep();
+    recording = true;
+    overflowed = false;
+    append({0, 0, Target::STEP});
+}
+
+void WriteJournal::endStep() noexcept
+{
+    if(!recording) return;
+    recording = false;
+    // The step's marker was discarded to make room for its own entries, so none of it was kept.
+    if(!overflowed) steps++;
+}
+
+void WriteJournal::recordMemory(quint16 address, quint8 oldValue)
+{
+    append({address, oldValue, Target::MEMORY});
+}
+
+void WriteJournal::recordRegister(quint8 reg, quint8 oldValue)
+{
+    append({reg, oldValue, Target::REGISTER});
+}
+
+void WriteJournal::recordStatusBits(quint8 oldValue)
+{
+    append({0, oldValue, Target::STATUS_BITS});
+}
+
+void WriteJournal::recordControl(quint8 slot, quint16 oldValue)
+{
+    append({oldValue, slot, Target::CONTROL});
+}
+
+void WriteJournal::recordInput(quint16 address, quint8 consumed)
+{
+    append({address, consumed, Target::INPUT});
+}
+
+int WriteJournal::stepCount() const noexcept
+{
+    return steps;
+}
+
+bool WriteJournal::popStep(QVector<Entry> &entries)
+{
+    entries.clear();
+    if(recording || steps == 0) return false;
+    // Walk backwards from the newest entry to the step's marker.
+    while(size > 0) {
+        const Entry& entry = buffer[indexOf(--size)];
+        if(entry.target == Target::STEP) break;
+        entries.append(entry);
+    }
+    steps--;
+    return true;
+}
+
+void WriteJournal::clear() noexcept
+{
+    head = 0;
+    size = 0;
+    steps = 0;
+    recording = false;
+    overflowed = false;
+}
+
+void WriteJournal::append(Entry entry)
+{
+    if(!recording || overflowed) return;
+    if(size == buffer.size() && !dropOldestStep()) {
+        // A single step modified more state than the journal holds. Neither it nor
+        // any step before it can be undone, so forget everything.
+        overflowed = true;
+        head = 0;
+        size = 0;
+        return;
+    }
+    buffer[indexOf(size++)] = entry;
+}
+
+bool WriteJournal::dropOldestStep() noexcept
+{
+    if(steps == 0) return false;
+    // Remove the marker, and then the entries up to the next step's marker.
+    do {
+        head = indexOf(1);
+        size--;
+    } while(size > 0 && buffer[head].target != Target::STEP);
+    steps--;
+    return true;
+}
@@ -0,0 +1,104 @@
+// File: writejournal.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef WRITEJOURNAL_H
+#define WRITEJOURNAL_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/*
+ * An undo log of the values overwritten by each step of a simulation, so that a debugger
+ * may step backwards without re-executing the program.
+ *
+ * A step is opened with beginStep(), after which the simulator records the old value of
+ * every byte of memory, register, or other piece of state it modifies. The journal is a ring
+ * buffer of fixed capacity, so its size is proportional to the number of writes recorded,
+ * rather than to the size of the machine. When full, the oldest steps are discarded.
+ */
+class WriteJournal
+{
+public:
+    enum class Target: quint8
+    {
+        // Marks the start of a step.
+        STEP,
+        // address is a memory address, value its old contents.
+        MEMORY,
+        // address is a register number, value the register byte's old contents.
+        REGISTER,
+        // value holds the old status bits.
+        STATUS_BITS,
+        // State private to the simulator. value names the piece of state, and address is its old value.
+        CONTROL,
+        // address is an input address, value a byte of input consumed from it.
+        INPUT
+    };
+    struct Entry
+    {
+        quint16 address;
+        quint8 value;
+        Target target;
+    };
+    // Four bytes per entry, so the default journal occupies 4 MiB.
+    static constexpr int defaultCapacity = 1 << 20;
+
+    explicit WriteJournal(int capacity = defaultCapacity);
+
+    // Close any open step, and open a new one. Entries are only recorded while a step is open.
+    void beginStep();
+    void endStep() noexcept;
+    inline bool isRecording() const noexcept
+    {
+        return recording;
+    }
+    void recordMemory(quint16 address, quint8 oldValue);
+    void recordRegister(quint8 reg, quint8 oldValue);
+    void recordStatusBits(quint8 oldValue);
+    void recordControl(quint8 slot, quint16 oldValue);
+    void recordInput(quint16 address, quint8 consumed);
+
+    // Number of complete steps that may be undone.
+    int stepCount() const noexcept;
+    // Remove the most recent complete step, and store its entries in entries with the most
+    // recent first, which is the order in which they must be undone. The step marker is omitted.
+    // Returns false if there is no step to undo.
+    bool popStep(QVector<Entry>& entries);
+    void clear() noexcept;
+
+private:
+    QVector<Entry> buffer;
+    // Index of the oldest entry, and the number of entries held.
+    int head, size;
+    int steps;
+    bool recording;
+    // Set if the open step did not fit in the journal, and so can't be undone.
+    bool overflowed;
+    void append(Entry entry);
+    // Discard the oldest step. Returns false if the only step is the one being recorded.
+    bool dropOldestStep() noexcept;
+    inline int indexOf(int offset) const noexcept
+    {
+        return (head + offset) % buffer.size();
+    }
+};
+
+#endif // WRITEJOURNAL_H
@@ -0,0 +1,54 @@
+// File: controlstore.cpp
+/*
+    Pep9CPU is a CPU simulator for executing microcode sequences to
+    implement instructions in the instruction set of the Pep/9 computer.
+
+    Copyright (C) 2018  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "controlstore.h"
+
+#include "microcode.h"
+#include "microcodeprogram.h"
+#include "symbolentry.h"
+
+static_assert(ControlWord::clockSignalCount <= 16, "Clock signals must fit in ControlWord::clockMask.");
+
+ControlStore::ControlStore(const MicrocodeProgram &program): words(program.codeLength())
+{
+    for(int it = 0; it < program.codeLength(); it++) {
+        const MicroCode* line = program.getCodeLine(static_cast<quint16>(it));
+        ControlWord& word = words[it];
+        for(int signal = 0; signal < ControlWord::controlSignalCount; signal++) {
+            word.controlSignals[static_cast<std::size_t>(signal)] =
+                    line->getControlSignal(static_cast<Enu::EControlSignals>(signal));
+        }
+        word.clockMask = 0;
+        for(int clock = 0; clock < ControlWord::clockSignalCount; clock++) {
+            if(line->getClockSignal(static_cast<Enu::EClockSignals>(clock))) {
+                word.clockMask |= 1 << clock;
+            }
+        }
+        word.branchFunction = line->getBranchFunction();
+        // MicrocodeProgram points any missing targets at the line itself.
+        word.trueTarget = static_cast<quint16>(line->getTrueTarget()->getValue());
+        word.falseTarget = static_cast<quint16>(line->getFalseTarget()->getValue());
+    }
+}
+
+ControlStore::~ControlStore()
+{
+
+}
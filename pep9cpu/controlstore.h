@@ -0,0 +1,89 @@
+// File: controlstore.h
+/*
+    Pep9CPU is a CPU simulator for executing microcode sequences to
+    implement instructions in the instruction set of the Pep/9 computer.
+
+    Copyright (C) 2018  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CONTROLSTORE_H
+#define CONTROLSTORE_H
+
+#include <array>
+
+#include <QSharedPointer>
+#include <QVector>
+
+#include "enu.h"
+class MicrocodeProgram;
+
+/*
+ * A single line of microcode, packed for execution.
+ *
+ * Control signals are stored in the same layout as CPUDataSection's, so
+ * that they may be copied in one step. Clock signal i is asserted when bit i
+ * of clockMask is set. Branch targets are resolved to microprogram counter values.
+ */
+struct ControlWord
+{
+    static constexpr int controlSignalCount = Enu::controlSignalCount;
+    static constexpr int clockSignalCount = Enu::clockSignalCount;
+
+    std::array<quint8, controlSignalCount> controlSignals;
+    quint16 clockMask;
+    Enu::EBranchFunctions branchFunction;
+    quint16 trueTarget, falseTarget;
+
+    inline bool getClockSignal(Enu::EClockSignals clock) const noexcept
+    {
+        return clockMask & (1 << clock);
+    }
+};
+
+/*
+ * The control store of a microcoded CPU, compiled from a MicrocodeProgram when
+ * the program is loaded. Executing from the control store avoids copying QVectors
+ * and chasing symbol table entries on every cycle.
+ *
+ * Breakpoints are not compiled, since they may be changed while a program runs.
+ * Use the MicrocodeProgram to check them.
+ */
+class ControlStore
+{
+public:
+    explicit ControlStore(const MicrocodeProgram& program);
+    ~ControlStore();
+
+    // Number of lines of microcode in the store.
+    inline int length() const noexcept
+    {
+        return words.length();
+    }
+    // Returns true if microprogramCounter addresses a line of microcode.
+    inline bool contains(quint16 microprogramCounter) const noexcept
+    {
+        return microprogramCounter < words.length();
+    }
+    // Pre: contains(microprogramCounter).
+    inline const ControlWord& at(quint16 microprogramCounter) const noexcept
+    {
+        return words.data()[microprogramCounter];
+    }
+
+private:
+    QVector<ControlWord> words;
+};
+
+#endif // CONTROLSTORE_H
@@ -19,6 +19,7 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "cpudata.h"
+#include "controlstore.h"
 #include "microcode.h"
 #include "microcodeprogram.h"
 #include "amemorydevice.h"
@@ -27,10 +28,105 @@
 #include <exception>
 #include <string>
 #include <registerfile.h>
+namespace {
+/*
+ * Table-driven ALU, with one entry for each Enu::EALUFunc.
+ *
+ * Each function computes its result from A, B, and the carry in. It returns false if it
+ * needs a carry in that is not available, and only ORs into NZVC the bits it computes itself.
+ * If computesNZ is set, the caller derives N and Z from the result.
+ */
+using ALUFunction = bool (*)(quint8 a, quint8 b, bool hasCIn, bool carryIn, quint8& res, quint8& NZVC);
+struct ALUEntry
+{
+    ALUFunction function;
+    bool computesNZ;
+};
+
+// Shared by all of the adding functions.
+inline bool aluAdd(quint8 a, quint8 b, quint8 carryIn, quint8& res, quint8& NZVC)
+{
+    // Might cause overflow, but overflow is well defined for unsigned ints
+    res = a + b + carryIn;
+    NZVC |= Enu::CMask * quint8{res<a||res<b}; // Carry out if result is unsigned less than a or b.
+    // There is a signed overflow iff the high order bits of the input are the same,
+    // and the inputs & output differs in sign.
+    // Shifts in 0's (unsigned chars), so after shift, only high order bit remain.
+    NZVC |= Enu::VMask * ((~(a ^ b) & (a ^ res)) >> 7) ;
+    return true;
+}
+
+const std::array<ALUEntry, 16> aluTable = {{
+    // A
+    {[](quint8 a, quint8, bool, bool, quint8& res, quint8&) {res = a; return true;}, true},
+    // A plus B
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8& NZVC) {return aluAdd(a, b, 0, res, NZVC);}, true},
+    // A plus B plus Cin
+    {[](quint8 a, quint8 b, bool hasCIn, bool carryIn, quint8& res, quint8& NZVC) {
+         // Expected carry in, none was provided, so ALU calculation yeilds a meaningless result
+         return hasCIn && aluAdd(a, b, quint8{carryIn}, res, NZVC);}, true},
+    // A plus ~B plus 1
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8& NZVC) {return aluAdd(a, static_cast<quint8>(~b), 1, res, NZVC);}, true},
+    // A plus ~B plus Cin
+    {[](quint8 a, quint8 b, bool hasCIn, bool carryIn, quint8& res, quint8& NZVC) {
+         return hasCIn && aluAdd(a, static_cast<quint8>(~b), quint8{carryIn}, res, NZVC);}, true},
+    // A * B
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8&) {res = a & b; return true;}, true},
+    // ~(A * B)
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8&) {res = ~(a & b); return true;}, true},
+    // A + B
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8&) {res = a | b; return true;}, true},
+    // ~(A + B)
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8&) {res = ~(a | b); return true;}, true},
+    // A xor B
+    {[](quint8 a, quint8 b, bool, bool, quint8& res, quint8&) {res = a ^ b; return true;}, true},
+    // ~A
+    {[](quint8 a, quint8, bool, bool, quint8& res, quint8&) {res = ~a; return true;}, true},
+    // ASL A
+    {[](quint8 a, quint8, bool, bool, quint8& res, quint8& NZVC) {
+         res = static_cast<quint8>(a<<1);
+         NZVC |= Enu::CMask * ((a & 0x80) >> 7); // Carry out equals the hi order bit
+         // Signed overflow if a<hi> doesn't match a<hi-1>. Mask off the carry that << shifted into bit 8.
+         NZVC |= Enu::VMask * ((((a << 1) ^ a) & 0x80) >> 7);
+         return true;}, true},
+    // ROL A
+    {[](quint8 a, quint8, bool hasCIn, bool carryIn, quint8& res, quint8& NZVC) {
+         if (!hasCIn) return false;
+         res = static_cast<quint8>(a<<1 | quint8{carryIn});
+         NZVC |= Enu::CMask * ((a & 0x80) >> 7); // Carry out equals the hi order bit
+         // Signed overflow if a<hi> doesn't match a<hi-1>. Mask off the carry that << shifted into bit 8.
+         NZVC |= Enu::VMask * ((((a << 1) ^ a) & 0x80) >> 7);
+         return true;}, true},
+    // ASR A, which differs from ROR A only in how the carry in is calculated
+    {[](quint8 a, quint8, bool, bool, quint8& res, quint8& NZVC) {
+         res = static_cast<quint8>(a >> 1 | static_cast<quint8>(static_cast<bool>(a & 128)) << 7);
+         // Carry out is lowest order bit of a
+         NZVC |= Enu::CMask * (a & 1);
+         return true;}, true},
+    // ROR A
+    {[](quint8 a, quint8, bool hasCIn, bool carryIn, quint8& res, quint8& NZVC) {
+         if (!hasCIn) return false;
+         // A will not be sign extended since it is unsigned.
+         // Widen carryIn so that << yields a meaningful result.
+         res = static_cast<quint8>(a >> 1 | static_cast<quint8>(carryIn) << 7);
+         // Carry out is lowest order bit of a
+         NZVC |= Enu::CMask * (a & 1);
+         return true;}, true},
+    // Move A to NZVC
+    {[](quint8 a, quint8, bool, bool, quint8& res, quint8& NZVC) {
+         res = 0;
+         NZVC |= Enu::NMask & a;
+         NZVC |= Enu::ZMask & a;
+         NZVC |= Enu::VMask & a;
+         NZVC |= Enu::CMask & a;
+         return true;}, false},
+}};
+}
+
 CPUDataSection::CPUDataSection(Enu::CPUType type, QSharedPointer<AMemoryDevice> memDev, QObject *parent): QObject(parent), memDevice(memDev),
     cpuFeatures(type), mainBusState(Enu::None),
-    registerBank(QSharedPointer<RegisterFile>::create()), memoryRegisters(6), controlSignals(Pep::numControlSignals()),
-    clockSignals(Pep::numClockSignals()), emitEvents(true), hadDataError(false), errorMessage(""),
+    registerBank(QSharedPointer<RegisterFile>::create()), memoryRegisters(), controlSignals(),
+    clockSignals(), emitEvents(true), hadDataError(false), errorMessage(""),
     isALUCacheValid(false), ALUHasOutputCache(false), ALUOutputCache(0), ALUStatusBitCache(0)
 {
     presetStaticRegisters();
@@ -103,7 +199,7 @@ bool CPUDataSection::calculateALUOutput(quint8 &res, quint8 &NZVC) const
     }
     // This function should not set any errors.
     // Errors will be handled by step(..)
-    quint8 a, b;
+    quint8 a = 0, b = 0;
     bool carryIn = false;
     bool hasA = getAMuxOutput(a), hasB = valueOnBBus(b);
     bool hasCIn = calculateCSMuxOutput(carryIn);
@@ -113,90 +209,13 @@ bool CPUDataSection::calculateALUOutput(quint8 &res, quint8 &NZVC) const
         ALUHasOutputCache = false;
         return ALUHasOutputCache;
     }
-    // Unless otherwise noted, do not return true (sucessfully) early, or the calculation for the NZ bits will be skipped.
-    switch(controlSignals[Enu::ALU]) {
-    case Enu::A_func: // A
-        res = a;
-        break;
-    case Enu::ApB_func: // A plus B
-        res = a + b;
-        NZVC |= Enu::CMask * quint8{res<a||res<b}; // Carry out if result is unsigned less than a or b.
-        // There is a signed overflow iff the high order bits of the input are the same,
-        // and the inputs & output differs in sign.
-        // Shifts in 0's (unsigned chars), so after shift, only high order bit remain.
-        NZVC |= Enu::VMask * ((~(a ^ b) & (a ^ res)) >> 7) ;
-        break;
-    case Enu::ApnBp1_func: // A plus ~B plus 1
-        hasCIn = true;
-        carryIn = 1;
-        [[fallthrough]];
-    case Enu::ApnBpCin_func: // A plus ~B plus Cin
-        // Clang thinks this is a garbage value. It isn't.
-        // Lots of "errors" spawn from this, but this is well-defined behavior.
-        b = ~b;
-        [[fallthrough]];
-    case Enu::ApBpCin_func: // A plus B plus Cin
-        // Expected carry in, none was provided, so ALU calculation yeilds a meaningless result
-        if (!hasCIn) return false;
-        // Might cause overflow, but overflow is well defined for unsigned ints
-        res = a + b + quint8{carryIn};
-        NZVC |= Enu::CMask * quint8{res<a||res<b}; // Carry out if result is unsigned less than a or b.
-        // There is a signed overflow iff the high order bits of the input are the same,
-        // and the inputs & output differs in sign.
-        // Shifts in 0's (unsigned chars), so after shift, only high order bit remain.
-        NZVC |= Enu::VMask * ((~(a ^ b) & (a ^ res)) >> 7) ;
-        break;
-    case Enu::AandB_func: // A * B
-        res = a & b;
-        break;
-    case Enu::nAandB_func: // ~(A * B)
-        res = ~(a & b);
-        break;
-    case Enu::AorB_func: // A + B
-        res = a | b;
-        break;
-    case Enu::nAorB_func: // ~(A + B)
-        res = ~(a | b);
-        break;
-    case Enu::AxorB_func: // A xor B
-        res = a ^ b;
-        break;
-    case Enu::nA_func: // ~A
-        res = ~a;
-        break;
-    case Enu::ASLA_func: // ASL A
-        res = static_cast<quint8>(a<<1);
-        NZVC |= Enu::CMask * ((a & 0x80) >> 7); // Carry out equals the hi order bit
-        NZVC |= Enu::VMask * (((a << 1) ^ a) >>7); // Signed overflow if a<hi> doesn't match a<hi-1>
-        break;
-    case Enu::ROLA_func: // ROL A
-        if (!hasCIn) return false;
-        res = static_cast<quint8>(a<<1 | quint8{carryIn});
-        NZVC |= Enu::CMask * ((a & 0x80) >> 7); // Carry out equals the hi order bit
-        NZVC |= Enu::VMask * (((a << 1) ^a) >>7); // Signed overflow if a<hi> doesn't match a<hi-1>
-        break;
-    case Enu::ASRA_func: // ASR A
-        hasCIn = true;
-        carryIn = a & 128; // RORA and ASRA only differ by how the carryIn is calculated
-        [[fallthrough]];
-    case Enu::RORA_func: // ROR a
-        if (!hasCIn) return false;
-        // A will not be sign extended since it is unsigned.
-        // Widen carryIn so that << yields a meaningful result.
-        res = static_cast<quint8>(a >> 1 | static_cast<quint8>(carryIn) << 7);
-        // Carry out is lowest order bit of a
-        NZVC |= Enu::CMask * (a & 1);
-        break;
-    case Enu::NZVCA_func: // Move A to NZVC
-        res = 0;
-        NZVC |= Enu::NMask & a;
-        NZVC |= Enu::ZMask & a;
-        NZVC |= Enu::VMask & a;
-        NZVC |= Enu::CMask & a;
-        return true; // Must return early to avoid NZ calculation
-    default: // If the default has been hit, then an invalid function was selected
-        return false;
-    }
+    // Functions past the end of the table are invalid, and have no output.
+    quint8 aluFunc = controlSignals[Enu::ALU];
+    if(aluFunc >= aluTable.size()) return false;
+    const ALUEntry& entry = aluTable[aluFunc];
+    if(!entry.function(a, b, hasCIn, carryIn, res, NZVC)) return false;
+    // Must return early to avoid NZ calculation
+    if(!entry.computesNZ) return true;
     // Calculate N, then shift to correct position
     NZVC |= (res & 0x80) ? Enu::NMask : 0; // Result is negative if high order bit is 1
     // Calculate Z, then shift to correct position
@@ -284,6 +303,11 @@ Enu::MainBusState CPUDataSection::getMainBusState() const
     return mainBusState;
 }
 
+void CPUDataSection::setMainBusState(Enu::MainBusState state) noexcept
+{
+    mainBusState = state;
+}
+
 bool CPUDataSection::getStatusBit(Enu::EStatusBit statusBit) const
 {
     quint8 NZVCSbits = registerBank->readStatusBitsCurrent();
@@ -308,24 +332,14 @@ bool CPUDataSection::getStatusBit(Enu::EStatusBit statusBit) const
 
 void CPUDataSection::onSetStatusBit(Enu::EStatusBit statusBit, bool val)
 {
-    bool oldVal = false;
-
-    // Mask out the original value, then or it with the properly shifted bit
-    oldVal = registerBank->readStatusBitCurrent(statusBit);
-    registerBank->writeStatusBit(statusBit, val);
-    if(emitEvents) {
-        if(oldVal != val) emit statusBitChanged(statusBit, val);
-    }
+    if(emitEvents) setStatusBit<true>(statusBit, val);
+    else setStatusBit<false>(statusBit, val);
 }
 
 void CPUDataSection::onSetRegisterByte(quint8 reg, quint8 val)
 {
-    if(reg > 21) return; // Don't allow static registers to be written to
-    quint8 oldVal = getRegisterBankByte(reg);
-    registerBank->writeRegisterByte(reg, val);
-    if(emitEvents) {
-        if(oldVal != val) emit registerChanged(reg, oldVal, val);
-    }
+    if(emitEvents) setRegisterByte<true>(reg, val);
+    else setRegisterByte<false>(reg, val);
 }
 
 void CPUDataSection::onSetRegisterWord(quint8 reg, quint16 val)
@@ -343,11 +357,8 @@ void CPUDataSection::onSetRegisterWord(quint8 reg, quint16 val)
 
 void CPUDataSection::onSetMemoryRegister(Enu::EMemoryRegisters reg, quint8 val)
 {
-    quint8 oldVal = memoryRegisters[reg];
-    memoryRegisters[reg] = val;
-    if(emitEvents) {
-    if(oldVal != val) emit memoryRegisterChanged(reg, oldVal, val);
-    }
+    if(emitEvents) setMemoryRegister<true>(reg, val);
+    else setMemoryRegister<false>(reg, val);
 }
 
 void CPUDataSection::onSetClock(Enu::EClockSignals clock, bool value)
@@ -371,11 +382,11 @@ bool CPUDataSection::setSignalsFromMicrocode(const MicroCode *line)
      * to be the most time consuming piece of the simulation. Memcpy yielded a ~30%
      * increase in perfomance.
      */
-    if(controlSignals.length() == line->getControlSignals().length()) {
+    if(static_cast<int>(controlSignals.size()) == line->getControlSignals().length()) {
         // Memcpy is safe as long as both arrays match in size.
         memcpy(controlSignals.data(),
                line->getControlSignals().data(),
-               static_cast<std::size_t>(controlSignals.length()));
+               controlSignals.size());
     }
     else {
         hadDataError = true;
@@ -385,11 +396,11 @@ bool CPUDataSection::setSignalsFromMicrocode(const MicroCode *line)
     }
 
     // Same verification as described above, except for clock signals.
-    if(clockSignals.length() == line->getClockSignals().length()) {
+    if(static_cast<int>(clockSignals.size()) == line->getClockSignals().length()) {
         // Memcpy is safe as long as both arrays match in size.
         memcpy(clockSignals.data(),
                line->getClockSignals().data(),
-               static_cast<std::size_t>(clockSignals.length()));
+               clockSignals.size());
     }
     else {
         hadDataError = true;
@@ -400,6 +411,14 @@ bool CPUDataSection::setSignalsFromMicrocode(const MicroCode *line)
     return true;
 }
 
+void CPUDataSection::setSignalsFromControlWord(const ControlWord &word) noexcept
+{
+    memcpy(controlSignals.data(), word.controlSignals.data(), controlSignals.size());
+    for(std::size_t it = 0; it < clockSignals.size(); it++) {
+        clockSignals[it] = word.clockMask & (1 << it);
+    }
+}
+
 void CPUDataSection::setEmitEvents(bool b)
 {
     emitEvents = b;
@@ -471,169 +490,119 @@ void CPUDataSection::handleMainBusState() noexcept
     }
 }
 
-void CPUDataSection::stepOneByte() noexcept
+template<bool emitChanges>
+void CPUDataSection::setStatusBit(Enu::EStatusBit statusBit, bool val)
 {
-    //Update the bus state first, as the rest of the read / write functionality depends on it
-    handleMainBusState();
-    if(hadErrorOnStep()) return; //If the bus had an error, give up now
-
-    isALUCacheValid = false;
-    //Set up all variables needed by stepping calculation
-    Enu::EALUFunc aluFunc = static_cast<Enu::EALUFunc>(controlSignals[Enu::ALU]);
-    quint8 a = 0, b = 0, c = 0, alu = 0, NZVC = 0;
-    bool hasA = valueOnABus(a), hasB = valueOnBBus(b), hasC = valueOnCBus(c), statusBitError = false;
-    bool hasALUOutput = calculateALUOutput(alu,NZVC);
-
-    //Handle write to memory
-    if(mainBusState == Enu::MemWriteReady) {
-        // << upcasts from quint8 to int32, must explicitly narrow.
-        quint16 address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
-                | memoryRegisters[Enu::MEM_MARB]);
-        memDevice->writeByte(address, memoryRegisters[Enu::MEM_MDR]);
-    }
-
-    //MARCk
-    if(clockSignals[Enu::MARCk] && hasA && hasB) {
-        onSetMemoryRegister(Enu::MEM_MARA, a);
-        onSetMemoryRegister(Enu::MEM_MARB, b);
-    }
-    else if(clockSignals[Enu::MARCk]) {//Handle error where no data is present
-        hadDataError = true;
-        errorMessage = "No values on A & B during MARCk.";
-        return;
-    }
-
-    //LoadCk
-    if(clockSignals[Enu::LoadCk]) {
-        if(controlSignals[Enu::C] == Enu::signalDisabled) {
-            hadDataError = true;
-            errorMessage = "No destination register specified for LoadCk.";
-        }
-        else if(!hasC) {
-            hadDataError = true;
-            errorMessage = "No value on C Bus to clock in.";
-        }
-        else onSetRegisterByte(controlSignals[Enu::C], c);
-    }
-    quint16 address;
-    quint8 value;
-
-    //MDRCk
-    if(clockSignals[Enu::MDRCk]) {
-        switch(controlSignals[Enu::MDRMux]) {
-        case 0: //Pick memory
-            address = static_cast<quint16>(memoryRegisters[Enu::MEM_MARA]<<8) + memoryRegisters[Enu::MEM_MARB];
-            if(mainBusState != Enu::MemReadReady) {
-                hadDataError = true;
-                errorMessage = "No value from data bus to write to MDR.";
-            }
-            else {
-                memDevice->getByte(address, value);
-                onSetMemoryRegister(Enu::MEM_MDR, value);
-            }
-            break;
-        case 1: //Pick C Bus;
-            if(!hasC) {
-                hadDataError = true;
-                errorMessage = "No value on C bus to write to MDR.";
-            }
-            else onSetMemoryRegister(Enu::MEM_MDR,c);
-            break;
-        default:
-            hadDataError = true;
-            errorMessage = "No value to clock into MDR.";
-            break;
-        }
-
-    }
-
-    //NCk
-    if(clockSignals[Enu::NCk]) {
-        if(aluFunc!=Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_N,Enu::NMask & NZVC);
-        else statusBitError = true;
+    if constexpr(emitChanges) {
+        // Mask out the original value, then or it with the properly shifted bit
+        bool oldVal = registerBank->readStatusBitCurrent(statusBit);
+        registerBank->writeStatusBit(statusBit, val);
+        if(oldVal != val) emit statusBitChanged(statusBit, val);
     }
-
-    //ZCk
-    if(clockSignals[Enu::ZCk]) {
-        if(aluFunc!=Enu::UNDEFINED_func && hasALUOutput)
-        {
-            if(controlSignals[Enu::AndZ] == 0) {
-                onSetStatusBit(Enu::STATUS_Z,Enu::ZMask & NZVC);
-            }
-            else if(controlSignals[Enu::AndZ] == 1) {
-                onSetStatusBit(Enu::STATUS_Z, static_cast<bool>((Enu::ZMask & NZVC) && getStatusBit(Enu::STATUS_Z)));
-            }
-            else statusBitError = true;
-        }
-        else statusBitError = true;
+    else {
+        registerBank->writeStatusBit(statusBit, val);
     }
+}
 
-    //VCk
-    if(clockSignals[Enu::VCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_V,Enu::VMask & NZVC);
-        else statusBitError = true;
+template<bool emitChanges>
+void CPUDataSection::setRegisterByte(quint8 reg, quint8 val)
+{
+    if(reg > 21) return; // Don't allow static registers to be written to
+    if constexpr(emitChanges) {
+        quint8 oldVal = getRegisterBankByte(reg);
+        registerBank->writeRegisterByte(reg, val);
+        if(oldVal != val) emit registerChanged(reg, oldVal, val);
     }
-
-    //CCk
-    if(clockSignals[Enu::CCk]) {
-        if(aluFunc!=Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_C,Enu::CMask & NZVC);
-        else statusBitError = true;
+    else {
+        registerBank->writeRegisterByte(reg, val);
     }
+}
 
-    //SCk
-    if(clockSignals[Enu::SCk]) {
-        if(aluFunc!=Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_S,Enu::CMask & NZVC);
-        else statusBitError = true;
+template<bool emitChanges>
+void CPUDataSection::setMemoryRegister(Enu::EMemoryRegisters reg, quint8 val)
+{
+    if constexpr(emitChanges) {
+        quint8 oldVal = memoryRegisters[reg];
+        memoryRegisters[reg] = val;
+        if(oldVal != val) emit memoryRegisterChanged(reg, oldVal, val);
     }
-
-    if(statusBitError) {
-        hadDataError = true;
-        errorMessage = "ALU Error: No output from ALU to clock into status bits.";
+    else {
+        memoryRegisters[reg] = val;
     }
-
 }
 
-void CPUDataSection::stepTwoByte() noexcept
+template<Enu::CPUType type, bool emitChanges>
+void CPUDataSection::stepKernel() noexcept
 {
     //Update the bus state first, as the rest of the read / write functionality depends on it
     handleMainBusState();
     if(hadErrorOnStep()) return; //If the bus had an error, give up now
 
     isALUCacheValid = false;
-    // Set up all variables needed by stepping calculation
+    // Evaluate every bus and the ALU once, before any clocked element changes.
     Enu::EALUFunc aluFunc = static_cast<Enu::EALUFunc>(controlSignals[Enu::ALU]);
-    quint8 a = 0, b = 0, c = 0, alu = 0, NZVC = 0, temp = 0;
-    quint16 address;
-    bool memSigError = false, hasA = valueOnABus(a), hasB = valueOnBBus(b), hasC = valueOnCBus(c);
-    bool statusBitError = false, hasALUOutput = calculateALUOutput(alu, NZVC);
-
-    // Handle write to memory
-    if(mainBusState == Enu::MemWriteReady) {
-        // << widens quint8 to int32, must explictly narrow.
-        quint16 address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
-                | memoryRegisters[Enu::MEM_MARB]);
-        address&=0xFFFE; // Memory access ignores lowest order bit
-        memDevice->writeWord(address, memoryRegisters[Enu::MEM_MDRE]*256 + memoryRegisters[Enu::MEM_MDRO]);
-    }
-
-    // MARCk
-    if(clockSignals[Enu::MARCk]) {
-        if(controlSignals[Enu::MARMux] == 0) {
-            // If MARMux is 0, route MDRE, MDRO to MARA, MARB
-            onSetMemoryRegister(Enu::MEM_MARA, memoryRegisters[Enu::MEM_MDRE]);
-            onSetMemoryRegister(Enu::MEM_MARB, memoryRegisters[Enu::MEM_MDRO]);
+    quint8 a = 0, b = 0, c = 0, alu = 0, NZVC = 0;
+    bool hasA = valueOnABus(a), hasB = valueOnBBus(b);
+    bool hasALUOutput = calculateALUOutput(alu, NZVC);
+    // Equivalent to valueOnCBus(c), without asking the ALU for its output a second time.
+    bool hasC = false;
+    if(controlSignals[Enu::CMux] == 0) {
+        // If CMux is 0, then the NZVC bits (minus S) are directly routed to C
+        c = (registerBank->readStatusBitsCurrent() & (~Enu::SMask));
+        hasC = true;
+    }
+    else if(controlSignals[Enu::CMux] == 1 && hasALUOutput) {
+        c = alu;
+        hasC = true;
+    }
+    bool statusBitError = false;
+    // << widens quint8 to int32, must explictly narrow.
+    quint16 address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
+            | memoryRegisters[Enu::MEM_MARB]);
+
+    if constexpr(type == Enu::OneByteDataBus) {
+        //Handle write to memory
+        if(mainBusState == Enu::MemWriteReady) {
+            memDevice->writeByte(address, memoryRegisters[Enu::MEM_MDR]);
         }
-        else if(controlSignals[Enu::MARMux] == 1 && hasA && hasB) {
-            // If MARMux is 1, route A, B to MARA, MARB
-            onSetMemoryRegister(Enu::MEM_MARA, a);
-            onSetMemoryRegister(Enu::MEM_MARB,b );
+
+        //MARCk
+        if(clockSignals[Enu::MARCk] && hasA && hasB) {
+            setMemoryRegister<emitChanges>(Enu::MEM_MARA, a);
+            setMemoryRegister<emitChanges>(Enu::MEM_MARB, b);
         }
-        else {  // Otherwise MARCk is high, but no data flows through MARMux
+        else if(clockSignals[Enu::MARCk]) {//Handle error where no data is present
             hadDataError = true;
-            errorMessage = "MARMux has no output but MARCk.";
+            errorMessage = "No values on A & B during MARCk.";
             return;
         }
     }
+    else {
+        // Handle write to memory
+        if(mainBusState == Enu::MemWriteReady) {
+            // Memory access ignores lowest order bit
+            memDevice->writeWord(static_cast<quint16>(address & 0xFFFE), memoryRegisters[Enu::MEM_MDRE]*256 + memoryRegisters[Enu::MEM_MDRO]);
+        }
+
+        // MARCk
+        if(clockSignals[Enu::MARCk]) {
+            if(controlSignals[Enu::MARMux] == 0) {
+                // If MARMux is 0, route MDRE, MDRO to MARA, MARB
+                setMemoryRegister<emitChanges>(Enu::MEM_MARA, memoryRegisters[Enu::MEM_MDRE]);
+                setMemoryRegister<emitChanges>(Enu::MEM_MARB, memoryRegisters[Enu::MEM_MDRO]);
+            }
+            else if(controlSignals[Enu::MARMux] == 1 && hasA && hasB) {
+                // If MARMux is 1, route A, B to MARA, MARB
+                setMemoryRegister<emitChanges>(Enu::MEM_MARA, a);
+                setMemoryRegister<emitChanges>(Enu::MEM_MARB, b);
+            }
+            else {  // Otherwise MARCk is high, but no data flows through MARMux
+                hadDataError = true;
+                errorMessage = "MARMux has no output but MARCk.";
+                return;
+            }
+        }
+    }
 
     // LoadCk
     if(clockSignals[Enu::LoadCk]) {
@@ -645,105 +614,125 @@ void CPUDataSection::stepTwoByte() noexcept
             hadDataError = true;
             errorMessage = "No value on C Bus to clock in.";
         }
-        else onSetRegisterByte(controlSignals[Enu::C], c);
-    }
-
-    // MDRECk
-    if(clockSignals[Enu::MDRECk]) {
-        switch(controlSignals[Enu::MDREMux])
-        {
-        case 0: // Pick memory
-            // << widens quint8 to int32, must explictly narrow.
-            address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
-                    | memoryRegisters[Enu::MEM_MARB]);
-            address &= 0xFFFE; // Memory access ignores lowest order bit
-            if(mainBusState != Enu::MemReadReady){
+        else setRegisterByte<emitChanges>(controlSignals[Enu::C], c);
+    }
+
+    // MARCk may have changed the address used by memory reads.
+    address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
+            | memoryRegisters[Enu::MEM_MARB]);
+    quint8 value;
+    if constexpr(type == Enu::OneByteDataBus) {
+        //MDRCk
+        if(clockSignals[Enu::MDRCk]) {
+            switch(controlSignals[Enu::MDRMux]) {
+            case 0: //Pick memory
+                if(mainBusState != Enu::MemReadReady) {
+                    hadDataError = true;
+                    errorMessage = "No value from data bus to write to MDR.";
+                }
+                else {
+                    memDevice->getByte(address, value);
+                    setMemoryRegister<emitChanges>(Enu::MEM_MDR, value);
+                }
+                break;
+            case 1: //Pick C Bus;
+                if(!hasC) {
+                    hadDataError = true;
+                    errorMessage = "No value on C bus to write to MDR.";
+                }
+                else setMemoryRegister<emitChanges>(Enu::MEM_MDR,c);
+                break;
+            default:
                 hadDataError = true;
-                errorMessage = "No value from data bus to write to MDRE.";
-                return;
+                errorMessage = "No value to clock into MDR.";
+                break;
             }
-            else {
-                memSigError = memDevice->readByte(address, temp);
-                if(!memSigError) {
+        }
+    }
+    else {
+        address &= 0xFFFE; // Memory access ignores lowest order bit
+        // MDRECk
+        if(clockSignals[Enu::MDRECk]) {
+            switch(controlSignals[Enu::MDREMux])
+            {
+            case 0: // Pick memory
+                if(mainBusState != Enu::MemReadReady){
+                    hadDataError = true;
+                    errorMessage = "No value from data bus to write to MDRE.";
+                    return;
+                }
+                else if(!memDevice->readByte(address, value)) {
                     hadDataError = true;
                     errorMessage = "Unable to read from memory into MDRE.";
                     return;
                 }
-                onSetMemoryRegister(Enu::MEM_MDRE, temp);
-            }
-            break;
-        case 1: // Pick C Bus;
-            if(!hasC) {
-                hadDataError=true;
-                errorMessage = "No value on C bus to write to MDRE.";
-                return;
+                setMemoryRegister<emitChanges>(Enu::MEM_MDRE, value);
+                break;
+            case 1: // Pick C Bus;
+                if(!hasC) {
+                    hadDataError=true;
+                    errorMessage = "No value on C bus to write to MDRE.";
+                    return;
+                }
+                else setMemoryRegister<emitChanges>(Enu::MEM_MDRE,c);
+                break;
+            default:
+                hadDataError = true;
+                errorMessage = "No value to clock into MDRE.";
+                break;
             }
-            else onSetMemoryRegister(Enu::MEM_MDRE,c);
-            break;
-        default:
-            hadDataError = true;
-            errorMessage = "No value to clock into MDRE.";
-            break;
         }
 
-    }
-
-    //MDRECk
-    if(clockSignals[Enu::MDROCk]) {
-        switch(controlSignals[Enu::MDROMux])
-        {
-        case 0: //Pick memory
-            // << widens to quint8 to int32, must explictly narrow.
-            address = static_cast<quint16>((memoryRegisters[Enu::MEM_MARA]<<8)
-                    | memoryRegisters[Enu::MEM_MARB]);
-            address &= 0xFFFE; //Memory access ignores lowest order bit
-            address += 1;
-            if(mainBusState != Enu::MemReadReady){
-                hadDataError = true;
-                errorMessage = "No value from data bus to write to MDRO.";
-                return;
-            }
-            else {
-                memSigError = memDevice->readByte(address, temp);
-                if(!memSigError) {
+        // MDROCk
+        if(clockSignals[Enu::MDROCk]) {
+            switch(controlSignals[Enu::MDROMux])
+            {
+            case 0: //Pick memory
+                if(mainBusState != Enu::MemReadReady){
+                    hadDataError = true;
+                    errorMessage = "No value from data bus to write to MDRO.";
+                    return;
+                }
+                else if(!memDevice->readByte(static_cast<quint16>(address + 1), value)) {
                     hadDataError = true;
                     errorMessage = "Unable to read from memory into MDRE.";
                     return;
                 }
-                onSetMemoryRegister(Enu::MEM_MDRO, temp);
-            }
-            break;
-        case 1: //Pick C Bus;
-            if(!hasC) {
+                setMemoryRegister<emitChanges>(Enu::MEM_MDRO, value);
+                break;
+            case 1: //Pick C Bus;
+                if(!hasC) {
+                    hadDataError = true;
+                    errorMessage = "No value on C bus to write to MDRO.";
+                    return;
+                }
+                else setMemoryRegister<emitChanges>(Enu::MEM_MDRO, c);
+                break;
+            default:
                 hadDataError = true;
-                errorMessage = "No value on C bus to write to MDRO.";
-                return;
+                errorMessage = "No value to clock into MDRO.";
+                break;
             }
-            else onSetMemoryRegister(Enu::MEM_MDRO, c);
-            break;
-        default:
-            hadDataError = true;
-            errorMessage = "No value to clock into MDRO.";
-            break;
         }
-
     }
 
+    // If no ALU output, don't set flags.
+    bool canClockStatusBits = aluFunc != Enu::UNDEFINED_func && hasALUOutput;
+
     //NCk
     if(clockSignals[Enu::NCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_N, Enu::NMask & NZVC);
+        if(canClockStatusBits) setStatusBit<emitChanges>(Enu::STATUS_N, Enu::NMask & NZVC);
         else statusBitError = true;
     }
 
-    //If no ALU output, don't set flags.
     //ZCk
     if(clockSignals[Enu::ZCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) {
+        if(canClockStatusBits) {
             if(controlSignals[Enu::AndZ] == 0) {
-                onSetStatusBit(Enu::STATUS_Z,Enu::ZMask & NZVC);
+                setStatusBit<emitChanges>(Enu::STATUS_Z, Enu::ZMask & NZVC);
             }
             else if(controlSignals[Enu::AndZ] == 1) {
-                onSetStatusBit(Enu::STATUS_Z, static_cast<bool>((Enu::ZMask & NZVC) && getStatusBit(Enu::STATUS_Z)));
+                setStatusBit<emitChanges>(Enu::STATUS_Z, static_cast<bool>((Enu::ZMask & NZVC) && getStatusBit(Enu::STATUS_Z)));
             }
             else statusBitError = true;
         }
@@ -752,19 +741,19 @@ void CPUDataSection::stepTwoByte() noexcept
 
     //VCk
     if(clockSignals[Enu::VCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_V, Enu::VMask & NZVC);
+        if(canClockStatusBits) setStatusBit<emitChanges>(Enu::STATUS_V, Enu::VMask & NZVC);
         else statusBitError = true;
     }
 
     //CCk
     if(clockSignals[Enu::CCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_C, Enu::CMask & NZVC);
+        if(canClockStatusBits) setStatusBit<emitChanges>(Enu::STATUS_C, Enu::CMask & NZVC);
         else statusBitError = true;
     }
 
     //SCk
     if(clockSignals[Enu::SCk]) {
-        if(aluFunc != Enu::UNDEFINED_func && hasALUOutput) onSetStatusBit(Enu::STATUS_S, Enu::CMask & NZVC);
+        if(canClockStatusBits) setStatusBit<emitChanges>(Enu::STATUS_S, Enu::CMask & NZVC);
         else statusBitError = true;
     }
 
@@ -792,17 +781,13 @@ void CPUDataSection::presetStaticRegisters() noexcept
 void CPUDataSection::clearControlSignals() noexcept
 {
     //Set all control signals to disabled
-    for(int it = 0; it < controlSignals.length(); it++) {
-        controlSignals[it] = Enu::signalDisabled;
-    }
+    controlSignals.fill(Enu::signalDisabled);
 }
 
 void CPUDataSection::clearClockSignals() noexcept
 {
     //Set all clock signals to low
-    for(int it = 0; it < clockSignals.length(); it++) {
-        clockSignals[it]=false;
-    }
+    clockSignals.fill(false);
 }
 
 void CPUDataSection::clearRegisters() noexcept
@@ -813,9 +798,7 @@ void CPUDataSection::clearRegisters() noexcept
     presetStaticRegisters();
 
      // Clear all values from memory registers
-    for(int it = 0; it < memoryRegisters.length(); it++) {
-        memoryRegisters[it] = 0;
-    }
+    memoryRegisters.fill(0);
 }
 
 void CPUDataSection::clearErrors() noexcept
@@ -829,10 +812,12 @@ void CPUDataSection::onStep() noexcept
     //If the error hasn't been handled by now, clear it
     clearErrors();
     if(cpuFeatures == Enu::OneByteDataBus) {
-        stepOneByte();
+        if(emitEvents) stepKernel<Enu::OneByteDataBus, true>();
+        else stepKernel<Enu::OneByteDataBus, false>();
     }
     else if(cpuFeatures == Enu::TwoByteDataBus) {
-        stepTwoByte();
+        if(emitEvents) stepKernel<Enu::TwoByteDataBus, true>();
+        else stepKernel<Enu::TwoByteDataBus, false>();
     }
 }
 
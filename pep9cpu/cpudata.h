@@ -21,6 +21,8 @@
 #ifndef CPUDATASECTION_H
 #define CPUDATASECTION_H
 
+#include <array>
+
 #include <QObject>
 #include <QObject>
 #include <QVector>
@@ -28,6 +30,7 @@
 #include <QString>
 #include "enu.h"
 class AMemoryDevice;
+struct ControlWord;
 class InterfaceMCCPU;
 class MemorySection;
 class MicroCode;
@@ -57,6 +60,8 @@ public:
     bool valueOnBBus(quint8& result) const;
     bool valueOnCBus(quint8& result) const;
     Enu::MainBusState getMainBusState() const;
+    // Only needed to undo a cycle, as the bus state otherwise changes only while stepping.
+    void setMainBusState(Enu::MainBusState state) noexcept;
 
     //Test for Signals and Registers
     quint8 getControlSignals(Enu::EControlSignals controlSignal) const;
@@ -64,6 +69,9 @@ public:
     bool getStatusBit(Enu::EStatusBit) const;
 
     bool setSignalsFromMicrocode(const MicroCode* line);
+    // Faster alternative to setSignalsFromMicrocode(...) for use while simulating.
+    // Control words always match the data section's layout, so this cannot fail.
+    void setSignalsFromControlWord(const ControlWord& word) noexcept;
     void setEmitEvents(bool b);
     //Return information about errors on the last step
     bool hadErrorOnStep() const;
@@ -85,6 +93,7 @@ public:
     //Helper functions to clear different aspects of the data section
     void clearControlSignals() noexcept;
     void clearClockSignals() noexcept;
+    void clearErrors() noexcept;
 
 private:
     void setMemoryDevice(QSharedPointer<AMemoryDevice> newDevice);
@@ -96,11 +105,11 @@ private:
 
     //Data registers
     QSharedPointer<RegisterFile> registerBank;
-    QVector<quint8> memoryRegisters;
+    std::array<quint8, 6> memoryRegisters;
 
     //Control Signals
-    QVector<quint8> controlSignals;
-    QVector<bool> clockSignals;
+    std::array<quint8, Enu::controlSignalCount> controlSignals;
+    std::array<bool, Enu::clockSignalCount> clockSignals;
 
     //Error handling
     bool hadDataError;
@@ -117,12 +126,21 @@ private:
     void presetStaticRegisters() noexcept;
 
     void clearRegisters() noexcept;
-    void clearErrors() noexcept;
 
     //Simulation stepping logic
     void handleMainBusState() noexcept;
-    void stepOneByte() noexcept;
-    void stepTwoByte() noexcept;
+    // Execute one cycle of the data section. There is one kernel per bus width,
+    // and per setting of emitEvents, so neither is checked while the cycle executes.
+    template<Enu::CPUType type, bool emitChanges>
+    void stepKernel() noexcept;
+
+    // Setters used by the kernels, which only emit change signals if emitChanges is true.
+    template<bool emitChanges>
+    void setStatusBit(Enu::EStatusBit statusBit, bool val);
+    template<bool emitChanges>
+    void setRegisterByte(quint8 reg, quint8 val);
+    template<bool emitChanges>
+    void setMemoryRegister(Enu::EMemoryRegisters reg, quint8 val);
 
 public slots:
     void onSetStatusBit(Enu::EStatusBit,bool val);
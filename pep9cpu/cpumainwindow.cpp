@@ -54,6 +54,7 @@
 #include "microcodeprogram.h"
 #include "microobjectcodepane.h"
 #include "partialmicrocodedcpu.h"
+#include "simulationrunner.h"
 #include "symboltable.h"
 #include "updatechecker.h"
 
@@ -62,7 +63,7 @@ CPUMainWindow::CPUMainWindow(QWidget *parent) :
     ui(new Ui::CPUMainWindow), debugState(DebugState::DISABLED), codeFont(QFont(Pep::codeFont, Pep::codeFontSize)),
     updateChecker(new UpdateChecker()),  isInDarkMode(false),
     memDevice(new MainMemory(nullptr)), controlSection(new PartialMicrocodedCPU(Enu::CPUType::OneByteDataBus, memDevice)),
-    dataSection(controlSection->getDataSection()),
+    dataSection(controlSection->getDataSection()), runner(new SimulationRunner(controlSection, this)),
     cpuModesGroup(new QActionGroup(this))
 {
     // Initialize the memory subsystem
@@ -139,6 +140,8 @@ CPUMainWindow::CPUMainWindow(QWidget *parent) :
     connect(this, &CPUMainWindow::simulationFinished, ui->memoryWidget, &MemoryDumpPane::onSimulationFinished, Qt::QueuedConnection);
     // Connect MainWindow so that it can propogate simulationFinished event and clean up when execution is finished.
     connect(controlSection.get(), &PartialMicrocodedCPU::simulationFinished, this, &CPUMainWindow::onSimulationFinished);
+    connect(runner, &SimulationRunner::finished, this, &CPUMainWindow::onRunFinished);
+    connect(runner, &SimulationRunner::progress, this, &CPUMainWindow::onRunProgress);
 
     // Connect simulation events that are internal to the class.
     connect(this, &CPUMainWindow::simulationUpdate, this, &CPUMainWindow::handleDebugButtons, Qt::UniqueConnection);
@@ -187,6 +190,11 @@ CPUMainWindow::CPUMainWindow(QWidget *parent) :
 
 CPUMainWindow::~CPUMainWindow()
 {
+    // A simulation on the worker thread must stop before the objects it uses are destroyed.
+    if(runner->isRunning()) {
+        controlSection->requestCancel();
+        runner->waitForFinished();
+    }
     delete ui;
     //delete helpDialog;
     delete aboutPepDialog;
@@ -744,19 +752,13 @@ void CPUMainWindow::on_actionBuild_Run_triggered()
         memDevice->clearBytesSet();
         memDevice->clearBytesWritten();
         controlSection->onSimulationStarted();
-        controlSection->onRun();
-        // Make sure to highlight modified memory addresses to make it clear to the user
-        // what has been modified over the course of execution.
-        highlightActiveLines();
-        connectViewUpdate();
-
+        // Execution continues in the background, and is wrapped up by onRunFinished().
+        runner->start([this](){controlSection->onRun();});
     }
     else {
         // If the simulation can't be initialized, revert to default state.
         debugState = DebugState::DISABLED;
    }
-   // If somehow the simulation is not finished, then make sure to terminate it.
-   if(debugState != DebugState::DISABLED) onSimulationFinished();
 }
 
 // Debug slots
@@ -815,6 +817,11 @@ bool CPUMainWindow::on_actionDebug_Start_Debugging_triggered()
 
 void CPUMainWindow::on_actionDebug_Stop_Debugging_triggered()
 {
+    if(runner->isRunning()) {
+        // Let onRunFinished() clean up once the simulation stops.
+        controlSection->requestCancel();
+        return;
+    }
     connectViewUpdate();
     highlightActiveLines();
     debugState = DebugState::DISABLED;
@@ -844,16 +851,8 @@ void CPUMainWindow::on_actionDebug_Continue_triggered()
     debugState = DebugState::DEBUG_RESUMED;
     handleDebugButtons();
     disconnectViewUpdate();
-    controlSection->onRun();
-    connectViewUpdate();
-    emit simulationUpdate();
-    QApplication::processEvents();
-    if(controlSection->hadErrorOnStep()) {
-        return; // we'll just return here instead of letting it fail and go to the bottom
-    }
-    if(controlSection->stoppedForBreakpoint()) {
-        highlightActiveLines();
-    }
+    // Execution continues in the background, and is wrapped up by onRunFinished().
+    runner->start([this](){controlSection->onRun();});
 }
 
 void CPUMainWindow::on_actionDebug_Single_Step_Microcode_triggered()
@@ -941,6 +940,29 @@ void CPUMainWindow::onSimulationFinished()
     else ui->statusBar->showMessage("Execution finished", 4000);
 }
 
+void CPUMainWindow::onRunFinished()
+{
+    // Make sure to highlight modified memory addresses to make it clear to the user
+    // what has been modified over the course of execution.
+    highlightActiveLines();
+    connectViewUpdate();
+    // The CPU's signals are blocked while it runs in the background, so determine how the
+    // simulation stopped after the fact. A run (as opposed to debugging) always terminates.
+    if(debugState == DebugState::RUN || controlSection->getExecutionFinished() || controlSection->hadErrorOnStep()) {
+        onSimulationFinished();
+        return;
+    }
+    if(controlSection->stoppedForBreakpoint()) {
+        onBreakpointHit(Enu::BreakpointTypes::MICROCODE);
+    }
+    emit simulationUpdate();
+}
+
+void CPUMainWindow::onRunProgress(ACPUModel::RunStatus status)
+{
+    ui->statusBar->showMessage(SimulationRunner::describeProgress(status, "cycles"));
+}
+
 void CPUMainWindow::onDarkModeChanged()
 {
     isInDarkMode = inDarkMode();
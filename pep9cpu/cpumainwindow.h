@@ -23,6 +23,7 @@
 
 #include <QtWidgets/QMainWindow>
 
+#include "acpumodel.h"
 #include "enu.h"
 #include "pep.h"
 #include <QDir>
@@ -45,6 +46,7 @@ class QActionGroup;
 class PartialMicrocodedCPU;
 class CPUDataSection;
 class MainMemory;
+class SimulationRunner;
 
 /*
  * The set of possible states for the debugger.
@@ -86,6 +88,8 @@ private:
     QSharedPointer<MainMemory> memDevice;
     QSharedPointer<PartialMicrocodedCPU> controlSection;
     QSharedPointer<CPUDataSection> dataSection;
+    // Runs simulations on a worker thread.
+    SimulationRunner* runner;
 
     CPUHelpDialog *helpDialog;
     AboutPep *aboutPepDialog;
@@ -207,6 +211,9 @@ private slots:
 
     //Run events
     void onSimulationFinished();
+    // React to a run or continue that stopped, either because it finished, failed, or hit a breakpoint.
+    void onRunFinished();
+    void onRunProgress(ACPUModel::RunStatus status);
 
     // Byte converter
     void slotByteConverterDecEdited(const QString &);
@@ -19,9 +19,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "interfacemccpu.h"
+#include "controlstore.h"
 #include "microcodeprogram.h"
 InterfaceMCCPU::InterfaceMCCPU(Enu::CPUType type) noexcept: microprogramCounter(0), microCycleCounter(0),
-    microBreakpointHit(false), sharedProgram(nullptr), type(type)
+    microBreakpointHit(false), sharedProgram(nullptr), controlStore(nullptr), type(type)
 {
 
 }
@@ -41,6 +42,11 @@ quint16 InterfaceMCCPU::getMicrocodeLineNumber() const noexcept
     return microprogramCounter;
 }
 
+bool InterfaceMCCPU::stoppedForMicroBreakpoint() const noexcept
+{
+    return microBreakpointHit;
+}
+
 QSharedPointer<const MicrocodeProgram> InterfaceMCCPU::getProgram() const noexcept
 {
     return sharedProgram;
@@ -54,6 +60,8 @@ const MicroCode* InterfaceMCCPU::getCurrentMicrocodeLine() const noexcept
 void InterfaceMCCPU::setMicrocodeProgram(QSharedPointer<MicrocodeProgram> program)
 {
     this->sharedProgram = program;
+    if(program.isNull()) controlStore.clear();
+    else controlStore = QSharedPointer<const ControlStore>::create(*program);
     microprogramCounter = 0;
 }
 
@@ -23,6 +23,7 @@
 
 #include "acpumodel.h"
 #include "enu.h"
+class ControlStore;
 class MicroCode;
 class MicrocodeProgram;
 /*
@@ -42,12 +43,15 @@ public:
     quint64 getCycleCounter() const noexcept;
     // Get the index of the currently executing line of microcode
     quint16 getMicrocodeLineNumber() const noexcept;
+    // Returns true if execution is halted because of a microcode breakpoint.
+    bool stoppedForMicroBreakpoint() const noexcept;
 
     // May be nullptr if no program has been loaded
     QSharedPointer<const MicrocodeProgram> getProgram() const noexcept;
     const MicroCode* getCurrentMicrocodeLine() const noexcept;
 
 
+    // Also compiles the program into the control store that the CPU executes from.
     void setMicrocodeProgram(QSharedPointer<MicrocodeProgram> sharedProgram);
     Enu::CPUType getCPUType() const noexcept;
 
@@ -80,6 +84,8 @@ protected:
     quint64 microCycleCounter;
     bool microBreakpointHit;
     QSharedPointer<MicrocodeProgram> sharedProgram;
+    // Packed form of sharedProgram's microcode, rebuilt whenever the program changes.
+    QSharedPointer<const ControlStore> controlStore;
     Enu::CPUType type;
 };
 
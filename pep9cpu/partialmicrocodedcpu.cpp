@@ -24,6 +24,7 @@
 #include <QTimer>
 
 #include "amemorydevice.h"
+#include "controlstore.h"
 #include "cpudata.h"
 #include "interrupthandler.h"
 #include "microcode.h"
@@ -223,33 +224,28 @@ void PartialMicrocodedCPU::onMCStep()
     }
 
     // Do step logic
-    const MicroCode* prog = sharedProgram->getCodeLine(microprogramCounter);
-
-    try {
-        data->setSignalsFromMicrocode(prog);
-    }
-    /*
-     * An invalid_argument execption will be thrown if data's memcpy would fail.
-     * By catching this exception, we convert a hard failure to a friendly error message
-     * for the user application. Any other exceptions should crash the program, because
-     * we do not expect other issues to arise from memcpy.
-     *
-     * Since exceptions are zero-cost during error-free execution, and failing to set microcode
-     * signals would be irreparable, the decisions to communicate failure through execptions
-     * was made as a perfomance decision.
-     */
-    catch (std::invalid_argument &) {
+    if(!controlStore->contains(microprogramCounter)) {
+        controlError = true;
+        executionFinished = true;
+        errorMessage = "ERROR: µPC does not address a line of microcode.";
         return;
     }
+    data->setSignalsFromControlWord(controlStore->at(microprogramCounter));
 
     data->onStep();
     branchHandler();
     microCycleCounter++;
     //qDebug().nospace().noquote() << prog->getSourceCode();
 
+    // Give requests made while running (e.g. cancellation) a chance to be acted upon.
+    if(microCycleCounter % 5000 == 0) {
+        pollRequests(microCycleCounter);
+    }
+
     if(executionFinished || hadErrorOnStep()) {
         memoizer->storeStateInstrEnd();
         data->getRegisterBank().flattenFile();
+        if(headless) synchronizeChanges();
         emit simulationFinished();
 
     }
@@ -276,7 +272,7 @@ void PartialMicrocodedCPU::onClock()
 
 void PartialMicrocodedCPU::branchHandler()
 {
-    if(sharedProgram->getCodeLine(microprogramCounter)->getBranchFunction() == Enu::EBranchFunctions::Stop) {
+    if(controlStore->at(microprogramCounter).branchFunction == Enu::EBranchFunctions::Stop) {
         executionFinished = true;
     }
     else if(executionFinished) {
@@ -290,6 +286,7 @@ void PartialMicrocodedCPU::branchHandler()
 void PartialMicrocodedCPU::breakpointMicroHandler()
 {
     microBreakpointHit = true;
+    if(headless) synchronizeChanges();
     emit hitBreakpoint(Enu::BreakpointTypes::MICROCODE);
     return;
 }
@@ -21,14 +21,16 @@
 */
 #include "fullmicrocodedcpu.h"
 
-#include <QApplication>
 #include <QTimer>
 
 #include "amemorydevice.h"
 #include "asmprogrammanager.h"
+#include "controlstore.h"
 #include "cpudata.h"
 #include "fullmicrocodedmemoizer.h"
 #include "interrupthandler.h"
+#include "isacpu.h"
+#include "mainmemory.h"
 #include "microcode.h"
 #include "microcodeprogram.h"
 #include "pep.h"
@@ -36,7 +38,10 @@
 #include "symbolentry.h"
 FullMicrocodedCPU::FullMicrocodedCPU(const AsmProgramManager* manager, QSharedPointer<AMemoryDevice> memoryDev, QObject* parent) noexcept: ACPUModel (memoryDev, parent),
     InterfaceMCCPU(Enu::CPUType::TwoByteDataBus),
-    InterfaceISACPU(memoryDev.get(), manager), memoizer(new FullMicrocodedMemoizer(*this))
+    InterfaceISACPU(memoryDev.get(), manager), memoizer(new FullMicrocodedMemoizer(*this)),
+    nativeCpu(new IsaCpu(manager, memoryDev, nullptr, IsaCpuCore::THREADED)), hybridExecution(false),
+    microcodedMnemonics(), microcodedRanges(), microcodedSpecifiers(), nativeInstructionCounter(0),
+    journal(nullptr), journalStart()
 {
     data = new CPUDataSection(Enu::CPUType::TwoByteDataBus, memoryDev, parent);
     dataShared = QSharedPointer<CPUDataSection>(data);
@@ -51,7 +56,10 @@ FullMicrocodedCPU::FullMicrocodedCPU(const AsmProgramManager* manager, QSharedPo
 FullMicrocodedCPU::~FullMicrocodedCPU()
 {
     //This object should last the lifetime of the  program, it does not need to be cleaned up.
+    // Memory may outlive the CPU, so it must let go of the journal.
+    setReverseStepEnabled(false);
     delete memoizer;
+    delete nativeCpu;
     // No need to delete data, as it will be cleaned up by dataShared.
 }
 
@@ -71,6 +79,149 @@ void FullMicrocodedCPU::setMicroPCToStart() noexcept
     microprogramCounter = startLine;
 }
 
+void FullMicrocodedCPU::setHybridExecution(bool enabled) noexcept
+{
+    hybridExecution = enabled;
+}
+
+bool FullMicrocodedCPU::getHybridExecution() const noexcept
+{
+    return hybridExecution;
+}
+
+void FullMicrocodedCPU::setMicrocodedMnemonics(QList<Enu::EMnemonic> mnemonics)
+{
+    microcodedMnemonics = mnemonics;
+    calculateMicrocodedSpecifiers();
+}
+
+void FullMicrocodedCPU::setMicrocodedRanges(QList<QPair<quint16, quint16> > ranges)
+{
+    microcodedRanges = ranges;
+}
+
+quint64 FullMicrocodedCPU::getNativeInstructionCount() const noexcept
+{
+    return nativeInstructionCounter;
+}
+
+bool FullMicrocodedCPU::setReverseStepEnabled(bool enabled, int capacity)
+{
+    MainMemory* mainMemory = dynamic_cast<MainMemory*>(memory.get());
+    if(enabled && mainMemory == nullptr) return false;
+    if(mainMemory != nullptr) mainMemory->setJournal(nullptr);
+    delete journal;
+    journal = nullptr;
+    if(enabled) {
+        journal = new WriteJournal(capacity);
+        mainMemory->setJournal(journal);
+    }
+    return true;
+}
+
+bool FullMicrocodedCPU::isReverseStepEnabled() const noexcept
+{
+    return journal != nullptr;
+}
+
+bool FullMicrocodedCPU::canStepBack() const noexcept
+{
+    return journal != nullptr && journal->stepCount() > 0;
+}
+
+bool FullMicrocodedCPU::stepBackMicrocode()
+{
+    QVector<WriteJournal::Entry> entries;
+    if(journal == nullptr || !journal->popStep(entries)) return false;
+    // Clear at start, so as to preserve highlighting AFTER finshing a write.
+    memory->clearBytesWritten();
+    RegisterFile& registers = data->getRegisterBank();
+    // Entries are ordered most recent first, so a location written twice ends up with its oldest value.
+    for(const WriteJournal::Entry& entry : entries) {
+        switch(entry.target) {
+        case WriteJournal::Target::MEMORY:
+            memory->setByte(entry.address, entry.value);
+            break;
+        case WriteJournal::Target::REGISTER:
+            registers.writeRegisterByte(static_cast<quint8>(entry.address), entry.value);
+            break;
+        case WriteJournal::Target::STATUS_BITS:
+            registers.writeStatusBits(entry.value);
+            break;
+        case WriteJournal::Target::CONTROL:
+            switch(entry.value) {
+            case JournalSlot::MICRO_PC:
+                microprogramCounter = entry.address;
+                break;
+            case JournalSlot::MICRO_CYCLES:
+                microCycleCounter -= entry.address;
+                break;
+            case JournalSlot::ASM_INSTRUCTIONS:
+                asmInstructionCounter -= entry.address;
+                break;
+            case JournalSlot::NATIVE_INSTRUCTIONS:
+                nativeInstructionCounter -= entry.address;
+                break;
+            case JournalSlot::CALL_DEPTH:
+                callDepth = static_cast<qint16>(entry.address);
+                break;
+            case JournalSlot::OPERAND_VALUE:
+                opValCache = entry.address;
+                break;
+            case JournalSlot::PREFETCH_VALID:
+                isPrefetchValid = entry.address != 0;
+                break;
+            case JournalSlot::REGISTER_START:
+                registers.writeRegisterByteStart(static_cast<quint8>(entry.address >> 8),
+                                                 static_cast<quint8>(entry.address & 0xff));
+                break;
+            case JournalSlot::STATUS_BITS_START:
+                registers.writeStatusBitsStart(static_cast<quint8>(entry.address));
+                break;
+            case JournalSlot::MEMORY_REGISTER:
+                data->onSetMemoryRegister(static_cast<Enu::EMemoryRegisters>(entry.address >> 8),
+                                          static_cast<quint8>(entry.address & 0xff));
+                break;
+            case JournalSlot::MAIN_BUS_STATE:
+                data->setMainBusState(static_cast<Enu::MainBusState>(entry.address));
+                break;
+            }
+            break;
+        case WriteJournal::Target::INPUT:
+            // Only a MainMemory may be journaled.
+            static_cast<MainMemory*>(memory.get())->unreadInput(entry.address, entry.value);
+            break;
+        default:
+            break;
+        }
+    }
+    // The first cycle of an instruction counted it in the histogram.
+    if(microprogramCounter == startLine) memoizer->undoStateInstrStart();
+    // The signals shown belong to the undone cycle, and the cycle before it can't be recovered.
+    data->clearControlSignals();
+    data->clearClockSignals();
+    // Undoing the cycle also undoes any error it caused.
+    data->clearErrors();
+    memory->clearErrors();
+    controlError = false;
+    executionFinished = false;
+    errorMessage = "";
+    microBreakpointHit = false;
+    asmBreakpointHit = false;
+    if(memTrace->userStack.isStackIntact()) {
+        memTrace->userStack.setStackIntact(false);
+        memTrace->userStack.setErrorMessage("WARNING: The stack trace is not available after stepping back.");
+    }
+    return true;
+}
+
+bool FullMicrocodedCPU::stepBack()
+{
+    if(!stepBackMicrocode()) return false;
+    while(microprogramCounter != startLine && stepBackMicrocode()) {}
+    return true;
+}
+
 bool FullMicrocodedCPU::getStatusBitCurrent(Enu::EStatusBit bit) const
 {
     return data->getRegisterBank().readStatusBitCurrent(bit);
@@ -143,8 +294,11 @@ void FullMicrocodedCPU::onSimulationStarted()
         startLine = 0;
     }
     memoizer->clear();
+    clearProfilers();
     calculateInstrJT();
     calculateAddrJT();
+    calculateMicrocodedSpecifiers();
+    nativeCpu->onSimulationStarted();
     ACPUModel::handler->clearQueuedInterrupts();
 }
 
@@ -243,6 +397,9 @@ void FullMicrocodedCPU::onResetCPU()
     memoizer->clear();
     InterfaceMCCPU::reset();
     InterfaceISACPU::reset();
+    nativeCpu->onResetCPU();
+    nativeInstructionCounter = 0;
+    if(journal != nullptr) journal->clear();
     inSimulation = false;
     inDebug = false;
     callDepth = 0;
@@ -256,6 +413,85 @@ void FullMicrocodedCPU::onResetCPU()
 }
 
 void FullMicrocodedCPU::onMCStep()
+{
+    if(journal == nullptr) {
+        executeCycle();
+        return;
+    }
+    beginJournalStep();
+    executeCycle();
+    endJournalStep();
+}
+
+void FullMicrocodedCPU::beginJournalStep()
+{
+    journal->beginStep();
+    journalStart.registers = data->getRegisterBank();
+    for(std::size_t reg = 0; reg < journalStart.memoryRegisters.size(); reg++) {
+        journalStart.memoryRegisters[reg] = data->getMemoryRegister(static_cast<Enu::EMemoryRegisters>(reg));
+    }
+    journalStart.mainBusState = data->getMainBusState();
+    journalStart.microprogramCounter = microprogramCounter;
+    journalStart.microCycleCounter = microCycleCounter;
+    journalStart.asmInstructionCounter = asmInstructionCounter;
+    journalStart.nativeInstructionCounter = nativeInstructionCounter;
+    journalStart.callDepth = callDepth;
+    journalStart.opValCache = opValCache;
+    journalStart.isPrefetchValid = isPrefetchValid;
+}
+
+void FullMicrocodedCPU::endJournalStep()
+{
+    const RegisterFile& registers = data->getRegisterBank();
+    registers.journalChanges(journalStart.registers, *journal);
+    // Starting values only change at the end of an instruction, when the file is flattened.
+    for(quint8 reg = 0; reg <= Enu::maxRegisterNumber; reg++) {
+        const quint8 previous = journalStart.registers.readRegisterByteStart(reg);
+        if(registers.readRegisterByteStart(reg) != previous) {
+            journal->recordControl(JournalSlot::REGISTER_START, static_cast<quint16>(reg << 8 | previous));
+        }
+    }
+    if(registers.readStatusBitsStart() != journalStart.registers.readStatusBitsStart()) {
+        journal->recordControl(JournalSlot::STATUS_BITS_START, journalStart.registers.readStatusBitsStart());
+    }
+    for(std::size_t reg = 0; reg < journalStart.memoryRegisters.size(); reg++) {
+        const quint8 previous = journalStart.memoryRegisters[reg];
+        if(data->getMemoryRegister(static_cast<Enu::EMemoryRegisters>(reg)) != previous) {
+            journal->recordControl(JournalSlot::MEMORY_REGISTER, static_cast<quint16>(reg << 8 | previous));
+        }
+    }
+    if(data->getMainBusState() != journalStart.mainBusState) {
+        journal->recordControl(JournalSlot::MAIN_BUS_STATE, static_cast<quint16>(journalStart.mainBusState));
+    }
+    if(microprogramCounter != journalStart.microprogramCounter) {
+        journal->recordControl(JournalSlot::MICRO_PC, journalStart.microprogramCounter);
+    }
+    // A cycle adds at most one to each of the counters.
+    if(microCycleCounter != journalStart.microCycleCounter) {
+        journal->recordControl(JournalSlot::MICRO_CYCLES,
+                               static_cast<quint16>(microCycleCounter - journalStart.microCycleCounter));
+    }
+    if(asmInstructionCounter != journalStart.asmInstructionCounter) {
+        journal->recordControl(JournalSlot::ASM_INSTRUCTIONS,
+                               static_cast<quint16>(asmInstructionCounter - journalStart.asmInstructionCounter));
+    }
+    if(nativeInstructionCounter != journalStart.nativeInstructionCounter) {
+        journal->recordControl(JournalSlot::NATIVE_INSTRUCTIONS,
+                               static_cast<quint16>(nativeInstructionCounter - journalStart.nativeInstructionCounter));
+    }
+    if(callDepth != journalStart.callDepth) {
+        journal->recordControl(JournalSlot::CALL_DEPTH, static_cast<quint16>(journalStart.callDepth));
+    }
+    if(opValCache != journalStart.opValCache) {
+        journal->recordControl(JournalSlot::OPERAND_VALUE, journalStart.opValCache);
+    }
+    if(isPrefetchValid != journalStart.isPrefetchValid) {
+        journal->recordControl(JournalSlot::PREFETCH_VALID, journalStart.isPrefetchValid ? 1 : 0);
+    }
+    journal->endStep();
+}
+
+void FullMicrocodedCPU::executeCycle()
 {
     microBreakpointHit = false;
     asmBreakpointHit = false;
@@ -268,28 +504,22 @@ void FullMicrocodedCPU::onMCStep()
         memoizer->storeStateInstrStart();
         memory->onCycleStarted();
         InterfaceISACPU::calculateStackChangeStart(this->getCPURegByteStart(Enu::CPURegisters::IS));
+        if(hybridExecution && executesNatively()) {
+            onNativeStep();
+            return;
+        }
     }
 
     // Do step logic
-    const MicroCode* prog = sharedProgram->getCodeLine(microprogramCounter);
-
-    this->setSignalsFromMicrocode(prog);
-    try {
-        data->setSignalsFromMicrocode(prog);
-    }
-    /*
-     * An invalid_argument execption will be thrown if data's memcpy would fail.
-     * By catching this exception, we convert a hard failure to a friendly error message
-     * for the user application. Any other exceptions should crash the program, because
-     * we do not expect other issues to arise from memcpy.
-     *
-     * Since exceptions are zero-cost during error-free execution, and failing to set microcode
-     * signals would be irreparable, the decisions to communicate failure through execptions
-     * was made as a perfomance decision.
-     */
-    catch (std::invalid_argument &) {
+    if(!controlStore->contains(microprogramCounter)) {
+        controlError = true;
+        executionFinished = true;
+        errorMessage = "ERROR: µPC does not address a line of microcode.";
         return;
     }
+    const ControlWord& word = controlStore->at(microprogramCounter);
+    this->setSignalsFromControlWord(word);
+    data->setSignalsFromControlWord(word);
 
     // Step inside the data section, then hnalde updating microprogram counter.
     data->onStep();
@@ -299,34 +529,16 @@ void FullMicrocodedCPU::onMCStep()
     // If we just finished an entire ISA level instruction, perform additional
     // simulation logic needed to mantain ISA level state.
     if(microprogramCounter == startLine || executionFinished) {
-        quint16 progCounter = getCPURegWordStart(Enu::CPURegisters::PC);
-        InterfaceISACPU::calculateStackChangeEnd(this->getCPURegByteCurrent(Enu::CPURegisters::IS),
-                                                 this->getCPURegWordCurrent(Enu::CPURegisters::OS),
-                                                 this->getCPURegWordStart(Enu::CPURegisters::SP),
-                                                 this->getCPURegWordStart(Enu::CPURegisters::PC),
-                                                 this->getCPURegWordCurrent(Enu::CPURegisters::A));
-        memoizer->storeStateInstrEnd();
-        updateAtInstructionEnd();
-        emit asmInstructionFinished();
-        asmInstructionCounter++;
-        // qDebug().noquote().nospace() << memoizer->memoize();
-        data->getRegisterBank().flattenFile();
-        // If execution finished on this instruction, then restore original starting program counter,
-        // as the instruction at the current program counter will not be executed.
-        if(executionFinished || hadErrorOnStep()) {
-            data->getRegisterBank().writePCStart(progCounter);
-            emit simulationFinished();
-        }
-
+        finishInstruction();
     }
 
     // Modulus must be greater than 1, or there will be no gaurentee of forward progress.
     // If modulus were 1, then debug debug breakpoints that were signaled externally
     // during process events would never be cleared by branch handler.
     if(microCycleCounter % 5000 == 0) {
-        QApplication::processEvents();
+        pollRequests(microCycleCounter);
         if(inDebug && (microBreakpointHit || asmBreakpointHit)) {
-            // If a breakpoint was forced on us by the processEvents(), react to it now.
+            // If a breakpoint was forced on us while polling, react to it now.
             // Clear breakpoint flags, otherwise we might get stuck
             // reacting to this breakpoint forever.
             return;
@@ -349,6 +561,88 @@ void FullMicrocodedCPU::onMCStep()
     ACPUModel::handler->handleQueuedInterrupts();
 }
 
+void FullMicrocodedCPU::onNativeStep()
+{
+    // The native CPU works on a copy of the register bank, which is cheap
+    // compared to the dozens of cycles the instruction would take in microcode.
+    RegisterFile& registers = data->getRegisterBank();
+    nativeCpu->getRegisterBank() = registers;
+    nativeCpu->executeInstruction();
+    registers = nativeCpu->getRegisterBank();
+    // The microcode's prefetched byte in T1 was not kept up to date, so it must fetch anew.
+    isPrefetchValid = false;
+    nativeInstructionCounter++;
+
+    // Memory errors are already visible through the shared memory device.
+    if(nativeCpu->hadErrorOnStep() && !memory->hadError()) {
+        controlError = true;
+        errorMessage = nativeCpu->getErrorMessage();
+    }
+    if(nativeCpu->getExecutionFinished() || hadErrorOnStep()) {
+        executionFinished = true;
+    }
+    finishInstruction();
+
+    // Poll as often (in instructions) as the ISA level simulator does.
+    if(nativeInstructionCounter % 500 == 0) {
+        pollRequests(microCycleCounter);
+        if(inDebug && (microBreakpointHit || asmBreakpointHit)) {
+            return;
+        }
+    }
+
+    if(inDebug && breakpointsISA.contains(data->getRegisterBankWord(Enu::CPURegisters::PC))) {
+        ACPUModel::handler->interupt(Interrupts::BREAKPOINT_ASM);
+    }
+    ACPUModel::handler->handleQueuedInterrupts();
+}
+
+void FullMicrocodedCPU::finishInstruction()
+{
+    quint16 progCounter = getCPURegWordStart(Enu::CPURegisters::PC);
+    if(isAnyProfilerEnabled()) {
+        profileInstruction(progCounter, getCPURegByteCurrent(Enu::CPURegisters::IS),
+                           getCPURegWordCurrent(Enu::CPURegisters::PC), microCycleCounter);
+    }
+    InterfaceISACPU::calculateStackChangeEnd(this->getCPURegByteCurrent(Enu::CPURegisters::IS),
+                                             this->getCPURegWordCurrent(Enu::CPURegisters::OS),
+                                             this->getCPURegWordStart(Enu::CPURegisters::SP),
+                                             this->getCPURegWordStart(Enu::CPURegisters::PC),
+                                             this->getCPURegWordCurrent(Enu::CPURegisters::A));
+    memoizer->storeStateInstrEnd();
+    updateAtInstructionEnd();
+    if(!headless) emit asmInstructionFinished();
+    asmInstructionCounter++;
+    // qDebug().noquote().nospace() << memoizer->memoize();
+    data->getRegisterBank().flattenFile();
+    // If execution finished on this instruction, then restore original starting program counter,
+    // as the instruction at the current program counter will not be executed.
+    if(executionFinished || hadErrorOnStep()) {
+        data->getRegisterBank().writePCStart(progCounter);
+        if(headless) synchronizeChanges();
+        emit simulationFinished();
+    }
+}
+
+bool FullMicrocodedCPU::executesNatively() const
+{
+    quint16 pc = data->getRegisterBankWord(Enu::CPURegisters::PC);
+    quint8 instrSpec;
+    memory->getByte(pc, instrSpec);
+    if(microcodedSpecifiers[instrSpec]) return false;
+    for(const auto& range : microcodedRanges) {
+        if(range.first <= pc && pc <= range.second) return false;
+    }
+    return true;
+}
+
+void FullMicrocodedCPU::calculateMicrocodedSpecifiers()
+{
+    for(int it = 0; it < 256; it++) {
+        microcodedSpecifiers[static_cast<quint8>(it)] = microcodedMnemonics.contains(Pep::decodeMnemonic[it]);
+    }
+}
+
 void FullMicrocodedCPU::onClock()
 {
     //Do clock logic
@@ -404,8 +698,8 @@ bool FullMicrocodedCPU::canStepInto() const
 {
     quint8 byte;
     memory->getByte(getCPURegWordStart(Enu::CPURegisters::PC), byte);
-    Enu::EMnemonic mnemon = Pep::decodeMnemonic[byte];
-    return (mnemon == Enu::EMnemonic::CALL) || Pep::isTrapMap[mnemon];
+    const Pep::DecodedOp& op = Pep::decodeTable[byte];
+    return (op.mnemonic == Enu::EMnemonic::CALL) || op.isTrap;
 }
 
 void FullMicrocodedCPU::stepInto()
@@ -449,114 +743,113 @@ void FullMicrocodedCPU::branchHandler()
     // If execution is already finished, then nothing to update.
     if(executionFinished) return;
     else if(hadErrorOnStep()) executionFinished = true;
-    const MicroCode* prog = sharedProgram->getCodeLine(microprogramCounter);
+    const ControlWord& word = controlStore->at(microprogramCounter);
     int temp = microprogramCounter;
     quint8 byte = 0;
     QString tempString;
-    QSharedPointer<const SymbolTable> symTable = this->sharedProgram->getSymTable();
     QSharedPointer<SymbolEntry> val;
-    switch(prog->getBranchFunction())
+    switch(word.branchFunction)
     {
     case Enu::Unconditional:
-        temp = prog->getTrueTarget()->getValue();
+        temp = word.trueTarget;
         break;
     case Enu::uBRGT:
         if((!data->getStatusBit(Enu::STATUS_N) && !data->getStatusBit(Enu::STATUS_Z))) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRGE:
         if((!data->getStatusBit(Enu::STATUS_N))) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBREQ:
         if(data->getStatusBit(Enu::STATUS_Z)) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRLE:
         if(data->getStatusBit(Enu::STATUS_N) || data->getStatusBit(Enu::STATUS_Z)) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRLT:
         if(data->getStatusBit(Enu::STATUS_N)) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRNE:
         if((!data->getStatusBit(Enu::STATUS_Z))) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRV:
         if(data->getStatusBit(Enu::STATUS_V)) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRC:
         if(data->getStatusBit(Enu::STATUS_C))  {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::uBRS:
         if(data->getStatusBit(Enu::STATUS_S)) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::IsPrefetchValid:
         if(isPrefetchValid) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::IsUnary:
         byte = data->getRegisterBankByte(8);
         // At the hardware level, all traps are unary.
         // If it is a non-unary trap at the ASM level, loading the argument is part of the microcode trap handlers responsibility.
-        if(Pep::isUnaryMap[Pep::decodeMnemonic[byte]] || Pep::isTrapMap[Pep::decodeMnemonic[byte]]) {
-            temp = prog->getTrueTarget()->getValue();
+        if(Pep::decodeTable[byte].isUnary || Pep::decodeTable[byte].isTrap) {
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::IsPCEven:
         if(data->getRegisterBankByte(7)%2 == 0) {
-            temp = prog->getTrueTarget()->getValue();
+            temp = word.trueTarget;
         }
         else {
-            temp = prog->getFalseTarget()->getValue();
+            temp = word.falseTarget;
         }
         break;
     case Enu::AddressingModeDecoder:
@@ -617,7 +910,7 @@ void FullMicrocodedCPU::branchHandler()
         //If there was an error in the control section, make sure the CPU stops
         executionFinished = true;
     }
-    else if(temp == microprogramCounter && prog->getBranchFunction() != Enu::Stop) {
+    else if(temp == microprogramCounter && word.branchFunction != Enu::Stop) {
         executionFinished  = true;
         controlError = true;
         errorMessage = "ERROR: µInstructions cannot branch to themselves";
@@ -630,18 +923,7 @@ void FullMicrocodedCPU::branchHandler()
 void FullMicrocodedCPU::updateAtInstructionEnd()
 {
     // Handle changing of call stack depth if the executed instruction affects the call stack.
-    if(Pep::decodeMnemonic[data->getRegisterBankByte(Enu::CPURegisters::IS)] == Enu::EMnemonic::CALL){
-        callDepth++;
-    }
-    else if(Pep::isTrapMap[Pep::decodeMnemonic[data->getRegisterBankByte(Enu::CPURegisters::IS)]]){
-        callDepth++;
-    }
-    else if(Pep::decodeMnemonic[data->getRegisterBankByte(Enu::CPURegisters::IS)] == Enu::EMnemonic::RET){
-        callDepth--;
-    }
-    else if(Pep::decodeMnemonic[data->getRegisterBankByte(Enu::CPURegisters::IS)] == Enu::EMnemonic::RETTR){
-        callDepth--;
-    }
+    callDepth += Pep::decodeTable[data->getRegisterBankByte(Enu::CPURegisters::IS)].callDepthDelta;
 }
 
 void FullMicrocodedCPU::calculateInstrJT()
@@ -695,6 +977,7 @@ void FullMicrocodedCPU::calculateAddrJT()
 void FullMicrocodedCPU::breakpointAsmHandler()
 {
     asmBreakpointHit = true;
+    if(headless) synchronizeChanges();
     emit hitBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
     return;
 }
@@ -702,15 +985,16 @@ void FullMicrocodedCPU::breakpointAsmHandler()
 void FullMicrocodedCPU::breakpointMicroHandler()
 {
     microBreakpointHit = true;
+    if(headless) synchronizeChanges();
     emit hitBreakpoint(Enu::BreakpointTypes::MICROCODE);
     return;
 }
 
-void FullMicrocodedCPU::setSignalsFromMicrocode(const MicroCode *line)
+void FullMicrocodedCPU::setSignalsFromControlWord(const ControlWord &word)
 {
     int val;
-    if(line->getClockSignal(Enu::EClockSignals::PValidCk)) {
-        val = line->getControlSignal(Enu::EControlSignals::PValid);
+    if(word.getClockSignal(Enu::EClockSignals::PValidCk)) {
+        val = word.controlSignals[Enu::EControlSignals::PValid];
         if(val == Enu::signalDisabled) {
             errorMessage = "Error: Asserted PValidCk, but PValid was disabled.";
             controlError = true;
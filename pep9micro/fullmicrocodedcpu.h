@@ -24,10 +24,14 @@
 
 #include "interfacemccpu.h"
 #include "interfaceisacpu.h"
+#include "registerfile.h"
+#include "writejournal.h"
 #include <QElapsedTimer>
 #include <array>
 class CPUDataSection;
+struct ControlWord;
 class FullMicrocodedMemoizer;
+class IsaCpu;
 class FullMicrocodedCPU : public ACPUModel, public InterfaceMCCPU, public InterfaceISACPU
 {
     Q_OBJECT
@@ -45,6 +49,36 @@ public:
     // of a microcode program.
     void setMicroPCToStart() noexcept;
 
+    // In hybrid execution, each ISA level instruction is executed natively by an
+    // embedded IsaCpu over the same register bank and memory, unless its mnemonic
+    // is one of the microcoded mnemonics or its address lies in one of the microcoded
+    // ranges. Only those instructions are executed cycle-by-cycle in microcode.
+    // Architectural state is identical at every ISA boundary either way.
+    void setHybridExecution(bool enabled) noexcept;
+    bool getHybridExecution() const noexcept;
+    void setMicrocodedMnemonics(QList<Enu::EMnemonic> mnemonics);
+    // Ranges are inclusive pairs of (first address, last address).
+    void setMicrocodedRanges(QList<QPair<quint16, quint16>> ranges);
+    // Returns how many of the ISA level instructions were executed natively.
+    quint64 getNativeInstructionCount() const noexcept;
+
+    // When enabled, the old values of the state modified by each cycle are kept in a journal
+    // of at most capacity entries, so that cycles may be undone without re-executing the program.
+    // A natively executed instruction is journaled as a single cycle. The oldest cycles are
+    // forgotten once the journal fills. Returns false if the memory device is not a MainMemory.
+    bool setReverseStepEnabled(bool enabled, int capacity = WriteJournal::defaultCapacity);
+    bool isReverseStepEnabled() const noexcept;
+    // Is there a cycle in the journal that can be undone?
+    bool canStepBack() const noexcept;
+    // Undo the most recently executed cycle. Input it consumed is returned to the input buffer,
+    // but output can't be taken back, and the stack trace is abandoned, since trace tags can only be
+    // followed forwards.
+    // Returns false if there was no cycle to undo.
+    bool stepBackMicrocode();
+    // Undo cycles until the microprogram counter returns to the start of an ISA level instruction,
+    // which undoes the previous instruction when already at the start of one.
+    bool stepBack();
+
     // ACPUModel interface
     bool getStatusBitCurrent(Enu::EStatusBit) const override;
     bool getStatusBitStart(Enu::EStatusBit) const override;
@@ -90,6 +124,41 @@ private:
     CPUDataSection *data;
     QSharedPointer<CPUDataSection> dataShared;
     FullMicrocodedMemoizer *memoizer;
+    // Hybrid execution state. The microcoded instruction specifiers are derived
+    // from the microcoded mnemonics, and must be recomputed whenever the mnemonics
+    // or the Pep:: instruction mappings change.
+    IsaCpu *nativeCpu;
+    bool hybridExecution;
+    QList<Enu::EMnemonic> microcodedMnemonics;
+    QList<QPair<quint16, quint16>> microcodedRanges;
+    std::array<bool, 256> microcodedSpecifiers;
+    quint64 nativeInstructionCounter;
+
+    // Journal of the writes made by each cycle, or nullptr if reverse stepping is disabled.
+    WriteJournal* journal;
+    // Pieces of state, other than memory and the current registers, that must be restored
+    // when undoing a cycle. The 64 bit counters record the amount they were increased by.
+    // REGISTER_START and MEMORY_REGISTER pack the register number in the high byte of
+    // the entry's address, and its old value in the low byte.
+    enum JournalSlot: quint8
+    {
+        MICRO_PC, MICRO_CYCLES, ASM_INSTRUCTIONS, NATIVE_INSTRUCTIONS, CALL_DEPTH, OPERAND_VALUE,
+        PREFETCH_VALID, REGISTER_START, STATUS_BITS_START, MEMORY_REGISTER, MAIN_BUS_STATE
+    };
+    // The state of the machine at the start of the cycle being journaled.
+    struct JournalStart
+    {
+        RegisterFile registers;
+        std::array<quint8, 5> memoryRegisters;
+        Enu::MainBusState mainBusState;
+        quint16 microprogramCounter;
+        quint64 microCycleCounter, asmInstructionCounter, nativeInstructionCounter;
+        int callDepth;
+        quint16 opValCache;
+        bool isPrefetchValid;
+    } journalStart;
+    void beginJournalStep();
+    void endJournalStep();
     // A class to represent a single item in the instruction specifier
     // or addressing mode decoder.
     struct decoder_entry {
@@ -112,9 +181,18 @@ private:
     std::array<decoder_entry, 256> addrModeJT;
     quint16 startLine = 0;
 
+    // Execute one cycle, or one instruction natively. Wrapped by onMCStep() to journal the cycle.
+    void executeCycle();
+    // Should the instruction at the current program counter bypass microcode?
+    bool executesNatively() const;
+    // Execute one ISA level instruction on the native CPU in place of microcode.
+    void onNativeStep();
+    // Update ISA level state after an instruction, whether microcoded or native.
+    void finishInstruction();
+    void calculateMicrocodedSpecifiers();
     void breakpointAsmHandler();
     void breakpointMicroHandler();
-    void setSignalsFromMicrocode(const MicroCode *line);
+    void setSignalsFromControlWord(const ControlWord& word);
     void branchHandler() override;
     void updateAtInstructionEnd() override;
     // For all 256 instructions in the Pep/9 insturction set,
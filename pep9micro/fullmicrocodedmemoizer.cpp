@@ -60,6 +60,15 @@ void FullMicrocodedMemoizer::storeStateInstrStart()
     calculateOpVal();
 }
 
+void FullMicrocodedMemoizer::undoStateInstrStart()
+{
+    quint8 instr;
+    // The journal restored the instruction specifier along with the rest of memory.
+    cpu.getMemoryDevice()->getByte(cpu.data->getRegisterBank()
+                                   .readRegisterWordStart(Enu::CPURegisters::PC), instr);
+    state.instructionsCalled[instr]--;
+}
+
 QString FullMicrocodedMemoizer::memoize()
 {
     const RegisterFile& file = cpu.data->getRegisterBank();
@@ -81,16 +90,17 @@ QString FullMicrocodedMemoizer::memoize()
     build += "  " + AX;
     build += NZVC;
     ir = cpu.data->getRegisterBank().getIRCache();
-    if(Pep::isTrapMap[Pep::decodeMnemonic[ir]]) {
+    const Pep::DecodedOp& op = Pep::decodeTable[ir];
+    if(op.isTrap) {
         build += generateTrapFrame(state);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::RETTR) {
+    else if(op.mnemonic == Enu::EMnemonic::RETTR) {
         build += generateTrapFrame(state,false);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::CALL) {
+    else if(op.mnemonic == Enu::EMnemonic::CALL) {
         build += generateStackFrame(state);
     }
-    else if(Pep::decodeMnemonic[ir] == Enu::EMnemonic::RET) {
+    else if(op.mnemonic == Enu::EMnemonic::RET) {
         build += generateStackFrame(state,false);
     }
     return build;
@@ -105,13 +115,13 @@ QString FullMicrocodedMemoizer::finalStatistics()
     tally.append(0);
     int tallyIt = 0;
     for(int it = 0; it < 256; it++) {
-        if(mnemon == Pep::decodeMnemonic[it]) {
+        if(mnemon == Pep::decodeTable[static_cast<size_t>(it)].mnemonic) {
             tally[tallyIt]+= state.instructionsCalled[it];
         }
         else {
             tally.append(state.instructionsCalled[it]);
             tallyIt++;
-            mnemon = Pep::decodeMnemonic[it];
+            mnemon = Pep::decodeTable[static_cast<size_t>(it)].mnemonic;
             mnemonList.append(mnemon);
         }
     }
@@ -144,18 +154,18 @@ void FullMicrocodedMemoizer::calculateOpVal() const
 {
     quint8 instr;
     cpu.memory->getByte(cpu.getCPURegWordStart(Enu::CPURegisters::PC), instr);
-    Enu::EMnemonic instrToExecute = Pep::decodeMnemonic[instr];
-    Enu::EAddrMode addrMode = Pep::decodeAddrMode[instr];
-    if(Pep::isUnaryMap[instrToExecute]) {
+    const Pep::DecodedOp& op = Pep::decodeTable[instr];
+    Enu::EAddrMode addrMode = op.addrMode;
+    if(op.isUnary) {
         cpu.opValCache = 0;
         return;
     }
     quint16 opSpec;
     cpu.memory->getWord(cpu.getCPURegWordStart(Enu::CPURegisters::PC) +1 , opSpec);
-    if(Pep::isStoreMnemonic(instrToExecute)) {
+    if(Pep::isStoreMnemonic(op.mnemonic)) {
         calculateOpValStoreHelper(addrMode, opSpec);
     }
-    else if(Pep::operandDisplayFieldWidth(instrToExecute) == 2) {
+    else if(op.operandWidth == 1) {
         calculateOpValByteHelper(addrMode, opSpec);
     }
     else {
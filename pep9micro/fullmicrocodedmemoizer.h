@@ -37,6 +37,9 @@ public:
     // Must initialize InterfaceISACPU:opValCache here for FullMicrocoded CPU
     // to fulfill its contract with InterfaceISACPU.
     void storeStateInstrStart();
+    // Undo storeStateInstrStart() for an instruction that has been stepped back over.
+    // Memory and registers must already be restored to their values at the start of the instruction.
+    void undoStateInstrStart();
     QString memoize();
     QString finalStatistics();
     quint64 getCycleCount();
@@ -21,12 +21,51 @@
 */
 
 #include <QtWidgets/QApplication>
+#include <QCommandLineParser>
 #include "micromainwindow.h"
 #ifdef WIN32
 #include <string.h>
 #include <qvector.h>
 #endif
 #include <iostream>
+
+namespace {
+// Parse a comma separated list of mnemonics, such as "ldwa,stwa".
+bool parseMicrocodedMnemonics(const QString& text, QList<Enu::EMnemonic>& mnemonics, QString& errorMessage)
+{
+    for(const QString& name : text.split(",", Qt::SkipEmptyParts)) {
+        QString mnemonic = name.trimmed().toUpper();
+        if(!Pep::mnemonToEnumMap.contains(mnemonic)) {
+            errorMessage = QString("Unknown mnemonic \"%1\".").arg(name.trimmed());
+            return false;
+        }
+        mnemonics.append(Pep::mnemonToEnumMap.value(mnemonic));
+    }
+    return true;
+}
+
+// Parse a comma separated list of inclusive address ranges, such as "0x0000-0x00ff,0x0200-0x02ff".
+bool parseMicrocodedRanges(const QString& text, QList<QPair<quint16, quint16>>& ranges, QString& errorMessage)
+{
+    for(const QString& range : text.split(",", Qt::SkipEmptyParts)) {
+        QStringList bounds = range.split("-");
+        bool firstOk = false, lastOk = false;
+        quint16 first = 0, last = 0;
+        if(bounds.length() == 2) {
+            // Base 0 accepts both decimal and 0x prefixed hexadecimal addresses.
+            first = bounds[0].trimmed().toUShort(&firstOk, 0);
+            last = bounds[1].trimmed().toUShort(&lastOk, 0);
+        }
+        if(!firstOk || !lastOk || first > last) {
+            errorMessage = QString("Expected an address range first-last, not \"%1\".").arg(range.trimmed());
+            return false;
+        }
+        ranges.append({first, last});
+    }
+    return true;
+}
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef WIN32 //Always inject -platform windows:dpiawareness=0 flag to disable hi-dpi support.
@@ -61,7 +100,49 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("Pep9Micro");
     QCoreApplication::setApplicationVersion("9.3.0");
 
-    MicroMainWindow w;
+    // The CPU may access memory through a simulated cache, organized as in pep9term's run --cache.
+    // Parse leniently, since platforms may pass along options of their own.
+    QCommandLineParser parser;
+    QCommandLineOption cacheOption("cache", "Simulate a cache between the CPU and memory.", "cache_config");
+    parser.addOption(cacheOption);
+    // When the operating system is executed natively, these select which instructions are still microcoded.
+    QCommandLineOption mnemonicsOption("microcode-mnemonics",
+                                       "Comma separated mnemonics that are always executed in microcode.", "mnemonics");
+    parser.addOption(mnemonicsOption);
+    QCommandLineOption rangesOption("microcode-ranges",
+                                    "Comma separated address ranges, such as 0x0000-0x00ff, executed in microcode. "
+                                    "Defaults to every address below the operating system.", "ranges");
+    parser.addOption(rangesOption);
+    parser.parse(a.arguments());
+    std::optional<CacheMemoryDevice::Configuration> cacheConfiguration;
+    if(parser.isSet(cacheOption)) {
+        CacheMemoryDevice::Configuration configuration;
+        QString errorMessage;
+        if(!CacheMemoryDevice::Configuration::fromString(parser.value(cacheOption), configuration, errorMessage)) {
+            std::cerr << errorMessage.toStdString() << std::endl;
+            return 1;
+        }
+        cacheConfiguration = configuration;
+    }
+
+    QList<Enu::EMnemonic> microcodedMnemonics;
+    std::optional<QList<QPair<quint16, quint16>>> microcodedRanges;
+    QString errorMessage;
+    if(!parseMicrocodedMnemonics(parser.value(mnemonicsOption), microcodedMnemonics, errorMessage)) {
+        std::cerr << errorMessage.toStdString() << std::endl;
+        return 1;
+    }
+    if(parser.isSet(rangesOption)) {
+        QList<QPair<quint16, quint16>> ranges;
+        if(!parseMicrocodedRanges(parser.value(rangesOption), ranges, errorMessage)) {
+            std::cerr << errorMessage.toStdString() << std::endl;
+            return 1;
+        }
+        microcodedRanges = ranges;
+    }
+
+    MicroMainWindow w(nullptr, cacheConfiguration);
+    w.setMicrocodedSelection(microcodedMnemonics, microcodedRanges);
     w.show();
     return a.exec();
 }
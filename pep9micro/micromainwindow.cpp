@@ -68,18 +68,25 @@
 #include "microcodepane.h"
 #include "microcodeprogram.h"
 #include "microobjectcodepane.h"
+#include "osimagecache.h"
 #include "updatechecker.h"
 #include "redefinemnemonicsdialog.h"
 #include "registerfile.h"
+#include "simulationrunner.h"
 #include "symboltable.h"
 
-MicroMainWindow::MicroMainWindow(QWidget *parent) :
+MicroMainWindow::MicroMainWindow(QWidget *parent, std::optional<CacheMemoryDevice::Configuration> cacheConfiguration) :
     QMainWindow(parent),
     ui(new Ui::MicroMainWindow), debugState(DebugState::DISABLED), codeFont(QFont(Pep::codeFont, Pep::codeFontSize)),
     updateChecker(new UpdateChecker()), isInDarkMode(false),
-    memDevice(new MainMemory(nullptr)), controlSection(new FullMicrocodedCPU(AsmProgramManager::getInstance(), memDevice)),
-    dataSection(controlSection->getDataSection()), redefineMnemonicsDialog(new RedefineMnemonicsDialog(this)),
-    decoderTableDialog(new DecoderTableDialog(nullptr)), programManager(AsmProgramManager::getInstance())
+    programManager(new AsmProgramManager(this)),
+    memDevice(new MainMemory(nullptr)),
+    cacheDevice(cacheConfiguration ? new CacheMemoryDevice(memDevice, *cacheConfiguration) : nullptr),
+    controlSection(new FullMicrocodedCPU(programManager, cacheDevice.isNull() ? memDevice.staticCast<AMemoryDevice>()
+                                                                              : cacheDevice.staticCast<AMemoryDevice>())),
+    dataSection(controlSection->getDataSection()), runner(new SimulationRunner(controlSection, this)),
+    redefineMnemonicsDialog(new RedefineMnemonicsDialog(this)),
+    decoderTableDialog(new DecoderTableDialog(nullptr))
 
 {
     // Initialize the memory subsystem
@@ -101,7 +108,8 @@ MicroMainWindow::MicroMainWindow(QWidget *parent) :
     ui->microcodeWidget->init(controlSection, dataSection, true);
     ui->microObjectCodePane->init(controlSection, true);
     redefineMnemonicsDialog->init(false);
-    ui->executionStatisticsWidget->init(controlSection, true);
+    ui->executionStatisticsWidget->init(controlSection, programManager, true);
+    ui->executionStatisticsWidget->setCache(cacheDevice);
 
     // Create & connect all dialogs.
     helpDialog = new MicroHelpDialog(this);
@@ -175,6 +183,8 @@ MicroMainWindow::MicroMainWindow(QWidget *parent) :
 
     // Connect MainWindow so that it can propogate simulationFinished event and clean up when execution is finished.
     connect(controlSection.get(), &FullMicrocodedCPU::simulationFinished, this, &MicroMainWindow::onSimulationFinished);
+    connect(runner, &SimulationRunner::finished, this, &MicroMainWindow::onRunFinished);
+    connect(runner, &SimulationRunner::progress, this, &MicroMainWindow::onRunProgress);
 
 
     // Connect simulation events that are internal to the class.
@@ -283,11 +293,24 @@ MicroMainWindow::MicroMainWindow(QWidget *parent) :
 
 MicroMainWindow::~MicroMainWindow()
 {
+    // A simulation on the worker thread must stop before the objects it uses are destroyed.
+    if(runner->isRunning()) {
+        controlSection->requestCancel();
+        memDevice->clearIO();
+        runner->waitForFinished();
+    }
     delete ui;
     delete helpDialog;
     delete aboutPepDialog;
 }
 
+void MicroMainWindow::setMicrocodedSelection(QList<Enu::EMnemonic> mnemonics,
+                                             std::optional<QList<QPair<quint16, quint16> > > ranges)
+{
+    microcodedMnemonics = mnemonics;
+    microcodedRanges = ranges;
+}
+
 void MicroMainWindow::changeEvent(QEvent *e)
 {
     QMainWindow::changeEvent(e);
@@ -887,10 +910,21 @@ void MicroMainWindow::assembleDefaultOperatingSystem()
     // If there is text, attempt to assemble it
     if(!defaultOSText.isEmpty()) {
         QSharedPointer<AsmProgram> prog;
+        // Prefer the image written next to the application by the build, and then the one cached
+        // by an earlier launch. Either is only loaded if it matches the source and the mnemonics.
+        OsImageCache bundledImage(OsImageCache::bundledImageFile());
+        OsImageCache userImage(OsImageCache::defaultImageFile());
+        if(!(prog = bundledImage.load(defaultOSText)).isNull() || !(prog = userImage.load(defaultOSText)).isNull()) {
+            // The listing is only assembled once the operating system is traced or profiled.
+            programManager->setOperatingSystemImage(prog, defaultOSText);
+            return;
+        }
         auto elist = QList<QPair<int, QString>>();
         IsaAsm assembler(*programManager);
         if(assembler.assembleOperatingSystem(defaultOSText, true, prog, elist)) {
             programManager->setOperatingSystem(prog);
+            // Failing to write the image only costs the next launch an assembly.
+            userImage.store(defaultOSText, *prog);
         }
         // If the operating system failed to assembly, we can't progress any further.
         // All application functionality depends on the operating system being defined.
@@ -1021,6 +1055,8 @@ void MicroMainWindow::debugButtonEnableHelper(const int which)
     ui->actionDebug_Interupt_Execution->setEnabled(which & DebugButtons::INTERRUPT);
     ui->actionDebug_Continue->setEnabled(which & DebugButtons::CONTINUE);
     ui->actionDebug_Stop_Debugging->setEnabled(which & DebugButtons::STOP);
+    ui->actionDebug_Step_Back_Assembler->setEnabled(which & DebugButtons::STEP_BACK_ASM);
+    ui->actionDebug_Step_Back_Microcode->setEnabled(which & DebugButtons::STEP_BACK_MICRO);
     ui->actionDebug_Single_Step_Assembler->setEnabled(which & DebugButtons::STEP_OVER_ASM);
     ui->actionDebug_Step_Over_Assembler->setEnabled(which & DebugButtons::STEP_OVER_ASM);
     ui->actionDebug_Step_Into_Assembler->setEnabled(which & DebugButtons::STEP_INTO_ASM);
@@ -1038,6 +1074,7 @@ void MicroMainWindow::debugButtonEnableHelper(const int which)
     ui->actionSystem_Assemble_Install_New_OS->setEnabled(which & DebugButtons::INSTALL_OS);
     ui->actionSystem_Code_Fragment->setEnabled(which & DebugButtons::INSTALL_OS);
     ui->actionSystem_Complete_Microcode->setEnabled(which & DebugButtons::INSTALL_OS);
+    ui->actionSystem_Execute_OS_Natively->setEnabled(which & DebugButtons::INSTALL_OS);
     ui->actionSystem_Redefine_Decoder_Tables->setEnabled(which & DebugButtons::INSTALL_OS);
 
     // System actions
@@ -1097,6 +1134,23 @@ bool MicroMainWindow::initializeSimulation()
     controlSection->onResetCPU();
     controlSection->initCPU();
     ui->cpuWidget->clearCpu();
+    // Every run starts with a cold cache.
+    if(!cacheDevice.isNull()) cacheDevice->reset();
+
+    // When executing the OS natively, only the selected mnemonics and addresses are microcoded.
+    // Recompute the mnemonics' instruction specifiers, since they may have been redefined.
+    controlSection->setHybridExecution(ui->actionSystem_Execute_OS_Natively->isChecked());
+    controlSection->setMicrocodedMnemonics(microcodedMnemonics);
+    if(microcodedRanges) {
+        controlSection->setMicrocodedRanges(*microcodedRanges);
+    }
+    else {
+        // By default, the addresses below the OS are microcoded. An OS burned
+        // at address 0 leaves no such addresses, rather than all of them.
+        quint16 osStart = programManager->getOperatingSystem()->getBurnAddress();
+        if(osStart == 0) controlSection->setMicrocodedRanges({});
+        else controlSection->setMicrocodedRanges({{0, static_cast<quint16>(osStart - 1)}});
+    }
 
     // Don't allow the microcode pane to be edited while the program is running
     ui->microcodeWidget->setReadOnly(true);
@@ -1408,23 +1462,14 @@ void MicroMainWindow::on_actionBuild_Execute_triggered()
         ui->memoryWidget->clearHighlight();
         ui->memoryWidget->refreshMemory();
         controlSection->onSimulationStarted();
-        controlSection->onRun();
-        connectViewUpdate();
+        // Only debugging can step backwards, so don't pay for the journal.
+        controlSection->setReverseStepEnabled(false);
+        // Execution continues in the background, and is wrapped up by onRunFinished().
+        runner->start([this](){controlSection->onRun();});
     }
     else {
         debugState = DebugState::DISABLED;
-    }
-    // If the simulator finished, then propogate that information to connect components.
-    if(controlSection->getExecutionFinished()) {
-        debugState = DebugState::DISABLED;
-        onSimulationFinished();
-        emit simulationFinished();
-    }
-    // Otherwise, the simulator paused execution, so don't explicitly terminate
-    // the simulator.
-    else {
-        handleDebugButtons();
-        emit simulationUpdate();
+        onRunFinished();
     }
 }
 
@@ -1443,23 +1488,13 @@ void MicroMainWindow::on_actionBuild_Run_triggered()
         ui->memoryWidget->updateMemory();
         ui->memoryTracePane->updateTrace();
         controlSection->onSimulationStarted();
-        controlSection->onRun();
-        connectViewUpdate();
-
+        controlSection->setReverseStepEnabled(false);
+        // Execution continues in the background, and is wrapped up by onRunFinished().
+        runner->start([this](){controlSection->onRun();});
     }
     else {
         debugState = DebugState::DISABLED;
-   }
-    // If the simulator finished, then propogate that information to connect components.
-    if(controlSection->getExecutionFinished()) {
-        debugState = DebugState::DISABLED;
-        onSimulationFinished();
-    }
-    // Otherwise, the simulator paused execution, so don't explicitly terminate
-    // the simulator.
-    else {
-        handleDebugButtons();
-        emit simulationUpdate();
+        onRunFinished();
     }
 }
 
@@ -1478,6 +1513,7 @@ void MicroMainWindow::on_actionBuild_Run_Object_triggered()
 void MicroMainWindow::handleDebugButtons()
 {
     bool enable_into = controlSection->canStepInto();
+    bool enable_back = controlSection->canStepBack();
     // Disable button stepping if waiting on IO
     bool waiting_io =
             // If the simulation is running
@@ -1508,12 +1544,14 @@ void MicroMainWindow::handleDebugButtons()
         enabledButtons |= DebugButtons::STEP_OUT_ASM*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_OVER_ASM*(!waiting_io) | DebugButtons::SINGLE_STEP_MICRO*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_INTO_ASM*(enable_into * !waiting_io);
+        enabledButtons |= (DebugButtons::STEP_BACK_ASM | DebugButtons::STEP_BACK_MICRO)*(enable_back * !waiting_io);
         break;
     case DebugState::DEBUG_MICRO:
         enabledButtons = DebugButtons::INTERRUPT | DebugButtons::STOP | DebugButtons::CONTINUE*(!waiting_io);
         enabledButtons |= /*DebugButtons::SINGLE_STEP_ASM*(!waiting_io * 0) |*/ DebugButtons::STEP_OUT_ASM*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_OVER_ASM*(!waiting_io) | DebugButtons::SINGLE_STEP_MICRO*(!waiting_io);
         enabledButtons |= DebugButtons::STEP_INTO_ASM*(enable_into * !waiting_io);
+        enabledButtons |= (DebugButtons::STEP_BACK_ASM | DebugButtons::STEP_BACK_MICRO)*(enable_back * !waiting_io);
         break;
     case DebugState::DEBUG_RESUMED:
         enabledButtons = DebugButtons::INTERRUPT | DebugButtons::STOP;
@@ -1521,6 +1559,7 @@ void MicroMainWindow::handleDebugButtons()
     case DebugState::DEBUG_ONLY_MICRO:
         enabledButtons =  DebugButtons::STOP | DebugButtons::CONTINUE;
         enabledButtons |= DebugButtons::SINGLE_STEP_MICRO;
+        enabledButtons |= DebugButtons::STEP_BACK_MICRO*enable_back;
         break;
     default:
         break;
@@ -1547,6 +1586,8 @@ bool MicroMainWindow::on_actionDebug_Start_Debugging_Object_triggered()
     if(initializeSimulation()) {
         emit simulationStarted();
         controlSection->onSimulationStarted();
+        // Journal every cycle, so that the debugger may step backwards.
+        controlSection->setReverseStepEnabled(true);
         controlSection->enableDebugging();
         controlSection->breakpointsSet(programManager->getBreakpoints());
         ui->tabWidget->setCurrentIndex(ui->tabWidget->indexOf(ui->debuggerTab));
@@ -1645,6 +1686,7 @@ bool MicroMainWindow::on_actionDebug_Start_Debugging_Microcode_triggered()
 
     emit simulationStarted();
     controlSection->onSimulationStarted();
+    controlSection->setReverseStepEnabled(true);
     controlSection->enableDebugging();
     controlSection->breakpointsSet(programManager->getBreakpoints());
     ui->tabWidget->setCurrentIndex(ui->tabWidget->indexOf(ui->debuggerTab));
@@ -1666,6 +1708,13 @@ bool MicroMainWindow::on_actionDebug_Start_Debugging_Microcode_triggered()
 
 void MicroMainWindow::on_actionDebug_Stop_Debugging_triggered()
 {
+    if(runner->isRunning()) {
+        // Release any pending input, and let onRunFinished() clean up once the simulation stops.
+        controlSection->requestCancel();
+        memDevice->clearIO();
+        ui->ioWidget->cancelWaiting();
+        return;
+    }
     connectViewUpdate();
     highlightActiveLines();
     debugState = DebugState::DISABLED;
@@ -1707,6 +1756,11 @@ void MicroMainWindow::on_actionDebug_Single_Step_Assembler_triggered()
 
 void MicroMainWindow::on_actionDebug_Interupt_Execution_triggered()
 {
+    if(runner->isRunning()) {
+        // The simulation pauses once it notices the request, and onRunFinished() updates the UI.
+        controlSection->requestBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
+        return;
+    }
     // Enable debugging in CPU and then temporarily pause execution.
     controlSection->enableDebugging();
     controlSection->forceBreakpoint(Enu::BreakpointTypes::ASSEMBLER);
@@ -1731,16 +1785,8 @@ void MicroMainWindow::on_actionDebug_Continue_triggered()
 
     handleDebugButtons();
     disconnectViewUpdate();
-    controlSection->onRun();
-    connectViewUpdate();
-    emit simulationUpdate();
-    QApplication::processEvents();
-    if(controlSection->hadErrorOnStep()) {
-        return; // we'll just return here instead of letting it fail and go to the bottom
-    }
-    else if(controlSection->stoppedForBreakpoint()) {
-        highlightActiveLines();
-    }
+    // Execution continues in the background, and is wrapped up by onRunFinished().
+    runner->start([this](){controlSection->onRun();});
 }
 
 void MicroMainWindow::on_actionDebug_Step_Over_Assembler_triggered()
@@ -1813,6 +1859,30 @@ void MicroMainWindow::on_actionDebug_Single_Step_Microcode_triggered()
 
 }
 
+void MicroMainWindow::on_actionDebug_Step_Back_Assembler_triggered()
+{
+    debugState = DebugState::DEBUG_ISA;
+    ui->debuggerTabWidget->setCurrentIndex(ui->debuggerTabWidget->indexOf(ui->assemblerDebuggerTab));
+    // Many cycles might be undone, so don't redraw after each one.
+    disconnectViewUpdate();
+    controlSection->stepBack();
+    connectViewUpdate();
+    // Memory may have changed anywhere, so re-render it rather than update it in place.
+    ui->memoryWidget->refreshMemory();
+    emit simulationUpdate();
+}
+
+void MicroMainWindow::on_actionDebug_Step_Back_Microcode_triggered()
+{
+    // Don't allow transition from microcode-only simulation to ISA level simulation.
+    if(debugState != DebugState::DEBUG_ONLY_MICRO) {
+        debugState = DebugState::DEBUG_MICRO;
+    }
+    ui->debuggerTabWidget->setCurrentIndex(ui->debuggerTabWidget->indexOf(ui->microcodeDebuggerTab));
+    controlSection->stepBackMicrocode();
+    emit simulationUpdate();
+}
+
 void MicroMainWindow::onMicroBreakpointHit()
 {
     // Don't allow a transition from microcode-only to ISA level.
@@ -1934,6 +2004,33 @@ void MicroMainWindow::onSimulationFinished()
 
 }
 
+void MicroMainWindow::onRunFinished()
+{
+    connectViewUpdate();
+    // The CPU's signals are blocked while it runs in the background,
+    // so determine how the simulation stopped after the fact.
+    if(controlSection->getExecutionFinished() || controlSection->hadErrorOnStep()) {
+        debugState = DebugState::DISABLED;
+        onSimulationFinished();
+        return;
+    }
+    if(controlSection->stoppedForMicroBreakpoint()) {
+        onBreakpointHit(Enu::BreakpointTypes::MICROCODE);
+    }
+    else if(controlSection->stoppedForBreakpoint()) {
+        onBreakpointHit(Enu::BreakpointTypes::ASSEMBLER);
+    }
+    // Otherwise, the simulator paused execution, so don't explicitly terminate
+    // the simulator.
+    handleDebugButtons();
+    emit simulationUpdate();
+}
+
+void MicroMainWindow::onRunProgress(ACPUModel::RunStatus status)
+{
+    ui->statusBar->showMessage(SimulationRunner::describeProgress(status, "cycles"));
+}
+
 void MicroMainWindow::onDarkModeChanged()
 {
     isInDarkMode = inDarkMode();
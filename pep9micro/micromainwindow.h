@@ -23,7 +23,10 @@
 #define MICROMAINWINDOW_H
 
 #include <QtWidgets/QMainWindow>
+#include <optional>
 
+#include "acpumodel.h"
+#include "cachememorydevice.h"
 #include "pep.h"
 #include <QDir>
 #include "isaasm.h"
@@ -47,6 +50,7 @@ class MicroObjectCodePane;
 class CPUDataSection;
 class UpdateChecker;
 class RedefineMnemonicsDialog;
+class SimulationRunner;
 
 /*
  * The set of possible states for the debugger.
@@ -66,8 +70,15 @@ enum class DebugState
 class MicroMainWindow : public QMainWindow {
     Q_OBJECT
 public:
-    MicroMainWindow(QWidget *parent = nullptr);
+    // If cacheConfiguration is set, the CPU accesses memory through a cache organized accordingly.
+    MicroMainWindow(QWidget *parent = nullptr,
+                    std::optional<CacheMemoryDevice::Configuration> cacheConfiguration = std::nullopt);
     ~MicroMainWindow();
+    // When the operating system is executed natively, instructions whose mnemonic is in mnemonics
+    // are always executed in microcode, as are instructions whose address lies in one of ranges.
+    // If ranges is not set, every address below the operating system is microcoded.
+    void setMicrocodedSelection(QList<Enu::EMnemonic> mnemonics,
+                                std::optional<QList<QPair<quint16, quint16>>> ranges);
 protected:
     void changeEvent(QEvent *e);
     void closeEvent(QCloseEvent *e);
@@ -87,10 +98,21 @@ private:
     ByteConverterDec *byteConverterDec;
     ByteConverterHex *byteConverterHex;
     ByteConverterInstr *byteConverterInstr;
+    // Owns the user program and operating system shown in this window.
+    // Must be declared before the CPU, which is constructed with it.
+    AsmProgramManager* programManager;
     // Main Memory
     QSharedPointer<MainMemory> memDevice;
+    // Cache between the CPU and main memory, or nullptr if no cache was configured.
+    // Must be declared before the CPU, which is constructed with it.
+    QSharedPointer<CacheMemoryDevice> cacheDevice;
     QSharedPointer<FullMicrocodedCPU> controlSection;
     QSharedPointer<CPUDataSection> dataSection;
+    // Runs simulations on a worker thread.
+    SimulationRunner* runner;
+    // Instructions executed in microcode when the operating system is executed natively.
+    QList<Enu::EMnemonic> microcodedMnemonics;
+    std::optional<QList<QPair<quint16, quint16>>> microcodedRanges;
 
     // Dialogues
     MicroHelpDialog *helpDialog;
@@ -98,8 +120,6 @@ private:
     RedefineMnemonicsDialog *redefineMnemonicsDialog;
     DecoderTableDialog *decoderTableDialog;
 
-    AsmProgramManager* programManager;
-
     // Disconnect or reconnect events that notify views of changes in model,
     // Disconnecting these events allow for faster execution when running or continuing.
     void connectViewUpdate();
@@ -142,7 +162,8 @@ private:
         static const int RUN = 1<<0, RUN_OBJECT = 1<<1, DEBUG = 1<<2, DEBUG_OBJECT = 1<<3, DEBUG_LOADER = 1<<4,
         INTERRUPT = 1<<5, CONTINUE = 1<<6, STOP = 1<<8, STEP_OVER_ASM = 1<<9, STEP_INTO_ASM = 1<<10,
         STEP_OUT_ASM = 1<<11, SINGLE_STEP_MICRO = 1<<12/*, SINGLE_STEP_ASM = 1<<13*/, BUILD_ASM = 1<<14, BUILD_MICRO = 1<<15,
-        OPEN_NEW = 1<<17, INSTALL_OS = 1<<18, DEBUG_MICRO = 1<<19, CLEAR = 1 <<20;
+        STEP_BACK_ASM = 1<<16, OPEN_NEW = 1<<17, INSTALL_OS = 1<<18, DEBUG_MICRO = 1<<19, CLEAR = 1 <<20,
+        STEP_BACK_MICRO = 1<<21;
     };
 
     // Which debug buttons to enable, based on integer cracking of the above struct. It is not strongly typed with an enum, because the casting
@@ -220,6 +241,9 @@ private slots:
     void on_actionDebug_Step_Out_Assembler_triggered();
     // Executes a single line of microcode, which is the behavior of Pep/9CPU
     void on_actionDebug_Single_Step_Microcode_triggered();
+    // Undo the last ISA instruction or line of microcode, using the CPU's journal.
+    void on_actionDebug_Step_Back_Assembler_triggered();
+    void on_actionDebug_Step_Back_Microcode_triggered();
 
     // System
     void on_actionSystem_Clear_CPU_triggered();
@@ -259,6 +283,9 @@ private slots:
 
     //Run events
     void onSimulationFinished();
+    // React to a run or continue that stopped, either because it finished, failed, or hit a breakpoint.
+    void onRunFinished();
+    void onRunProgress(ACPUModel::RunStatus status);
 
     // Byte converter
     void slotByteConverterDecEdited(const QString &);
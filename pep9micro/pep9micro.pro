@@ -92,5 +92,9 @@ include("../installer/installer-creator.pri")
 #Generate SHA hash of current git commit, and make available as GIT_SHA macro.
 include("../gitversion.pri")
 
+#Write an image of the default operating system next to the executable, using Pep9Term.
+OS_IMAGE_SOURCE = $$PWD/help-micro/alignedIO-OS.pep
+include("../osimage.pri")
+
 
 
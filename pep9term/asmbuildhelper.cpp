@@ -19,11 +19,13 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "asmbuildhelper.h"
+#include <iostream>
 
 #include "asmcode.h"
 #include "asmprogram.h"
 #include "asmprogrammanager.h"
 #include "isaasm.h"
+#include "objectfile.h"
 #include "pep.h"
 #include "symbolentry.h"
 #include "symboltable.h"
@@ -59,6 +61,11 @@ void ASMBuildHelper::set_error_file(QString error_file)
     this->error_log = error_file;
 }
 
+void ASMBuildHelper::set_report_timing(bool timing)
+{
+    this->timing = timing;
+}
+
 bool ASMBuildHelper::buildProgram()
 {
     // Construct files that will be needed for assembly
@@ -70,7 +77,19 @@ bool ASMBuildHelper::buildProgram()
     IsaAsm assmembler(manager);
 
     // Returns true if object code is successfully generated (i.e. program is non-null).
+    QElapsedTimer timer;
+    timer.start();
     bool success = assmembler.assembleUserProgram(source, program, elist);
+    if(timing) {
+        qint64 elapsed = timer.elapsed();
+        int lines = source.count('\n') + 1;
+        std::cout << "Assembled " << lines << " lines in " << elapsed << " ms";
+        // Avoid dividing by zero on programs that assemble within one timer tick.
+        if(elapsed > 0) {
+            std::cout << " (" << static_cast<quint64>(lines / (elapsed / 1000.0)) << " lines/sec)";
+        }
+        std::cout << "." << std::endl;
+    }
 
     // If there were errors, attempt to write all of them to the error file.
     // If the error file can't be opened, log that failure to standard output.
@@ -120,6 +139,14 @@ bool ASMBuildHelper::buildProgram()
             objectFile.close();
         }
 
+        // The binary object file and the listing file both describe the program with its symbols.
+        ObjectFile binaryObject(*program);
+        QString binaryFileName = QFileInfo(objectFile).absoluteDir().absoluteFilePath(
+                    QFileInfo(objectFile).baseName() + "." + ObjectFile::extension);
+        if(!binaryObject.store(binaryFileName)) {
+            qDebug().noquote() << errLogOpenErr.arg(binaryFileName);
+        }
+
         // Also attempt to generate listing file from assembled program as well.
         QFile listingFile(QFileInfo(objectFile).absoluteDir().absoluteFilePath(
                               QFileInfo(objectFile).baseName() + ".pepl"));
@@ -130,11 +157,7 @@ bool ASMBuildHelper::buildProgram()
         // Otherwise, write out the listing (and symbol table) to the file.
         else {
             QTextStream listingStream(&listingFile);
-            listingStream << program->getProgramListing();
-            if(!program->getSymbolTable()->getSymbolMap().isEmpty()) {
-                listingStream << "\n";
-                listingStream << program->getSymbolTable()->getSymbolTableListing();
-            }
+            listingStream << binaryObject.getListing();
             listingFile.close();
         }
     }
@@ -68,11 +68,15 @@ public:
     // Instead of using the output file as a base file name, manually specify
     // error file path.
     void set_error_file(QString error_file);
+    // Report the number of source lines assembled and the assembler's
+    // throughput (lines per second) to the console.
+    void set_report_timing(bool timing);
 private:
     const QString source;
     QFileInfo objFileInfo;
     AsmProgramManager& manager;
     QFileInfo error_log;
+    bool timing = false;
     // Helper method responsible for triggering program assembly.
     bool buildProgram();
 };
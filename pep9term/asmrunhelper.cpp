@@ -28,19 +28,23 @@
 #include "asmprogram.h"
 #include "asmprogrammanager.h"
 #include "boundexecisacpu.h"
+#include "charoutsink.h"
+#include "inputsource.h"
 #include "isaasm.h"
 #include "isacpu.h"
 #include "mainmemory.h"
+#include "memoryaccesstrace.h"
 #include "memorychips.h"
+#include "objectfile.h"
 #include "pep.h"
 #include "symbolentry.h"
 #include "symboltable.h"
 #include "termhelper.h"
 
-ASMRunHelper::ASMRunHelper(const QString objectCodeString,quint64 maxSimSteps,
-                     QFileInfo programOutput, QFileInfo programInput, AsmProgramManager &manager,
+ASMRunHelper::ASMRunHelper(const QVector<quint8> objectCode,quint64 maxSimSteps,
+                     QFileInfo programOutput, QFileInfo programInput, const AsmProgramManager &manager,
                      QObject *parent):
-    QObject(parent), QRunnable (), objectCodeString(objectCodeString),
+    QObject(parent), QRunnable (), objectCode(objectCode), objectFile(nullptr),
     programOutput(programOutput), programInput(programInput) ,manager(manager),
     // Explicitly initialize both simulation objects to nullptr,
     // so that it is clear to that neither object has been allocated
@@ -52,6 +56,8 @@ ASMRunHelper::ASMRunHelper(const QString objectCodeString,quint64 maxSimSteps,
 
 ASMRunHelper::~ASMRunHelper()
 {
+    // Any buffered output must reach the file before it is released.
+    outputSink.clear();
     // If we allocated an output file, we need to perform special work to free it.
     if(outputFile != nullptr) {
         outputFile->flush();
@@ -64,15 +70,12 @@ ASMRunHelper::~ASMRunHelper()
 
 void ASMRunHelper::loadOperatingSystem()
 {
-    QVector<quint8> values;
-    quint16 startAddress;
-    values = manager.getOperatingSystem()->getObjectCode();
-    startAddress = manager.getOperatingSystem()->getBurnAddress();
-
-    // Get addresses for I/O chips
-    auto osSymTable = manager.getOperatingSystem()->getSymbolTable();
-    charIn = static_cast<quint16>(osSymTable->getValue("charIn")->getValue());
-    charOut = static_cast<quint16>(osSymTable->getValue("charOut")->getValue());
+    if(osImage.isNull()) {
+        osImage = QSharedPointer<const OperatingSystemImage>::create(extractOperatingSystemImage(manager));
+    }
+    quint16 startAddress = osImage->burnAddress;
+    charIn = osImage->charIn;
+    charOut = osImage->charOut;
 
     // Construct main memory according to the current configuration of the operating system.
     QList<MemoryChipSpec> list;
@@ -80,7 +83,7 @@ void ASMRunHelper::loadOperatingSystem()
     // right up to the start of the operating system.
     list.append({AMemoryChip::ChipTypes::RAM, 0, startAddress});
     // ROM goes from the first byte of memory until the last installed address.
-    list.append({AMemoryChip::ChipTypes::ROM, startAddress, static_cast<quint32>(values.length())});
+    list.append({AMemoryChip::ChipTypes::ROM, startAddress, static_cast<quint32>(osImage->objectCode.length())});
     // Character input / output ports are only 1 byte wide by design.
     list.append({AMemoryChip::ChipTypes::IDEV, charIn, 1});
     list.append({AMemoryChip::ChipTypes::ODEV, charOut, 1});
@@ -88,7 +91,7 @@ void ASMRunHelper::loadOperatingSystem()
 
 
     memory->autoUpdateMemoryMap(true);
-    memory->loadValues(manager.getOperatingSystem()->getBurnAddress(), values);
+    memory->loadValues(startAddress, osImage->objectCode);
 }
 
 void ASMRunHelper::onInputRequested(quint16 address)
@@ -104,14 +107,8 @@ void ASMRunHelper::onOutputReceived(quint16 address, quint8 value)
     // We do not currently support memory mapped output
     // other than the charOut.
     if(address != charOut) return;
-    if(outputFile != nullptr) {
-        // Use a temporary (anonymous) text stream to make writing easy.
-        QTextStream (&*outputFile) << QChar(value);
-        // Try to block and make sure the IO actually completes.
-        outputFile->waitForBytesWritten(300);
-        if(echo) {
-            std::cout << static_cast<char>(value);
-        }
+    if(!outputSink.isNull()) {
+        outputSink->append(value);
     }
 }
 
@@ -126,20 +123,24 @@ void ASMRunHelper::onSimulationFinished()
 void ASMRunHelper::runProgram()
 {
 
-    // Buffer input file into memory mapped input if possible.
-    QFile input(programInput.absoluteFilePath());
-
-    // If there is not input, append a newline so that there is a least one character buffered.
-    if(!programInput.exists()) {
-        memory->onInputReceived(charIn, "\n");
+    // Stream the input file into memory mapped input if possible.
+    // Input always ends with a newline, so that there is a least one character buffered.
+    if(programInput.exists()) {
+        auto input = QSharedPointer<FileInputSource>::create(programInput.absoluteFilePath());
+        if(!input->open()) {
+            qDebug().noquote() << errLogOpenErr.arg(programInput.absoluteFilePath());
+            throw std::logic_error("Can't open input file.");
+        }
+        memory->onInputReceived(charIn, input);
     }
-    else if(!input.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug().noquote() << errLogOpenErr.arg(input.fileName());
-        throw std::logic_error("Can't open input file.");
-    } else {
-        QTextStream inputStream(&input);
-        memory->onInputReceived(charIn, inputStream.readAll() % "\n");
-        input.close();
+    memory->onInputReceived(charIn, "\n");
+
+    // Release the output of any previous run before opening this run's output.
+    outputSink.clear();
+    if(outputFile != nullptr) {
+        outputFile->flush();
+        outputFile->deleteLater();
+        outputFile = nullptr;
     }
 
     // Open up program output file if possible.
@@ -151,14 +152,73 @@ void ASMRunHelper::runProgram()
     } else {
         // If it could be opened, map charOut to the file.
         outputFile = output;
+        outputSink = QSharedPointer<CharOutSink>::create(outputFile, echo);
+    }
+
+    // Start recording memory accesses just before the program starts executing.
+    QScopedPointer<MemoryAccessTraceWriter> traceWriter;
+    if(!tracer.isNull()) {
+        traceWriter.reset(new MemoryAccessTraceWriter(memoryTraceFile));
+        if(!traceWriter->open()) {
+            qDebug().noquote() << errLogOpenErr.arg(memoryTraceFile);
+            throw std::logic_error("Can't open memory trace file.");
+        }
+        tracer->setWriter(traceWriter.data());
     }
 
+    // Every run starts with a cold cache.
+    if(!cache.isNull()) cache->reset();
+
     // Make sure to set up any last minute flags needed by CPU to perform simulation.
+    success = false;
     cpu->onSimulationStarted();
-    if(!cpu->onRun()) {
+    QElapsedTimer timer;
+    timer.start();
+    success = cpu->onRun();
+    // Write out any remaining output before reporting on the simulation.
+    outputSink->flush();
+    if(!traceWriter.isNull()) {
+        tracer->setWriter(nullptr);
+        if(!traceWriter->close()) {
+            qDebug().noquote() << "Failed to write memory trace to" << memoryTraceFile;
+        }
+    }
+    if(timing) {
+        qint64 elapsed = timer.elapsed();
+        // Count the instructions the OS would have executed for accelerated traps,
+        // so that the figures are comparable with and without acceleration.
+        quint64 count = cpu->getEmulatedInstructionCount();
+        std::cout << "Executed " << count << " instructions in " << elapsed << " ms";
+        // Avoid dividing by zero on programs that finish within one timer tick.
+        if(elapsed > 0) {
+            std::cout << " (" << static_cast<quint64>(count / (elapsed / 1000.0)) << " instructions/sec)";
+        }
+        std::cout << "." << std::endl;
+        if(cpu->isTrapAccelerationActive()) {
+            std::cout << "Accelerated " << cpu->getAcceleratedTrapCount() << " traps, "
+                      << cpu->getInstructionCount() << " instructions executed directly." << std::endl;
+        }
+        if(cpu->isCallGraphProfilingEnabled()) {
+            std::cout << cpu->getCallGraphProfiler()->report(manager).toStdString();
+        }
+        if(!traceWriter.isNull()) {
+            std::cout << "Traced " << traceWriter->getAccessCount() << " memory accesses." << std::endl;
+        }
+    }
+    if(!cache.isNull()) {
+        std::cout << cache->report().toStdString();
+    }
+    if(cpu->isProfilingEnabled()) writeProfile();
+    if(cpu->isCallGraphProfilingEnabled()) writeFoldedStacks();
+    if(!success) {
         qDebug().noquote()
                 << "The CPU failed for the following reason: "
                 << cpu->getErrorMessage();
+        // Binary object files know which line of source each instruction came from.
+        if(!objectFile.isNull()) {
+            quint16 pc = qAsConst(*cpu).getRegisterBank().readRegisterWordStart(Enu::CPURegisters::PC);
+            qDebug().noquote() << "The failing instruction is at" << objectFile->describeAddress(pc);
+        }
         QTextStream (&*outputFile)
                 << "[["
                 << cpu->getErrorMessage()
@@ -178,30 +238,67 @@ void ASMRunHelper::run()
         QSharedPointer<RAMChip> ramChip(new RAMChip(1<<16, 0, memory.get()));
         memory->insertChip(ramChip, 0);
 
-        cpu = QSharedPointer<BoundExecIsaCpu>::create(maxSimSteps, &manager, memory, nullptr);
+        QSharedPointer<AMemoryDevice> cpuMemory = memory;
+        if(useCache) {
+            cache = QSharedPointer<CacheMemoryDevice>::create(memory, cacheConfiguration);
+            cpuMemory = cache;
+        }
+        // Trace the accesses made by the CPU, which are the ones the cache sees.
+        if(!memoryTraceFile.isEmpty()) {
+            tracer = QSharedPointer<TracingMemoryDevice>::create(cpuMemory);
+            cpuMemory = tracer;
+        }
+
+        // Use the threaded core, since the terminal runner is all about throughput.
+        cpu = QSharedPointer<BoundExecIsaCpu>::create(maxSimSteps, &manager, cpuMemory, nullptr,
+                                                      IsaCpuCore::THREADED);
+        // Nothing observes individual instructions or stores, so skip emitting them.
+        cpu->setHeadless(true);
+        memory->setHeadless(true);
+        // Programs loop far more than they modify their own code, so decoding each block once pays off.
+        // Cached instructions are not fetched from memory, so the block cache would hide them from
+        // the trace and the simulated cache.
+        cpu->setBlockCacheEnabled(tracer.isNull() && cache.isNull());
+        if(!tracer.isNull()) tracer->setProgramCounterSource(&qAsConst(*cpu).getRegisterBank());
+        cpu->setTrapAccelerationEnabled(accelerateTraps);
+        cpu->setProfilingEnabled(!profileFile.isEmpty());
+        cpu->setCallGraphProfilingEnabled(!foldedStacksFile.isEmpty());
 
         // Connect IO events. IO *MUST* complete before execution moves forward.
-        // Use a blocking connection to serialize IO. Use asynchronous connection
-        // so that memory and helper don't need to reside in the same thread.
-        connect(memory.get(), &MainMemory::inputRequested, this, &ASMRunHelper::onInputRequested, Qt::BlockingQueuedConnection);
-        connect(memory.get(), &MainMemory::outputWritten, this, &ASMRunHelper::onOutputReceived, Qt::BlockingQueuedConnection);
+        // Input requests only touch memory, which belongs to the simulation thread, so handle
+        // them directly. This also lets a helper be run synchronously on any thread.
+        connect(memory.get(), &MainMemory::inputRequested, this, &ASMRunHelper::onInputRequested, Qt::DirectConnection);
+        // Output only touches outputSink, which belongs to the simulation thread, so
+        // handle it directly rather than paying for a round trip to the main thread per byte.
+        connect(memory.get(), &MainMemory::outputWritten, this, &ASMRunHelper::onOutputReceived, Qt::DirectConnection);
+
+        // Output must be on disk before the main thread is told the simulation finished.
+        connect(cpu.get(), &IsaCpu::simulationFinished, this, [this](){
+            if(!outputSink.isNull()) outputSink->flush();
+        }, Qt::DirectConnection);
+
+        // Instead of directly allowing run() to kill itself, uses events to "schedule"
+        // shutting down the application. This should ensure all IO completes. We were
+        // having an error where closing IO streams directly after simulation completion would
+        // cause a race condition with IO pending for the file. The overhead of the simulation events
+        // seems to "serialize" writes / closing.
+        connect(cpu.get(), &IsaCpu::simulationFinished, this, &ASMRunHelper::onSimulationFinished);
+    }
+
+    // A machine that has been run before only needs the memory the last run modified
+    // put back, rather than the operating system and program reloaded.
+    if(!cpu->restoreSnapshot()) {
+        // Load operating system & user program into memory.
+        loadOperatingSystem();
+        // Textual object code has no load address, and always starts at 0.
+        memory->loadValues(objectFile.isNull() ? 0 : objectFile->getLoadAddress(), objectCode);
+
+        // Clear & initialize all values in CPU before starting simulation.
+        cpu->reset();
+        cpu->initCPU();
+        cpu->takeSnapshot();
     }
 
-    // Load operating system & user program into memory.
-    loadOperatingSystem();
-    auto objCode = convertObjectCodeToIntArray(objectCodeString);
-    memory->loadValues(0, objCode);
-
-    // Clear & initialize all values in CPU before starting simulation.
-    cpu->reset();
-    cpu->initCPU();
-
-    // Instead of directly allowing run() to kill itself, uses events to "schedule"
-    // shutting down the application. This should ensure all IO completes. We were
-    // having an error where closing IO streams directly after simulation completion would
-    // cause a race condition with IO pending for the file. The overhead of the simulation events
-    // seems to "serialize" writes / closing.
-    connect(cpu.get(), &IsaCpu::simulationFinished, this, &ASMRunHelper::onSimulationFinished);
     runProgram();
 
     // Make sure any outstanding events are handled.
@@ -212,3 +309,77 @@ void ASMRunHelper::set_echo_charout(bool echo)
 {
     this->echo = echo;
 }
+
+void ASMRunHelper::set_report_timing(bool timing)
+{
+    this->timing = timing;
+}
+
+void ASMRunHelper::set_accelerate_traps(bool accelerate)
+{
+    this->accelerateTraps = accelerate;
+}
+
+void ASMRunHelper::set_profile_file(QString profileFile)
+{
+    this->profileFile = profileFile;
+}
+
+void ASMRunHelper::writeProfile()
+{
+    QFile file(profileFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qDebug().noquote() << errLogOpenErr.arg(file.fileName());
+        return;
+    }
+    QTextStream(&file) << cpu->getProfiler()->report(manager, *memory);
+    file.close();
+}
+
+void ASMRunHelper::set_folded_stacks_file(QString foldedStacksFile)
+{
+    this->foldedStacksFile = foldedStacksFile;
+}
+
+void ASMRunHelper::writeFoldedStacks()
+{
+    QFile file(foldedStacksFile);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qDebug().noquote() << errLogOpenErr.arg(file.fileName());
+        return;
+    }
+    QTextStream(&file) << cpu->getCallGraphProfiler()->foldedStacks(manager);
+    file.close();
+}
+
+void ASMRunHelper::set_memory_trace_file(QString memoryTraceFile)
+{
+    this->memoryTraceFile = memoryTraceFile;
+}
+
+void ASMRunHelper::set_cache_configuration(const CacheMemoryDevice::Configuration &cacheConfiguration)
+{
+    this->useCache = true;
+    this->cacheConfiguration = cacheConfiguration;
+}
+
+void ASMRunHelper::set_object_file(QSharedPointer<const ObjectFile> objectFile)
+{
+    this->objectFile = objectFile;
+}
+
+void ASMRunHelper::set_io_files(QFileInfo programOutput, QFileInfo programInput)
+{
+    this->programOutput = programOutput;
+    this->programInput = programInput;
+}
+
+void ASMRunHelper::set_operating_system_image(QSharedPointer<const OperatingSystemImage> image)
+{
+    this->osImage = image;
+}
+
+bool ASMRunHelper::succeeded() const
+{
+    return success;
+}
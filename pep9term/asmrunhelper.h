@@ -23,13 +23,19 @@
 #include <QtCore>
 #include <QRunnable>
 
+#include "cachememorydevice.h"
+#include "termhelper.h"
+
 class AsmProgramManager;
 class BoundExecIsaCpu;
+class CharOutSink;
 class MainMemory;
+class ObjectFile;
+class TracingMemoryDevice;
 
 /*
  * This class is responsible for executing a single assembly language program.
- * Given a string of object code (00 01 .. FF zz), the object code will be loaded into a memory
+ * Given the bytes of a program's object code, the object code will be loaded into a memory
  * device, programInput will be loaded and buffered as values of charIn,
  * and any program output will be written programOutput.
  *
@@ -41,8 +47,8 @@ class ASMRunHelper: public QObject, public QRunnable {
 public:
     // Program input may be an empty file. If it is empty or does not
     // exist, then it will be ignored.
-    explicit ASMRunHelper(const QString objectCodeString, quint64 maxSimSteps,
-                       QFileInfo programOutput, QFileInfo programInput, AsmProgramManager& manager,
+    explicit ASMRunHelper(const QVector<quint8> objectCode, quint64 maxSimSteps,
+                       QFileInfo programOutput, QFileInfo programInput, const AsmProgramManager& manager,
                        QObject *parent = nullptr);
     ~ASMRunHelper() override;
 
@@ -52,6 +58,7 @@ public:
     void onInputRequested(quint16 address);
 
     // On output received. Assumes there could be multiple memory mapped outputs.
+    // Called on the simulation thread, and buffers the value in outputSink.
     void onOutputReceived(quint16 address, quint8 value);
 
 signals:
@@ -66,19 +73,51 @@ public:
 
     // Pre: The operating system has been built and installed.
     // Pre: The Pep9 mnemonic maps have been initizialized correctly.
-    // Pre: objectCodeString contains only valid space/newline separated object code bytes
-    //      (00, 01, ..., FF, zz).
     // Pre: programOutput is a valid file that can be written to by the program. Will abort otherwise.
     // Post:The program is run to completion, or is terminated for taking too long.
     // Post:All program output is written to programOutput.
+    // Post:If run() has been called before, the machine is restored from a snapshot taken
+    //      after the first load rather than having the OS and program reloaded.
     void run() override;
 
     // Echo the values written to CharOut to the console.
     void set_echo_charout(bool echo);
+    // Report the number of instructions executed and the simulator's
+    // throughput (instructions per second) to the console.
+    void set_report_timing(bool timing);
+    // Perform DECI, DECO, HEXO, and STRO directly, rather than simulating the
+    // operating system's trap handlers. Has no effect unless the stock OS is loaded.
+    void set_accelerate_traps(bool accelerate);
+    // Count the executions of every instruction, and write an annotated listing
+    // of the counts to profileFile once the program finishes. Disabled if empty.
+    void set_profile_file(QString profileFile);
+    // Attribute executed instructions to the subroutines on the call stack, and write
+    // them to foldedStacksFile as folded stacks once the program finishes. Disabled if empty.
+    void set_folded_stacks_file(QString foldedStacksFile);
+    // Record every memory access made by the program, and the PC of the instruction making it,
+    // to memoryTraceFile in a compact binary format. Disabled if empty. Disables the block cache,
+    // so that instruction fetches are recorded too.
+    void set_memory_trace_file(QString memoryTraceFile);
+    // Simulate a cache between the CPU and memory, and report its hits, misses, and evictions
+    // to the console once the program finishes. Disables the block cache, so that instruction
+    // fetches reach the cache too.
+    void set_cache_configuration(const CacheMemoryDevice::Configuration& cacheConfiguration);
+    // Read input from and write output to different files on the next call to run().
+    void set_io_files(QFileInfo programOutput, QFileInfo programInput);
+    // The binary object file the object code was read from, if any. It is used to report
+    // where in the program the CPU failed.
+    void set_object_file(QSharedPointer<const ObjectFile> objectFile);
+    // Load the operating system from image rather than extracting it from the program manager.
+    void set_operating_system_image(QSharedPointer<const OperatingSystemImage> image);
+    // Did the last call to run() complete without a CPU, memory, or file error?
+    bool succeeded() const;
 private:
-    const QString objectCodeString;
+    const QVector<quint8> objectCode;
+    QSharedPointer<const ObjectFile> objectFile;
     QFileInfo programOutput, programInput;
-    AsmProgramManager& manager;
+    const AsmProgramManager& manager;
+    // Operating system loaded before the program, shared between simulations when possible.
+    QSharedPointer<const OperatingSystemImage> osImage;
     // Runnable will be executed in a separate thread, all objects being pointed to
     // must be constructed in this thread. The object is constructed in the main thread
     // so do not attempt to allocate objects there. Instead, allocate objects,
@@ -87,6 +126,10 @@ private:
 
     // Memory device used by simulation.
     QSharedPointer<MainMemory> memory;
+    // Device through which the CPU accesses memory when accesses are being traced, or nullptr.
+    QSharedPointer<TracingMemoryDevice> tracer;
+    // Cache between the CPU and memory, or nullptr if no cache is being simulated.
+    QSharedPointer<CacheMemoryDevice> cache;
     // The CPU simulator that will perform the computation.
     // It is limited to executing a finite numbers of steps,
     // so that applications using Pep9Term will not hang if given a bad program.
@@ -94,19 +137,42 @@ private:
 
     // Potentially multiple output sources, but don't take time to simulate now.
     QFile* outputFile;
+    // Buffers values written to charOut, so that they reach outputFile in large chunks.
+    QSharedPointer<CharOutSink> outputSink;
     // Addresses of the character input / character output ports.
     quint16 charIn, charOut;
     // Maximum number of steps the simulator should execute before force quitting.
     quint64 maxSimSteps;
 
+    // Set once the simulation has run without error.
+    bool success = false;
+
     // Control if the values written to CharOut get echoed to the console.
     bool echo = false;
+    // Control if execution statistics are written to the console.
+    bool timing = false;
+    // Control if the stock operating system's traps are accelerated.
+    bool accelerateTraps = false;
+    // File to which the execution profile is written, if any.
+    QString profileFile;
+    // File to which the call stack profile is written, if any.
+    QString foldedStacksFile;
+    // File to which memory accesses are written, if any.
+    QString memoryTraceFile;
+    // Control if a cache is simulated, and how it is organized.
+    bool useCache = false;
+    CacheMemoryDevice::Configuration cacheConfiguration;
 
     // Helper method responsible for buffering input, opening output streams,
     // converting string object code to a byte list, and executing the object
     // code in memory.
     void runProgram();
 
+    // Write the execution profile gathered by the CPU to profileFile.
+    void writeProfile();
+    // Write the call stack profile gathered by the CPU to foldedStacksFile.
+    void writeFoldedStacks();
+
     // Load the object code of the operating system into memory from manager.
     void loadOperatingSystem();
 };
@@ -0,0 +1,205 @@
+// File: batchrunhelper.cpp
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "batchrunhelper.h"
+
+#include <iostream>
+
+#include <QRegularExpression>
+#include <QThreadPool>
+
+#include "asmrunhelper.h"
+#include "pep.h"
+
+namespace {
+// Adapts a member function to a runnable, so that it may be started in a thread pool.
+class BatchWorker: public QRunnable
+{
+public:
+    explicit BatchWorker(std::function<void()> work): work(work) {}
+    void run() override { work(); }
+private:
+    std::function<void()> work;
+};
+}
+
+BatchRunHelper::BatchRunHelper(QList<Job> jobs, int threadCount, const AsmProgramManager &manager,
+                               QObject *parent): QObject(parent), QRunnable(), jobs(jobs),
+    threadCount(threadCount), manager(manager), osImage(nullptr), nextJob(0), failedJobs(0), consoleMutex()
+{
+
+}
+
+BatchRunHelper::~BatchRunHelper()
+{
+
+}
+
+bool BatchRunHelper::parseManifest(const QString &manifestFile, quint64 defaultMaxSteps,
+                                   QList<Job> &jobs, QString &errorMessage)
+{
+    QFile file(manifestFile);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        errorMessage = errLogOpenErr.arg(file.fileName());
+        return false;
+    }
+    QDir base = QFileInfo(manifestFile).absoluteDir();
+    QTextStream stream(&file);
+    int lineNumber = 0;
+    while(!stream.atEnd()) {
+        QString line = stream.readLine().trimmed();
+        lineNumber++;
+        if(line.isEmpty() || line.startsWith('#')) continue;
+
+        Job job {lineNumber, "", "", "", defaultMaxSteps};
+        QStringList tokens = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        for(int it = 0; it < tokens.length(); it += 2) {
+            if(it + 1 == tokens.length()) {
+                errorMessage = QString("Line %1: %2 requires a value.").arg(lineNumber).arg(tokens[it]);
+                return false;
+            }
+            const QString& value = tokens[it + 1];
+            if(tokens[it] == "-s") job.objectFile = base.absoluteFilePath(value);
+            else if(tokens[it] == "-i") job.inputFile = base.absoluteFilePath(value);
+            else if(tokens[it] == "-o") job.outputFile = base.absoluteFilePath(value);
+            else if(tokens[it] == "-m") {
+                bool ok = false;
+                job.maxSteps = value.toULongLong(&ok);
+                if(!ok || job.maxSteps == 0) {
+                    errorMessage = QString("Line %1: %2 is not a positive number.").arg(lineNumber).arg(value);
+                    return false;
+                }
+            }
+            else {
+                errorMessage = QString("Line %1: Unknown option %2.").arg(lineNumber).arg(tokens[it]);
+                return false;
+            }
+        }
+        // Jobs have the same requirements as the run subcommand.
+        if(job.objectFile.isEmpty()) {
+            errorMessage = QString("Line %1: Must set object code input (-s).").arg(lineNumber);
+            return false;
+        }
+        else if(job.outputFile.isEmpty()) {
+            errorMessage = QString("Line %1: Must set output log file (-o).").arg(lineNumber);
+            return false;
+        }
+        jobs.append(job);
+    }
+    return true;
+}
+
+void BatchRunHelper::set_accelerate_traps(bool accelerate)
+{
+    this->accelerateTraps = accelerate;
+}
+
+void BatchRunHelper::set_report_timing(bool timing)
+{
+    this->timing = timing;
+}
+
+void BatchRunHelper::run()
+{
+    // Extract the operating system once, before any worker needs it.
+    osImage = QSharedPointer<const OperatingSystemImage>::create(extractOperatingSystemImage(manager));
+    QElapsedTimer timer;
+    timer.start();
+
+    // Workers read the mnemonic maps concurrently, so nothing may reinitialize them until all are done.
+    Pep::freezeMaps();
+    QThreadPool pool;
+    int workers = qMax(1, qMin(threadCount, jobs.length()));
+    pool.setMaxThreadCount(workers);
+    for(int it = 0; it < workers; it++) {
+        pool.start(new BatchWorker([this](){runWorker();}));
+    }
+    pool.waitForDone();
+    Pep::thawMaps();
+
+    if(timing) {
+        std::cout << "Ran " << jobs.length() << " jobs (" << failedJobs.load() << " failed) on "
+                  << workers << " threads in " << timer.elapsed() << " ms." << std::endl;
+    }
+    emit finished();
+}
+
+void BatchRunHelper::runWorker()
+{
+    // The helper used for the last job, and the job it was created for.
+    QSharedPointer<ASMRunHelper> helper;
+    const Job* helperJob = nullptr;
+    for(int index = nextJob.fetchAndAddRelaxed(1); index < jobs.length(); index = nextJob.fetchAndAddRelaxed(1)) {
+        if(!runJob(jobs[index], helperJob, helper)) failedJobs.fetchAndAddRelaxed(1);
+        // Output files are released with deleteLater(), and pool threads have no event loop
+        // to process it. Release them now, rather than holding every file open until the batch ends.
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+    helper.clear();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+bool BatchRunHelper::runJob(const Job &job, const Job*& helperJob, QSharedPointer<ASMRunHelper>& helper)
+{
+    if(!helper.isNull() && helperJob->objectFile == job.objectFile && helperJob->maxSteps == job.maxSteps) {
+        // The helper's machine already holds this program, so it only needs new IO files.
+        helper->set_io_files(QFileInfo(job.outputFile), QFileInfo(job.inputFile));
+        return runHelper(job, *helper);
+    }
+
+    QVector<quint8> objectCode;
+    QSharedPointer<const ObjectFile> objectFile;
+    QString errorMessage;
+    if(!readObjectCodeFile(job.objectFile, objectCode, objectFile, errorMessage)) {
+        reportFailure(job, errorMessage);
+        return false;
+    }
+
+    // The helper is owned by this thread, so it runs synchronously here.
+    helper = QSharedPointer<ASMRunHelper>::create(objectCode, job.maxSteps, QFileInfo(job.outputFile),
+                                                  QFileInfo(job.inputFile), manager);
+    helperJob = &job;
+    helper->set_object_file(objectFile);
+    helper->set_operating_system_image(osImage);
+    helper->set_accelerate_traps(accelerateTraps);
+    return runHelper(job, *helper);
+}
+
+bool BatchRunHelper::runHelper(const Job &job, ASMRunHelper &helper)
+{
+    try {
+        helper.run();
+    } catch(const std::exception& e) {
+        reportFailure(job, e.what());
+        return false;
+    }
+    if(!helper.succeeded()) {
+        reportFailure(job, "The CPU reported an error. See " + job.outputFile + ".");
+        return false;
+    }
+    return true;
+}
+
+void BatchRunHelper::reportFailure(const Job &job, const QString &reason)
+{
+    QMutexLocker locker(&consoleMutex);
+    std::cerr << "Job on line " << job.line << " (" << job.objectFile.toStdString() << ") failed: "
+              << reason.toStdString() << std::endl;
+}
@@ -0,0 +1,106 @@
+// File: batchrunhelper.h
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef BATCHRUNHELPER_H
+#define BATCHRUNHELPER_H
+#include <QtCore>
+#include <QRunnable>
+
+#include "termhelper.h"
+
+class AsmProgramManager;
+class ASMRunHelper;
+
+/*
+ * This class is responsible for executing many object code programs in parallel,
+ * such as every (submission, test input) pair of an assignment.
+ *
+ * Each job is a line of a manifest, written with the same flags as the run subcommand:
+ *     -s object_file [-i charin_file] -o charout_file [-m max_steps]
+ * Blank lines and lines beginning with # are ignored. Relative paths are resolved
+ * against the directory containing the manifest.
+ *
+ * The operating system is assembled once, and its image is shared by every job. Each job gets
+ * its own memory and CPU through an ASMRunHelper, so its output file is identical to
+ * one produced by running the job alone. Idle workers claim the next unstarted job, so
+ * one long running job does not hold up the jobs queued behind it. When a worker claims
+ * consecutive jobs for the same object file, such as one program run against many inputs, it
+ * restores its machine from a snapshot rather than reloading the operating system and program.
+ *
+ * When every job has completed, finished() will be emitted so that the application may shut down safely.
+ */
+class BatchRunHelper: public QObject, public QRunnable {
+    Q_OBJECT
+public:
+    struct Job
+    {
+        // Line of the manifest on which the job was defined.
+        int line;
+        QString objectFile, inputFile, outputFile;
+        quint64 maxSteps;
+    };
+
+    // Pre: The operating system has been built and installed in manager.
+    // Pre: The Pep9 mnemonic maps have been initizialized correctly.
+    // Post:The maps are frozen (see Pep::freezeMaps()) while run() executes jobs.
+    explicit BatchRunHelper(QList<Job> jobs, int threadCount, const AsmProgramManager& manager,
+                            QObject *parent = nullptr);
+    ~BatchRunHelper() override;
+
+    // Parse the jobs in manifestFile, using defaultMaxSteps for jobs that do not specify -m.
+    // Returns false and sets errorMessage if the manifest could not be read or is malformed.
+    static bool parseManifest(const QString& manifestFile, quint64 defaultMaxSteps,
+                              QList<Job>& jobs, QString& errorMessage);
+
+    // Perform DECI, DECO, HEXO, and STRO directly in every job.
+    void set_accelerate_traps(bool accelerate);
+    // Report the number of jobs run, failed, and the elapsed time to the console.
+    void set_report_timing(bool timing);
+
+    // Post: Every job has run to completion, failed, or been terminated for taking too long.
+    void run() override;
+
+signals:
+    // Signals fired when every job has completed.
+    void finished();
+
+private:
+    const QList<Job> jobs;
+    int threadCount;
+    const AsmProgramManager& manager;
+    QSharedPointer<const OperatingSystemImage> osImage;
+    bool accelerateTraps = false;
+    bool timing = false;
+    // Index of the next job to be claimed by a worker, and the number of jobs that failed.
+    QAtomicInt nextJob, failedJobs;
+    // Serializes console messages from workers.
+    QMutex consoleMutex;
+
+    // Claim and run jobs until none remain. Executed concurrently by every worker.
+    void runWorker();
+    // Returns true if the job ran without error. If helper was created for a job with the same
+    // object file and step limit, it is reused. Otherwise, it is replaced with a helper for this job.
+    bool runJob(const Job& job, const Job*& helperJob, QSharedPointer<ASMRunHelper>& helper);
+    // Run the next job on helper, which is already configured for it.
+    bool runHelper(const Job& job, ASMRunHelper& helper);
+    void reportFailure(const Job& job, const QString& reason);
+};
+
+#endif // BATCHRUNHELPER_H
@@ -20,14 +20,16 @@
 */
 #include "boundexecisacpu.h"
 
+#include <algorithm>
 #include <QCoreApplication>
 #include <QTimer>
 
 #include "amemorydevice.h"
 
 BoundExecIsaCpu::BoundExecIsaCpu(quint64 stepCount, const AsmProgramManager *manager,
-                                   QSharedPointer<AMemoryDevice> memDevice, QObject *parent):
-    IsaCpu(manager, memDevice, parent), maxSteps(stepCount)
+                                   QSharedPointer<AMemoryDevice> memDevice, QObject *parent,
+                                   IsaCpuCore core):
+    IsaCpu(manager, memDevice, parent, core), maxSteps(stepCount)
 
 {
     // This version of the CPU does not respond to breakpoints, and as such
@@ -45,20 +47,30 @@ quint64 BoundExecIsaCpu::getDefaultMaxSteps()
     return defaultMaxSteps;
 }
 
+quint64 BoundExecIsaCpu::stepLimit() const noexcept
+{
+    const quint64 executed = getEmulatedInstructionCount();
+    return executed < maxSteps ? std::min(maxSteps - executed, IsaCpu::stepLimit()) : 1;
+}
+
 bool BoundExecIsaCpu::onRun()
 {
     // Execute instructions until an error occurs, the simulation finished,
     // or we exceed our step count.
-    std::function<bool(void)> cond = [this](){ if(maxSteps <=asmInstructionCounter) {
+    std::function<bool(void)> cond = [this](){ if(maxSteps <= getEmulatedInstructionCount()) {
             controlError = true;
             errorMessage = "Possible endless loop detected.";
             // Make sure to explicitly terminate simulation, else will be stuck in infinite loop.
+            synchronizeStatusBits();
+            if(headless) synchronizeChanges();
             emit simulationFinished();
             return false;
         }
         return !hadErrorOnStep() && !executionFinished;
     };
     doISAStepWhile(cond);
+    // Execution may have been cancelled between instructions.
+    synchronizeStatusBits();
 
     //If there was an error on the control flow
     if(hadErrorOnStep()) {
@@ -37,7 +37,8 @@ class BoundExecIsaCpu : public IsaCpu
 {
 public:
     explicit BoundExecIsaCpu(quint64 stepCount,const AsmProgramManager* manager,
-                     QSharedPointer<AMemoryDevice> memDevice, QObject* parent = nullptr);
+                     QSharedPointer<AMemoryDevice> memDevice, QObject* parent = nullptr,
+                     IsaCpuCore core = IsaCpuCore::SWITCH);
     virtual ~BoundExecIsaCpu() override;
 
     // Get the default maximum number of instructions to execute.
@@ -46,6 +47,10 @@ public:
 public slots:
     bool onRun() override;
 
+protected:
+    // Cached blocks must not run past maxSteps.
+    quint64 stepLimit() const noexcept override;
+
 private:
     quint64 maxSteps;
     // Default to a large number of instructions, since
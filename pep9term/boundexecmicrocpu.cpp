@@ -53,6 +53,7 @@ bool BoundExecMicroCpu::onRun()
             controlError = true;
             errorMessage = "Possible endless loop detected.";
             // Make sure to explicitly terminate simulation, else will be stuck in infinite loop.
+            if(headless) synchronizeChanges();
             emit simulationFinished();
             return false;
         }
@@ -0,0 +1,49 @@
+// File: charoutsink.cpp
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "charoutsink.h"
+
+#include <iostream>
+
+CharOutSink::CharOutSink(QFile *outputFile, bool echo): outputFile(outputFile), echo(echo)
+{
+
+}
+
+CharOutSink::~CharOutSink()
+{
+    flush();
+}
+
+void CharOutSink::flush()
+{
+    if(length == 0) return;
+    if(outputFile != nullptr) {
+        // Each byte used to be written as QChar(value), which is a Latin-1 character.
+        // Decoding the whole chunk as Latin-1 lets the stream's codec produce the same bytes.
+        QTextStream (outputFile) << QString::fromLatin1(buffer.data(), length);
+        outputFile->flush();
+    }
+    if(echo) {
+        std::cout.write(buffer.data(), length);
+        std::cout.flush();
+    }
+    length = 0;
+}
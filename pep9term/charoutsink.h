@@ -0,0 +1,64 @@
+// File: charoutsink.h
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CHAROUTSINK_H
+#define CHAROUTSINK_H
+
+#include <array>
+
+#include <QtCore>
+
+/*
+ * Collects the bytes a program writes to charOut on the simulation thread,
+ * and writes them to the output file (and optionally the console) in large chunks.
+ *
+ * Bytes are encoded exactly as if each had been streamed to the file individually
+ * as a QChar, so batching never changes the contents of the output file.
+ *
+ * The sink does not own the output file. Call flush() when the simulation
+ * ends or fails, and before writing anything else to the file.
+ */
+class CharOutSink
+{
+public:
+    // Number of bytes buffered before they are automatically written out.
+    static constexpr int capacity = 1 << 16;
+
+    explicit CharOutSink(QFile* outputFile, bool echo = false);
+    ~CharOutSink();
+
+    // Append a single byte, writing out the buffer if it has become full.
+    inline void append(quint8 value);
+    // Write every buffered byte to the file (and console when echoing).
+    void flush();
+
+private:
+    QFile* outputFile;
+    bool echo;
+    std::array<char, capacity> buffer;
+    int length = 0;
+};
+
+inline void CharOutSink::append(quint8 value)
+{
+    buffer[length++] = static_cast<char>(value);
+    if(length == capacity) flush();
+}
+#endif // CHAROUTSINK_H
@@ -223,6 +223,8 @@ void CPURunHelper::run()
         memory->insertChip(ramChip, 0);
 
         cpu = QSharedPointer<PartialMicrocodedCPU>::create(type, memory, nullptr);
+        // Nothing observes individual cycles or stores, so skip emitting them.
+        cpu->setHeadless(true);
     }
 
     // Clear & initialize all values in CPU before starting simulation.
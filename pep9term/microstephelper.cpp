@@ -37,8 +37,9 @@ MicroStepHelper::MicroStepHelper(const quint64 maxCycleCount,
                                  const QString microcodeProgram,
                                  QFileInfo microcodeProgramFile,
                                  const QString preconditionsProgram,
+                                 const AsmProgramManager& manager,
                                  QObject *parent) :
-    QObject(parent), QRunnable(), maxStepCount(maxCycleCount),
+    QObject(parent), QRunnable(), maxStepCount(maxCycleCount), manager(manager),
     microcodeProgram(microcodeProgram), microcodeProgramFile(microcodeProgramFile),
     preconditionsProgram(preconditionsProgram),
     // Explicitly initialize both simulation objects to nullptr,
@@ -238,8 +239,10 @@ void MicroStepHelper::run()
 
 
         cpu = QSharedPointer<BoundExecMicroCpu>::create(maxStepCount,
-                                                        AsmProgramManager::getInstance(),
+                                                        &manager,
                                                         memory, nullptr);
+        // Nothing observes individual cycles or stores, so skip emitting them.
+        cpu->setHeadless(true);
     }
 
     // Clear & initialize all values in CPU before starting simulation.
@@ -28,6 +28,7 @@
 
 #include "enu.h"
 
+class AsmProgramManager;
 class BoundExecMicroCpu;
 class MainMemory;
 class MicrocodeProgram;
@@ -59,7 +60,7 @@ public:
     // exist, then it will be ignored.
     explicit MicroStepHelper(const quint64 maxCycleCount,
                              const QString microcodeProgram, QFileInfo microcodeProgramFile,
-                             const QString preconditionsProgram,
+                             const QString preconditionsProgram, const AsmProgramManager& manager,
                              QObject *parent = nullptr);
     ~MicroStepHelper() override;
 
@@ -94,6 +95,7 @@ protected:
 
 private:
    const quint64 maxStepCount;
+   const AsmProgramManager& manager;
    const QString microcodeProgram;
    QFileInfo microcodeProgramFile;
    const QString preconditionsProgram;
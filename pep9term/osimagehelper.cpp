@@ -0,0 +1,71 @@
+// File: osimagehelper.cpp
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaevn, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "osimagehelper.h"
+
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "isaasm.h"
+#include "osimagecache.h"
+#include "termhelper.h"
+
+OSImageHelper::OSImageHelper(const QString source, QFileInfo imageFileInfo,
+                             AsmProgramManager &manager, QObject *parent): QObject(parent),
+    QRunnable(), source(source), imageFileInfo(imageFileInfo), manager(manager)
+{
+
+}
+
+OSImageHelper::~OSImageHelper()
+{
+    // All of our memory is owned by sharedpointers, so we
+    // should not attempt to delete anything ourselves.
+}
+
+void OSImageHelper::run()
+{
+    buildImage();
+    // Application will live forever if we don't signal it to die.
+    emit finished();
+}
+
+bool OSImageHelper::buildImage()
+{
+    QSharedPointer<AsmProgram> program;
+    auto elist = QList<QPair<int, QString>>();
+    IsaAsm assembler(manager);
+    // Operating systems are always burned at the top of memory, as the default ones are.
+    if(!assembler.assembleOperatingSystem(source, true, program, elist)) {
+        qDebug() << "OS failed to assemble.";
+        auto textList = source.split("\n");
+        for(auto errorPair : elist) {
+            qDebug().noquote() << textList[errorPair.first] << errorPair.second;
+        }
+        return false;
+    }
+
+    OsImageCache image(imageFileInfo.absoluteFilePath());
+    if(!image.store(source, *program)) {
+        qDebug().noquote() << errLogOpenErr.arg(imageFileInfo.absoluteFilePath());
+        return false;
+    }
+    qDebug() << "Operating system image written successfully.";
+    return true;
+}
@@ -0,0 +1,64 @@
+// File: osimagehelper.h
+/*
+    Pep9Term is a  command line tool utility for assembling Pep/9 programs to
+    object code and executing object code programs.
+
+    Copyright (C) 2019  J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef OSIMAGEHELPER_H
+#define OSIMAGEHELPER_H
+
+#include <QtCore>
+#include <QRunnable>
+
+class AsmProgramManager;
+
+/*
+ * This class is responsible for assembling an operating system, and writing it to
+ * an OsImageCache image, so that an application may install it without assembling it.
+ * The build uses it to write an image of each application's default operating system.
+ *
+ * If the operating system fails to assemble, its errors are written to the console,
+ * and no image is written.
+ *
+ * When the image is written, or assembly fails, finished() will be emitted
+ * so that the application may shut down safely.
+ */
+class OSImageHelper: public QObject, public QRunnable {
+    Q_OBJECT
+public:
+    explicit OSImageHelper(const QString source, QFileInfo imageFileInfo, AsmProgramManager& manager,
+                           QObject *parent = nullptr);
+    ~OSImageHelper() override;
+
+signals:
+    // Signals fired when the image has been written, or could not be written.
+    void finished();
+
+    // QRunnable interface
+public:
+    void run() override;
+    // Pre: The Pep9 mnemonic maps have been initizialized correctly.
+
+private:
+    const QString source;
+    QFileInfo imageFileInfo;
+    AsmProgramManager& manager;
+    // Helper method responsible for assembling the operating system and writing its image.
+    bool buildImage();
+};
+
+#endif // OSIMAGEHELPER_H
@@ -45,10 +45,13 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs depr
 SOURCES += \
     asmbuildhelper.cpp \
     asmrunhelper.cpp \
+    batchrunhelper.cpp \
     boundexecmicrocpu.cpp \
+    charoutsink.cpp \
     cpubuildhelper.cpp \
     cpurunhelper.cpp \
     microstephelper.cpp \
+    osimagehelper.cpp \
     termhelper.cpp \
     boundexecisacpu.cpp \
     termmain.cpp
@@ -61,11 +64,14 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 HEADERS += \
     asmbuildhelper.h \
     asmrunhelper.h \
+    batchrunhelper.h \
     boundexecmicrocpu.h \
+    charoutsink.h \
     cpubuildhelper.h \
     cpurunhelper.h \
     CLI11.hpp \
     microstephelper.h \
+    osimagehelper.h \
     termformatter.h \
     termhelper.h \
     boundexecisacpu.h
@@ -32,6 +32,8 @@
 #include "memorychips.h"
 #include "microcode.h"
 #include "microcodeprogram.h"
+#include "objectfile.h"
+#include "osimagecache.h"
 #include "pep.h"
 #include "symbolentry.h"
 #include "symboltable.h"
@@ -41,32 +43,89 @@ const QString errLogOpenErr = "Could not open file: %1.";
 const QString hadErr        = "Errors/warnings encountered while generating output for file: %1.";
 const QString assemble      = "About to assemble %1 into object file %2.";
 
-QVector<quint8> convertObjectCodeToIntArray(QString program)
+QVector<quint8> convertObjectCodeToIntArray(const QString& program)
 {
-    bool ok = false;
-    quint8 temp;
     QVector<quint8> output;
-    program.replace(QRegExp("\n")," ");
-    for(QString byte : program.split(" ")) {
-        // toShort(...) should never throw any errors, so there should be no concerns if byte is not a hex constant.
-        temp = static_cast<quint8>(byte.toShort(&ok, 16));
-        // There could be a loss in precision if given text outside the range of an uchar but in range of a ushort.
-        if(ok && byte.length()>0) output.append(temp);
+    // Every byte takes three characters of text.
+    output.reserve(program.length() / 3 + 1);
+    // Bytes are whitespace separated hexadecimal numbers. Anything else, such as the
+    // terminating zz, is skipped. Numbers too large for a short are skipped, and
+    // larger ones are truncated to their low byte.
+    int value = 0, digits = 0;
+    bool valid = true;
+    // Iterate one past the end, so that the last number is terminated like the others.
+    for(int index = 0; index <= program.length(); index++) {
+        const QChar ch = index < program.length() ? program[index] : QChar(' ');
+        if(ch.isSpace()) {
+            if(valid && digits > 0) output.append(static_cast<quint8>(value));
+            value = 0;
+            digits = 0;
+            valid = true;
+            continue;
+        }
+        const ushort code = ch.unicode();
+        int digit = -1;
+        if(code >= '0' && code <= '9') digit = code - '0';
+        else if(code >= 'a' && code <= 'f') digit = code - 'a' + 10;
+        else if(code >= 'A' && code <= 'F') digit = code - 'A' + 10;
+        if(digit < 0 || !valid) {
+            valid = false;
+            continue;
+        }
+        value = value * 16 + digit;
+        digits++;
+        if(value > 0x7fff) valid = false;
     }
     return output;
 }
 
-void buildDefaultOperatingSystem(AsmProgramManager &manager)
+bool readObjectCodeFile(const QString &fileName, QVector<quint8> &objectCode,
+                        QSharedPointer<const ObjectFile> &objectFile, QString &errorMessage)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly)) {
+        errorMessage = errLogOpenErr.arg(file.fileName());
+        return false;
+    }
+    // Read the whole file at once, and only then decide how to interpret it.
+    QByteArray bytes = file.readAll();
+    file.close();
+
+    if(ObjectFile::isObjectFile(bytes)) {
+        auto parsed = QSharedPointer<ObjectFile>::create();
+        if(!ObjectFile::fromBytes(bytes, *parsed, errorMessage)) {
+            errorMessage = QString("%1: %2").arg(fileName, errorMessage);
+            return false;
+        }
+        objectCode = parsed->getObjectCode();
+        objectFile = parsed;
+    }
+    else {
+        objectCode = convertObjectCodeToIntArray(QString::fromLatin1(bytes));
+        objectFile.clear();
+    }
+    return true;
+}
+
+void buildDefaultOperatingSystem(AsmProgramManager &manager, bool useImageCache)
 {
     // Need to assemble operating system.
     QString defaultOSText = Pep::resToString(":/help-asm/figures/pep9os.pep", false);
     // If there is text, attempt to assemble it
     if(!defaultOSText.isEmpty()) {
         QSharedPointer<AsmProgram> prog;
+        OsImageCache imageCache(OsImageCache::defaultImageFile());
+        // Skip the assembler entirely if an image of this operating system is up to date.
+        if(useImageCache && !(prog = imageCache.load(defaultOSText)).isNull()) {
+            manager.setOperatingSystemImage(prog, defaultOSText);
+            return;
+        }
         auto elist = QList<QPair<int, QString>>();
         IsaAsm assembler(manager);
         if(assembler.assembleOperatingSystem(defaultOSText, true, prog, elist)) {
             manager.setOperatingSystem(prog);
+            // Failing to write the image only costs the next launch an assembly.
+            if(useImageCache) imageCache.store(defaultOSText, *prog);
         }
         // If the operating system failed to assembly, we can't progress any further.
         // All application functionality depends on the operating system being defined.
@@ -87,3 +146,14 @@ void buildDefaultOperatingSystem(AsmProgramManager &manager)
 
 }
 
+OperatingSystemImage extractOperatingSystemImage(const AsmProgramManager &manager)
+{
+    auto os = manager.getOperatingSystem();
+    auto osSymTable = os->getSymbolTable();
+    OperatingSystemImage image;
+    image.objectCode = os->getObjectCode();
+    image.burnAddress = os->getBurnAddress();
+    image.charIn = static_cast<quint16>(osSymTable->getValue("charIn")->getValue());
+    image.charOut = static_cast<quint16>(osSymTable->getValue("charOut")->getValue());
+    return image;
+}
@@ -28,13 +28,35 @@ extern const QString hadErr;
 extern const QString assemble;
 
 class AsmProgramManager;
+class ObjectFile;
 
 // Assemble the default operating system from the help documentation,
 // and install it into the program manager.
-void buildDefaultOperatingSystem(AsmProgramManager& manager);
+// If useImageCache is set, install the image cached by an earlier launch instead when it
+// is still valid, or cache an image of the newly assembled operating system otherwise.
+// Operating systems loaded from an image have no listing.
+void buildDefaultOperatingSystem(AsmProgramManager& manager, bool useImageCache = true);
+
+// The parts of an assembled operating system needed to load it into memory.
+// Extracted once, so that any number of simulations may share it without
+// walking the operating system's listing or symbol table.
+struct OperatingSystemImage
+{
+    QVector<quint8> objectCode;
+    quint16 burnAddress;
+    // Addresses of the character input / character output ports.
+    quint16 charIn, charOut;
+};
+OperatingSystemImage extractOperatingSystemImage(const AsmProgramManager& manager);
 
 // Helper function that turns hexadecimal object code into a vector of
 // unsigned characters, which is easier to copy into memory.
-QVector<quint8> convertObjectCodeToIntArray(QString program);
+QVector<quint8> convertObjectCodeToIntArray(const QString& program);
+
+// Read the object code of a program from fileName, which may hold either the hexadecimal text
+// of a .pepo file or a binary object file. A binary object file is also returned through objectFile,
+// which is set to null for text. Returns false and explains why in errorMessage if the file can't be read.
+bool readObjectCodeFile(const QString& fileName, QVector<quint8>& objectCode,
+                        QSharedPointer<const ObjectFile>& objectFile, QString& errorMessage);
 
 #endif // TERMHELPER_H
@@ -30,8 +30,10 @@
 #include "asmbuildhelper.h"
 #include "asmrunhelper.h"
 #include "asmprogrammanager.h"
+#include "batchrunhelper.h"
 #include "boundexecisacpu.h"
 #include "boundexecmicrocpu.h"
+#include "cachememorydevice.h"
 #include "CLI11.hpp"
 #include "cpubuildhelper.h"
 #include "cpurunhelper.h"
@@ -39,25 +41,37 @@
 #include "mainmemory.h"
 #include "memorychips.h"
 #include "microstephelper.h"
+#include "osimagehelper.h"
 #include "pep.h"
 #include "termformatter.h"
 
 const std::string application_description = "Translate and run Pep/9 assembly language and microcode programs.";
 const std::string asm_description = "Assemble a Pep/9 assembler source code program to object code.";
 const std::string run_description = "Run a Pep/9 object code program.";
+const std::string batch_description = "Run many Pep/9 object code programs in parallel.";
 const std::string cpuasm_description = "Check a Pep/9 microcode program for syntax errors.";
 const std::string cpurun_description = "Run a Pep/9 microcode program.";
+const std::string osimage_description = "Assemble a Pep/9 operating system to an image the applications install at launch.";
 
 const std::string asm_description_detailed = "The source_file must be a .pep file. \
 The object_file must be a .pepo file. \
+A binary object file holding the object code, symbol table, and listing is written next to object_file, with a .pepb extension. \
 If there are assembly errors, an error log file named <source_file>_errLog.txt is created with the error messages. \
 <source_file> is the name of source_file without the .pep extension. \
 If there are no errors, the error log file is not created.";
-const std::string run_description_detailed = "The object_file must be a .pepo file. \
+const std::string run_description_detailed = "The object_file must be a .pepo file or a .pepb binary object file. \
+When run from a binary object file, CPU errors report the source line of the failing instruction. \
 If the program takes input, -i is required. \
 If the program produces output, -o is required. \
 As a guard against endless loops the program will abort after max_steps assembly instructions execute. \
 The default value of max_steps is %1.";
+const std::string batch_description_detailed = "The manifest_file lists one job per line, using the same flags as run: \
+-s object_file [-i charin_file] -o charout_file [-m max_steps]. \
+Blank lines and lines beginning with # are ignored. \
+Relative paths are resolved against the directory containing manifest_file. \
+Each job produces the same charout_file as running it with run. \
+The operating system is assembled once and shared by every job. \
+If -m is specified, it overrides the default value of max_steps for jobs that do not specify -m.";
 const std::string cpuasm_description_detailed = "The microcode_file must be a .pepcpu file. \
 If there are micro-assembly errors, an error log file named <microcode_file>_errLog.txt is created with the error messages. \
 <microcode_file> is the name of microcode_file without the .pepcpu extension. \
@@ -72,6 +86,10 @@ Supports 1- and 2-byte data buses with the 1-byte data bus as the default. \
 If -p is specified, then all UnitPre and UnitPost statements in microcode_file are ignored. \
 The UnitPre and UnitPost statments from precondition_file will be used instead. \
 The precondition_file must be a .pepcpu file.";
+const std::string osimage_description_detailed = "The os_source_file must be a .pep file that assembles to a burned operating system. \
+The build writes image_file next to Pep9 and Pep9Micro, which install it instead of assembling their default operating system, \
+as long as it was written by Pep9Term from the same build and os_source_file is their default operating system. \
+If there are assembly errors, they are written to the console and image_file is not written.";
 
 const std::string asm_input_file_text = "Input Pep/9 source program for assembler.";
 const std::string asm_output_file_text = "Output object code generated from source.";
@@ -80,6 +98,19 @@ const std::string obj_input_file_text = "Input Pep/9 object code program for sim
 const std::string charin_file_text = "File buffered behind the charIn input port.";
 const std::string charout_file_text = "File to which the charOut output port is streamed.";
 const std::string charout_echo_text = "Echo data written to charOut to std::out.";
+const std::string timing_text = "Report the number of instructions executed and instructions per second to std::out.";
+const std::string asm_timing_text = "Report the number of lines assembled and lines per second to std::out.";
+const std::string accelerate_traps_text = "Perform DECI, DECO, HEXO, and STRO without simulating the operating system's trap handlers.";
+const std::string profile_file_text = "Write the number of times each instruction executed, annotated with source where available, to profile_file.";
+const std::string folded_stacks_file_text = "Write the instructions executed by each call stack to folded_stacks_file, in the folded format read by flame graph tools. \
+With --timing, also report the instructions executed per subroutine to std::out.";
+const std::string trace_mem_file_text = "Write every memory access made by the program, and the PC of the instruction making it, \
+to trace_file in a compact binary format. Instruction fetches are included, so the run is slower.";
+const std::string cache_text = "Simulate a cache between the CPU and memory, and report its hits, misses, and evictions to std::out. \
+cache_config is a comma separated list of size=bytes, ways=associativity, line=bytes, write=back|through, and replace=lru|fifo|random, \
+where omitted settings default to size=1024,ways=2,line=16,write=back,replace=lru.";
+const std::string manifest_file_text = "Input list of jobs to run.";
+const std::string thread_count_text = "Override the number of jobs run at once (default is the number of processor cores).";
 const std::string isaMaxStepText = "Override the default value of max_steps.";
 const std::string microMaxStepText = "Override the default value of max_steps.";
 const std::string cpuasm_input_file_text = "Input Pep/9 microcode source program for microassembler.";
@@ -92,20 +123,27 @@ const std::string cpu_full_control = "Assemble the microprogram with the full co
 const std::string cpu_preconditions = "Input Pep/9 microcode source program for microassembler.";
 const std::string cpu_run_log = "Override the name of the default error log file.";
 
+const std::string osimage_input_file_text = "Input Pep/9 operating system source program for assembler.";
+const std::string osimage_output_file_text = "Output operating system image generated from source.";
+
 struct command_line_values {
     bool had_version{false}, had_about{false}, had_d2{false}, had_full_control{false}, had_echo_output{false};
-    std::string e{}, s{}, o{}, i{}, mc{}, p{};
+    bool had_timing{false}, had_accelerate_traps{false};
+    std::string e{}, s{}, o{}, i{}, mc{}, p{}, profile{}, folded_stacks{}, trace_mem{}, cache{};
     uint64_t m{2500};
+    int j{0};
 };
 
 void handle_full_control(command_line_values&, bool use_full_control);
 void handle_databus_size(command_line_values&, bool two_byte);
 void handle_version(command_line_values&, int64_t);
 void handle_about(command_line_values&, int64_t);
-void handle_asm(command_line_values&, QRunnable**);
-void handle_run(command_line_values&, QRunnable**);
+void handle_asm(command_line_values&, AsmProgramManager&, QRunnable**);
+void handle_run(command_line_values&, AsmProgramManager&, QRunnable**);
+void handle_batch(command_line_values&, AsmProgramManager&, QRunnable**);
 void handle_cpuasm(command_line_values&, QRunnable**);
-void handle_cpurun(command_line_values&, QRunnable**);
+void handle_cpurun(command_line_values&, AsmProgramManager&, QRunnable**);
+void handle_osimage(command_line_values&, AsmProgramManager&, QRunnable**);
 
 int main(int argc, char *argv[])
 {
@@ -129,6 +167,9 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("Pep9Term");
     QCoreApplication::setApplicationVersion("9.3.0");
 
+    // Owns the operating system shared by every simulation started by this process.
+    AsmProgramManager manager;
+
     // Runnable into which the executable program will be loaded by the below subcommands.
     QRunnable* run = nullptr;
 
@@ -167,8 +208,9 @@ int main(int argc, char *argv[])
     // File to which object code will be written.
     asm_subcommand->add_option("-o", values.o, asm_output_file_text)->expected(1)->required(1);
     parameter_formatting["asm"]["o"] = "object_file";
+    asm_subcommand->add_flag("--timing", values.had_timing, asm_timing_text);
     // Create a runnable application from command line arguments
-    asm_subcommand->callback(std::function<void()>([&](){handle_asm(values, &run);}));
+    asm_subcommand->callback(std::function<void()>([&](){handle_asm(values, manager, &run);}));
 
     // Subcommands for RUN
    parameter_formatting.insert_or_assign("run", std::map<std::string,std::string>());
@@ -181,6 +223,20 @@ int main(int argc, char *argv[])
     run_subcommand->add_option("-o", values.o, charout_file_text)->expected(1);
     parameter_formatting["run"]["o"] = "charout_file";
     run_subcommand->add_flag("--echo-output", values.had_echo_output, charout_echo_text);
+    run_subcommand->add_flag("--timing", values.had_timing, timing_text);
+    run_subcommand->add_flag("--accelerate-traps", values.had_accelerate_traps, accelerate_traps_text);
+    // File to which a per-address execution profile will be written.
+    run_subcommand->add_option("--profile", values.profile, profile_file_text)->expected(1);
+    parameter_formatting["run"]["profile"] = "profile_file";
+    // File to which the instructions executed per call stack will be written.
+    run_subcommand->add_option("--folded-stacks", values.folded_stacks, folded_stacks_file_text)->expected(1);
+    parameter_formatting["run"]["folded-stacks"] = "folded_stacks_file";
+    // File to which every memory access will be written.
+    run_subcommand->add_option("--trace-mem", values.trace_mem, trace_mem_file_text)->expected(1);
+    parameter_formatting["run"]["trace-mem"] = "trace_file";
+    // Organization of the cache to simulate, if any.
+    run_subcommand->add_option("--cache", values.cache, cache_text)->expected(1);
+    parameter_formatting["run"]["cache"] = "cache_config";
     //run_subcommand->add_option("-e", obj_input_file_text);
     // Maximum number of instructions to be executed.
     std::string max_steps_text = isaMaxStepText;
@@ -191,7 +247,23 @@ int main(int argc, char *argv[])
     run_subcommand->add_option("-s", values.s, obj_input_file_text)->expected(1)->required(true);
     parameter_formatting["run"]["s"] = "object_file";
     // Create a runnable application from command line arguments
-    run_subcommand->callback(std::function<void()>([&](){handle_run(values, &run);}));
+    run_subcommand->callback(std::function<void()>([&](){handle_run(values, manager, &run);}));
+
+    // Subcommands for BATCH
+    parameter_formatting.insert_or_assign("batch", std::map<std::string,std::string>());
+    auto batch_subcommand = parser.add_subcommand("batch", batch_description);
+    detailed_descriptions["batch"] = batch_description_detailed;
+    batch_subcommand->add_option("-s", values.s, manifest_file_text)->expected(1)->required(true);
+    parameter_formatting["batch"]["s"] = "manifest_file";
+    batch_subcommand->add_option("-j", values.j, thread_count_text)->expected(1)->check(CLI::PositiveNumber);
+    parameter_formatting["batch"]["j"] = "thread_count";
+    batch_subcommand->add_option("-m", values.m, max_steps_text)->expected(1)->check(CLI::PositiveNumber)
+            ->default_val(std::to_string(BoundExecIsaCpu::getDefaultMaxSteps()));
+    parameter_formatting["batch"]["m"] = "max_steps";
+    batch_subcommand->add_flag("--timing", values.had_timing, timing_text);
+    batch_subcommand->add_flag("--accelerate-traps", values.had_accelerate_traps, accelerate_traps_text);
+    // Create a runnable application from command line arguments
+    batch_subcommand->callback(std::function<void()>([&](){handle_batch(values, manager, &run);}));
 
     // Subcommands for CPUASM
     parameter_formatting.insert_or_assign("cpuasm", std::map<std::string,std::string>());
@@ -234,7 +306,20 @@ int main(int argc, char *argv[])
     cpurun_subcommand->add_option("-s", values.mc, cpuasm_input_file_text)->expected(1)->required(true);
     parameter_formatting["cpurun"]["s"] = "microcode_file";
     // Create a runnable application from command line arguments
-    cpurun_subcommand->callback(std::function<void()>([&](){handle_cpurun(values, &run);}));
+    cpurun_subcommand->callback(std::function<void()>([&](){handle_cpurun(values, manager, &run);}));
+
+    // Subcommands for OSIMAGE
+    parameter_formatting.insert_or_assign("osimage", std::map<std::string,std::string>());
+    auto osimage_subcommand = parser.add_subcommand("osimage", osimage_description);
+    detailed_descriptions["osimage"] = osimage_description_detailed;
+    // File from which the operating system will be assembled.
+    osimage_subcommand->add_option("-s", values.s, osimage_input_file_text)->expected(1)->required(true);
+    parameter_formatting["osimage"]["s"] = "os_source_file";
+    // File to which the image will be written.
+    osimage_subcommand->add_option("-o", values.o, osimage_output_file_text)->expected(1)->required(true);
+    parameter_formatting["osimage"]["o"] = "image_file";
+    // Create a runnable application from command line arguments
+    osimage_subcommand->callback(std::function<void()>([&](){handle_osimage(values, manager, &run);}));
 
     // Require that one of the modes be used.
     parser.require_subcommand();
@@ -251,7 +336,11 @@ int main(int argc, char *argv[])
 
     // Assemble the default operating system from this thread, so that
     // no worker threads have to check for the presence of an operating system.
-    buildDefaultOperatingSystem(*AsmProgramManager::getInstance());
+    // Profiles annotate the operating system's listing, which a cached image lacks.
+    // Writing an image assembles its own operating system, so needs no default one.
+    if(!osimage_subcommand->parsed()) {
+        buildDefaultOperatingSystem(manager, values.profile.empty());
+    }
 
     /*
      * This asynchronous approach must be used, because if quit() is called
@@ -300,7 +389,7 @@ void handle_about(command_line_values &values, int64_t)
     aboutFile.close();
 }
 
-void handle_asm(command_line_values &values, QRunnable **runnable)
+void handle_asm(command_line_values &values, AsmProgramManager &manager, QRunnable **runnable)
 {
     // Needs a assembler source program to be well defined.
     if(values.s.empty()) {
@@ -329,11 +418,11 @@ void handle_asm(command_line_values &values, QRunnable **runnable)
         sourceText = sourceStream.readAll();
         sourceFile.close();
 
-        ASMBuildHelper *helper = new ASMBuildHelper(sourceText, objectFileString,
-                                                    *AsmProgramManager::getInstance());
+        ASMBuildHelper *helper = new ASMBuildHelper(sourceText, objectFileString, manager);
         if(!values.e.empty()) {
             helper->set_error_file(QString::fromStdString(values.e));
         }
+        helper->set_report_timing(values.had_timing);
 
         QObject::connect(helper, &ASMBuildHelper::finished, QCoreApplication::instance(), &QCoreApplication::quit);
 
@@ -341,7 +430,7 @@ void handle_asm(command_line_values &values, QRunnable **runnable)
     }
 }
 
-void handle_run(command_line_values &values, QRunnable **runnable)
+void handle_run(command_line_values &values, AsmProgramManager &manager, QRunnable **runnable)
 {
     // Needs a source object code program to be well defined.
     if(values.s.empty()) {
@@ -360,26 +449,54 @@ void handle_run(command_line_values &values, QRunnable **runnable)
     QString textOutputFileName = QString::fromStdString(values.o);
     // Attempt to parse stepMax string as an integer.
     quint64 stepMaxValue = values.m;
-
-    // Load object code string from file if possible, else print error log.
-    QFile objFile(objCodeFileName);
-    if(!objFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        //qDebug().noquote() << errLogOpenErr.arg(objFile.fileName());
-        throw CLI::ValidationError(errLogOpenErr.arg(objFile.fileName()).toStdString(), -1);
+    // Reject a malformed cache before doing any work.
+    CacheMemoryDevice::Configuration cacheConfiguration;
+    QString cacheError;
+    if(!values.cache.empty() && !CacheMemoryDevice::Configuration::fromString(QString::fromStdString(values.cache),
+                                                                               cacheConfiguration, cacheError)) {
+        throw CLI::ValidationError(cacheError.toStdString(), -1);
     }
 
-    QTextStream objStream(&objFile);
-    QString objText = objStream.readAll();
-    objFile.close();
+    // Load object code from either a .pepo or a binary object file if possible, else print error log.
+    QVector<quint8> objectCode;
+    QSharedPointer<const ObjectFile> objectFile;
+    QString errorMessage;
+    if(!readObjectCodeFile(objCodeFileName, objectCode, objectFile, errorMessage)) {
+        throw CLI::ValidationError(errorMessage.toStdString(), -1);
+    }
 
-    ASMRunHelper *helper = new ASMRunHelper(objText, stepMaxValue, textOutputFileName,
-                                      textInputFileName, *AsmProgramManager::getInstance());
+    ASMRunHelper *helper = new ASMRunHelper(objectCode, stepMaxValue, textOutputFileName,
+                                      textInputFileName, manager);
+    helper->set_object_file(objectFile);
     helper->set_echo_charout(values.had_echo_output);
+    helper->set_report_timing(values.had_timing);
+    helper->set_accelerate_traps(values.had_accelerate_traps);
+    helper->set_profile_file(QString::fromStdString(values.profile));
+    helper->set_folded_stacks_file(QString::fromStdString(values.folded_stacks));
+    helper->set_memory_trace_file(QString::fromStdString(values.trace_mem));
+    if(!values.cache.empty()) helper->set_cache_configuration(cacheConfiguration);
     QObject::connect(helper, &ASMRunHelper::finished, QCoreApplication::instance(), &QCoreApplication::quit);
 
     (*runnable) = helper;
 }
 
+void handle_batch(command_line_values &values, AsmProgramManager &manager, QRunnable **runnable)
+{
+    QList<BatchRunHelper::Job> jobs;
+    QString errorMessage;
+    if(!BatchRunHelper::parseManifest(QString::fromStdString(values.s), values.m, jobs, errorMessage)) {
+        throw CLI::ValidationError(errorMessage.toStdString(), -1);
+    }
+
+    int threadCount = values.j > 0 ? values.j : QThread::idealThreadCount();
+    BatchRunHelper *helper = new BatchRunHelper(jobs, threadCount, manager);
+    helper->set_report_timing(values.had_timing);
+    helper->set_accelerate_traps(values.had_accelerate_traps);
+    QObject::connect(helper, &BatchRunHelper::finished, QCoreApplication::instance(), &QCoreApplication::quit);
+
+    (*runnable) = helper;
+}
+
 void handle_cpuasm(command_line_values &values, QRunnable **runnable)
 {
     // Needs a microcode source program to be well defined.
@@ -424,7 +541,7 @@ void handle_cpuasm(command_line_values &values, QRunnable **runnable)
 
 }
 
-void handle_cpurun(command_line_values &values, QRunnable **run)
+void handle_cpurun(command_line_values &values, AsmProgramManager &manager, QRunnable **run)
 {
     // Needs a microcode source program to be well defined.
     if(values.mc.empty()) {
@@ -491,6 +608,7 @@ void handle_cpurun(command_line_values &values, QRunnable **run)
                                                       microprogramText,
                                                       QFileInfo(microcodeFile),
                                                       preconditionText,
+                                                      manager,
                                                       nullptr);
         if(!values.e.empty()) {
             helper->set_error_file(QString::fromStdString(values.e));
@@ -501,3 +619,32 @@ void handle_cpurun(command_line_values &values, QRunnable **run)
 
     }
 }
+
+void handle_osimage(command_line_values &values, AsmProgramManager &manager, QRunnable **runnable)
+{
+    // Needs an operating system source program to be well defined.
+    if(values.s.empty()) {
+        throw CLI::ValidationError("Must set operating system input (-s).", -1);
+    }
+    // Needs an image output to be well defined.
+    else if(values.o.empty()) {
+        throw CLI::ValidationError("Must set image output (-o).", -1);
+    }
+
+    QString sourceFileString = QString::fromStdString(values.s);
+    QString imageFileString = QString::fromStdString(values.o);
+
+    QFile sourceFile(sourceFileString);
+    if(!sourceFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        throw CLI::ValidationError(errLogOpenErr.arg(sourceFile.fileName()).toStdString(), -1);
+    }
+    sourceFile.close();
+    // Images are keyed to the text of their source, so read it exactly as the applications
+    // read their default operating system from their resources.
+    QString sourceText = Pep::resToString(sourceFileString, false);
+
+    OSImageHelper *helper = new OSImageHelper(sourceText, imageFileString, manager);
+    QObject::connect(helper, &OSImageHelper::finished, QCoreApplication::instance(), &QCoreApplication::quit);
+
+    (*runnable) = helper;
+}
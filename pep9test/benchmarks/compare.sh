@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+# File: compare.sh
+# Builds Pep9Term at two revisions and times the benchmark programs in this directory on both.
+# Revisions older than the --timing flag can only be timed from the outside,
+# so both builds are timed by wall clock, and each figure is the fastest of several runs.
+#
+# Usage: compare.sh execute|assemble [before-revision] [after-revision]
+#   execute times execute.pep, by default before the MainMemory page table and at HEAD.
+#   assemble times assemble.pep, by default before the hand written IsaAsm scanner and at HEAD.
+#   QMAKE selects the qmake of the Qt kit to build with, RUNS the number of runs per figure.
+set -euo pipefail
+# Let a failed build stop the script, even though its output is captured.
+shopt -s inherit_errexit
+
+BENCHMARK=${1:-}
+case "$BENCHMARK" in
+    execute) DEFAULT_BEFORE=bcef376^ ;;
+    assemble) DEFAULT_BEFORE=86e8852^ ;;
+    *) echo "Usage: $0 execute|assemble [before-revision] [after-revision]" >&2; exit 2 ;;
+esac
+BEFORE=${2:-$DEFAULT_BEFORE}
+AFTER=${3:-HEAD}
+QMAKE=${QMAKE:-qmake}
+RUNS=${RUNS:-5}
+JOBS=${JOBS:-$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 4)}
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+REPO=$(git -C "$HERE" rev-parse --show-toplevel)
+WORK=$(mktemp -d)
+trap 'git -C "$REPO" worktree remove --force "$WORK/before" >/dev/null 2>&1 || true;
+      git -C "$REPO" worktree remove --force "$WORK/after" >/dev/null 2>&1 || true;
+      rm -rf "$WORK"' EXIT
+
+# Check out a revision into its own worktree, and build a release Pep9Term from it.
+build() {
+    local name=$1 revision=$2
+    git -C "$REPO" worktree add --detach "$WORK/$name" "$revision" >/dev/null 2>&1
+    mkdir -p "$WORK/$name-build"
+    (cd "$WORK/$name-build" && "$QMAKE" CONFIG+=release "$WORK/$name/pep9term/pep9term.pro" >/dev/null \
+        && make -j"$JOBS" >/dev/null)
+    local term
+    term=$(find "$WORK/$name-build" -type f -name Pep9Term -perm -u+x | head -n 1)
+    if [ -z "$term" ]; then
+        echo "No Pep9Term was built from $revision." >&2
+        exit 1
+    fi
+    echo "$term"
+}
+
+# Print the fastest wall clock time, in seconds, of RUNS runs of a command.
+fastest() {
+    local best="" seconds
+    local TIMEFORMAT=%R
+    for _ in $(seq "$RUNS"); do
+        seconds=$( { time "$@" >/dev/null 2>&1; } 2>&1 )
+        if [ -z "$best" ] || awk "BEGIN {exit !($seconds < $best)}"; then
+            best=$seconds
+        fi
+    done
+    echo "$best"
+}
+
+echo "Building $BEFORE and $AFTER with $QMAKE."
+BEFORE_TERM=$(build before "$BEFORE")
+AFTER_TERM=$(build after "$AFTER")
+
+# Print a line of the comparison for one revision.
+report() {
+    awk -v r="$1" -v s="$2" -v n="$3" -v unit="$4" \
+        'BEGIN {printf "  %-12s %8.3f s %14.0f %s/sec\n", r, s, n / s, unit}'
+}
+
+if [ "$BENCHMARK" = execute ]; then
+    # Assemble with the newer build, so both builds run identical object code.
+    "$AFTER_TERM" asm -s "$HERE/execute.pep" -o "$WORK/execute.pepo" >/dev/null
+    INSTRUCTIONS=$("$AFTER_TERM" run -s "$WORK/execute.pepo" -m 20000000 --timing -o "$WORK/execute.out" \
+        | sed -n 's/^Executed \([0-9]*\) instructions.*/\1/p')
+
+    echo "execute.pep: $INSTRUCTIONS instructions, fastest of $RUNS runs."
+    for name in before after; do
+        if [ $name = before ]; then term=$BEFORE_TERM; revision=$BEFORE; else term=$AFTER_TERM; revision=$AFTER; fi
+        seconds=$(fastest "$term" run -s "$WORK/execute.pepo" -m 20000000 -o "$WORK/execute.out")
+        report "$revision" "$seconds" "$INSTRUCTIONS" instructions
+    done
+else
+    # Every asm invocation also assembles the operating system, and the source is only a few thousand lines,
+    # so subtract the time taken to assemble an empty program.
+    printf '         STOP\n         .END\n' > "$WORK/empty.pep"
+    LINES=$(($(wc -l < "$HERE/assemble.pep") + 1))
+
+    echo "assemble.pep: $LINES lines, fastest of $RUNS runs, less the time to assemble an empty program."
+    for name in before after; do
+        if [ $name = before ]; then term=$BEFORE_TERM; revision=$BEFORE; else term=$AFTER_TERM; revision=$AFTER; fi
+        seconds=$(fastest "$term" asm -s "$HERE/assemble.pep" -o "$WORK/assemble.pepo")
+        empty=$(fastest "$term" asm -s "$WORK/empty.pep" -o "$WORK/empty.pepo")
+        report "$revision" "$(awk -v a="$seconds" -v b="$empty" 'BEGIN {print a - b}')" "$LINES" lines
+    done
+fi
@@ -0,0 +1,226 @@
+// File: isamachine.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "isamachine.h"
+
+#include <stdexcept>
+
+#include "amemorychip.h"
+#include "amemorydevice.h"
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "boundexecisacpu.h"
+#include "isaasm.h"
+#include "mainmemory.h"
+#include "memorychips.h"
+#include "pep.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+AsmProgramManager* IsaMachine::manager = nullptr;
+
+bool IsaMachine::State::operator==(const State &other) const
+{
+    return a == other.a && x == other.x && sp == other.sp && pc == other.pc && os == other.os
+            && is == other.is && nzvc == other.nzvc && memory == other.memory && output == other.output;
+}
+
+bool IsaMachine::State::operator!=(const State &other) const
+{
+    return !(*this == other);
+}
+
+void IsaMachine::initializeOperatingSystem()
+{
+    if(manager != nullptr) return;
+    manager = new AsmProgramManager(nullptr);
+    QString osText = Pep::resToString(":/help-asm/figures/pep9os.pep", false);
+    QSharedPointer<AsmProgram> os;
+    auto elist = QList<QPair<int, QString>>();
+    IsaAsm assembler(*manager);
+    if(osText.isEmpty() || !assembler.assembleOperatingSystem(osText, true, os, elist)) {
+        throw std::logic_error("The default operating system failed to assemble.");
+    }
+    manager->setOperatingSystem(os);
+}
+
+const AsmProgramManager &IsaMachine::getManager()
+{
+    return *manager;
+}
+
+QVector<quint8> IsaMachine::assemble(const QString &sourceText, QString &errorMessage)
+{
+    auto program = assembleProgram(sourceText, errorMessage);
+    if(program.isNull()) return {};
+    return program->getObjectCode();
+}
+
+QSharedPointer<AsmProgram> IsaMachine::assembleProgram(const QString &sourceText, QString &errorMessage)
+{
+    QSharedPointer<AsmProgram> program;
+    auto elist = QList<QPair<int, QString>>();
+    IsaAsm assembler(*manager);
+    if(!assembler.assembleUserProgram(sourceText, program, elist)) {
+        auto textList = sourceText.split("\n");
+        errorMessage.clear();
+        for(auto errorPair : elist) {
+            errorMessage += QString("%1 %2\n").arg(textList.value(errorPair.first), errorPair.second);
+        }
+        return nullptr;
+    }
+    return program;
+}
+
+QString IsaMachine::figureSource(const QString &name)
+{
+    return Pep::resToString(QString(":/help-asm/figures/%1.pep").arg(name), false);
+}
+
+IsaMachine::IsaMachine(IsaCpuCore core,
+                       std::function<QSharedPointer<AMemoryDevice>(QSharedPointer<MainMemory>)> wrap,
+                       quint64 maxSteps): QObject(nullptr), memory(QSharedPointer<MainMemory>::create(nullptr)),
+    cpu(nullptr), charIn(0), charOut(0), output()
+{
+    // Lay out memory as Pep9Term does: RAM up to the operating system, the operating
+    // system in ROM, and single byte ports for charIn / charOut.
+    QSharedPointer<RAMChip> ramChip(new RAMChip(1<<16, 0, memory.get()));
+    memory->insertChip(ramChip, 0);
+    auto os = manager->getOperatingSystem();
+    auto osSymTable = os->getSymbolTable();
+    quint16 startAddress = os->getBurnAddress();
+    charIn = static_cast<quint16>(osSymTable->getValue("charIn")->getValue());
+    charOut = static_cast<quint16>(osSymTable->getValue("charOut")->getValue());
+    QList<MemoryChipSpec> list;
+    list.append({AMemoryChip::ChipTypes::RAM, 0, startAddress});
+    list.append({AMemoryChip::ChipTypes::ROM, startAddress, static_cast<quint32>(os->getObjectCode().length())});
+    list.append({AMemoryChip::ChipTypes::IDEV, charIn, 1});
+    list.append({AMemoryChip::ChipTypes::ODEV, charOut, 1});
+    memory->constructMemoryDevice(list);
+    memory->autoUpdateMemoryMap(true);
+
+    QSharedPointer<AMemoryDevice> cpuMemory = memory;
+    if(wrap) cpuMemory = wrap(memory);
+    cpu = QSharedPointer<BoundExecIsaCpu>::create(maxSteps, manager, cpuMemory, nullptr, core);
+    cpu->setHeadless(true);
+    memory->setHeadless(true);
+
+    // All input is buffered before the program runs, so a request for more can't be satisfied.
+    connect(memory.get(), &MainMemory::inputRequested, this, [this](quint16 address){
+        memory->onInputAborted(address);
+    }, Qt::DirectConnection);
+    connect(memory.get(), &MainMemory::outputWritten, this, [this](quint16 address, quint8 value){
+        if(address == charOut) output.append(static_cast<char>(value));
+    }, Qt::DirectConnection);
+}
+
+IsaMachine::~IsaMachine()
+{
+    // The CPU must let go of memory before memory is destroyed.
+    cpu.clear();
+}
+
+void IsaMachine::load(const QVector<quint8> &objectCode)
+{
+    auto os = manager->getOperatingSystem();
+    memory->loadValues(os->getBurnAddress(), os->getObjectCode());
+    memory->loadValues(0, objectCode);
+    cpu->reset();
+    cpu->initCPU();
+}
+
+void IsaMachine::setInput(const QString &input)
+{
+    memory->onInputReceived(charIn, input + "\n");
+}
+
+bool IsaMachine::run()
+{
+    cpu->onSimulationStarted();
+    return cpu->onRun();
+}
+
+QSharedPointer<MainMemory> IsaMachine::getMemory() const
+{
+    return memory;
+}
+
+QSharedPointer<BoundExecIsaCpu> IsaMachine::getCpu() const
+{
+    return cpu;
+}
+
+QByteArray IsaMachine::getOutput() const
+{
+    return output;
+}
+
+void IsaMachine::clearOutput()
+{
+    output.clear();
+}
+
+IsaMachine::State IsaMachine::getState() const
+{
+    State state;
+    const IsaCpu& isaCpu = *cpu;
+    state.a = isaCpu.getCPURegWordCurrent(Enu::CPURegisters::A);
+    state.x = isaCpu.getCPURegWordCurrent(Enu::CPURegisters::X);
+    state.sp = isaCpu.getCPURegWordCurrent(Enu::CPURegisters::SP);
+    state.pc = isaCpu.getCPURegWordCurrent(Enu::CPURegisters::PC);
+    state.os = isaCpu.getCPURegWordCurrent(Enu::CPURegisters::OS);
+    state.is = isaCpu.getCPURegByteCurrent(Enu::CPURegisters::IS);
+    state.nzvc = static_cast<quint8>(isaCpu.getStatusBitCurrent(Enu::STATUS_N) << 3
+                                     | isaCpu.getStatusBitCurrent(Enu::STATUS_Z) << 2
+                                     | isaCpu.getStatusBitCurrent(Enu::STATUS_V) << 1
+                                     | isaCpu.getStatusBitCurrent(Enu::STATUS_C));
+    // Read through getByte(), which does not trigger memory mapped IO.
+    state.memory.resize(1 << 16);
+    for(int address = 0; address < (1 << 16); address++) {
+        quint8 value = 0;
+        memory->getByte(static_cast<quint16>(address), value);
+        state.memory[address] = static_cast<char>(value);
+    }
+    state.output = output;
+    return state;
+}
+
+IsaMachine::State IsaMachine::getStateWithoutIO() const
+{
+    State state = getState();
+    state.memory[charIn] = 0;
+    state.memory[charOut] = 0;
+    state.output.clear();
+    return state;
+}
+
+char *toString(const IsaMachine::State &state)
+{
+    QString text = QString("A=%1 X=%2 SP=%3 PC=%4 IS=%5 OS=%6 NZVC=%7 memory=%8 output=\"%9\"")
+            .arg(state.a, 4, 16, QChar('0')).arg(state.x, 4, 16, QChar('0'))
+            .arg(state.sp, 4, 16, QChar('0')).arg(state.pc, 4, 16, QChar('0'))
+            .arg(static_cast<uint>(state.is), 2, 16, QChar('0')).arg(state.os, 4, 16, QChar('0'))
+            .arg(static_cast<uint>(state.nzvc), 4, 2, QChar('0'))
+            .arg(QString(QCryptographicHash::hash(state.memory, QCryptographicHash::Md5).toHex()))
+            .arg(QString::fromLatin1(state.output));
+    return qstrdup(text.toLatin1().constData());
+}
@@ -0,0 +1,106 @@
+// File: isamachine.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef ISAMACHINE_H
+#define ISAMACHINE_H
+
+#include <functional>
+
+#include <QtCore>
+
+#include "isacpu.h"
+
+class AMemoryDevice;
+class AsmProgram;
+class AsmProgramManager;
+class BoundExecIsaCpu;
+class MainMemory;
+
+/*
+ * A complete Pep/9 machine for tests, built the same way Pep9Term builds one.
+ * The default operating system is burned into ROM, a user program is loaded into RAM,
+ * all input is buffered on charIn before the program starts, and everything
+ * written to charOut is collected in memory.
+ */
+class IsaMachine: public QObject
+{
+public:
+    // The architecturally visible state of a machine, which is compared between machines.
+    struct State
+    {
+        quint16 a, x, sp, pc, os;
+        quint8 is;
+        // Status bits as NZVC, with N in the most significant of the four bits.
+        quint8 nzvc;
+        QByteArray memory;
+        QByteArray output;
+        bool operator==(const State& other) const;
+        bool operator!=(const State& other) const;
+    };
+
+    // Assemble the default operating system. Must be called before any machine is constructed.
+    static void initializeOperatingSystem();
+    static const AsmProgramManager& getManager();
+    // Assemble sourceText as a user program. Returns an empty vector, and explains why
+    // in errorMessage, if it fails to assemble.
+    static QVector<quint8> assemble(const QString& sourceText, QString& errorMessage);
+    // The same as assemble(), but returns the whole program, or nullptr if it fails to assemble.
+    static QSharedPointer<AsmProgram> assembleProgram(const QString& sourceText, QString& errorMessage);
+    // Source of the textbook figure with the given name, such as "fig0625", from the help resources.
+    static QString figureSource(const QString& name);
+
+    // If wrap is set, the CPU accesses memory through wrap(memory) rather than memory itself,
+    // so that the accesses may be cached or traced.
+    explicit IsaMachine(IsaCpuCore core = IsaCpuCore::SWITCH,
+                        std::function<QSharedPointer<AMemoryDevice>(QSharedPointer<MainMemory>)> wrap = nullptr,
+                        quint64 maxSteps = 1000000);
+    ~IsaMachine() override;
+
+    // Load the operating system and objectCode, and prepare the CPU to execute them.
+    void load(const QVector<quint8>& objectCode);
+    // Buffer input on charIn. A newline is always appended, as Pep9Term does.
+    void setInput(const QString& input);
+    // Run until the program stops, fails, or exceeds the step limit.
+    // Returns true if it stopped without error.
+    bool run();
+
+    QSharedPointer<MainMemory> getMemory() const;
+    QSharedPointer<BoundExecIsaCpu> getCpu() const;
+    // Bytes written to charOut since the machine was constructed or clearOutput() was last called.
+    QByteArray getOutput() const;
+    void clearOutput();
+    State getState() const;
+    // The same as getState(), but without anything memory mapped IO has touched:
+    // the output, and the contents of charIn / charOut.
+    State getStateWithoutIO() const;
+
+private:
+    static AsmProgramManager* manager;
+    QSharedPointer<MainMemory> memory;
+    QSharedPointer<BoundExecIsaCpu> cpu;
+    quint16 charIn, charOut;
+    QByteArray output;
+};
+
+// Describe a state, so that QCOMPARE failures are readable. Memory is summarized by a checksum.
+char* toString(const IsaMachine::State& state);
+
+#endif // ISAMACHINE_H
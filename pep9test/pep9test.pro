@@ -0,0 +1,73 @@
+# Automated tests for the simulators shared by Pep9, Pep9Micro, and Pep9Term.
+# -------------------------------------------------
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# Console application specific configuration.
+QT -= gui
+QT += testlib
+CONFIG += c++17 console testcase
+
+TARGET = Pep9Test
+#Prevent Windows from trying to parse the project three times per build.
+CONFIG -= debug_and_release \
+    debug_and_release_target
+#Flag for enabling C++17 features.
+#Due to support for C++17 features being added before the standard was finalized, and the placeholder text of "C++1z" has remained
+CONFIG += c++1z
+win32{
+    #MSVC doesn't recognize c++1z flag, so use the MSVC specific flag here
+    win32-msvc*: QMAKE_CXXFLAGS += /std:c++17
+}
+
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    isamachine.cpp \
+    testmain.cpp \
+    tst_cachememorydevice.cpp \
+    tst_cpudatasection.cpp \
+    tst_isacpucores.cpp \
+    tst_isalexer.cpp \
+    tst_memorytrace.cpp \
+    tst_objectfile.cpp \
+    tst_reversestep.cpp \
+    tst_snapshot.cpp \
+    tst_trapacceleration.cpp \
+    boundexecisacpu.cpp
+
+HEADERS += \
+    isamachine.h \
+    tst_cachememorydevice.h \
+    tst_cpudatasection.h \
+    tst_isacpucores.h \
+    tst_isalexer.h \
+    tst_memorytrace.h \
+    tst_objectfile.h \
+    tst_reversestep.h \
+    tst_snapshot.h \
+    tst_trapacceleration.h \
+    boundexecisacpu.h
+
+RESOURCES += \
+    ../pep9asm/pep9asm-resources.qrc \
+    ../pep9asm/pep9asm-helpresources.qrc
+
+INCLUDEPATH += $$PWD/../pep9common
+INCLUDEPATH += $$PWD/../pep9asm
+INCLUDEPATH += $$PWD/../pep9cpu
+INCLUDEPATH += $$PWD/../pep9term
+
+#Include own directory in VPATH, otherwise qmake might accidentally import files with
+#the same name from other directories.
+VPATH += $$PWD
+VPATH += $$PWD/../pep9common
+VPATH += $$PWD/../pep9asm
+VPATH += $$PWD/../pep9cpu
+VPATH += $$PWD/../pep9term
+
+include(../pep9common/pep9common.pro)
+include(../pep9asm/pep9asm-common.pro)
+include(../pep9cpu/pep9cpu-common.pro)
+
+#Generate SHA hash of current git commit, and make available as GIT_SHA macro.
+include("../gitversion.pri")
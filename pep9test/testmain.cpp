@@ -0,0 +1,88 @@
+// File: testmain.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QCoreApplication>
+#include <QtTest>
+
+#include "isamachine.h"
+#include "pep.h"
+#include "tst_cachememorydevice.h"
+#include "tst_cpudatasection.h"
+#include "tst_isacpucores.h"
+#include "tst_isalexer.h"
+#include "tst_memorytrace.h"
+#include "tst_objectfile.h"
+#include "tst_reversestep.h"
+#include "tst_snapshot.h"
+#include "tst_trapacceleration.h"
+
+int main(int argc, char *argv[])
+{
+    // Initialize global state maps, as Pep9Term does.
+    Pep::initEnumMnemonMaps();
+    Pep::initMnemonicMaps(true);
+    Pep::initAddrModesMap();
+    Pep::initDecoderTables();
+    Pep::initMicroDecoderTables();
+
+    QCoreApplication a(argc, argv);
+    IsaMachine::initializeOperatingSystem();
+
+    // Run every test class, and fail if any of them failed.
+    int status = 0;
+    {
+        TestIsaCpuCores test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestReverseStep test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestSnapshot test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestMemoryTrace test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestCacheMemoryDevice test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestObjectFile test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestTrapAcceleration test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestIsaLexer test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    {
+        TestCpuDataSection test;
+        status |= QTest::qExec(&test, argc, argv);
+    }
+    return status;
+}
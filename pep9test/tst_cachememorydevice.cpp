@@ -0,0 +1,214 @@
+// File: tst_cachememorydevice.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_cachememorydevice.h"
+
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "cachememorydevice.h"
+#include "isamachine.h"
+#include "mainmemory.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+namespace {
+// Counts that are compared as a whole, so that a failure shows every one of them.
+struct Counts
+{
+    quint64 readHits, readMisses, writeHits, writeMisses, evictions, writeBacks, uncached;
+    bool operator==(const Counts& other) const
+    {
+        return readHits == other.readHits && readMisses == other.readMisses
+                && writeHits == other.writeHits && writeMisses == other.writeMisses
+                && evictions == other.evictions && writeBacks == other.writeBacks
+                && uncached == other.uncached;
+    }
+};
+
+Counts countsOf(const CacheMemoryDevice& cache)
+{
+    const CacheMemoryDevice::Statistics& stats = cache.getStatistics();
+    return {stats.readHits, stats.readMisses, stats.writeHits, stats.writeMisses,
+            stats.evictions, stats.writeBacks, stats.uncached};
+}
+
+// Describe counts, so that QCOMPARE failures are readable.
+char* toString(const Counts& counts)
+{
+    return qstrdup(QString("read %1/%2 write %3/%4 (hits/misses), %5 evictions, %6 write backs, %7 uncached")
+                   .arg(counts.readHits).arg(counts.readMisses).arg(counts.writeHits).arg(counts.writeMisses)
+                   .arg(counts.evictions).arg(counts.writeBacks).arg(counts.uncached).toLatin1().constData());
+}
+
+// A machine whose CPU accesses memory through a cache built from spec.
+// Accesses are made directly on the cache, well below the operating system.
+class CachedMachine
+{
+public:
+    explicit CachedMachine(const QString& spec): cache(), machine(IsaCpuCore::SWITCH,
+        [this, spec](QSharedPointer<MainMemory> memory) {
+            CacheMemoryDevice::Configuration configuration;
+            QString errorMessage;
+            if(!CacheMemoryDevice::Configuration::fromString(spec, configuration, errorMessage)) {
+                QTest::qFail(qPrintable(errorMessage), __FILE__, __LINE__);
+            }
+            cache = QSharedPointer<CacheMemoryDevice>::create(memory, configuration);
+            return cache.staticCast<AMemoryDevice>();
+        })
+    {
+    }
+    quint8 read(quint16 address)
+    {
+        quint8 value = 0;
+        cache->readByte(address, value);
+        return value;
+    }
+    void write(quint16 address, quint8 value)
+    {
+        cache->writeByte(address, value);
+    }
+    QSharedPointer<CacheMemoryDevice> cache;
+    IsaMachine machine;
+};
+}
+
+void TestCacheMemoryDevice::directMappedConflicts()
+{
+    // Four sets of one 16 byte line, so 0x0000 and 0x0040 compete for set 0.
+    CachedMachine cached("size=64,ways=1,line=16");
+    cached.read(0x0000);
+    cached.read(0x0001);
+    cached.read(0x000f);
+    cached.read(0x0040);
+    cached.read(0x0000);
+    QCOMPARE(countsOf(*cached.cache), (Counts{2, 3, 0, 0, 2, 0, 0}));
+}
+
+void TestCacheMemoryDevice::writeBackCountsDirtyEvictions()
+{
+    CachedMachine cached("size=64,ways=1,line=16,write=back");
+    // Allocates on the miss, and leaves the line dirty.
+    cached.write(0x0000, 0x11);
+    cached.write(0x0004, 0x22);
+    // Evicts the dirty line, then the clean one.
+    cached.read(0x0040);
+    cached.read(0x0000);
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 2, 1, 1, 2, 1, 0}));
+    // Values always live in memory.
+    QCOMPARE(cached.read(0x0000), static_cast<quint8>(0x11));
+    QCOMPARE(cached.read(0x0004), static_cast<quint8>(0x22));
+}
+
+void TestCacheMemoryDevice::writeThroughDoesNotAllocate()
+{
+    CachedMachine cached("size=64,ways=1,line=16,write=through");
+    cached.write(0x0010, 0x33);
+    // Not allocated by the write, so this misses, and only then allocates.
+    cached.read(0x0010);
+    cached.write(0x0010, 0x44);
+    // A write-through line is never dirty.
+    cached.read(0x0050);
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 2, 1, 1, 1, 0, 0}));
+}
+
+void TestCacheMemoryDevice::replacementPolicies_data()
+{
+    QTest::addColumn<QString>("spec");
+    QTest::addColumn<quint64>("hits");
+    QTest::addColumn<quint64>("misses");
+    // A single set of two lines, accessed A B A C A. LRU evicts B for C, keeping A.
+    // FIFO evicts A for C, as it was filled first, and then B for A.
+    QTest::newRow("lru") << "size=32,ways=2,line=16,replace=lru" << quint64(2) << quint64(3);
+    QTest::newRow("fifo") << "size=32,ways=2,line=16,replace=fifo" << quint64(1) << quint64(4);
+}
+
+void TestCacheMemoryDevice::replacementPolicies()
+{
+    QFETCH(QString, spec);
+    QFETCH(quint64, hits);
+    QFETCH(quint64, misses);
+    CachedMachine cached(spec);
+    for(quint16 address : {0x0000, 0x0010, 0x0000, 0x0020, 0x0000}) {
+        cached.read(address);
+    }
+    QCOMPARE(cached.cache->getStatistics().readHits, hits);
+    QCOMPARE(cached.cache->getStatistics().readMisses, misses);
+}
+
+void TestCacheMemoryDevice::wordsStraddlingLines()
+{
+    CachedMachine cached("size=64,ways=1,line=16");
+    quint16 value;
+    // Touches the lines at 0x0000 and 0x0010.
+    cached.cache->readWord(0x000f, value);
+    // Both lines are now resident.
+    cached.cache->readWord(0x000e, value);
+    cached.cache->writeWord(0x0010, 0xabcd);
+    QCOMPARE(countsOf(*cached.cache), (Counts{1, 2, 1, 0, 0, 0, 0}));
+    cached.cache->readWord(0x0010, value);
+    QCOMPARE(value, static_cast<quint16>(0xabcd));
+}
+
+void TestCacheMemoryDevice::bypassesCache()
+{
+    CachedMachine cached("size=64,ways=1,line=16");
+    quint8 byte;
+    cached.cache->setByte(0x0000, 0x55);
+    cached.cache->getByte(0x0000, byte);
+    QCOMPARE(byte, static_cast<quint8>(0x55));
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 0, 0, 0, 0, 0, 0}));
+    const quint16 charOut = static_cast<quint16>(IsaMachine::getManager().getOperatingSystem()
+                                                 ->getSymbolTable()->getValue("charOut")->getValue());
+    cached.write(charOut, 'x');
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 0, 0, 0, 0, 0, 1}));
+    // The line was never filled, so this still misses.
+    cached.read(0x0000);
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 1, 0, 0, 0, 0, 1}));
+    cached.cache->reset();
+    QCOMPARE(countsOf(*cached.cache), (Counts{0, 0, 0, 0, 0, 0, 0}));
+}
+
+void TestCacheMemoryDevice::programUnaffected()
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(IsaMachine::figureSource("fig0634"), errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+
+    IsaMachine plain;
+    plain.load(objectCode);
+    plain.setInput("2 26 -3 9");
+    QVERIFY(plain.run());
+
+    CachedMachine cached("size=256,ways=2,line=16");
+    cached.machine.load(objectCode);
+    cached.machine.setInput("2 26 -3 9");
+    // Loading uses set, so the cache starts the run cold.
+    QCOMPARE(cached.cache->getStatistics().misses(), quint64(0));
+    QVERIFY(cached.machine.run());
+    QCOMPARE(cached.machine.getState(), plain.getState());
+    // Every instruction is fetched through the cache.
+    const CacheMemoryDevice::Statistics& stats = cached.cache->getStatistics();
+    QVERIFY(stats.hits() + stats.misses() >= cached.machine.getCpu()->getInstructionCount());
+    QVERIFY(stats.hits() > stats.misses());
+    // Characters are printed through the uncached output port.
+    QVERIFY(stats.uncached > 0);
+}
@@ -0,0 +1,47 @@
+// File: tst_cachememorydevice.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_CACHEMEMORYDEVICE_H
+#define TST_CACHEMEMORYDEVICE_H
+
+#include <QtTest>
+
+/*
+ * A CacheMemoryDevice must count the hits, misses, evictions, and write backs that a cache of its
+ * configuration would have, for access patterns small enough to work out by hand.
+ */
+class TestCacheMemoryDevice: public QObject
+{
+    Q_OBJECT
+private slots:
+    void directMappedConflicts();
+    void writeBackCountsDirtyEvictions();
+    void writeThroughDoesNotAllocate();
+    void replacementPolicies_data();
+    void replacementPolicies();
+    void wordsStraddlingLines();
+    // Get / set, and accesses to memory mapped IO, never touch the cache.
+    void bypassesCache();
+    // A program behaves identically with or without a cache in front of memory.
+    void programUnaffected();
+};
+
+#endif // TST_CACHEMEMORYDEVICE_H
@@ -0,0 +1,400 @@
+// File: tst_cpudatasection.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_cpudatasection.h"
+
+#include "cpudata.h"
+#include "mainmemory.h"
+#include "memorychips.h"
+#include "microasm.h"
+#include "microcode.h"
+#include "microcodeprogram.h"
+#include "partialmicrocodedcpu.h"
+#include "pep.h"
+#include "registerfile.h"
+#include "symboltable.h"
+
+namespace {
+// Status bit masks, for writing the expected status bits of a row.
+const int NBit = Enu::NMask, ZBit = Enu::ZMask, VBit = Enu::VMask, CBit = Enu::CMask, SBit = Enu::SMask;
+
+QString busName(Enu::CPUType type)
+{
+    return type == Enu::OneByteDataBus ? "one-byte bus" : "two-byte bus";
+}
+
+// Spell out status bits, so that a mismatch names the bits that differ.
+QString statusBits(int bits)
+{
+    return QString("N=%1 Z=%2 V=%3 C=%4 S=%5")
+            .arg(bits & NBit ? 1 : 0).arg(bits & ZBit ? 1 : 0).arg(bits & VBit ? 1 : 0)
+            .arg(bits & CBit ? 1 : 0).arg(bits & SBit ? 1 : 0);
+}
+
+/*
+ * A PartialMicrocodedCPU with 64 KiB of RAM, set up the way CPURunHelper sets up Pep9Term's.
+ * The microcode mnemonics of its bus must be loaded into Pep's maps before it assembles a microprogram.
+ */
+class MicroMachine
+{
+public:
+    MicroMachine(Enu::CPUType type, bool emitEvents): type(type),
+        memory(QSharedPointer<MainMemory>::create(nullptr)),
+        cpu(QSharedPointer<PartialMicrocodedCPU>::create(type, memory, nullptr))
+    {
+        memory->insertChip(QSharedPointer<RAMChip>::create(1<<16, 0, memory.get()), 0);
+        cpu->setHeadless(true);
+        // Either instantiation of the data section's step kernel may be chosen.
+        cpu->getDataSection()->setEmitEvents(emitEvents);
+        cpu->onResetCPU();
+        cpu->initCPU();
+    }
+
+    // Assemble source as Pep9Term's microassembler would, and apply its preconditions.
+    // Returns false with errorMessage set if any line does not assemble.
+    bool load(const QStringList& source, QString& errorMessage)
+    {
+        MicroAsm assembler(type, false);
+        QSharedPointer<SymbolTable> symbolTable = QSharedPointer<SymbolTable>::create();
+        QVector<AMicroCode*> codeList;
+        for(const QString& line : source) {
+            AMicroCode* code = nullptr;
+            if(!assembler.processSourceLine(symbolTable.data(), line, code, errorMessage)) {
+                errorMessage = line + " " + errorMessage;
+                // The program deletes the lines assembled so far.
+                QSharedPointer<MicrocodeProgram>::create(codeList, symbolTable);
+                return false;
+            }
+            codeList.append(code);
+        }
+        program = QSharedPointer<MicrocodeProgram>::create(codeList, symbolTable);
+        cpu->setMicrocodeProgram(program);
+        for(AMicroCode* line : program->getObjectCode()) {
+            if(line->hasUnitPre()) {
+                static_cast<UnitPreCode*>(line)->setUnitPre(data(), memory.get());
+            }
+        }
+        return true;
+    }
+
+    // Run until the microprogram stops, returning false if any cycle failed.
+    bool run()
+    {
+        cpu->onSimulationStarted();
+        return cpu->onRun();
+    }
+
+    // Returns false with errorMessage set if any postcondition does not hold.
+    bool testPostconditions(QString& errorMessage) const
+    {
+        for(AMicroCode* line : program->getObjectCode()) {
+            if(line->hasUnitPost()
+                    && !static_cast<UnitPostCode*>(line)->testPostcondition(data(), memory.get(), errorMessage)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    CPUDataSection* data() const
+    {
+        return cpu->getDataSection().get();
+    }
+
+    quint16 mar() const
+    {
+        return static_cast<quint16>(data()->getMemoryRegister(Enu::MEM_MARA) * 256
+                                    + data()->getMemoryRegister(Enu::MEM_MARB));
+    }
+
+    // MDR on the one-byte bus, or MDRE followed by MDRO on the two-byte bus.
+    quint16 mdr() const
+    {
+        if(type == Enu::OneByteDataBus) return data()->getMemoryRegister(Enu::MEM_MDR);
+        return static_cast<quint16>(data()->getMemoryRegister(Enu::MEM_MDRE) * 256
+                                    + data()->getMemoryRegister(Enu::MEM_MDRO));
+    }
+
+    Enu::CPUType type;
+    QSharedPointer<MainMemory> memory;
+    QSharedPointer<PartialMicrocodedCPU> cpu;
+    QSharedPointer<MicrocodeProgram> program;
+};
+}
+
+/*
+ * Every row starts from A = a:00, X = b:00, and the status bits before, clocks the ALU's output
+ * into the high byte of SP, and clocks all five status bits. S receives the ALU's carry out.
+ * Unless noted otherwise, a is 0xA5 (-91) and b is 0x3C (60).
+ * The results and status bits were worked out by hand from the Pep/9 ALU's definition,
+ * not by running the simulator.
+ */
+void TestCpuDataSection::aluFunctions_data()
+{
+    QTest::addColumn<int>("function");
+    QTest::addColumn<int>("a");
+    QTest::addColumn<int>("b");
+    QTest::addColumn<int>("csMux");
+    QTest::addColumn<int>("andZ");
+    QTest::addColumn<int>("before");
+    QTest::addColumn<int>("result");
+    QTest::addColumn<int>("after");
+
+    QTest::newRow("0: A") << 0 << 0xA5 << 0x3C << 0 << 0 << 0 << 0xA5 << NBit;
+    // -91 + 60 = -31.
+    QTest::newRow("1: A plus B") << 1 << 0xA5 << 0x3C << 0 << 0 << 0 << 0xE1 << NBit;
+    // 127 + 1 overflows to -128.
+    QTest::newRow("1: A plus B, overflow") << 1 << 0x7F << 0x01 << 0 << 0 << 0 << 0x80 << (NBit | VBit);
+    // -1 + 1 carries out, with a zero result.
+    QTest::newRow("1: A plus B, carry") << 1 << 0xFF << 0x01 << 0 << 0 << 0 << 0x00 << (ZBit | CBit | SBit);
+    QTest::newRow("2: A plus B plus Cin") << 2 << 0xA5 << 0x3C << 0 << 0 << CBit << 0xE2 << NBit;
+    // 0xA5 + 0xC3 + 1 = 0x169. -91 - 60 = -151 overflows.
+    QTest::newRow("3: A plus ~B plus 1") << 3 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x69 << (VBit | CBit | SBit);
+    // 0xA5 + 0xC3 + 0 = 0x168.
+    QTest::newRow("4: A plus ~B plus Cin") << 4 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x68 << (VBit | CBit | SBit);
+    // The carry in comes from S rather than C when CSMux is 1.
+    QTest::newRow("4: A plus ~B plus Cin, Cin from S") << 4 << 0xA5 << 0x3C << 1 << 0 << SBit
+                                                        << 0x69 << (VBit | CBit | SBit);
+    QTest::newRow("5: A and B") << 5 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x24 << 0;
+    // With AndZ, Z stays clear even though the result is zero.
+    QTest::newRow("5: A and B, AndZ with Z clear") << 5 << 0xF0 << 0x0F << 0 << 1 << 0 << 0x00 << 0;
+    QTest::newRow("5: A and B, AndZ with Z set") << 5 << 0xF0 << 0x0F << 0 << 1 << ZBit << 0x00 << ZBit;
+    QTest::newRow("6: A nand B") << 6 << 0xA5 << 0x3C << 0 << 0 << 0 << 0xDB << NBit;
+    QTest::newRow("7: A or B") << 7 << 0xA5 << 0x3C << 0 << 0 << 0 << 0xBD << NBit;
+    QTest::newRow("8: A nor B") << 8 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x42 << 0;
+    QTest::newRow("9: A xor B") << 9 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x99 << NBit;
+    QTest::newRow("10: not A") << 10 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x5A << 0;
+    // The two high order bits of A differ, so the shift overflows.
+    QTest::newRow("11: ASL A") << 11 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x4A << (VBit | CBit | SBit);
+    // The two high order bits of A match, so the shift does not overflow.
+    QTest::newRow("11: ASL A, no overflow") << 11 << 0xC0 << 0x3C << 0 << 0 << 0 << 0x80 << (NBit | CBit | SBit);
+    QTest::newRow("12: ROL A") << 12 << 0xA5 << 0x3C << 0 << 0 << CBit << 0x4B << (VBit | CBit | SBit);
+    QTest::newRow("12: ROL A, Cin from S") << 12 << 0x01 << 0x3C << 1 << 0 << SBit << 0x03 << 0;
+    QTest::newRow("13: ASR A") << 13 << 0xA5 << 0x3C << 0 << 0 << 0 << 0xD2 << (NBit | CBit | SBit);
+    // Unlike ASR A, the high order bit comes from the carry in.
+    QTest::newRow("14: ROR A") << 14 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x52 << (CBit | SBit);
+    // The low nibble of A, 0101, becomes NZVC, and the result is 0.
+    QTest::newRow("15: A to NZVC") << 15 << 0xA5 << 0x3C << 0 << 0 << 0 << 0x00 << (ZBit | CBit | SBit);
+}
+
+void TestCpuDataSection::aluFunctions()
+{
+    QFETCH(int, function);
+    QFETCH(int, a);
+    QFETCH(int, b);
+    QFETCH(int, csMux);
+    QFETCH(int, andZ);
+    QFETCH(int, before);
+    QFETCH(int, result);
+    QFETCH(int, after);
+
+    QStringList source = {
+        QString("UnitPre: A=0x%1, X=0x%2, N=%3, Z=%4, V=%5, C=%6, S=%7")
+            .arg(a * 256, 4, 16, QLatin1Char('0')).arg(b * 256, 4, 16, QLatin1Char('0'))
+            .arg(before & NBit ? 1 : 0).arg(before & ZBit ? 1 : 0).arg(before & VBit ? 1 : 0)
+            .arg(before & CBit ? 1 : 0).arg(before & SBit ? 1 : 0),
+        QString("A=0, B=2, AMux=1, CSMux=%1, ALU=%2, AndZ=%3, CMux=1, C=4; NCk, ZCk, VCk, CCk, SCk, LoadCk")
+            .arg(csMux).arg(function).arg(andZ)
+    };
+    for(Enu::CPUType type : {Enu::OneByteDataBus, Enu::TwoByteDataBus}) {
+        for(bool emitEvents : {false, true}) {
+            Pep::initMicroEnumMnemonMaps(type, false);
+            MicroMachine machine(type, emitEvents);
+            QString errorMessage;
+            QVERIFY2(machine.load(source, errorMessage), qPrintable(errorMessage));
+            QVERIFY2(machine.run(), qPrintable(busName(type) + ": " + machine.cpu->getErrorMessage()));
+            QCOMPARE(static_cast<int>(machine.data()->getRegisterBankByte(4)), result);
+            QCOMPARE(statusBits(machine.data()->getRegisterBank().readStatusBitsCurrent()), statusBits(after));
+            // The operands are untouched.
+            QCOMPARE(static_cast<int>(machine.data()->getRegisterBankWord(0)), a * 256);
+            QCOMPARE(static_cast<int>(machine.data()->getRegisterBankWord(2)), b * 256);
+            QCOMPARE(machine.cpu->getCycleCounter(), static_cast<quint64>(1));
+        }
+    }
+}
+
+/*
+ * Each program lists the state it leaves behind as postconditions. The MAR, MDR, and
+ * cycle count after it stops, like the postconditions, were worked out by hand: a read or write
+ * completes on the third consecutive cycle that asserts MemRead or MemWrite with MAR unchanged.
+ */
+void TestCpuDataSection::memoryAccess_data()
+{
+    QTest::addColumn<Enu::CPUType>("type");
+    QTest::addColumn<QStringList>("source");
+    QTest::addColumn<int>("mar");
+    QTest::addColumn<int>("mdr");
+    QTest::addColumn<int>("cycles");
+
+    // Figure 12.5.
+    QTest::newRow("one-byte bus: fetch and increment PC") << Enu::OneByteDataBus << QStringList{
+        "UnitPre: IR=0x000000, PC=0x00FF, Mem[0x00FF]=0xAB, S=0",
+        "UnitPost: IR=0xAB0000, PC=0x0100, S=1",
+        "A=6, B=7; MARCk",
+        "MemRead",
+        "MemRead",
+        "MemRead, MDRMux=0; MDRCk",
+        "AMux=0, ALU=0, CMux=1, C=8; LoadCk",
+        "A=7, B=23, AMux=1, ALU=1, CMux=1, C=7; SCk, LoadCk",
+        "A=6, B=22, AMux=1, CSMux=1, ALU=2, CMux=1, C=6; LoadCk"} << 0x00FF << 0xAB << 7;
+    QTest::newRow("one-byte bus: store a byte") << Enu::OneByteDataBus << QStringList{
+        "UnitPre: A=0x1234, X=0x0042, Mem[0x0042]=0x00",
+        "UnitPost: Mem[0x0042]=0x12, Mem[0x0043]=0x00, A=0x1234",
+        "A=2, B=3; MARCk",
+        "A=0, AMux=1, ALU=0, CMux=1, MDRMux=1; MDRCk",
+        "MemWrite",
+        "MemWrite",
+        "MemWrite"} << 0x0042 << 0x12 << 5;
+    // Changing MAR during a read restarts it, so the byte comes from the second address.
+    QTest::newRow("one-byte bus: change MAR during a read") << Enu::OneByteDataBus << QStringList{
+        "UnitPre: A=0x0000, X=0x0010, SP=0x0020, Mem[0x0010]=0x11, Mem[0x0020]=0x22",
+        "UnitPost: A=0x2200",
+        "A=2, B=3; MARCk",
+        "MemRead",
+        "MemRead, A=4, B=5; MARCk",
+        "MemRead",
+        "MemRead, MDRMux=0; MDRCk",
+        "AMux=0, ALU=0, CMux=1, C=0; LoadCk"} << 0x0020 << 0x22 << 6;
+    // Figure 12.20. PC + 1 does not carry, so S is cleared.
+    QTest::newRow("two-byte bus: fetch and increment PC") << Enu::TwoByteDataBus << QStringList{
+        "UnitPre: IR=0x000000, PC=0x00FE, Mem[0x00FE]=0xABCD, S=1",
+        "UnitPost: IR=0xAB0000, PC=0x00FF, T1=0xCD, S=0",
+        "A=6, B=7, MARMux=1; MARCk",
+        "MemRead, A=7, B=23, AMux=1, ALU=1, CMux=1, C=7; SCk, LoadCk",
+        "MemRead, A=6, B=22, AMux=1, CSMux=1, ALU=2, CMux=1, C=6; LoadCk",
+        "MemRead, MDREMux=0, MDROMux=0; MDRECk, MDROCk",
+        "EOMux=0, AMux=0, ALU=0, CMux=1, C=8; LoadCk",
+        "EOMux=1, AMux=0, ALU=0, CMux=1, C=11; LoadCk"} << 0x00FE << 0xABCD << 6;
+    // The low order bit of MAR is ignored, so the word is stored at 0x0100.
+    QTest::newRow("two-byte bus: store a word at an odd address") << Enu::TwoByteDataBus << QStringList{
+        "UnitPre: A=0x1234, X=0x0101, Mem[0x0100]=0x0000, Mem[0x0102]=0x0000",
+        "UnitPost: Mem[0x0100]=0x1234, Mem[0x0102]=0x0000",
+        "A=2, B=3, MARMux=1; MARCk",
+        "A=0, AMux=1, ALU=0, CMux=1, MDREMux=1; MDRECk",
+        "A=1, AMux=1, ALU=0, CMux=1, MDROMux=1; MDROCk",
+        "MemWrite",
+        "MemWrite",
+        "MemWrite"} << 0x0101 << 0x1234 << 6;
+    // MARMux=0 routes MDRE and MDRO into MAR.
+    QTest::newRow("two-byte bus: address memory through MDR") << Enu::TwoByteDataBus << QStringList{
+        "UnitPre: A=0x0102, X=0x0000, Mem[0x0102]=0xBEEF",
+        "UnitPost: A=0x0102, X=0xBEEF",
+        "A=0, AMux=1, ALU=0, CMux=1, MDREMux=1; MDRECk",
+        "A=1, AMux=1, ALU=0, CMux=1, MDROMux=1; MDROCk",
+        "MARMux=0; MARCk",
+        "MemRead",
+        "MemRead",
+        "MemRead, MDREMux=0, MDROMux=0; MDRECk, MDROCk",
+        "EOMux=0, AMux=0, ALU=0, CMux=1, C=2; LoadCk",
+        "EOMux=1, AMux=0, ALU=0, CMux=1, C=3; LoadCk"} << 0x0102 << 0xBEEF << 8;
+}
+
+void TestCpuDataSection::memoryAccess()
+{
+    QFETCH(Enu::CPUType, type);
+    QFETCH(QStringList, source);
+    QFETCH(int, mar);
+    QFETCH(int, mdr);
+    QFETCH(int, cycles);
+
+    Pep::initMicroEnumMnemonMaps(type, false);
+    for(bool emitEvents : {false, true}) {
+        MicroMachine machine(type, emitEvents);
+        QString errorMessage;
+        QVERIFY2(machine.load(source, errorMessage), qPrintable(errorMessage));
+        QVERIFY2(machine.run(), qPrintable(machine.cpu->getErrorMessage()));
+        QVERIFY2(machine.testPostconditions(errorMessage), qPrintable(errorMessage));
+        QCOMPARE(static_cast<int>(machine.mar()), mar);
+        QCOMPARE(static_cast<int>(machine.mdr()), mdr);
+        QCOMPARE(machine.cpu->getCycleCounter(), static_cast<quint64>(cycles));
+    }
+}
+
+/*
+ * The failing cycle is counted, so cycles is the number of the line that fails.
+ */
+void TestCpuDataSection::errors_data()
+{
+    QTest::addColumn<Enu::CPUType>("type");
+    QTest::addColumn<QStringList>("source");
+    QTest::addColumn<QString>("message");
+    QTest::addColumn<int>("cycles");
+
+    QTest::newRow("one-byte bus: MARCk without B") << Enu::OneByteDataBus
+        << QStringList{"A=6; MARCk"} << "No values on A & B during MARCk." << 1;
+    QTest::newRow("one-byte bus: MDRCk before the read completes") << Enu::OneByteDataBus
+        << QStringList{"A=6, B=7; MARCk", "MemRead", "MemRead, MDRMux=0; MDRCk"}
+        << "No value from data bus to write to MDR." << 3;
+    QTest::newRow("one-byte bus: MDRCk from an empty C bus") << Enu::OneByteDataBus
+        << QStringList{"MDRMux=1; MDRCk"} << "No value on C bus to write to MDR." << 1;
+    QTest::newRow("one-byte bus: MDRCk without MDRMux") << Enu::OneByteDataBus
+        << QStringList{"A=6; MDRCk"} << "No value to clock into MDR." << 1;
+    QTest::newRow("one-byte bus: LoadCk without C") << Enu::OneByteDataBus
+        << QStringList{"A=0, AMux=1, ALU=0, CMux=1; LoadCk"}
+        << "No destination register specified for LoadCk." << 1;
+    // A plus B plus Cin has no output without CSMux.
+    QTest::newRow("one-byte bus: LoadCk without a carry in") << Enu::OneByteDataBus
+        << QStringList{"A=0, B=2, AMux=1, ALU=2, CMux=1, C=4; LoadCk"} << "No value on C Bus to clock in." << 1;
+    QTest::newRow("one-byte bus: NCk without B") << Enu::OneByteDataBus
+        << QStringList{"A=0, AMux=1, ALU=1; NCk"}
+        << "ALU Error: No output from ALU to clock into status bits." << 1;
+    QTest::newRow("one-byte bus: ZCk without AndZ") << Enu::OneByteDataBus
+        << QStringList{"A=0, AMux=1, ALU=0; ZCk"}
+        << "ALU Error: No output from ALU to clock into status bits." << 1;
+    QTest::newRow("two-byte bus: MARCk without MARMux") << Enu::TwoByteDataBus
+        << QStringList{"A=6, B=7; MARCk"} << "MARMux has no output but MARCk." << 1;
+    QTest::newRow("two-byte bus: MDRECk before the read completes") << Enu::TwoByteDataBus
+        << QStringList{"A=6, B=7, MARMux=1; MARCk", "MemRead", "MemRead, MDREMux=0; MDRECk"}
+        << "No value from data bus to write to MDRE." << 3;
+    QTest::newRow("two-byte bus: MDROCk before the read completes") << Enu::TwoByteDataBus
+        << QStringList{"A=6, B=7, MARMux=1; MARCk", "MemRead", "MemRead, MDROMux=0; MDROCk"}
+        << "No value from data bus to write to MDRO." << 3;
+    QTest::newRow("two-byte bus: MDRECk from an empty C bus") << Enu::TwoByteDataBus
+        << QStringList{"MDREMux=1; MDRECk"} << "No value on C bus to write to MDRE." << 1;
+    QTest::newRow("two-byte bus: MDROCk from an empty C bus") << Enu::TwoByteDataBus
+        << QStringList{"MDROMux=1; MDROCk"} << "No value on C bus to write to MDRO." << 1;
+    QTest::newRow("two-byte bus: MDRECk without MDREMux") << Enu::TwoByteDataBus
+        << QStringList{"A=6; MDRECk"} << "No value to clock into MDRE." << 1;
+    QTest::newRow("two-byte bus: MDROCk without MDROMux") << Enu::TwoByteDataBus
+        << QStringList{"A=6; MDROCk"} << "No value to clock into MDRO." << 1;
+    // AMux=0 selects MDRE or MDRO through EOMux, so the ALU has no input.
+    QTest::newRow("two-byte bus: AMux without EOMux") << Enu::TwoByteDataBus
+        << QStringList{"AMux=0, ALU=0, CMux=1, C=0; LoadCk"} << "No value on C Bus to clock in." << 1;
+}
+
+void TestCpuDataSection::errors()
+{
+    QFETCH(Enu::CPUType, type);
+    QFETCH(QStringList, source);
+    QFETCH(QString, message);
+    QFETCH(int, cycles);
+
+    Pep::initMicroEnumMnemonMaps(type, false);
+    for(bool emitEvents : {false, true}) {
+        MicroMachine machine(type, emitEvents);
+        QString errorMessage;
+        QVERIFY2(machine.load(source, errorMessage), qPrintable(errorMessage));
+        QVERIFY(!machine.run());
+        QVERIFY(machine.cpu->hadErrorOnStep());
+        QCOMPARE(machine.cpu->getErrorMessage(), message);
+        QCOMPARE(machine.cpu->getCycleCounter(), static_cast<quint64>(cycles));
+    }
+}
@@ -0,0 +1,52 @@
+// File: tst_cpudatasection.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_CPUDATASECTION_H
+#define TST_CPUDATASECTION_H
+
+#include <QtTest>
+
+#include "enu.h"
+
+/*
+ * Microprograms run by PartialMicrocodedCPU on the one- and two-byte data bus must leave
+ * the registers, status bits, and memory with values worked out by hand, after the number of
+ * cycles counted by hand. A cycle whose clock signals have no input must stop the CPU with
+ * the data section's error message.
+ */
+class TestCpuDataSection: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Clock the output of each ALU function into a register and all five status bits.
+    void aluFunctions_data();
+    void aluFunctions();
+    // Read and write memory through MDR, or through MDRE and MDRO.
+    void memoryAccess_data();
+    void memoryAccess();
+    // Stop on the first cycle that clocks in a value which is not there.
+    void errors_data();
+    void errors();
+};
+
+Q_DECLARE_METATYPE(Enu::CPUType)
+
+#endif // TST_CPUDATASECTION_H
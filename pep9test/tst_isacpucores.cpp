@@ -0,0 +1,220 @@
+// File: tst_isacpucores.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_isacpucores.h"
+
+#include "boundexecisacpu.h"
+#include "isamachine.h"
+#include "pep.h"
+
+namespace {
+// Textbook figures covering recursion, pointers, arrays, jump tables, the heap, and every trap.
+void addFigureRows()
+{
+    QTest::addColumn<QString>("figure");
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QByteArray>("output");
+    QTest::newRow("fig0625") << "fig0625" << "" << QByteArray("binCoeff(3, 1) = 3\n");
+    QTest::newRow("fig0627") << "fig0627" << "30 20"
+                             << QByteArray("Enter an integer: Enter an integer: Ordered they are: 20, 30\n");
+    QTest::newRow("fig0634") << "fig0634" << "2 26 -3 9" << QByteArray("3 9\n2 -3\n1 26\n0 2\n");
+    QTest::newRow("fig0636") << "fig0636" << "2 26 -3 9" << QByteArray("3 9\n2 -3\n1 26\n0 2\n");
+    QTest::newRow("fig0638") << "fig0638" << "4 8 -1 7 3" << QByteArray("8 -1 7 3 \n");
+    QTest::newRow("fig0640") << "fig0640" << "2" << QByteArray("Pick a number 0..3: Right on\n");
+    QTest::newRow("fig0648") << "fig0648" << "10 20 30 -9999" << QByteArray("30 20 10 ");
+}
+
+// Run the figure on machine, and return the state it stopped in.
+IsaMachine::State runFigure(IsaMachine& machine, const QString& figure, const QString& input)
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(IsaMachine::figureSource(figure), errorMessage);
+    if(objectCode.isEmpty()) QTest::qFail(qPrintable(errorMessage), __FILE__, __LINE__);
+    machine.load(objectCode);
+    machine.setInput(input);
+    if(!machine.run()) {
+        QTest::qFail(qPrintable(machine.getCpu()->getErrorMessage()), __FILE__, __LINE__);
+    }
+    return machine.getState();
+}
+
+// Rewrites the operand specifier of an instruction after executing it, and prints 57.
+const QString selfModifyingSource =
+        "         LDWX    2,i\n"
+        "loop:    LDWA    5,i         ;Operand specifier at 0x0004\n"
+        "         STWA    value,d\n"
+        "         DECO    value,d\n"
+        "         LDWA    7,i\n"
+        "         STWA    0x0004,d\n"
+        "         SUBX    1,i\n"
+        "         BRNE    loop\n"
+        "         STOP\n"
+        "value:   .BLOCK  2\n"
+        "         .END\n";
+
+// Never terminates.
+const QString endlessSource =
+        "loop:    ADDA    1,i\n"
+        "         SUBX    1,i\n"
+        "         BR      loop\n"
+        "         .END\n";
+
+// Executes about 180,000 instructions without any traps, and prints 24464.
+const QString benchmarkSource =
+        "         LDWA    0,i\n"
+        "         STWA    total,d\n"
+        "         LDWX    30000,i\n"
+        "loop:    LDWA    total,d\n"
+        "         ADDA    3,i\n"
+        "         ANDA    0x7FFF,i\n"
+        "         STWA    total,d\n"
+        "         SUBX    1,i\n"
+        "         BRNE    loop\n"
+        "         DECO    total,d\n"
+        "         STOP\n"
+        "total:   .BLOCK  2\n"
+        "         .END\n";
+}
+
+void TestIsaCpuCores::coresAgree_data()
+{
+    addFigureRows();
+}
+
+void TestIsaCpuCores::coresAgree()
+{
+    QFETCH(QString, figure);
+    QFETCH(QString, input);
+    QFETCH(QByteArray, output);
+
+    IsaMachine switched(IsaCpuCore::SWITCH), threaded(IsaCpuCore::THREADED);
+    IsaMachine::State switchedState = runFigure(switched, figure, input);
+    IsaMachine::State threadedState = runFigure(threaded, figure, input);
+    QCOMPARE(switchedState.output, output);
+    QCOMPARE(threadedState, switchedState);
+    QCOMPARE(threaded.getCpu()->getInstructionCount(), switched.getCpu()->getInstructionCount());
+}
+
+void TestIsaCpuCores::blockCacheAgrees_data()
+{
+    addFigureRows();
+}
+
+void TestIsaCpuCores::blockCacheAgrees()
+{
+    QFETCH(QString, figure);
+    QFETCH(QString, input);
+    QFETCH(QByteArray, output);
+
+    IsaMachine switched(IsaCpuCore::SWITCH), cached(IsaCpuCore::THREADED);
+    cached.getCpu()->setBlockCacheEnabled(true);
+    IsaMachine::State switchedState = runFigure(switched, figure, input);
+    IsaMachine::State cachedState = runFigure(cached, figure, input);
+    QCOMPARE(cachedState.output, output);
+    QCOMPARE(cachedState, switchedState);
+    QCOMPARE(cached.getCpu()->getInstructionCount(), switched.getCpu()->getInstructionCount());
+}
+
+void TestIsaCpuCores::blockCacheSeesSelfModifyingCode()
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(selfModifyingSource, errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+    IsaMachine machine(IsaCpuCore::THREADED);
+    machine.getCpu()->setBlockCacheEnabled(true);
+    {
+        // A second CPU watching, and then no longer watching, the same memory.
+        BoundExecIsaCpu other(BoundExecIsaCpu::getDefaultMaxSteps(), &IsaMachine::getManager(),
+                              machine.getMemory(), nullptr, IsaCpuCore::THREADED);
+        other.setBlockCacheEnabled(true);
+        other.setBlockCacheEnabled(false);
+    }
+    machine.load(objectCode);
+    QVERIFY(machine.run());
+    QCOMPARE(machine.getOutput(), QByteArray("57"));
+}
+
+void TestIsaCpuCores::blockCacheHonorsStepLimit()
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(endlessSource, errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+    IsaMachine stepped(IsaCpuCore::THREADED, nullptr, 1000), cached(IsaCpuCore::THREADED, nullptr, 1000);
+    cached.getCpu()->setBlockCacheEnabled(true);
+    stepped.load(objectCode);
+    cached.load(objectCode);
+    QVERIFY(!stepped.run());
+    QVERIFY(!cached.run());
+    QCOMPARE(cached.getCpu()->getInstructionCount(), static_cast<quint64>(1000));
+    QCOMPARE(cached.getState(), stepped.getState());
+}
+
+void TestIsaCpuCores::handlersFollowRedefinedMnemonics()
+{
+    // NOP0 is a trap when the threaded CPU is built, and then is redefined as a plain unary no-op.
+    IsaMachine threaded(IsaCpuCore::THREADED);
+    Pep::initMnemonicMaps(false);
+    Pep::initDecoderTables();
+    IsaMachine switched(IsaCpuCore::SWITCH);
+
+    // NOP0, STOP
+    QVector<quint8> objectCode{0x26, 0x00};
+    switched.load(objectCode);
+    threaded.load(objectCode);
+    bool switchedOk = switched.run(), threadedOk = threaded.run();
+    IsaMachine::State switchedState = switched.getState(), threadedState = threaded.getState();
+
+    // Restore the definitions every other test expects before checking anything.
+    Pep::initMnemonicMaps(true);
+    Pep::initDecoderTables();
+    QVERIFY(switchedOk);
+    QVERIFY(threadedOk);
+    QCOMPARE(threadedState, switchedState);
+    // Neither CPU may have entered the operating system's trap handler.
+    QCOMPARE(threaded.getCpu()->getInstructionCount(), static_cast<quint64>(2));
+}
+
+void TestIsaCpuCores::benchmarkCores_data()
+{
+    QTest::addColumn<IsaCpuCore>("core");
+    QTest::addColumn<bool>("blockCache");
+    QTest::newRow("switch") << IsaCpuCore::SWITCH << false;
+    QTest::newRow("threaded") << IsaCpuCore::THREADED << false;
+    QTest::newRow("threaded, block cache") << IsaCpuCore::THREADED << true;
+}
+
+void TestIsaCpuCores::benchmarkCores()
+{
+    QFETCH(IsaCpuCore, core);
+    QFETCH(bool, blockCache);
+
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(benchmarkSource, errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+    IsaMachine machine(core);
+    machine.getCpu()->setBlockCacheEnabled(blockCache);
+    QBENCHMARK {
+        machine.clearOutput();
+        machine.load(objectCode);
+        QVERIFY(machine.run());
+    }
+    QCOMPARE(machine.getOutput(), QByteArray("24464"));
+}
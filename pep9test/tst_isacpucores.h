@@ -0,0 +1,55 @@
+// File: tst_isacpucores.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_ISACPUCORES_H
+#define TST_ISACPUCORES_H
+
+#include <QtTest>
+
+#include "isacpu.h"
+
+/*
+ * The SWITCH and THREADED cores of IsaCpu, with and without the block cache,
+ * must leave identical registers, status bits, memory, and output behind.
+ */
+class TestIsaCpuCores: public QObject
+{
+    Q_OBJECT
+private slots:
+    void coresAgree_data();
+    void coresAgree();
+    void blockCacheAgrees_data();
+    void blockCacheAgrees();
+    // Patching a cached instruction must discard its block, even after another CPU's
+    // cache has stopped watching the same memory.
+    void blockCacheSeesSelfModifyingCode();
+    // Running whole blocks must not overshoot a BoundExecIsaCpu's step limit.
+    void blockCacheHonorsStepLimit();
+    // A threaded CPU built before a mnemonic is redefined must execute the new definition.
+    void handlersFollowRedefinedMnemonics();
+    // Throughput of each core on a tight loop. Run "Pep9Test benchmarkCores" to compare them.
+    void benchmarkCores_data();
+    void benchmarkCores();
+};
+
+Q_DECLARE_METATYPE(IsaCpuCore)
+
+#endif // TST_ISACPUCORES_H
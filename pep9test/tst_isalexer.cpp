@@ -0,0 +1,231 @@
+// File: tst_isalexer.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_isalexer.h"
+
+#include <thread>
+#include <vector>
+
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "isaasm.h"
+#include "isamachine.h"
+
+using namespace IsaParserHelper;
+
+namespace {
+const int tokenError = -1;
+
+// Lex the first token of line. Returns the token type, or tokenError if the token was malformed.
+int lexFirst(const QString& line, QString& text, QString& rest)
+{
+    AsmProgramManager manager;
+    IsaAsm assembler(manager);
+    QStringView view(line);
+    ELexicalToken token;
+    bool okay = assembler.getToken(view, token, text);
+    rest = view.toString();
+    return okay ? token : tokenError;
+}
+}
+
+void TestIsaLexer::firstToken_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<int>("token");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("rest");
+
+    QTest::newRow("empty") << "   " << int(LT_EMPTY) << "" << "";
+    QTest::newRow("leading spaces") << "   LDWA" << int(LT_IDENTIFIER) << "LDWA" << "";
+
+    // Addressing modes are case insensitive, and may have spaces after the comma.
+    QTest::newRow(",i") << ",i" << int(LT_ADDRESSING_MODE) << ",i" << "";
+    QTest::newRow(", D") << ", D" << int(LT_ADDRESSING_MODE) << ", D" << "";
+    QTest::newRow(",s") << ",s ;c" << int(LT_ADDRESSING_MODE) << ",s" << " ;c";
+    QTest::newRow(",sq") << ",sq" << int(LT_ADDRESSING_MODE) << ",s" << "q";
+    QTest::newRow(",sf") << ",sf" << int(LT_ADDRESSING_MODE) << ",sf" << "";
+    QTest::newRow(",sx") << ",sx" << int(LT_ADDRESSING_MODE) << ",sx" << "";
+    QTest::newRow(",sfx") << ",sfx" << int(LT_ADDRESSING_MODE) << ",sfx" << "";
+    QTest::newRow(",SFX") << ",SFX" << int(LT_ADDRESSING_MODE) << ",SFX" << "";
+
+    QTest::newRow("'a'") << "'a',i" << int(LT_CHAR_CONSTANT) << "'a'" << ",i";
+    QTest::newRow("'\\n'") << "'\\n'" << int(LT_CHAR_CONSTANT) << "'\\n'" << "";
+    QTest::newRow("'\\''") << "'\\''" << int(LT_CHAR_CONSTANT) << "'\\''" << "";
+    QTest::newRow("'\\x41'") << "'\\x41'" << int(LT_CHAR_CONSTANT) << "'\\x41'" << "";
+    QTest::newRow("'\\X4f'") << "'\\X4f'" << int(LT_CHAR_CONSTANT) << "'\\X4f'" << "";
+    // The original character classes were written as [x|X] and ['|b|...], so '|' was accepted
+    // both as a simple escape and as the prefix of a hexadecimal escape.
+    QTest::newRow("'\\|'") << "'\\|'" << int(LT_CHAR_CONSTANT) << "'\\|'" << "";
+    QTest::newRow("'\\|AB'") << "'\\|AB'" << int(LT_CHAR_CONSTANT) << "'\\|AB'" << "";
+
+    QTest::newRow("comment") << "; it's \"all\" a comment" << int(LT_COMMENT) << "; it's \"all\" a comment" << "";
+
+    QTest::newRow("0x1F") << "0x1F,i" << int(LT_HEX_CONSTANT) << "0x1F" << ",i";
+    QTest::newRow("0X|a") << "0X|a" << int(LT_HEX_CONSTANT) << "0X|a" << "";
+    QTest::newRow("0xFFG") << "0xFFG" << int(LT_HEX_CONSTANT) << "0xFF" << "G";
+
+    QTest::newRow("123") << "123" << int(LT_DEC_CONSTANT) << "123" << "";
+    QTest::newRow("-5") << "-5,i" << int(LT_DEC_CONSTANT) << "-5" << ",i";
+    QTest::newRow("+7") << "+7" << int(LT_DEC_CONSTANT) << "+7" << "";
+    QTest::newRow("007") << "007" << int(LT_DEC_CONSTANT) << "007" << "";
+
+    QTest::newRow(".BLOCK") << ".BLOCK 2" << int(LT_DOT_COMMAND) << ".BLOCK" << " 2";
+    QTest::newRow(".|x") << ".|x" << int(LT_DOT_COMMAND) << ".|x" << "";
+    // \w matched any letter, digit, or mark, not only ASCII ones.
+    QTest::newRow(".a_1\u00e9") << QString(".a_1") + QChar(0x00e9) << int(LT_DOT_COMMAND)
+                                << QString(".a_1") + QChar(0x00e9) << "";
+
+    QTest::newRow("main:") << "main:" << int(LT_SYMBOL_DEF) << "main:" << "";
+    QTest::newRow("ab: c") << "ab: c" << int(LT_SYMBOL_DEF) << "ab:" << " c";
+    QTest::newRow("_x1") << "_x1" << int(LT_IDENTIFIER) << "_x1" << "";
+    QTest::newRow("a\u00e9:") << QString("a") + QChar(0x00e9) + ":" << int(LT_SYMBOL_DEF)
+                              << QString("a") + QChar(0x00e9) + ":" << "";
+
+    QTest::newRow("\"Hi\\n\"") << "\"Hi\\n\" ;c" << int(LT_STRING_CONSTANT) << "\"Hi\\n\"" << " ;c";
+    QTest::newRow("\"\"") << "\"\"" << int(LT_STRING_CONSTANT) << "\"\"" << "";
+    QTest::newRow("\"\\|\"") << "\"\\|\"" << int(LT_STRING_CONSTANT) << "\"\\|\"" << "";
+    QTest::newRow("\"a\\|AB\"") << "\"a\\|AB\"" << int(LT_STRING_CONSTANT) << "\"a\\|AB\"" << "";
+    QTest::newRow("\"\\x00\"") << "\"\\x00\"" << int(LT_STRING_CONSTANT) << "\"\\x00\"" << "";
+}
+
+void TestIsaLexer::firstToken()
+{
+    QFETCH(QString, line);
+    QFETCH(int, token);
+    QFETCH(QString, text);
+    QFETCH(QString, rest);
+    QString actualText, actualRest;
+    QCOMPARE(lexFirst(line, actualText, actualRest), token);
+    QCOMPARE(actualText, text);
+    QCOMPARE(actualRest, rest);
+}
+
+void TestIsaLexer::errors_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<QString>("message");
+    const QString addrMode = ";ERROR: Malformed addressing mode.";
+    const QString charConst = ";ERROR: Malformed character constant.";
+    const QString hexConst = ";ERROR: Malformed hex constant.";
+    const QString decConst = ";ERROR: Malformed decimal constant.";
+    const QString dotCommand = ";ERROR: Malformed dot command.";
+    const QString identifier = ";ERROR: Malformed identifier.";
+    const QString stringConst = ";ERROR: Malformed string constant.";
+    const QString syntax = ";ERROR: Syntax error.";
+
+    // sxf is neither sx nor sfx.
+    QTest::newRow(",sxf") << ",sxf" << addrMode;
+    QTest::newRow(",q") << ",q" << addrMode;
+    QTest::newRow(",") << "," << addrMode;
+
+    QTest::newRow("''") << "''" << charConst;
+    QTest::newRow("'''") << "'''" << charConst;
+    QTest::newRow("'ab'") << "'ab'" << charConst;
+    QTest::newRow("'\\q'") << "'\\q'" << charConst;
+    QTest::newRow("'\\x4'") << "'\\x4'" << charConst;
+    QTest::newRow("'a") << "'a" << charConst;
+
+    QTest::newRow("0x") << "0x" << hexConst;
+    QTest::newRow("0xG") << "0xG" << hexConst;
+
+    QTest::newRow("+") << "+" << decConst;
+    QTest::newRow("-x") << "-x" << decConst;
+    // Digits other than 0 through 9 start a decimal constant, but can't be part of one.
+    QTest::newRow("arabic-indic digit") << QString(QChar(0x0663)) << decConst;
+
+    QTest::newRow(".5") << ".5" << dotCommand;
+    QTest::newRow(".") << "." << dotCommand;
+
+    // Identifiers must start with an ASCII letter, even though any letter leads to them.
+    QTest::newRow("\u00e9") << QString(QChar(0x00e9)) << identifier;
+
+    QTest::newRow("\"abc") << "\"abc" << stringConst;
+    QTest::newRow("\"a\\\"") << "\"a\\\"" << stringConst;
+    QTest::newRow("\"a\\q\"") << "\"a\\q\"" << stringConst;
+    QTest::newRow("\"a\\x4\"") << "\"a\\x4\"" << stringConst;
+
+    QTest::newRow("@") << "@" << syntax;
+    QTest::newRow("#") << "#2d" << syntax;
+}
+
+void TestIsaLexer::errors()
+{
+    QFETCH(QString, line);
+    QFETCH(QString, message);
+    QString text, rest;
+    QCOMPARE(lexFirst(line, text, rest), tokenError);
+    QCOMPARE(text, message);
+}
+
+void TestIsaLexer::wholeLine()
+{
+    const QString line = "loop:    LDBA    'a',sfx ;c #2d";
+    const QVector<QPair<int, QString>> expected = {
+        {LT_SYMBOL_DEF, "loop:"}, {LT_IDENTIFIER, "LDBA"}, {LT_CHAR_CONSTANT, "'a'"},
+        {LT_ADDRESSING_MODE, ",sfx"}, {LT_COMMENT, ";c #2d"}, {LT_EMPTY, ""}
+    };
+    AsmProgramManager manager;
+    IsaAsm assembler(manager);
+    QStringView view(line);
+    QString text;
+    for(const auto& next : expected) {
+        ELexicalToken token;
+        QVERIFY2(assembler.getToken(view, token, text), qPrintable(text));
+        QCOMPARE(static_cast<int>(token), next.first);
+        QCOMPARE(text, next.second);
+    }
+    // The line itself is only viewed, never modified.
+    QCOMPARE(line, QString("loop:    LDBA    'a',sfx ;c #2d"));
+}
+
+void TestIsaLexer::concurrentAssemblers()
+{
+    // Uses struct, array, and malloc trace tags, which are analyzed with shared regular expressions.
+    const QString source = IsaMachine::figureSource("fig0648");
+    QString errorMessage;
+    auto reference = IsaMachine::assembleProgram(source, errorMessage);
+    QVERIFY2(!reference.isNull(), qPrintable(errorMessage));
+    QVERIFY(reference->getTraceInfo()->hadTraceTags);
+
+    const int threadCount = 4, repetitions = 25;
+    std::vector<int> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    for(int index = 0; index < threadCount; index++) {
+        threads.emplace_back([&, index](){
+            for(int it = 0; it < repetitions; it++) {
+                QString threadError;
+                auto program = IsaMachine::assembleProgram(source, threadError);
+                if(program.isNull()
+                        || program->getObjectCode() != reference->getObjectCode()
+                        || program->getProgramListing() != reference->getProgramListing()
+                        || program->getTraceInfo()->staticTraceError != reference->getTraceInfo()->staticTraceError
+                        || program->getTraceInfo()->hasHeapMalloc != reference->getTraceInfo()->hasHeapMalloc) {
+                    mismatches[static_cast<size_t>(index)]++;
+                }
+            }
+        });
+    }
+    for(auto& thread : threads) thread.join();
+    for(int index = 0; index < threadCount; index++) {
+        QCOMPARE(mismatches[static_cast<size_t>(index)], 0);
+    }
+}
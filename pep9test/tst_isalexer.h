@@ -0,0 +1,48 @@
+// File: tst_isalexer.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_ISALEXER_H
+#define TST_ISALEXER_H
+
+#include <QtTest>
+
+/*
+ * The hand written scanner in IsaAsm::getToken must produce the same tokens and error messages
+ * as the regular expressions it replaced, including for their unusual edge cases,
+ * and assemblers must produce identical programs when run concurrently.
+ */
+class TestIsaLexer: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Lex the first token of a line, and check its type, text, and what remains of the line.
+    void firstToken_data();
+    void firstToken();
+    // Malformed tokens are reported with the same messages as before.
+    void errors_data();
+    void errors();
+    // Lex a whole line, one token after another.
+    void wholeLine();
+    // Assemble a trace tagged program on several threads at once.
+    void concurrentAssemblers();
+};
+
+#endif // TST_ISALEXER_H
@@ -0,0 +1,209 @@
+// File: tst_memorytrace.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_memorytrace.h"
+
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "boundexecisacpu.h"
+#include "isamachine.h"
+#include "mainmemory.h"
+#include "memoryaccesstrace.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+namespace {
+using AccessKind = MemoryAccessTraceWriter::AccessKind;
+
+struct Record
+{
+    AccessKind kind;
+    bool word;
+    quint16 pc, address, value;
+    bool operator==(const Record& other) const
+    {
+        return kind == other.kind && word == other.word && pc == other.pc
+                && address == other.address && value == other.value;
+    }
+};
+
+// Read a zigzag encoded LEB128 varint at offset, and return it as a 16 bit difference.
+bool readDelta(const QByteArray& bytes, int& offset, quint16& delta)
+{
+    quint32 zigzag = 0;
+    for(int shift = 0; offset < bytes.size() && shift < 32; shift += 7) {
+        const quint8 byte = static_cast<quint8>(bytes[offset++]);
+        zigzag |= static_cast<quint32>(byte & 0x7f) << shift;
+        if(!(byte & 0x80)) {
+            const int signedDelta = zigzag & 1 ? -static_cast<int>((zigzag + 1) / 2) : static_cast<int>(zigzag / 2);
+            delta = static_cast<quint16>(signedDelta);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decode a whole trace file. Returns false if it is malformed.
+bool decode(const QByteArray& bytes, QVector<Record>& records)
+{
+    if(bytes.size() < 5 || bytes.left(4) != "P9MT" || bytes[4] != MemoryAccessTraceWriter::version) return false;
+    quint16 pc = 0, nextAddress = 0;
+    for(int offset = 5; offset < bytes.size();) {
+        const quint8 tag = static_cast<quint8>(bytes[offset++]);
+        if(tag >> 5) return false;
+        Record record{static_cast<AccessKind>(tag & 0b11), (tag & 0b100) != 0, pc, nextAddress, 0};
+        quint16 delta = 0;
+        if(tag & 0b1000) {
+            if(!readDelta(bytes, offset, delta)) return false;
+            record.pc = static_cast<quint16>(pc + delta);
+        }
+        if(tag & 0b10000) {
+            if(!readDelta(bytes, offset, delta)) return false;
+            record.address = static_cast<quint16>(nextAddress + delta);
+        }
+        const int width = record.word ? 2 : 1;
+        if(offset + width > bytes.size()) return false;
+        for(int it = 0; it < width; it++) {
+            record.value = static_cast<quint16>(record.value << 8 | static_cast<quint8>(bytes[offset++]));
+        }
+        pc = record.pc;
+        nextAddress = static_cast<quint16>(record.address + width);
+        records.append(record);
+    }
+    return true;
+}
+
+// Record every access in a new trace file, and decode what was written.
+QVector<Record> roundTrip(const QVector<Record>& recorded)
+{
+    QTemporaryDir directory;
+    const QString fileName = directory.filePath("trace.p9mt");
+    MemoryAccessTraceWriter writer(fileName);
+    if(!writer.open()) QTest::qFail("Could not open the trace file", __FILE__, __LINE__);
+    for(const Record& record : recorded) {
+        writer.record(record.kind, record.word, record.pc, record.address, record.value);
+    }
+    if(!writer.close()) QTest::qFail("Could not write the trace file", __FILE__, __LINE__);
+    if(writer.getAccessCount() != static_cast<quint64>(recorded.size())) {
+        QTest::qFail("The writer miscounted accesses", __FILE__, __LINE__);
+    }
+    QFile file(fileName);
+    QVector<Record> decoded;
+    if(!file.open(QIODevice::ReadOnly) || !decode(file.readAll(), decoded)) {
+        QTest::qFail("The trace file is malformed", __FILE__, __LINE__);
+    }
+    return decoded;
+}
+
+quint16 symbolValue(const QString& name)
+{
+    auto os = IsaMachine::getManager().getOperatingSystem();
+    return static_cast<quint16>(os->getSymbolTable()->getValue(name)->getValue());
+}
+}
+
+void TestMemoryTrace::writerRoundTrip()
+{
+    const QVector<Record> recorded{
+        // Starts from a PC and address of 0, so neither delta is needed.
+        {AccessKind::READ, false, 0, 0, 0x12},
+        // Sequential fetches.
+        {AccessKind::READ, true, 0, 1, 0xbeef},
+        {AccessKind::READ, false, 0, 3, 0x00},
+        // Small moves in each direction.
+        {AccessKind::WRITE, true, 3, 0xfb00, 0x0102},
+        {AccessKind::WRITE, false, 3, 0xfaf0, 0xff},
+        // Moves needing multi-byte varints, and the largest moves in each direction.
+        {AccessKind::GET, false, 0x0300, 0x1234, 0x7f},
+        {AccessKind::SET, true, 0x8300, 0x9234, 0x8000},
+        {AccessKind::SET, false, 0x0301, 0x1236, 0x80},
+        // Wrapping around the end of memory.
+        {AccessKind::READ, true, 0xffff, 0xffff, 0xa5a5},
+        {AccessKind::READ, false, 0x0000, 0x0001, 0x5a},
+    };
+    QCOMPARE(roundTrip(recorded), recorded);
+}
+
+void TestMemoryTrace::writerOverflowsBuffer()
+{
+    QVector<Record> recorded;
+    // Several times the capacity of the writer's ring buffer.
+    for(int it = 0; it < 300000; it++) {
+        const quint16 address = static_cast<quint16>(it * 7919);
+        recorded.append({static_cast<AccessKind>(it % 4), it % 3 == 0, static_cast<quint16>(it / 5),
+                         address, static_cast<quint16>(it % 3 == 0 ? it : it & 0xff)});
+    }
+    QVector<Record> decoded = roundTrip(recorded);
+    QCOMPARE(decoded.size(), recorded.size());
+    QVERIFY(decoded == recorded);
+}
+
+void TestMemoryTrace::tracedProgramReplays()
+{
+    QTemporaryDir directory;
+    MemoryAccessTraceWriter writer(directory.filePath("trace.p9mt"));
+    QVERIFY(writer.open());
+    QSharedPointer<TracingMemoryDevice> tracer;
+    IsaMachine machine(IsaCpuCore::SWITCH, [&tracer](QSharedPointer<MainMemory> memory) {
+        tracer = QSharedPointer<TracingMemoryDevice>::create(memory);
+        return tracer.staticCast<AMemoryDevice>();
+    });
+    tracer->setProgramCounterSource(&machine.getCpu()->getRegisterBank());
+
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(IsaMachine::figureSource("fig0634"), errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+    machine.load(objectCode);
+    machine.setInput("2 26 -3 9");
+    QByteArray memory = machine.getStateWithoutIO().memory;
+    tracer->setWriter(&writer);
+    QVERIFY(machine.run());
+    tracer->setWriter(nullptr);
+    QVERIFY(writer.close());
+
+    QFile file(directory.filePath("trace.p9mt"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVector<Record> records;
+    QVERIFY(decode(file.readAll(), records));
+    QCOMPARE(static_cast<quint64>(records.size()), writer.getAccessCount());
+    // Every instruction is fetched, so at least that many reads were recorded.
+    QVERIFY(static_cast<quint64>(records.size()) >= machine.getCpu()->getInstructionCount());
+
+    // Memory mapped IO neither holds what was written, nor what will be read, so skip it.
+    const quint16 charIn = symbolValue("charIn"), charOut = symbolValue("charOut");
+    for(const Record& record : records) {
+        const int width = record.word ? 2 : 1;
+        for(int it = 0; it < width; it++) {
+            const quint16 address = static_cast<quint16>(record.address + it);
+            if(address == charIn || address == charOut) continue;
+            const char byte = static_cast<char>(record.word && it == 0 ? record.value >> 8 : record.value & 0xff);
+            if(record.kind == AccessKind::WRITE || record.kind == AccessKind::SET) {
+                memory[address] = byte;
+            }
+            else if(memory[address] != byte) {
+                QFAIL(qPrintable(QString("Read of %1 at PC %2 does not match the trace's writes")
+                                 .arg(address, 4, 16, QChar('0')).arg(record.pc, 4, 16, QChar('0'))));
+            }
+        }
+    }
+    QCOMPARE(memory, machine.getStateWithoutIO().memory);
+}
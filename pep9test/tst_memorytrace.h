@@ -0,0 +1,44 @@
+// File: tst_memorytrace.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_MEMORYTRACE_H
+#define TST_MEMORYTRACE_H
+
+#include <QtTest>
+
+/*
+ * Memory access traces must decode, following the format described in memoryaccesstrace.h,
+ * to exactly the accesses that were recorded.
+ */
+class TestMemoryTrace: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Accesses recorded directly, covering every kind, width, and size of delta.
+    void writerRoundTrip();
+    // More accesses than the writer's buffer holds, so the producer must wait on the writer thread.
+    void writerOverflowsBuffer();
+    // A traced program's reads must see the values of the writes before them, and replaying
+    // its writes over the loaded memory must produce the memory the program ended with.
+    void tracedProgramReplays();
+};
+
+#endif // TST_MEMORYTRACE_H
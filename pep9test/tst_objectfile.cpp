@@ -0,0 +1,227 @@
+// File: tst_objectfile.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_objectfile.h"
+
+#include "asmprogram.h"
+#include "asmprogrammanager.h"
+#include "isamachine.h"
+#include "objectfile.h"
+#include "symbolentry.h"
+#include "symboltable.h"
+#include "symbolvalue.h"
+
+namespace {
+// The default operating system, which unlike the figures is burned into ROM.
+const QString operatingSystem = "pep9os";
+
+QSharedPointer<const AsmProgram> assembleProgram(const QString& name)
+{
+    if(name == operatingSystem) return IsaMachine::getManager().getOperatingSystem();
+    QString errorMessage;
+    auto program = IsaMachine::assembleProgram(IsaMachine::figureSource(name), errorMessage);
+    if(program.isNull()) QTest::qFail(qPrintable(errorMessage), __FILE__, __LINE__);
+    return program;
+}
+
+QByteArray objectFileBytes(const QString& name)
+{
+    auto program = assembleProgram(name);
+    if(program.isNull()) return {};
+    return ObjectFile(*program).toBytes();
+}
+
+// Offsets of the fixed size fields at the start of every object file.
+const int versionOffset = 4;
+const int loadAddressOffset = 6;
+
+void writeWord(QByteArray& bytes, int offset, quint16 value)
+{
+    bytes[offset] = static_cast<char>(value >> 8);
+    bytes[offset + 1] = static_cast<char>(value & 0xff);
+}
+}
+
+void TestObjectFile::roundTrip_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::newRow("fig0625") << "fig0625";
+    // Has heap and malloc symbols in its trace information.
+    QTest::newRow("fig0648") << "fig0648";
+    QTest::newRow("operating system") << operatingSystem;
+}
+
+void TestObjectFile::roundTrip()
+{
+    QFETCH(QString, name);
+    auto program = assembleProgram(name);
+    QVERIFY(!program.isNull());
+    ObjectFile original(*program);
+    QByteArray bytes = original.toBytes();
+
+    ObjectFile parsed;
+    QString errorMessage;
+    QVERIFY2(ObjectFile::fromBytes(bytes, parsed, errorMessage), qPrintable(errorMessage));
+
+    QCOMPARE(parsed.getObjectCode(), program->getObjectCode());
+    QCOMPARE(parsed.hasBurn(), program->hasBurn());
+    if(program->hasBurn()) {
+        QCOMPARE(parsed.getLoadAddress(), program->getBurnAddress());
+        QCOMPARE(parsed.getBurnValue(), program->getBurnValue());
+    }
+    else QCOMPARE(parsed.getLoadAddress(), static_cast<quint16>(0));
+    QCOMPARE(parsed.getListing(), original.getListing());
+
+    auto symbols = original.getSymbolTable()->getSymbolEntries();
+    QVERIFY(!symbols.isEmpty());
+    QCOMPARE(parsed.getSymbolTable()->getSymbolEntries().size(), symbols.size());
+    for(const auto& symbol : symbols) {
+        auto parsedSymbol = parsed.getSymbolTable()->getValue(symbol->getName());
+        QVERIFY2(!parsedSymbol.isNull(), qPrintable(symbol->getName()));
+        QCOMPARE(parsedSymbol->getValue(), symbol->getValue());
+        QCOMPARE(parsedSymbol->getRawValue()->getSymbolType(), symbol->getRawValue()->getSymbolType());
+    }
+
+    auto traceInfo = original.getTraceInfo(), parsedTraceInfo = parsed.getTraceInfo();
+    QCOMPARE(parsedTraceInfo->staticTraceError, traceInfo->staticTraceError);
+    QCOMPARE(parsedTraceInfo->hadTraceTags, traceInfo->hadTraceTags);
+    QCOMPARE(parsedTraceInfo->hasHeapMalloc, traceInfo->hasHeapMalloc);
+    QCOMPARE(parsedTraceInfo->heapPtr.isNull(), traceInfo->heapPtr.isNull());
+    QCOMPARE(parsedTraceInfo->mallocPtr.isNull(), traceInfo->mallocPtr.isNull());
+    if(!traceInfo->heapPtr.isNull()) QCOMPARE(parsedTraceInfo->heapPtr->getName(), traceInfo->heapPtr->getName());
+    if(!traceInfo->mallocPtr.isNull()) QCOMPARE(parsedTraceInfo->mallocPtr->getName(), traceInfo->mallocPtr->getName());
+
+    QVERIFY(!original.getLines().isEmpty());
+    QCOMPARE(parsed.getLines().size(), original.getLines().size());
+    for(int index = 0; index < original.getLines().size(); index++) {
+        const auto& line = original.getLines()[index];
+        const auto& parsedLine = parsed.getLines()[index];
+        QCOMPARE(parsedLine.address, line.address);
+        QCOMPARE(parsedLine.length, line.length);
+        QCOMPARE(parsedLine.sourceLine, line.sourceLine);
+        QCOMPARE(parsedLine.source, line.source);
+        QCOMPARE(parsed.describeAddress(line.address), original.describeAddress(line.address));
+    }
+
+    // Nothing is lost or reordered, so writing the parsed file reproduces it exactly.
+    QCOMPARE(parsed.toBytes(), bytes);
+}
+
+void TestObjectFile::recognizesObjectFiles()
+{
+    QByteArray bytes = objectFileBytes("fig0625");
+    QVERIFY(ObjectFile::isObjectFile(bytes));
+    QVERIFY(!ObjectFile::isObjectFile(QByteArray("D1 FC 15 F1 FC 16 00 zz\n")));
+    QVERIFY(!ObjectFile::isObjectFile(bytes.left(3)));
+    QVERIFY(!ObjectFile::isObjectFile(QByteArray()));
+}
+
+void TestObjectFile::rejectsWrongMagic()
+{
+    QByteArray bytes = objectFileBytes("fig0625");
+    bytes[0] = static_cast<char>(bytes[0] ^ 0xff);
+    QVERIFY(!ObjectFile::isObjectFile(bytes));
+    ObjectFile parsed;
+    QString errorMessage;
+    QVERIFY(!ObjectFile::fromBytes(bytes, parsed, errorMessage));
+    QCOMPARE(errorMessage, QString("Not a Pep/9 object file."));
+}
+
+void TestObjectFile::rejectsWrongVersion()
+{
+    QByteArray bytes = objectFileBytes("fig0625");
+    writeWord(bytes, versionOffset, 2);
+    // Still an object file, just not one this version can read.
+    QVERIFY(ObjectFile::isObjectFile(bytes));
+    ObjectFile parsed;
+    QString errorMessage;
+    QVERIFY(!ObjectFile::fromBytes(bytes, parsed, errorMessage));
+    QCOMPARE(errorMessage, QString("Unsupported object file version 2."));
+}
+
+void TestObjectFile::rejectsTruncation_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::newRow("fig0625") << "fig0625";
+    QTest::newRow("fig0648") << "fig0648";
+}
+
+void TestObjectFile::rejectsTruncation()
+{
+    QFETCH(QString, name);
+    QByteArray bytes = objectFileBytes(name);
+    QVERIFY(!bytes.isEmpty());
+    // Cut the file off inside every field at the start, and at evenly spaced points after that.
+    QVector<int> lengths;
+    for(int length = 0; length < qMin(64, bytes.size()); length++) lengths.append(length);
+    const int step = qMax(1, bytes.size() / 256);
+    for(int length = 64; length < bytes.size(); length += step) lengths.append(length);
+    lengths.append(bytes.size() - 1);
+
+    for(int length : lengths) {
+        ObjectFile parsed;
+        QString errorMessage;
+        QVERIFY2(!ObjectFile::fromBytes(bytes.left(length), parsed, errorMessage),
+                 qPrintable(QString("Accepted the first %1 of %2 bytes.").arg(length).arg(bytes.size())));
+        QVERIFY(!errorMessage.isEmpty());
+    }
+}
+
+void TestObjectFile::rejectsUnknownSymbolType()
+{
+    QByteArray bytes = objectFileBytes("fig0648");
+    // Symbols are written as their name followed by a byte for their type. The symbol table
+    // precedes the lines and listing, so the first match is the symbol itself.
+    QByteArray name;
+    QDataStream out(&name, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_10);
+    out << QString("malloc");
+    int index = bytes.indexOf(name);
+    QVERIFY(index > 0);
+    bytes[index + name.size()] = static_cast<char>(0xff);
+
+    ObjectFile parsed;
+    QString errorMessage;
+    QVERIFY(!ObjectFile::fromBytes(bytes, parsed, errorMessage));
+    QCOMPARE(errorMessage, QString("The object file is damaged."));
+}
+
+void TestObjectFile::rejectsCodePastEndOfMemory()
+{
+    QByteArray bytes = objectFileBytes("fig0625");
+    ObjectFile parsed;
+    QString errorMessage;
+    QVERIFY(ObjectFile::fromBytes(bytes, parsed, errorMessage));
+    const int size = parsed.getObjectCode().size();
+    QVERIFY(size > 1);
+
+    // Ending on the last byte of memory is fine.
+    writeWord(bytes, loadAddressOffset, static_cast<quint16>((1 << 16) - size));
+    QVERIFY2(ObjectFile::fromBytes(bytes, parsed, errorMessage), qPrintable(errorMessage));
+    QCOMPARE(parsed.getLoadAddress(), static_cast<quint16>((1 << 16) - size));
+
+    // One byte further is not.
+    writeWord(bytes, loadAddressOffset, static_cast<quint16>((1 << 16) - size + 1));
+    QVERIFY(!ObjectFile::fromBytes(bytes, parsed, errorMessage));
+    QCOMPARE(errorMessage, QString("The object file is damaged."));
+    writeWord(bytes, loadAddressOffset, 0xffff);
+    QVERIFY(!ObjectFile::fromBytes(bytes, parsed, errorMessage));
+}
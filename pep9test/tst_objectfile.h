@@ -0,0 +1,49 @@
+// File: tst_objectfile.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_OBJECTFILE_H
+#define TST_OBJECTFILE_H
+
+#include <QtTest>
+
+/*
+ * A binary object file must read back as exactly the program that was written,
+ * and anything that is not an intact object file must be rejected rather than run.
+ */
+class TestObjectFile: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Object code, load address, symbols, lines, listing, and trace information survive a round trip.
+    void roundTrip_data();
+    void roundTrip();
+    // Only bytes starting with the magic number are taken for an object file.
+    void recognizesObjectFiles();
+    void rejectsWrongMagic();
+    void rejectsWrongVersion();
+    void rejectsTruncation_data();
+    void rejectsTruncation();
+    void rejectsUnknownSymbolType();
+    // Object code must fit in memory above its load address.
+    void rejectsCodePastEndOfMemory();
+};
+
+#endif // TST_OBJECTFILE_H
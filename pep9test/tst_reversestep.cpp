@@ -0,0 +1,159 @@
+// File: tst_reversestep.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_reversestep.h"
+
+#include "boundexecisacpu.h"
+#include "isamachine.h"
+
+namespace {
+// Upper bound on the instructions executed by any of the figures.
+constexpr int maxSteps = 100000;
+
+// The trap counters after an instruction.
+struct Counters
+{
+    quint64 acceleratedTraps, emulatedInstructions;
+    bool operator==(const Counters& other) const
+    {
+        return acceleratedTraps == other.acceleratedTraps && emulatedInstructions == other.emulatedInstructions;
+    }
+};
+
+Counters countersOf(const IsaCpu& cpu)
+{
+    return {cpu.getAcceleratedTrapCount(), cpu.getEmulatedInstructionCount()};
+}
+
+void addRows()
+{
+    QTest::addColumn<QString>("figure");
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<bool>("accelerateTraps");
+    QTest::newRow("fig0625") << "fig0625" << "" << false;
+    QTest::newRow("fig0625, accelerated") << "fig0625" << "" << true;
+    QTest::newRow("fig0634") << "fig0634" << "2 26 -3 9" << false;
+    QTest::newRow("fig0634, accelerated") << "fig0634" << "2 26 -3 9" << true;
+    QTest::newRow("fig0648") << "fig0648" << "10 20 30 -9999" << true;
+}
+
+// Load the figure, and prepare to step through it with the journal enabled.
+void prepare(IsaMachine& machine, const QString& figure, const QString& input, bool accelerateTraps)
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(IsaMachine::figureSource(figure), errorMessage);
+    if(objectCode.isEmpty()) QTest::qFail(qPrintable(errorMessage), __FILE__, __LINE__);
+    machine.load(objectCode);
+    machine.setInput(input);
+    auto cpu = machine.getCpu();
+    cpu->setTrapAccelerationEnabled(accelerateTraps);
+    cpu->onSimulationStarted();
+    cpu->setReverseStepEnabled(true);
+}
+
+// Step until the program stops, recording the counters after each instruction.
+// If outputLengths is given, also record the length of the output after each instruction.
+QVector<Counters> stepToEnd(IsaMachine& machine, QVector<int>* outputLengths = nullptr)
+{
+    auto cpu = machine.getCpu();
+    QVector<Counters> counters{countersOf(*cpu)};
+    if(outputLengths != nullptr) outputLengths->append(machine.getOutput().size());
+    while(!cpu->getExecutionFinished() && !cpu->hadErrorOnStep() && counters.size() <= maxSteps) {
+        cpu->stepInto();
+        counters.append(countersOf(*cpu));
+        if(outputLengths != nullptr) outputLengths->append(machine.getOutput().size());
+    }
+    return counters;
+}
+}
+
+void TestReverseStep::stepBackToStart_data()
+{
+    addRows();
+}
+
+void TestReverseStep::stepBackToStart()
+{
+    QFETCH(QString, figure);
+    QFETCH(QString, input);
+    QFETCH(bool, accelerateTraps);
+
+    IsaMachine machine;
+    prepare(machine, figure, input, accelerateTraps);
+    auto cpu = machine.getCpu();
+    // Memory mapped IO is not undone, so it is not compared.
+    IsaMachine::State start = machine.getStateWithoutIO();
+    QVector<Counters> counters = stepToEnd(machine);
+    QVERIFY2(!cpu->hadErrorOnStep(), qPrintable(cpu->getErrorMessage()));
+    QVERIFY(cpu->getExecutionFinished());
+    if(accelerateTraps) QVERIFY(cpu->getAcceleratedTrapCount() > 0);
+
+    // Every instruction can be undone, and each restores the counters it started with.
+    for(int step = counters.size() - 2; step >= 0; step--) {
+        QVERIFY(cpu->stepBack());
+        QCOMPARE(countersOf(*cpu), counters[step]);
+    }
+    QVERIFY(!cpu->canStepBack());
+    QCOMPARE(machine.getStateWithoutIO(), start);
+    QCOMPARE(cpu->getEmulatedInstructionCount(), static_cast<quint64>(0));
+    // Undone instructions are removed from the execution statistics.
+    QCOMPARE(cpu->getInstructionCount(), static_cast<quint64>(0));
+    QCOMPARE(cpu->getInstructionHistogram(), QVector<quint32>(256, 0));
+}
+
+void TestReverseStep::stepBackAndReplay_data()
+{
+    addRows();
+}
+
+void TestReverseStep::stepBackAndReplay()
+{
+    QFETCH(QString, figure);
+    QFETCH(QString, input);
+    QFETCH(bool, accelerateTraps);
+
+    IsaMachine machine;
+    prepare(machine, figure, input, accelerateTraps);
+    auto cpu = machine.getCpu();
+    QVector<int> outputLengths;
+    QVector<Counters> counters = stepToEnd(machine, &outputLengths);
+    QVERIFY2(!cpu->hadErrorOnStep(), qPrintable(cpu->getErrorMessage()));
+    QVERIFY(cpu->getExecutionFinished());
+    IsaMachine::State end = machine.getStateWithoutIO();
+    const QByteArray output = machine.getOutput();
+    const QVector<quint32> histogram = cpu->getInstructionHistogram();
+
+    // Undo every instruction but the first, so that all of the input must be read again.
+    const int undone = counters.size() - 2;
+    for(int step = 0; step < undone; step++) {
+        QVERIFY(cpu->stepBack());
+    }
+    QCOMPARE(countersOf(*cpu), counters[counters.size() - 1 - undone]);
+    // Output can't be taken back, so only collect what the replay writes.
+    machine.clearOutput();
+    QVector<Counters> replayed = stepToEnd(machine);
+    QVERIFY2(!cpu->hadErrorOnStep(), qPrintable(cpu->getErrorMessage()));
+    QCOMPARE(replayed.size(), undone + 1);
+    QCOMPARE(countersOf(*cpu), counters.last());
+    QCOMPARE(machine.getStateWithoutIO(), end);
+    QCOMPARE(machine.getOutput(), output.mid(outputLengths[counters.size() - 1 - undone]));
+    QCOMPARE(cpu->getInstructionHistogram(), histogram);
+}
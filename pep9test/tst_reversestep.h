@@ -0,0 +1,45 @@
+// File: tst_reversestep.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_REVERSESTEP_H
+#define TST_REVERSESTEP_H
+
+#include <QtTest>
+
+/*
+ * Stepping an IsaCpu backwards through its journal must return the registers, memory,
+ * counters, and unread input to the values they held before each instruction,
+ * with or without trap acceleration.
+ */
+class TestReverseStep: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Step through a whole program, then back to its first instruction.
+    void stepBackToStart_data();
+    void stepBackToStart();
+    // Step back part of the way, then forward again, and end where the first run ended,
+    // having read the same input and written the same output.
+    void stepBackAndReplay_data();
+    void stepBackAndReplay();
+};
+
+#endif // TST_REVERSESTEP_H
@@ -0,0 +1,94 @@
+// File: tst_snapshot.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_snapshot.h"
+
+#include "boundexecisacpu.h"
+#include "isamachine.h"
+
+namespace {
+QVector<quint8> assembleFigure(const QString& figure)
+{
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(IsaMachine::figureSource(figure), errorMessage);
+    if(objectCode.isEmpty()) QTest::qFail(qPrintable(errorMessage), __FILE__, __LINE__);
+    return objectCode;
+}
+}
+
+void TestSnapshot::restoreMatchesFreshLoad_data()
+{
+    QTest::addColumn<QString>("figure");
+    QTest::addColumn<QString>("firstInput");
+    QTest::addColumn<QString>("secondInput");
+    QTest::newRow("fig0625") << "fig0625" << "" << "";
+    QTest::newRow("fig0634") << "fig0634" << "1 2 3 4" << "2 26 -3 9";
+    // Allocates from a heap, whose pointer must be put back as well.
+    QTest::newRow("fig0648") << "fig0648" << "7 -9999" << "10 20 30 -9999";
+}
+
+void TestSnapshot::restoreMatchesFreshLoad()
+{
+    QFETCH(QString, figure);
+    QFETCH(QString, firstInput);
+    QFETCH(QString, secondInput);
+    QVector<quint8> objectCode = assembleFigure(figure);
+
+    IsaMachine fresh;
+    fresh.load(objectCode);
+    fresh.setInput(secondInput);
+    QVERIFY(fresh.run());
+
+    IsaMachine reused;
+    auto cpu = reused.getCpu();
+    QVERIFY(!cpu->restoreSnapshot());
+    reused.load(objectCode);
+    QVERIFY(cpu->takeSnapshot());
+    reused.setInput(firstInput);
+    QVERIFY(reused.run());
+    reused.clearOutput();
+
+    QVERIFY(cpu->restoreSnapshot());
+    reused.setInput(secondInput);
+    QVERIFY(reused.run());
+    QCOMPARE(reused.getState(), fresh.getState());
+    QCOMPARE(cpu->getInstructionCount(), fresh.getCpu()->getInstructionCount());
+}
+
+void TestSnapshot::restoreIsRepeatable()
+{
+    IsaMachine machine;
+    auto cpu = machine.getCpu();
+    machine.load(assembleFigure("fig0648"));
+    QVERIFY(cpu->takeSnapshot());
+    machine.setInput("10 20 30 -9999");
+    QVERIFY(machine.run());
+    IsaMachine::State first = machine.getState();
+
+    for(int run = 0; run < 3; run++) {
+        QVERIFY(cpu->restoreSnapshot());
+        QVERIFY(cpu->hasSnapshot());
+        machine.clearOutput();
+        machine.setInput("10 20 30 -9999");
+        QVERIFY(machine.run());
+        QCOMPARE(machine.getState(), first);
+    }
+}
@@ -0,0 +1,42 @@
+// File: tst_snapshot.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_SNAPSHOT_H
+#define TST_SNAPSHOT_H
+
+#include <QtTest>
+
+/*
+ * Restoring an IsaCpu's snapshot must leave the machine exactly as loading the
+ * operating system and program from scratch would, no matter what the last run modified.
+ */
+class TestSnapshot: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Run with one input, restore, and run with another. The second run must match a fresh machine's.
+    void restoreMatchesFreshLoad_data();
+    void restoreMatchesFreshLoad();
+    // The snapshot survives being restored, so every run after the first is identical.
+    void restoreIsRepeatable();
+};
+
+#endif // TST_SNAPSHOT_H
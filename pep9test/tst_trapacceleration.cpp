@@ -0,0 +1,238 @@
+// File: tst_trapacceleration.cpp
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tst_trapacceleration.h"
+
+#include "boundexecisacpu.h"
+#include "isamachine.h"
+
+namespace {
+// Print a space between numbers.
+const QStringList space = {
+    "         LDBA    ' ',i",
+    "         STBA    charOut,d"
+};
+
+// Reads seven numbers, one with each addressing mode DECI allows, and echoes each with DECO
+// through the same addressing mode. The status bits DECI set are kept in f1 through f7.
+QString deciProgram()
+{
+    QStringList lines = {
+        "         BR      main",
+        "num:     .BLOCK  2",
+        "ptr:     .ADDRSS vec",
+        "vec:     .BLOCK  6",
+        "f1:      .BLOCK  1",
+        "f2:      .BLOCK  1",
+        "f3:      .BLOCK  1",
+        "f4:      .BLOCK  1",
+        "f5:      .BLOCK  1",
+        "f6:      .BLOCK  1",
+        "f7:      .BLOCK  1",
+        "main:    DECI    num,d",
+        "         MOVFLGA",
+        "         STBA    f1,d",
+        "         DECO    num,d"};
+    lines << space << QStringList{
+        "         DECI    ptr,n",
+        "         MOVFLGA",
+        "         STBA    f2,d",
+        "         DECO    ptr,n"};
+    lines << space << QStringList{
+        "         LDWX    2,i",
+        "         DECI    vec,x",
+        "         MOVFLGA",
+        "         STBA    f3,d",
+        "         DECO    vec,x"};
+    // 0,s and 4,s hold numbers, and 2,s points to vec.
+    lines << space << QStringList{
+        "         SUBSP   6,i",
+        "         LDWA    vec,i",
+        "         STWA    2,s",
+        "         DECI    0,s",
+        "         MOVFLGA",
+        "         STBA    f4,d",
+        "         DECO    0,s"};
+    lines << space << QStringList{
+        "         DECI    2,sf",
+        "         MOVFLGA",
+        "         STBA    f5,d",
+        "         DECO    2,sf"};
+    lines << space << QStringList{
+        "         LDWX    4,i",
+        "         DECI    0,sx",
+        "         MOVFLGA",
+        "         STBA    f6,d",
+        "         DECO    0,sx"};
+    lines << space << QStringList{
+        "         DECI    2,sfx",
+        "         MOVFLGA",
+        "         STBA    f7,d",
+        "         DECO    2,sfx",
+        "         ADDSP   6,i",
+        "         STOP",
+        "         .END"};
+    return lines.join("\n");
+}
+
+// Writes numbers with both DECO and HEXO, through every addressing mode.
+QString outputProgram()
+{
+    QStringList lines = {
+        "         BR      main",
+        "num:     .WORD   20304",
+        "ptr:     .ADDRSS vec",
+        "vec:     .WORD   300",
+        "         .WORD   -1",
+        "         .WORD   0",
+        // 0,s is a number, and 2,s points to vec.
+        "main:    SUBSP   4,i",
+        "         LDWA    -7,i",
+        "         STWA    0,s",
+        "         LDWA    vec,i",
+        "         STWA    2,s"};
+    // Leading, embedded, and trailing zeros, both signs, and both extremes.
+    for(QString value : {"-32768", "32767", "0", "-1", "7", "100", "1005", "10000", "-20001"}) {
+        lines << QString("         DECO    %1,i").arg(value) << space;
+    }
+    for(QString value : {"0", "0xFFFF", "0xABCD", "0x09AF", "0x8000", "0x1234"}) {
+        lines << QString("         HEXO    %1,i").arg(value) << space;
+    }
+    const QStringList operands = {"num,d", "ptr,n", "0,s", "2,sf"};
+    for(const QString& operand : operands) {
+        lines << QString("         DECO    %1").arg(operand) << space;
+        lines << QString("         HEXO    %1").arg(operand) << space;
+    }
+    lines << "         LDWX    2,i";
+    for(const QString& operand : {"vec,x", "0,sx", "2,sfx"}) {
+        lines << QString("         DECO    %1").arg(operand) << space;
+        lines << QString("         HEXO    %1").arg(operand) << space;
+    }
+    lines << "         LDWX    4,i"
+          << "         DECO    2,sfx" << space
+          << "         HEXO    2,sfx"
+          << "         ADDSP   4,i"
+          << "         STOP"
+          << "         .END";
+    return lines.join("\n");
+}
+
+// Writes strings, including empty ones, through every addressing mode STRO allows.
+QString stroProgram()
+{
+    QStringList lines = {
+        "         BR      main",
+        "hello:   .ASCII  \"Hello, world\\n\\x00\"",
+        "empty:   .ASCII  \"\\x00\"",
+        "ptr:     .ADDRSS hello",
+        "vec:     .ASCII  \"ab\\x00\"",
+        "main:    STRO    hello,d",
+        "         STRO    empty,d",
+        "         STRO    ptr,n",
+        "         LDWX    1,i",
+        "         STRO    vec,x",
+        "         LDWX    2,i",
+        "         STRO    vec,x",
+        // 0,s holds the string "A", and 2,s points to a string.
+        "         SUBSP   4,i",
+        "         LDWA    0x4100,i",
+        "         STWA    0,s",
+        "         LDWA    empty,i",
+        "         STWA    2,s",
+        "         STRO    0,s",
+        "         STRO    1,s",
+        "         STRO    2,sf",
+        "         LDWA    hello,i",
+        "         STWA    2,s",
+        "         STRO    2,sf",
+        "         ADDSP   4,i",
+        "         STOP",
+        "         .END"};
+    return lines.join("\n");
+}
+
+// Describe the first address at which the two machines' memory differs, if there is one.
+QString firstDifference(const QByteArray& actual, const QByteArray& expected)
+{
+    for(int address = 0; address < expected.size(); address++) {
+        if(actual[address] == expected[address]) continue;
+        return QString("Memory differs at 0x%1: 0x%2 accelerated, 0x%3 simulated.")
+                .arg(address, 4, 16, QChar('0'))
+                .arg(static_cast<quint8>(actual[address]), 2, 16, QChar('0'))
+                .arg(static_cast<quint8>(expected[address]), 2, 16, QChar('0'));
+    }
+    return QString();
+}
+}
+
+void TestTrapAcceleration::matchesOperatingSystem_data()
+{
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("input");
+    QTest::newRow("DECI, positive") << deciProgram() << "1 22 333 4444 12345 7 9";
+    QTest::newRow("DECI, signs") << deciProgram() << "+5 -5 -0 +0 -32767 +32767 -1";
+    // -32768 is not an overflow, but 32768 and everything beyond either extreme is.
+    QTest::newRow("DECI, extremes") << deciProgram() << "32767 -32768 32768 -32769 65535 99999 -99999";
+    QTest::newRow("DECI, whitespace") << deciProgram() << "\n  12\n\n-3   +4 5,6;7 8";
+    QTest::newRow("DECI, leading zeros") << deciProgram() << "007 -0009 +00 0000032767 00 1 2";
+    // Input errors print the operating system's message, and halt inside the trap handler.
+    QTest::newRow("DECI, error at start") << deciProgram() << "x";
+    QTest::newRow("DECI, error after sign") << deciProgram() << "5 -x";
+    QTest::newRow("DECI, error at line feed after sign") << deciProgram() << "1 2 3 +\n";
+    QTest::newRow("DECI, error in last mode") << deciProgram() << "1 2 3 4 5 6 \t7";
+    QTest::newRow("DECO and HEXO") << outputProgram() << "";
+    QTest::newRow("STRO") << stroProgram() << "";
+}
+
+void TestTrapAcceleration::matchesOperatingSystem()
+{
+    QFETCH(QString, source);
+    QFETCH(QString, input);
+    QString errorMessage;
+    QVector<quint8> objectCode = IsaMachine::assemble(source, errorMessage);
+    QVERIFY2(!objectCode.isEmpty(), qPrintable(errorMessage));
+
+    IsaMachine simulated, accelerated;
+    auto simulatedCpu = simulated.getCpu(), acceleratedCpu = accelerated.getCpu();
+    acceleratedCpu->setTrapAccelerationEnabled(true);
+    for(IsaMachine* machine : {&simulated, &accelerated}) {
+        machine->load(objectCode);
+        machine->setInput(input);
+    }
+    const bool simulatedStopped = simulated.run();
+    const bool acceleratedStopped = accelerated.run();
+
+    QVERIFY(acceleratedCpu->isTrapAccelerationActive());
+    QVERIFY(acceleratedCpu->getAcceleratedTrapCount() > 0);
+    QCOMPARE(simulatedCpu->getAcceleratedTrapCount(), static_cast<quint64>(0));
+    QCOMPARE(acceleratedStopped, simulatedStopped);
+    QCOMPARE(acceleratedCpu->hadErrorOnStep(), simulatedCpu->hadErrorOnStep());
+
+    IsaMachine::State expected = simulated.getState(), actual = accelerated.getState();
+    QCOMPARE(QString::fromLatin1(actual.output), QString::fromLatin1(expected.output));
+    QString difference = firstDifference(actual.memory, expected.memory);
+    QVERIFY2(difference.isEmpty(), qPrintable(difference));
+    QCOMPARE(actual, expected);
+
+    QCOMPARE(simulatedCpu->getEmulatedInstructionCount(), simulatedCpu->getInstructionCount());
+    QCOMPARE(acceleratedCpu->getEmulatedInstructionCount(), simulatedCpu->getInstructionCount());
+    QVERIFY(acceleratedCpu->getInstructionCount() < simulatedCpu->getInstructionCount());
+}
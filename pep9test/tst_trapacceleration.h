@@ -0,0 +1,42 @@
+// File: tst_trapacceleration.h
+/*
+    The Pep/9 suite of applications (Pep9, Pep9CPU, Pep9Micro) are
+    simulators for the Pep/9 virtual machine, and allow users to
+    create, simulate, and debug across various levels of abstraction.
+
+    Copyright (C) 2019 J. Stanley Warford & Matthew McRaven, Pepperdine University
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TST_TRAPACCELERATION_H
+#define TST_TRAPACCELERATION_H
+
+#include <QtTest>
+
+/*
+ * An accelerated DECI, DECO, HEXO, or STRO trap must leave the machine exactly as the
+ * stock operating system's handler would: every register and status bit, all of memory
+ * including the handler's locals below the system stack pointer, the bytes written to charOut,
+ * and the number of instructions the handler would have executed.
+ */
+class TestTrapAcceleration: public QObject
+{
+    Q_OBJECT
+private slots:
+    // Run each program with the operating system simulated, then with traps accelerated.
+    void matchesOperatingSystem_data();
+    void matchesOperatingSystem();
+};
+
+#endif // TST_TRAPACCELERATION_H